@@ -43,6 +43,7 @@ typedef struct
     int overrideQualityAlpha;
     avifBool progressive; // automatic layered encoding (progressive) with single input
     avifBool layered;     // manual layered encoding by specifying each layer
+    avifBool remux;       // rewrite the container of an AVIF input without reencoding its AV1 samples
     int layers;
     int speed;
     avifHeaderFormat headerFormat;
@@ -235,6 +236,8 @@ static void syntaxLong(void)
     printf("    -g,--grid MxN                     : Encode a single-image grid AVIF with M cols & N rows. Either supply MxN identical W/H/D images, or a single\n");
     printf("                                        image that can be evenly split into the MxN grid and follow AVIF grid image restrictions. The grid will adopt\n");
     printf("                                        the color profile of the first image supplied.\n");
+    printf("    --remux                           : Rewrite the container of a single AVIF input without reencoding its AV1 payload. Only the metadata and\n");
+    printf("                                        property flags (such as --exif, --ignore-xmp, --icc, --cicp, --irot, --clli) apply.\n");
     printf("    -c,--codec C                      : AV1 codec to use (choose from versions list below)\n");
     printf("    --exif FILENAME                   : Provide an Exif metadata payload to be associated with the primary item (implies --ignore-exif)\n");
     printf("    --xmp FILENAME                    : Provide an XMP metadata payload to be associated with the primary item (implies --ignore-xmp)\n");
@@ -859,6 +862,69 @@ static avifBool avifImageSplitGrid(const avifImage * gridSplitImage, uint32_t gr
 #define PROGRESSIVE_WORST_QUALITY 10 // Not doing auto automatic layered encoding below this quality
 #define PROGRESSIVE_START_QUALITY 2  // First layer use this quality
 
+// Sets the pasp, clap, irot, imir and clli properties of image from the command line. Returns AVIF_FALSE if they are invalid.
+static avifBool avifImageApplyPropertySettings(avifImage * image,
+                                               avifSettings * settings,
+                                               avifBool cropConversionRequired,
+                                               uint8_t irotAngle,
+                                               uint8_t imirAxis)
+{
+    if (settings->paspPresent) {
+        image->transformFlags |= AVIF_TRANSFORM_PASP;
+        image->pasp.hSpacing = settings->paspValues[0];
+        image->pasp.vSpacing = settings->paspValues[1];
+    }
+    if (cropConversionRequired) {
+        if (!convertCropToClap(image->width, image->height, image->yuvFormat, settings->clapValues)) {
+            return AVIF_FALSE;
+        }
+        settings->clapValid = AVIF_TRUE;
+    }
+    if (settings->clapValid) {
+        image->transformFlags |= AVIF_TRANSFORM_CLAP;
+        image->clap.widthN = settings->clapValues[0];
+        image->clap.widthD = settings->clapValues[1];
+        image->clap.heightN = settings->clapValues[2];
+        image->clap.heightD = settings->clapValues[3];
+        image->clap.horizOffN = settings->clapValues[4];
+        image->clap.horizOffD = settings->clapValues[5];
+        image->clap.vertOffN = settings->clapValues[6];
+        image->clap.vertOffD = settings->clapValues[7];
+
+        // Validate clap
+        avifCropRect cropRect;
+        avifDiagnostics diag;
+        avifDiagnosticsClearError(&diag);
+        if (!avifCropRectConvertCleanApertureBox(&cropRect, &image->clap, image->width, image->height, image->yuvFormat, &diag)) {
+            fprintf(stderr,
+                    "ERROR: Invalid clap: width:[%d / %d], height:[%d / %d], horizOff:[%d / %d], vertOff:[%d / %d] - %s\n",
+                    (int32_t)image->clap.widthN,
+                    (int32_t)image->clap.widthD,
+                    (int32_t)image->clap.heightN,
+                    (int32_t)image->clap.heightD,
+                    (int32_t)image->clap.horizOffN,
+                    (int32_t)image->clap.horizOffD,
+                    (int32_t)image->clap.vertOffN,
+                    (int32_t)image->clap.vertOffD,
+                    diag.error);
+            return AVIF_FALSE;
+        }
+    }
+    if (irotAngle != 0xff) {
+        image->transformFlags |= AVIF_TRANSFORM_IROT;
+        image->irot.angle = irotAngle;
+    }
+    if (imirAxis != 0xff) {
+        image->transformFlags |= AVIF_TRANSFORM_IMIR;
+        image->imir.axis = imirAxis;
+    }
+    if (settings->clliPresent) {
+        image->clli.maxCLL = (uint16_t)settings->clliValues[0];
+        image->clli.maxPALL = (uint16_t)settings->clliValues[1];
+    }
+    return AVIF_TRUE;
+}
+
 static avifBool avifEncodeUpdateEncoderSettings(avifEncoder * encoder, const avifInputFileSettings * settings)
 {
     if (!settings) {
@@ -1136,11 +1202,62 @@ cleanup:
     return success;
 }
 
+// Returns NULL and prints an error if outputFilename cannot be written.
+static avifIO * avifCreateOutputFileWriter(const char * outputFilename, avifBool noOverwrite)
+{
+    if (noOverwrite && fileExists(outputFilename)) {
+        // check again before write
+        fprintf(stderr, "ERROR: output file %s already exists and --no-overwrite was specified\n", outputFilename);
+        return NULL;
+    }
+    avifIO * io = avifIOCreateFileWriter(outputFilename);
+    if (!io) {
+        fprintf(stderr, "ERROR: Failed to open file for write: %s\n", outputFilename);
+    }
+    return io;
+}
+
+static avifBool avifWriteOutputFile(const char * outputFilename, const avifRWData * raw, avifBool noOverwrite)
+{
+    avifIO * io = avifCreateOutputFileWriter(outputFilename, noOverwrite);
+    if (!io) {
+        return AVIF_FALSE;
+    }
+    const avifBool written = (io->write(io, AVIF_IO_WRITE_FLAG_FINISH, /*offset=*/0, raw->data, raw->size) == AVIF_RESULT_OK);
+    avifIODestroy(io);
+    if (!written) {
+        fprintf(stderr, "Failed to write %" AVIF_FMT_ZU " bytes: %s\n", raw->size, outputFilename);
+        return AVIF_FALSE;
+    }
+    return AVIF_TRUE;
+}
+
+// Same as avifEncoderFinish() followed by avifWriteOutputFile() but the file is written as it is serialized, so that it
+// is never entirely held in memory next to the encoded samples.
+static avifBool avifFinishToOutputFile(avifEncoder * encoder, const char * outputFilename, avifBool noOverwrite)
+{
+    avifIO * io = avifCreateOutputFileWriter(outputFilename, noOverwrite);
+    if (!io) {
+        return AVIF_FALSE;
+    }
+    const avifResult result = avifEncoderFinishToIO(encoder, io);
+    avifIODestroy(io);
+    if (result != AVIF_RESULT_OK) {
+        fprintf(stderr, "ERROR: Failed to finish encoding: %s\n", avifResultToString(result));
+        remove(outputFilename);
+        return AVIF_FALSE;
+    }
+    return AVIF_TRUE;
+}
+
+// If outputFilename is not NULL, the file is written there directly and encoded is left empty.
 static avifBool avifEncodeImagesFixedQuality(const avifSettings * settings,
                                              avifInput * input,
                                              const avifInputFile * firstFile,
                                              const avifImage * firstImage,
                                              const avifImage * const * gridCells,
+                                             const char * outputFilename,
+                                             avifBool noOverwrite,
                                              avifRWData * encoded,
                                              avifEncodedByteSizes * byteSizes)
 {
@@ -1268,10 +1385,16 @@ static avifBool avifEncodeImagesFixedQuality(const avifSettings * settings,
         }
     }
 
-    const avifResult finishResult = avifEncoderFinish(encoder, encoded);
-    if (finishResult != AVIF_RESULT_OK) {
-        fprintf(stderr, "ERROR: Failed to finish encoding: %s\n", avifResultToString(finishResult));
-        goto cleanup;
+    if (outputFilename) {
+        if (!avifFinishToOutputFile(encoder, outputFilename, noOverwrite)) {
+            goto cleanup;
+        }
+    } else {
+        const avifResult finishResult = avifEncoderFinish(encoder, encoded);
+        if (finishResult != AVIF_RESULT_OK) {
+            fprintf(stderr, "ERROR: Failed to finish encoding: %s\n", avifResultToString(finishResult));
+            goto cleanup;
+        }
     }
     success = AVIF_TRUE;
     byteSizes->colorSizeBytes = encoder->ioStats.colorOBUSize;
@@ -1290,16 +1413,20 @@ cleanup:
     return success;
 }
 
+// Encodes the input and writes the result to outputFilename.
 static avifBool avifEncodeImages(avifSettings * settings,
                                  avifInput * input,
                                  const avifInputFile * firstFile,
                                  const avifImage * firstImage,
                                  const avifImage * const * gridCells,
-                                 avifRWData * encoded,
+                                 const char * outputFilename,
+                                 avifBool noOverwrite,
                                  avifEncodedByteSizes * byteSizes)
 {
     if (settings->targetSize == -1) {
-        return avifEncodeImagesFixedQuality(settings, input, firstFile, firstImage, gridCells, encoded, byteSizes);
+        avifRWData unused = AVIF_DATA_EMPTY;
+        return avifEncodeImagesFixedQuality(settings, input, firstFile, firstImage, gridCells, outputFilename, noOverwrite,
+                                            &unused, byteSizes);
     }
 
     avifBool hasGainMap = AVIF_FALSE;
@@ -1325,6 +1452,7 @@ static avifBool avifEncodeImages(avifSettings * settings,
 
     // TODO(yguyon): Use quantizer instead of quality because quantizer range is smaller (faster binary search).
     int closestQuality = INVALID_QUALITY;
+    avifRWData encoded = AVIF_DATA_EMPTY;
     avifRWData closestEncoded = { NULL, 0 };
     size_t closestSizeDiff = 0;
     avifEncodedByteSizes closestByteSizes = { 0, 0, 0 };
@@ -1343,31 +1471,35 @@ static avifBool avifEncodeImages(avifSettings * settings,
             settings->qualityGainMap = quality;
         }
 
-        if (!avifEncodeImagesFixedQuality(settings, input, firstFile, firstImage, gridCells, encoded, byteSizes)) {
+        if (!avifEncodeImagesFixedQuality(settings, input, firstFile, firstImage, gridCells, /*outputFilename=*/NULL, noOverwrite,
+                                          &encoded, byteSizes)) {
             avifRWDataFree(&closestEncoded);
             return AVIF_FALSE;
         }
-        printf("Encoded image of size %" AVIF_FMT_ZU " bytes.\n", encoded->size);
+        printf("Encoded image of size %" AVIF_FMT_ZU " bytes.\n", encoded.size);
 
-        if (encoded->size == targetSize) {
-            return AVIF_TRUE;
+        if (encoded.size == targetSize) {
+            avifRWDataFree(&closestEncoded);
+            const avifBool written = avifWriteOutputFile(outputFilename, &encoded, noOverwrite);
+            avifRWDataFree(&encoded);
+            return written;
         }
 
         size_t sizeDiff;
-        if (encoded->size > targetSize) {
-            sizeDiff = encoded->size - targetSize;
+        if (encoded.size > targetSize) {
+            sizeDiff = encoded.size - targetSize;
             maxQuality = quality - 1;
         } else {
-            sizeDiff = targetSize - encoded->size;
+            sizeDiff = targetSize - encoded.size;
             minQuality = quality + 1;
         }
 
         if ((closestQuality == INVALID_QUALITY) || (sizeDiff < closestSizeDiff)) {
             closestQuality = quality;
             avifRWDataFree(&closestEncoded);
-            closestEncoded = *encoded;
-            encoded->size = 0;
-            encoded->data = NULL;
+            closestEncoded = encoded;
+            encoded.size = 0;
+            encoded.data = NULL;
             closestSizeDiff = sizeDiff;
             closestByteSizes = *byteSizes;
         }
@@ -1379,10 +1511,9 @@ static avifBool avifEncodeImages(avifSettings * settings,
     if (!settings->qualityAlphaIsConstrained) {
         settings->overrideQualityAlpha = closestQuality;
     }
-    avifRWDataFree(encoded);
-    *encoded = closestEncoded;
+    avifRWDataFree(&encoded);
     *byteSizes = closestByteSizes;
-    printf("Kept the encoded image of size %" AVIF_FMT_ZU " bytes generated with ", encoded->size);
+    printf("Kept the encoded image of size %" AVIF_FMT_ZU " bytes generated with ", closestEncoded.size);
     if (!settings->qualityIsConstrained) {
         printf("color quality %d", settings->overrideQuality);
     }
@@ -1393,7 +1524,90 @@ static avifBool avifEncodeImages(avifSettings * settings,
         printf("alpha quality %d", settings->overrideQualityAlpha);
     }
     printf(".\n");
-    return AVIF_TRUE;
+    const avifBool written = avifWriteOutputFile(outputFilename, &closestEncoded, noOverwrite);
+    avifRWDataFree(&closestEncoded);
+    return written;
+}
+
+// Rewrites the container of the AVIF file inputFilename into outputFilename, without decoding nor encoding
+// its AV1 samples. Only the metadata and property related settings are applied.
+static avifBool avifRemuxFile(const char * inputFilename,
+                              avifSettings * settings,
+                              const avifRWData * iccOverride,
+                              const avifRWData * exifOverride,
+                              const avifRWData * xmpOverride,
+                              avifBool cropConversionRequired,
+                              uint8_t irotAngle,
+                              uint8_t imirAxis,
+                              const char * outputFilename,
+                              avifBool noOverwrite)
+{
+    avifBool success = AVIF_FALSE;
+    avifEncoder * encoder = NULL;
+    avifDecoder * decoder = avifDecoderCreate();
+    if (!decoder) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        goto cleanup;
+    }
+    decoder->ignoreExif = settings->ignoreExif;
+    decoder->ignoreXMP = settings->ignoreXMP;
+    avifResult result = avifDecoderSetIOFile(decoder, inputFilename);
+    if (result == AVIF_RESULT_OK) {
+        result = avifDecoderParse(decoder);
+    }
+    if (result != AVIF_RESULT_OK) {
+        fprintf(stderr, "ERROR: Failed to parse %s: %s\n", inputFilename, avifResultToString(result));
+        avifDumpDiagnostics(&decoder->diag);
+        goto cleanup;
+    }
+    printf("Successfully parsed: %s\n", inputFilename);
+
+    avifImage * image = decoder->image;
+    if ((settings->ignoreColorProfile && (avifImageSetProfileICC(image, NULL, 0) != AVIF_RESULT_OK)) ||
+        (iccOverride->size && (avifImageSetProfileICC(image, iccOverride->data, iccOverride->size) != AVIF_RESULT_OK)) ||
+        (exifOverride->size && (avifImageSetMetadataExif(image, exifOverride->data, exifOverride->size) != AVIF_RESULT_OK)) ||
+        (xmpOverride->size && (avifImageSetMetadataXMP(image, xmpOverride->data, xmpOverride->size) != AVIF_RESULT_OK))) {
+        fprintf(stderr, "Error when setting overridden metadata: out of memory.\n");
+        goto cleanup;
+    }
+    if (settings->cicpExplicitlySet) {
+        image->colorPrimaries = settings->colorPrimaries;
+        image->transferCharacteristics = settings->transferCharacteristics;
+        image->matrixCoefficients = settings->matrixCoefficients;
+    }
+    if (!avifImageApplyPropertySettings(image, settings, cropConversionRequired, irotAngle, imirAxis)) {
+        goto cleanup;
+    }
+
+    encoder = avifEncoderCreate();
+    if (!encoder) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        goto cleanup;
+    }
+    encoder->headerFormat = settings->headerFormat;
+    result = avifEncoderRemux(encoder, decoder);
+    if (result != AVIF_RESULT_OK) {
+        fprintf(stderr, "ERROR: Failed to remux %s: %s\n", inputFilename, avifResultToString(result));
+        avifDumpDiagnostics(&encoder->diag);
+        goto cleanup;
+    }
+    if (!avifFinishToOutputFile(encoder, outputFilename, noOverwrite)) {
+        avifDumpDiagnostics(&encoder->diag);
+        goto cleanup;
+    }
+    printf("Remuxed successfully.\n");
+    printf(" * Color AV1 total size: %" AVIF_FMT_ZU " bytes\n", encoder->ioStats.colorOBUSize);
+    printf(" * Alpha AV1 total size: %" AVIF_FMT_ZU " bytes\n", encoder->ioStats.alphaOBUSize);
+    success = AVIF_TRUE;
+
+cleanup:
+    if (encoder) {
+        avifEncoderDestroy(encoder);
+    }
+    if (decoder) {
+        avifDecoderDestroy(decoder);
+    }
+    return success;
 }
 
 MAIN()
@@ -1431,6 +1645,7 @@ MAIN()
     settings.qualityGainMap = DEFAULT_QUALITY_GAIN_MAP;
     settings.progressive = AVIF_FALSE;
     settings.layered = AVIF_FALSE;
+    settings.remux = AVIF_FALSE;
     settings.layers = 0;
     settings.speed = 6;
     settings.headerFormat = AVIF_HEADER_FULL;
@@ -1451,7 +1666,6 @@ MAIN()
     avifRange requestedRange = AVIF_RANGE_FULL;
     avifBool lossless = AVIF_FALSE;
     avifImage * image = NULL;
-    avifRWData raw = AVIF_DATA_EMPTY;
     avifRWData exifOverride = AVIF_DATA_EMPTY;
     avifRWData xmpOverride = AVIF_DATA_EMPTY;
     avifRWData iccOverride = AVIF_DATA_EMPTY;
@@ -1708,6 +1922,8 @@ MAIN()
                 goto cleanup;
             }
             settings.progressive = AVIF_TRUE;
+        } else if (!strcmp(arg, "--remux")) {
+            settings.remux = AVIF_TRUE;
         } else if (!strcmp(arg, "--layered")) {
             if (settings.progressive) {
                 fprintf(stderr, "ERROR: Can not use both --progressive and --layered\n");
@@ -2027,6 +2243,28 @@ MAIN()
         fprintf(stderr, "WARNING: Trailing options with update suffix has no effect. Place them before the input you intend to apply to.\n");
     }
 
+    if (settings.remux) {
+        if (input.useStdin || (input.filesCount != 1)) {
+            fprintf(stderr, "ERROR: --remux requires exactly one input file.\n");
+            goto cleanup;
+        }
+        if (!avifRemuxFile(input.files[0].filename,
+                           &settings,
+                           &iccOverride,
+                           &exifOverride,
+                           &xmpOverride,
+                           cropConversionRequired,
+                           irotAngle,
+                           imirAxis,
+                           outputFilename,
+                           noOverwrite)) {
+            goto cleanup;
+        }
+        printf("Wrote AVIF: %s\n", outputFilename);
+        returnCode = 0;
+        goto cleanup;
+    }
+
     // Check layer config
     if (settings.progressive) {
         assert(!settings.layered);
@@ -2288,58 +2526,8 @@ MAIN()
         image->transferCharacteristics = AVIF_TRANSFER_CHARACTERISTICS_SRGB;
     }
 
-    if (settings.paspPresent) {
-        image->transformFlags |= AVIF_TRANSFORM_PASP;
-        image->pasp.hSpacing = settings.paspValues[0];
-        image->pasp.vSpacing = settings.paspValues[1];
-    }
-    if (cropConversionRequired) {
-        if (!convertCropToClap(image->width, image->height, image->yuvFormat, settings.clapValues)) {
-            goto cleanup;
-        }
-        settings.clapValid = AVIF_TRUE;
-    }
-    if (settings.clapValid) {
-        image->transformFlags |= AVIF_TRANSFORM_CLAP;
-        image->clap.widthN = settings.clapValues[0];
-        image->clap.widthD = settings.clapValues[1];
-        image->clap.heightN = settings.clapValues[2];
-        image->clap.heightD = settings.clapValues[3];
-        image->clap.horizOffN = settings.clapValues[4];
-        image->clap.horizOffD = settings.clapValues[5];
-        image->clap.vertOffN = settings.clapValues[6];
-        image->clap.vertOffD = settings.clapValues[7];
-
-        // Validate clap
-        avifCropRect cropRect;
-        avifDiagnostics diag;
-        avifDiagnosticsClearError(&diag);
-        if (!avifCropRectConvertCleanApertureBox(&cropRect, &image->clap, image->width, image->height, image->yuvFormat, &diag)) {
-            fprintf(stderr,
-                    "ERROR: Invalid clap: width:[%d / %d], height:[%d / %d], horizOff:[%d / %d], vertOff:[%d / %d] - %s\n",
-                    (int32_t)image->clap.widthN,
-                    (int32_t)image->clap.widthD,
-                    (int32_t)image->clap.heightN,
-                    (int32_t)image->clap.heightD,
-                    (int32_t)image->clap.horizOffN,
-                    (int32_t)image->clap.horizOffD,
-                    (int32_t)image->clap.vertOffN,
-                    (int32_t)image->clap.vertOffD,
-                    diag.error);
-            goto cleanup;
-        }
-    }
-    if (irotAngle != 0xff) {
-        image->transformFlags |= AVIF_TRANSFORM_IROT;
-        image->irot.angle = irotAngle;
-    }
-    if (imirAxis != 0xff) {
-        image->transformFlags |= AVIF_TRANSFORM_IMIR;
-        image->imir.axis = imirAxis;
-    }
-    if (settings.clliPresent) {
-        image->clli.maxCLL = (uint16_t)settings.clliValues[0];
-        image->clli.maxPALL = (uint16_t)settings.clliValues[1];
+    if (!avifImageApplyPropertySettings(image, &settings, cropConversionRequired, irotAngle, imirAxis)) {
+        goto cleanup;
     }
 
     avifBool hasAlpha = (image->alphaPlane && image->alphaRowBytes);
@@ -2512,7 +2700,14 @@ MAIN()
                   settings.layers > 1 ? AVIF_PROGRESSIVE_STATE_AVAILABLE : AVIF_PROGRESSIVE_STATE_UNAVAILABLE);
 
     avifEncodedByteSizes byteSizes = { 0, 0, 0 };
-    if (!avifEncodeImages(&settings, &input, firstFile, image, (const avifImage * const *)gridCells, &raw, &byteSizes)) {
+    if (!avifEncodeImages(&settings,
+                          &input,
+                          firstFile,
+                          image,
+                          (const avifImage * const *)gridCells,
+                          outputFilename,
+                          noOverwrite,
+                          &byteSizes)) {
         goto cleanup;
     }
 
@@ -2529,23 +2724,7 @@ MAIN()
             printf(" * Repetition Count: %d\n", settings.repetitionCount);
         }
     }
-    if (noOverwrite && fileExists(outputFilename)) {
-        // check again before write
-        fprintf(stderr, "ERROR: output file %s already exists and --no-overwrite was specified\n", outputFilename);
-        goto cleanup;
-    }
-    FILE * f = fopen(outputFilename, "wb");
-    if (!f) {
-        fprintf(stderr, "ERROR: Failed to open file for write: %s\n", outputFilename);
-        goto cleanup;
-    }
-    if (fwrite(raw.data, 1, raw.size, f) != raw.size) {
-        fprintf(stderr, "Failed to write %" AVIF_FMT_ZU " bytes: %s\n", raw.size, outputFilename);
-        goto cleanup;
-    } else {
-        printf("Wrote AVIF: %s\n", outputFilename);
-    }
-    fclose(f);
+    printf("Wrote AVIF: %s\n", outputFilename);
     returnCode = 0;
 
 cleanup:
@@ -2562,7 +2741,6 @@ cleanup:
     if (gridSplitImage) {
         avifImageDestroy(gridSplitImage);
     }
-    avifRWDataFree(&raw);
     avifRWDataFree(&exifOverride);
     avifRWDataFree(&xmpOverride);
     avifRWDataFree(&iccOverride);
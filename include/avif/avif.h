@@ -117,6 +117,9 @@ typedef int avifBool;
 // The number of spatial layers in AV1, with spatial_id = 0..3.
 #define AVIF_MAX_AV1_LAYER_COUNT 4
 
+// The maximum number of thumbnail items that avifEncoder can generate (see avifEncoder.thumbnailSizes).
+#define AVIF_MAX_THUMBNAIL_COUNT 4
+
 typedef enum avifPlanesFlag
 {
     AVIF_PLANES_YUV = (1 << 0),
@@ -190,6 +193,7 @@ typedef enum AVIF_NODISCARD avifResult
     AVIF_RESULT_DECODE_GAIN_MAP_FAILED = 30,
     AVIF_RESULT_INVALID_TONE_MAPPED_IMAGE = 31,
 #endif
+    AVIF_RESULT_MEMORY_LIMIT_EXCEEDED = 32, // decoding would use more memory than avifDecoder's memoryLimit
 
     // Kept for backward compatibility; please use the symbols above instead.
     AVIF_RESULT_NO_AV1_ITEMS_FOUND = AVIF_RESULT_MISSING_IMAGE_ITEM
@@ -788,9 +792,29 @@ AVIF_API void avifImageStealPlanes(avifImage * dstImage, avifImage * srcImage, a
 // ---------------------------------------------------------------------------
 // Scaling
 
+typedef enum avifScaleFilter
+{
+    AVIF_SCALE_FILTER_AUTOMATIC = 0, // Same as BOX
+    AVIF_SCALE_FILTER_NEAREST = 1,   // Point sampling. Fastest.
+    AVIF_SCALE_FILTER_BILINEAR = 2,  // Faster than BOX, but lower quality when scaling down
+    AVIF_SCALE_FILTER_BOX = 3,       // Area averaging when scaling down, bilinear when scaling up
+    AVIF_SCALE_FILTER_LANCZOS = 4    // Lanczos (3 lobes). Sharpest, slowest. Always uses the built-in resampler.
+} avifScaleFilter;
+
 // Scales the YUV/A planes in-place. dstWidth and dstHeight must both be <= AVIF_DEFAULT_IMAGE_DIMENSION_LIMIT and
 // dstWidth*dstHeight should be <= AVIF_DEFAULT_IMAGE_SIZE_LIMIT.
+// Same as avifImageScaleWithFilter() with AVIF_SCALE_FILTER_AUTOMATIC and a single thread.
 AVIF_API avifResult avifImageScale(avifImage * image, uint32_t dstWidth, uint32_t dstHeight, avifDiagnostics * diag);
+// Same as avifImageScale() with a choice of filter. Up to maxThreads threads (including the calling one) scale the planes,
+// and bands of rows of each plane, in parallel. Zero has the same effect as one. Negative values are invalid.
+// libyuv is used when possible. Planes with a dimension larger than 16384, or scaled with AVIF_SCALE_FILTER_LANCZOS, are
+// scaled by a built-in separable resampler instead.
+AVIF_API avifResult avifImageScaleWithFilter(avifImage * image,
+                                             uint32_t dstWidth,
+                                             uint32_t dstHeight,
+                                             avifScaleFilter filter,
+                                             int maxThreads,
+                                             avifDiagnostics * diag);
 
 // ---------------------------------------------------------------------------
 // Optional YUV<->RGB support
@@ -831,9 +855,16 @@ typedef enum avifRGBFormat
     //   r4 and r0 are the MSB and LSB of the red component respectively.
     //   g5 and g0 are the MSB and LSB of the green component respectively.
     //   b4 and b0 are the MSB and LSB of the blue component respectively.
-    // This format is only supported for YUV -> RGB conversion and when
-    // avifRGBImage.depth is set to 8.
+    // This format is only supported when avifRGBImage.depth is set to 8.
     AVIF_RGB_FORMAT_RGB_565,
+    // RGBA1010102 format uses ten bits for each of the red, green and blue
+    // components and two bits for the alpha component. Each RGBA pixel is 32
+    // bits (4 bytes), which is packed as follows:
+    //   uint32_t: [a1 a0 b9 ... b0 g9 ... g0 r9 ... r0]
+    //   r9 and r0 are the MSB and LSB of the red component respectively, and
+    //   so on for the other components.
+    // This format is only supported when avifRGBImage.depth is set to 10.
+    AVIF_RGB_FORMAT_RGBA1010102,
     AVIF_RGB_FORMAT_COUNT
 } avifRGBFormat;
 AVIF_API uint32_t avifRGBFormatChannelCount(avifRGBFormat format);
@@ -852,7 +883,8 @@ typedef enum avifChromaUpsampling
 typedef enum avifChromaDownsampling
 {
     AVIF_CHROMA_DOWNSAMPLING_AUTOMATIC = 0,    // Chooses best trade off of speed/quality (same as AVERAGE)
-    AVIF_CHROMA_DOWNSAMPLING_FASTEST = 1,      // Chooses speed over quality (same as AVERAGE)
+    AVIF_CHROMA_DOWNSAMPLING_FASTEST = 1,      // Chooses speed over quality (same as AVERAGE, but the built-in conversion
+                                               // uses fixed-point arithmetic for depths up to 12, which may be off by one)
     AVIF_CHROMA_DOWNSAMPLING_BEST_QUALITY = 2, // Chooses the best quality upsampling (same as AVERAGE)
     AVIF_CHROMA_DOWNSAMPLING_AVERAGE = 3,      // Uses averaging filter
     AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV = 4     // Uses sharp yuv filter (libsharpyuv), available for 4:2:0 only, ignored for 4:2:2
@@ -864,7 +896,7 @@ typedef struct avifRGBImage
 {
     uint32_t width;                        // must match associated avifImage
     uint32_t height;                       // must match associated avifImage
-    uint32_t depth;                        // legal depths [8, 10, 12, 16]. if depth>8, pixels must be uint16_t internally
+    uint32_t depth; // legal depths [8, 10, 12, 16], or 32 for float. if depth>8, pixels are uint16_t (float if depth is 32)
     avifRGBFormat format;                  // all channels are always full range
     avifChromaUpsampling chromaUpsampling; // How to upsample from 4:2:0 or 4:2:2 UV when converting to RGB (ignored for 4:4:4 and 4:0:0).
                                            // Ignored when converting to YUV. Defaults to AVIF_CHROMA_UPSAMPLING_AUTOMATIC.
@@ -875,10 +907,25 @@ typedef struct avifRGBImage
     avifBool ignoreAlpha; // Used for XRGB formats, treats formats containing alpha (such as ARGB) as if they were RGB, treating
                           // the alpha bits as if they were all 1.
     avifBool alphaPremultiplied; // indicates if RGB value is pre-multiplied by alpha. Default: false
-    avifBool isFloat; // indicates if RGBA values are in half float (f16) format. Valid only when depth == 16. Default: false
-    int maxThreads; // Number of threads to be used for the YUV to RGB conversion. Note that this value is ignored for RGB to YUV
-                    // conversion. Setting this to zero has the same effect as setting it to one. Negative values are invalid.
-                    // Default: 1.
+    avifBool isFloat; // indicates if RGBA values are in half float (f16) format when depth == 16, or in 32-bit float format
+                      // when depth == 32. The range [0.0, 1.0] is mapped to the full range of the YUV samples, other values
+                      // are clamped. depth == 32 is only supported by avifImageRGBToYUV(). Default: false
+    int maxThreads; // Number of threads to be used for the conversion between YUV and RGB. Setting this to zero has the same
+                    // effect as setting it to one. Negative values are invalid. Default: 1.
+    avifBool fixedPoint; // If AVIF_TRUE, avifImageRGBToYUV() and avifImageYUVToRGB() use an integer fixed-point pipeline
+                         // whose output is bit-exact on every platform and for any maxThreads value. libyuv and libsharpyuv
+                         // are not used. Only supported for YUV matrix coefficients (not identity or YCgCo) and depths up
+                         // to 12 bits. avifImageYUVToRGB() (un)multiplies alpha in integers too, when converting to a
+                         // format with alpha. AVIF_RESULT_NOT_IMPLEMENTED is returned otherwise, and by
+                         // avifImageRGBToYUV() if alpha has to be (un)multiplied. The arithmetic is documented in
+                         // reformat.c and may differ by one from the default conversion. Default: AVIF_FALSE.
+    avifBool ditherRGB565; // If AVIF_TRUE, a 4x4 ordered dither is applied when reducing the converted samples to
+                           // AVIF_RGB_FORMAT_RGB_565. This avoids banding in smooth gradients. Ignored for other formats and
+                           // when converting to YUV. Default: AVIF_FALSE.
+    avifBool isLinear; // If AVIF_TRUE and isFloat is AVIF_TRUE, avifImageRGBToYUV() considers the RGB values as linear light
+                       // where 1.0 is SDR white (203 cd/m2), and encodes them with the transfer function of
+                       // image->transferCharacteristics (such as PQ or HLG) before the conversion. Alpha is never encoded.
+                       // Ignored otherwise. Default: AVIF_FALSE.
 
     uint8_t * pixels;
     uint32_t rowBytes;
@@ -897,6 +944,12 @@ AVIF_API void avifRGBImageFreePixels(avifRGBImage * rgb);
 // The main conversion functions
 AVIF_API avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb);
 AVIF_API avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb);
+// Same as avifImageYUVToRGB() but rgb->width and rgb->height may differ from the dimensions of the image, which is
+// resampled with the given filter (see avifImageScaleWithFilter()) during the conversion. The YUV(A) planes are resampled
+// straight to the output dimensions in strips of a few rows, so neither a full size RGB image nor a scaled copy of the
+// YUV planes is ever allocated. The chroma planes are upsampled by the same filter, so rgb->chromaUpsampling is ignored.
+// The strips are resampled and converted by up to rgb->maxThreads threads.
+AVIF_API avifResult avifImageYUVToRGBScaled(const avifImage * image, avifRGBImage * rgb, avifScaleFilter filter);
 
 // Premultiply handling functions.
 // (Un)premultiply is automatically done by the main conversion functions above,
@@ -904,6 +957,55 @@ AVIF_API avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rg
 AVIF_API avifResult avifRGBImagePremultiplyAlpha(avifRGBImage * rgb);
 AVIF_API avifResult avifRGBImageUnpremultiplyAlpha(avifRGBImage * rgb);
 
+// ---------------------------------------------------------------------------
+// avifRGBPlanarImage
+
+typedef enum avifPlanarSampleType
+{
+    AVIF_PLANAR_SAMPLE_UINT8 = 0, // uint8_t samples. avifRGBPlanarImage.depth must be 8.
+    AVIF_PLANAR_SAMPLE_UINT16,    // uint16_t samples, at avifRGBPlanarImage.depth.
+    // float samples in [0:1], unless normalized. avifRGBPlanarImage.depth is ignored. The samples are computed by the
+    // 16-bit integer conversion then divided by 65535, so they are quantized to 16 bits (before normalization).
+    AVIF_PLANAR_SAMPLE_FLOAT32
+} avifPlanarSampleType;
+
+// RGB(A) with each channel in its own plane (for example a CHW tensor), as expected by most machine learning models.
+typedef struct avifRGBPlanarImage
+{
+    uint32_t width;  // must match associated avifImage
+    uint32_t height; // must match associated avifImage
+    uint32_t depth;  // legal depths [8, 10, 12, 16] for AVIF_PLANAR_SAMPLE_UINT16, 8 for AVIF_PLANAR_SAMPLE_UINT8
+    avifPlanarSampleType sampleType;
+    avifChromaUpsampling chromaUpsampling; // Same as in avifRGBImage.
+    avifBool avoidLibYUV;                  // Same as in avifRGBImage.
+    avifBool alphaPremultiplied;           // Same as in avifRGBImage.
+    int maxThreads;                        // Same as in avifRGBImage.
+    // Only used with AVIF_PLANAR_SAMPLE_FLOAT32. If AVIF_TRUE, each sample v in [0:1] of channel c is stored as
+    // (v - mean[c]) / std[c], in the same pass as the conversion. std[c] must not be zero. Default: AVIF_FALSE.
+    avifBool normalize;
+    float mean[4];
+    float std[4];
+
+    // R, G, B and A planes. The A plane is optional: if planes[3] is NULL, the image is converted as if to a format
+    // without alpha (see avifRGBImage).
+    uint8_t * planes[4];
+    uint32_t rowBytes[4];
+} avifRGBPlanarImage;
+
+// Sets rgb->width, rgb->height, and rgb->depth to image->width, image->height, and image->depth, rgb->sampleType to
+// AVIF_PLANAR_SAMPLE_UINT8 if image->depth is 8 and to AVIF_PLANAR_SAMPLE_UINT16 otherwise, rgb->mean to 0 and rgb->std
+// to 1. Sets the planes to NULL and the other fields of 'rgb' to default values.
+AVIF_API void avifRGBPlanarImageSetDefaults(avifRGBPlanarImage * rgb, const avifImage * image);
+// Allocates the R, G, B planes, and the A plane if withAlpha is AVIF_TRUE, contiguously one after the other starting at
+// rgb->planes[0], with no padding between rows.
+AVIF_API avifResult avifRGBPlanarImageAllocatePlanes(avifRGBPlanarImage * rgb, avifBool withAlpha);
+// Frees the planes allocated by avifRGBPlanarImageAllocatePlanes().
+AVIF_API void avifRGBPlanarImageFreePlanes(avifRGBPlanarImage * rgb);
+
+// Same as avifImageYUVToRGB() but with planar output. The image is converted in strips of a few rows that are stored in
+// the planes while they are still in cache, so there is no separate deinterleaving pass.
+AVIF_API avifResult avifImageYUVToRGBPlanar(const avifImage * image, avifRGBPlanarImage * rgb);
+
 // ---------------------------------------------------------------------------
 // YUV Utils
 
@@ -959,6 +1061,20 @@ typedef void (*avifIODestroyFunc)(struct avifIO * io);
 // * Otherwise, provide the range and return AVIF_RESULT_OK.
 typedef avifResult (*avifIOReadFunc)(struct avifIO * io, uint32_t readFlags, uint64_t offset, size_t size, avifROData * out);
 
+typedef enum avifIOWriteFlag
+{
+    AVIF_IO_WRITE_FLAG_NONE = 0,
+
+    // Set on the last call made by avifEncoderFinishToIO(), with no data. Everything written so far must be committed to
+    // the output (for example flushed or closed), and any error doing so must be returned.
+    AVIF_IO_WRITE_FLAG_FINISH = (1 << 0)
+} avifIOWriteFlag;
+typedef uint32_t avifIOWriteFlags;
+
+// This function should write the size bytes of data at offset. It is called by avifEncoderFinishToIO() in order, each
+// call starting where the previous one ended, so that sequential-only outputs such as pipes or sockets can be used.
+// writeFlags is a combination of avifIOWriteFlag values. Return AVIF_RESULT_OK on success, or AVIF_RESULT_IO_ERROR to
+// abort.
 typedef avifResult (*avifIOWriteFunc)(struct avifIO * io, uint32_t writeFlags, uint64_t offset, const uint8_t * data, size_t size);
 
 typedef struct avifIO
@@ -966,7 +1082,7 @@ typedef struct avifIO
     avifIODestroyFunc destroy;
     avifIOReadFunc read;
 
-    // This is reserved for future use - but currently ignored. Set it to a null pointer.
+    // Only used by avifEncoderFinishToIO(). Set it to a null pointer for readers.
     avifIOWriteFunc write;
 
     // If non-zero, this is a hint to internal structures of the max size offered by the content
@@ -994,6 +1110,9 @@ typedef struct avifIO
 AVIF_API avifIO * avifIOCreateMemoryReader(const uint8_t * data, size_t size);
 // Returns NULL if the file cannot be opened or if the reader cannot be allocated.
 AVIF_API avifIO * avifIOCreateFileReader(const char * filename);
+// Returns NULL if the file cannot be created or if the writer cannot be allocated. The file is closed when written to with
+// AVIF_IO_WRITE_FLAG_FINISH, which fails if the data cannot be flushed, or else by avifIODestroy().
+AVIF_API avifIO * avifIOCreateFileWriter(const char * filename);
 AVIF_API void avifIODestroy(avifIO * io);
 
 // ---------------------------------------------------------------------------
@@ -1231,6 +1350,19 @@ typedef struct avifDecoder
     // decoded either as an animated image sequence or as a still image (the primary image item) by setting avifDecoderSetSource
     // to the appropriate source.
     avifBool imageSequenceTrackPresent;
+
+    // If non-zero, avifDecoderParse() selects the smallest thumbnail item of the primary image item whose largest
+    // dimension is at least minThumbnailSize pixels, and decodes it instead of the primary image item. The primary image
+    // item is decoded if there is no such thumbnail. Exif and XMP metadata are still those of the primary image item.
+    // Ignored if the image sequence track is decoded (see avifDecoderSetSource()). Defaults to 0.
+    uint32_t minThumbnailSize;
+    // This is true when avifDecoderParse() selected a thumbnail item instead of the primary image item.
+    avifBool thumbnailSelected;
+
+    // If non-zero, avifDecoderParse() and avifDecoderSetSource() return AVIF_RESULT_MEMORY_LIMIT_EXCEEDED when the value
+    // returned by avifDecoderEstimateMemoryUsage() is greater than memoryLimit (in bytes), before any AV1 decoding happens.
+    // Defaults to 0 (no limit).
+    uint64_t memoryLimit;
 } avifDecoder;
 
 // Returns NULL in case of memory allocation failure.
@@ -1330,6 +1462,14 @@ typedef struct avifExtent
 // This function may be used after a successful call (AVIF_RESULT_OK) to avifDecoderParse().
 AVIF_API avifResult avifDecoderNthImageMaxExtent(const avifDecoder * decoder, uint32_t frameIndex, avifExtent * outExtent);
 
+// Sets outBytes to a worst-case estimate of the memory (in bytes) needed to decode the images of the selected source:
+// the frame buffers of the underlying AV1 decoder(s) for each tile (including reference frames for image sequences and
+// progressive images), the grid canvases, the alpha plane, the gain map if it is decoded, and the buffers holding the
+// encoded items that cannot be read in place. The avifDecoder and avifImage structures themselves are not counted.
+//
+// This function may be used after a successful call (AVIF_RESULT_OK) to avifDecoderParse(). See also memoryLimit.
+AVIF_API avifResult avifDecoderEstimateMemoryUsage(const avifDecoder * decoder, uint64_t * outBytes);
+
 // ---------------------------------------------------------------------------
 // avifEncoder
 
@@ -1366,6 +1506,10 @@ typedef struct avifScalingMode
 //   a combination of settings are tweaked to simulate this speed range.
 // * Extra layer count: [0 - (AVIF_MAX_AV1_LAYER_COUNT-1)]. Non-zero value indicates a layered
 //   (progressive) image.
+// * Each non-zero entry of thumbnailSizes adds a thumbnail item to a still image, that is an image
+//   given to avifEncoderAddImage() with AVIF_ADD_IMAGE_FLAG_SINGLE. The thumbnail is the image scaled
+//   down with avifImageScale() so that its largest dimension is the entry value, and is encoded with
+//   the same settings. Sizes that are not smaller than the largest dimension of the image are ignored.
 // * Some encoder settings can be changed after encoding starts. Changes will take effect in the next
 //   call to avifEncoderAddImage().
 typedef struct avifEncoder
@@ -1415,6 +1559,10 @@ typedef struct avifEncoder
 #if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
     int qualityGainMap; // changeable encoder setting
 #endif
+
+    // Largest dimension in pixels of each thumbnail item to generate. Zero entries are ignored.
+    // Defaults to all zeros (no thumbnail).
+    uint32_t thumbnailSizes[AVIF_MAX_THUMBNAIL_COUNT];
 } avifEncoder;
 
 // avifEncoderCreate() returns NULL if a memory allocation failed.
@@ -1422,6 +1570,19 @@ AVIF_NODISCARD AVIF_API avifEncoder * avifEncoderCreate(void);
 AVIF_API avifResult avifEncoderWrite(avifEncoder * encoder, const avifImage * image, avifRWData * output);
 AVIF_API void avifEncoderDestroy(avifEncoder * encoder);
 
+// Same as calling avifEncoderWrite() once per entry of widths, with image scaled down to that width (the height follows
+// the aspect ratio of image), and with a new avifEncoder using the settings of encoder each time. widths must be in
+// [1-image->width]. The downscale pyramid is built once, each level being scaled from the previous larger one. The count
+// outputs are then encoded concurrently, sharing the encoder->maxThreads budget.
+// outputs is an array of count empty avifRWData. If avifEncoderWriteMultiResolution() returns AVIF_RESULT_OK, outputs[i]
+// holds the AVIF file of width widths[i] and must be freed with avifRWDataFree(). encoder itself is not used for encoding
+// and can be reused or destroyed afterwards.
+AVIF_API avifResult avifEncoderWriteMultiResolution(avifEncoder * encoder,
+                                                    const avifImage * image,
+                                                    const uint32_t * widths,
+                                                    uint32_t count,
+                                                    avifRWData * outputs);
+
 typedef enum avifAddImageFlag
 {
     AVIF_ADD_IMAGE_FLAG_NONE = 0,
@@ -1469,6 +1630,58 @@ AVIF_API avifResult avifEncoderAddImageGrid(avifEncoder * encoder,
                                             avifAddImageFlags addImageFlags);
 AVIF_API avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output);
 
+// Output of avifEncoderFinishSegmented(). Writing segments[0], segments[1], ..., segments[segmentCount-1] one after the
+// other (for example with writev()) produces the same bytes as avifEncoderFinish().
+typedef struct avifEncoderSegments
+{
+    avifROData * segments;
+    uint32_t segmentCount;
+    size_t size; // Sum of the sizes of all segments.
+    // Storage of segments[0]: all the boxes and the header of the mdat box. The other segments point to the encoded
+    // samples and metadata owned by the avifEncoder, which stay valid until avifEncoderDestroy().
+    avifRWData header;
+} avifEncoderSegments;
+
+// Same as avifEncoderFinish() but the mdat payload is not copied into a single buffer. output must be zero-initialized or
+// previously filled by avifEncoderFinishSegmented(), in which case its content is replaced. If
+// avifEncoderFinishSegmented() returns AVIF_RESULT_OK, output must be freed with avifEncoderSegmentsFree().
+AVIF_API avifResult avifEncoderFinishSegmented(avifEncoder * encoder, avifEncoderSegments * output);
+AVIF_API void avifEncoderSegmentsFree(avifEncoderSegments * output);
+
+// Same as avifEncoderFinish() but the file is passed to io->write() as it is produced instead of being assembled in
+// memory: the boxes are serialized in a small buffer first, so that their sizes are known, then the mdat payload is
+// written chunk by chunk straight from the encoded samples. io is not destroyed by this function.
+AVIF_API avifResult avifEncoderFinishToIO(avifEncoder * encoder, avifIO * io);
+
+// Same as avifEncoderAddImage() but for an image that was already encoded with AV1 (or AV2 if
+// encoder->codecChoice is AVIF_CODEC_CHOICE_AVM), for example by a video pipeline. No codec is
+// involved: the given OBUs are copied as is into the output by avifEncoderFinish().
+// image only provides the properties written to the container (dimensions, depth, yuvFormat,
+// CICP, yuvRange, alphaPremultiplied, clli, transformations, ICC, Exif, XMP). Its planes are ignored
+// and may be NULL. colorOBUs is one temporal unit of the color channel. alphaOBUs is one temporal
+// unit of the alpha channel, or NULL if there is no alpha. In the first call, both must start
+// with a sequence header consistent with image.
+// Samples are marked as sync samples only for the first frame or if AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME
+// is set, so the flag must be set for each keyframe of an image sequence.
+// The encoder quality, speed and tiling settings are ignored. Grids and gain maps are not supported.
+// This cannot be mixed with avifEncoderAddImage() or avifEncoderAddImageGrid() in the same encode.
+AVIF_API avifResult avifEncoderAddEncodedImage(avifEncoder * encoder,
+                                               const avifImage * image,
+                                               const avifROData * colorOBUs,
+                                               const avifROData * alphaOBUs,
+                                               uint64_t durationInTimescales,
+                                               avifAddImageFlags addImageFlags);
+
+// Adds all the frames of the file parsed by decoder to encoder, as if each one was given to
+// avifEncoderAddEncodedImage() with its AV1 samples copied byte for byte and decoder->image as the
+// image properties. avifDecoderParse() must have succeeded. decoder->image may be modified in
+// between, for example to strip the Exif or XMP metadata (or set decoder->ignoreExif and
+// decoder->ignoreXMP before parsing), to set an ICC profile or to change the transformations.
+// The mdat box written by avifEncoderFinish() stores alpha before color, which is the best order
+// for progressive rendering. encoder->timescale and encoder->repetitionCount are set from decoder.
+// Grids, layered images and gain maps are not supported.
+AVIF_API avifResult avifEncoderRemux(avifEncoder * encoder, avifDecoder * decoder);
+
 // Codec-specific, optional "advanced" tuning settings, in the form of string key/value pairs,
 // to be consumed by the codec in the next avifEncoderAddImage() call.
 // See the codec documentation to know if a setting is persistent or applied only to the next frame.
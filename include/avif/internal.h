@@ -104,8 +104,11 @@ void avifColorPrimariesComputeYCoeffs(avifColorPrimaries colorPrimaries, float c
         uint32_t count;                                    \
         uint32_t capacity;                                 \
     } TYPENAME
+// No memory is allocated if initialCapacity is 0. The first call to avifArrayPush() or avifArrayReserve() will allocate it.
 AVIF_NODISCARD avifBool avifArrayCreate(void * arrayStruct, uint32_t elementSize, uint32_t initialCapacity);
 AVIF_NODISCARD void * avifArrayPush(void * arrayStruct);
+// Makes sure the array can hold at least capacity elements without reallocating.
+AVIF_NODISCARD avifBool avifArrayReserve(void * arrayStruct, uint32_t capacity);
 void avifArrayPop(void * arrayStruct);
 void avifArrayDestroy(void * arrayStruct);
 
@@ -215,6 +218,11 @@ typedef struct avifReformatState
 {
     avifRGBColorSpaceInfo rgb;
     avifYUVColorSpaceInfo yuv;
+
+    // YUV->RGB only. Post-processing steps applied by the built-in conversion routines to each RGB row right after it is
+    // converted, instead of in separate passes over the whole avifRGBImage.
+    avifAlphaMultiplyMode toRGBAlphaMultiplyMode; // Alpha (un)multiply, as done by avifRGBImage(Un)PremultiplyAlpha().
+    avifBool toRGBHalfFloat;                      // Conversion to half floats, as done for avifRGBImage::isFloat.
 } avifReformatState;
 
 // Retrieves the pixel value at position (x, y) expressed as floats in [0, 1]. If the image's format doesn't have alpha,
@@ -224,6 +232,29 @@ void avifGetRGBAPixel(const avifRGBImage * src, uint32_t x, uint32_t y, const av
 // support alpha, rgbaPixel[3] is ignored.
 void avifSetRGBAPixel(const avifRGBImage * dst, uint32_t x, uint32_t y, const avifRGBColorSpaceInfo * info, const float rgbaPixel[4]);
 
+// Stores rowCount rows of strip, starting at row stripY, into the destination 'data' starting at row y.
+typedef void (*avifStoreRGBRowsFunc)(const avifRGBImage * strip, uint32_t stripY, uint32_t rowCount, void * data, uint32_t y);
+
+// Converts image to RGB strip by strip, with the format, depth and settings of layout (its width, height and pixels are
+// ignored), and passes the converted rows to storeRows(). No full size RGB buffer is allocated. Up to layout->maxThreads
+// horizontal bands are converted in parallel, so storeRows() may be called concurrently for different rows.
+avifResult avifImageYUVToRGBRows(const avifImage * image,
+                                 const avifRGBImage * layout,
+                                 avifStoreRGBRowsFunc storeRows,
+                                 void * storeData);
+
+// Checks and prepares the conversion of image to rgb as avifImageYUVToRGB() does. The state stays valid for any image
+// and avifRGBImage that only differ from them by their dimensions and samples.
+avifResult avifImageYUVToRGBPrepare(const avifImage * image,
+                                    const avifRGBImage * rgb,
+                                    avifReformatState * state,
+                                    avifAlphaMultiplyMode * alphaMultiplyMode);
+// Converts image to rgb in the current thread, with the output of avifImageYUVToRGBPrepare().
+avifResult avifImageYUVToRGBWithState(const avifImage * image,
+                                      avifRGBImage * rgb,
+                                      avifReformatState * state,
+                                      avifAlphaMultiplyMode alphaMultiplyMode);
+
 // Returns:
 // * AVIF_RESULT_OK              - Converted successfully with libyuv
 // * AVIF_RESULT_NOT_IMPLEMENTED - The fast path for this combination is not implemented with libyuv, use built-in RGB conversion
@@ -273,6 +304,17 @@ AVIF_NODISCARD avifBool avifDimensionsTooLarge(uint32_t width, uint32_t height,
 // unit tests.
 void avifSetTileConfiguration(int threads, uint32_t width, uint32_t height, int * tileRowsLog2, int * tileColsLog2);
 
+// ---------------------------------------------------------------------------
+// Threads
+
+typedef void (*avifThreadFunc)(void * arg);
+typedef struct avifThread avifThread;
+
+// Starts a thread running func(arg). Returns NULL on failure.
+avifThread * avifThreadCreate(avifThreadFunc func, void * arg);
+// Waits for the thread to finish and frees it, even on failure.
+avifBool avifThreadJoin(avifThread * thread);
+
 // ---------------------------------------------------------------------------
 // Scaling
 
@@ -280,6 +322,8 @@ void avifSetTileConfiguration(int threads, uint32_t width, uint32_t height, int
 AVIF_NODISCARD avifResult avifImageScaleWithLimit(avifImage * image,
                                                   uint32_t dstWidth,
                                                   uint32_t dstHeight,
+                                                  avifScaleFilter filter,
+                                                  int maxThreads,
                                                   uint32_t imageSizeLimit,
                                                   uint32_t imageDimensionLimit,
                                                   avifDiagnostics * diag);
@@ -297,6 +341,15 @@ typedef enum avifItemCategory
     AVIF_ITEM_CATEGORY_COUNT
 } avifItemCategory;
 
+// Outputs the sampleIndex-th sample of the item or track of the given category, as stored in the file parsed by
+// avifDecoderParse(), without decoding it. Returns AVIF_RESULT_NOT_IMPLEMENTED for grids and layered images.
+// The sample data is owned by the decoder and stays valid until the decoder is reset or destroyed.
+avifResult avifDecoderReadSample(avifDecoder * decoder,
+                                  avifItemCategory category,
+                                  uint32_t sampleIndex,
+                                  avifROData * sample,
+                                  avifBool * sync);
+
 // ---------------------------------------------------------------------------
 
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
@@ -524,6 +577,12 @@ avifResult avifIsCompliant(const uint8_t * data, size_t size);
 
 typedef size_t avifBoxMarker;
 
+// Four-character codes (box types, item types, property types, brands) as big-endian 32-bit integers, so that they can be
+// compared with a single integer comparison and dispatched with switch statements.
+#define AVIF_FOURCC(a, b, c, d) \
+    (((uint32_t)(uint8_t)(a) << 24) | ((uint32_t)(uint8_t)(b) << 16) | ((uint32_t)(uint8_t)(c) << 8) | (uint32_t)(uint8_t)(d))
+#define AVIF_FOURCC_FROM_BYTES(bytes) AVIF_FOURCC((bytes)[0], (bytes)[1], (bytes)[2], (bytes)[3])
+
 typedef struct avifBoxHeader
 {
     // Size of the box in bytes, excluding the box header.
@@ -554,6 +613,18 @@ void avifROStreamStart(avifROStream * stream, avifROData * raw, avifDiagnostics
 size_t avifROStreamOffset(const avifROStream * stream);
 void avifROStreamSetOffset(avifROStream * stream, size_t offset);
 
+// Decode big-endian values from unaligned data. The shifts are recognized by compilers as byte swaps, and the loops
+// using them can be vectorized, unlike calls to avifNTOHL() and avifNTOH64() which are not inlined.
+static inline uint32_t avifLoadU32BE(const uint8_t * data)
+{
+    return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+}
+
+static inline uint64_t avifLoadU64BE(const uint8_t * data)
+{
+    return ((uint64_t)avifLoadU32BE(data) << 32) | (uint64_t)avifLoadU32BE(data + 4);
+}
+
 AVIF_NODISCARD avifBool avifROStreamHasBytesLeft(const avifROStream * stream, size_t byteCount);
 size_t avifROStreamRemainingBytes(const avifROStream * stream);
 // The following functions require byte alignment.
@@ -565,6 +636,9 @@ AVIF_NODISCARD avifBool avifROStreamReadU32(avifROStream * stream, uint32_t * v)
 AVIF_NODISCARD avifBool avifROStreamReadU32Endianness(avifROStream * stream, uint32_t * v, avifBool littleEndian);
 AVIF_NODISCARD avifBool avifROStreamReadUX8(avifROStream * stream, uint64_t * v, uint64_t factor); // Reads a factor*8 sized uint, saves in v
 AVIF_NODISCARD avifBool avifROStreamReadU64(avifROStream * stream, uint64_t * v);
+// Checks once that count elements of elementSize bytes can be read. On success, points data to the first one and skips
+// them all, so that they can be decoded with avifLoadU32BE() etc.
+AVIF_NODISCARD avifBool avifROStreamReadArray(avifROStream * stream, size_t count, size_t elementSize, const uint8_t ** data);
 AVIF_NODISCARD avifBool avifROStreamReadString(avifROStream * stream, char * output, size_t outputSize);
 AVIF_NODISCARD avifBool avifROStreamReadBoxHeader(avifROStream * stream, avifBoxHeader * header); // This fails if the size reported by the header cannot fit in the stream
 AVIF_NODISCARD avifBool avifROStreamReadBoxHeaderPartial(avifROStream * stream, avifBoxHeader * header); // This doesn't require that the full box can fit in the stream
@@ -592,6 +666,9 @@ void avifRWStreamStart(avifRWStream * stream, avifRWData * raw);
 size_t avifRWStreamOffset(const avifRWStream * stream);
 void avifRWStreamSetOffset(avifRWStream * stream, size_t offset);
 
+// Makes sure that at least size bytes can be written at the current offset without any further reallocation.
+// The final output size is still the offset reached at avifRWStreamFinishWrite().
+avifResult avifRWStreamReserve(avifRWStream * stream, size_t size);
 void avifRWStreamFinishWrite(avifRWStream * stream);
 // The following functions require byte alignment.
 avifResult avifRWStreamWrite(avifRWStream * stream, const void * data, size_t size);
@@ -658,6 +735,8 @@ AVIF_NODISCARD avifBool avifSequenceHeaderParse(avifSequenceHeader * header, con
 // The HDR headroom is log2 of the ratio of HDR to SDR white brightness of the display to tone map for.
 // 'toneMappedImage' should have the 'format', 'depth', and 'isFloat' fields set to the desired values.
 // If non NULL, 'clli' will be filled with the light level information of the tone mapped image.
+// The base image is converted to RGB and tone mapped in a single pass over horizontal strips, in up to
+// toneMappedImage->maxThreads threads.
 // NOTE: only used in tests for now, might be added to the public API at some point.
 struct avifRGBImage;
 avifResult avifImageApplyGainMap(const avifImage * baseImage,
@@ -126,6 +126,11 @@ avifResult avifRGBImagePremultiplyAlpha(avifRGBImage * rgb)
         return AVIF_RESULT_INVALID_ARGUMENT;
     }
 
+    // packed alpha.
+    if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
     avifResult libyuvResult = avifRGBImagePremultiplyAlphaLibYUV(rgb);
     if (libyuvResult != AVIF_RESULT_NOT_IMPLEMENTED) {
         return libyuvResult;
@@ -237,6 +242,11 @@ avifResult avifRGBImageUnpremultiplyAlpha(avifRGBImage * rgb)
         return AVIF_RESULT_REFORMAT_FAILED;
     }
 
+    // packed alpha.
+    if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
     avifResult libyuvResult = avifRGBImageUnpremultiplyAlphaLibYUV(rgb);
     if (libyuvResult != AVIF_RESULT_NOT_IMPLEMENTED) {
         return libyuvResult;
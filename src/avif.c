@@ -108,6 +108,7 @@ const char * avifResultToString(avifResult result)
         case AVIF_RESULT_DECODE_GAIN_MAP_FAILED:        return "Decoding of gain map planes failed";
         case AVIF_RESULT_INVALID_TONE_MAPPED_IMAGE:     return "Invalid tone mapped image item";
 #endif
+        case AVIF_RESULT_MEMORY_LIMIT_EXCEEDED:         return "Memory limit exceeded";
         case AVIF_RESULT_UNKNOWN_ERROR:
         default:
             break;
@@ -588,7 +589,10 @@ uint32_t avifRGBImagePixelSize(const avifRGBImage * rgb)
     if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
         return 2;
     }
-    return avifRGBFormatChannelCount(rgb->format) * ((rgb->depth > 8) ? 2 : 1);
+    if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        return 4;
+    }
+    return avifRGBFormatChannelCount(rgb->format) * ((rgb->depth > 16) ? 4 : (rgb->depth > 8) ? 2 : 1);
 }
 
 void avifRGBImageSetDefaults(avifRGBImage * rgb, const avifImage * image)
@@ -608,6 +612,9 @@ void avifRGBImageSetDefaults(avifRGBImage * rgb, const avifImage * image)
                                           // after calling avifRGBImageSetDefaults(),
     rgb->isFloat = AVIF_FALSE;
     rgb->maxThreads = 1;
+    rgb->fixedPoint = AVIF_FALSE;
+    rgb->ditherRGB565 = AVIF_FALSE;
+    rgb->isLinear = AVIF_FALSE;
 }
 
 avifResult avifRGBImageAllocatePixels(avifRGBImage * rgb)
@@ -630,6 +637,62 @@ void avifRGBImageFreePixels(avifRGBImage * rgb)
     rgb->rowBytes = 0;
 }
 
+// ---------------------------------------------------------------------------
+// avifRGBPlanarImage
+
+void avifRGBPlanarImageSetDefaults(avifRGBPlanarImage * rgb, const avifImage * image)
+{
+    memset(rgb, 0, sizeof(*rgb));
+    rgb->width = image->width;
+    rgb->height = image->height;
+    rgb->depth = image->depth;
+    rgb->sampleType = (image->depth > 8) ? AVIF_PLANAR_SAMPLE_UINT16 : AVIF_PLANAR_SAMPLE_UINT8;
+    rgb->chromaUpsampling = AVIF_CHROMA_UPSAMPLING_AUTOMATIC;
+    rgb->avoidLibYUV = AVIF_FALSE;
+    rgb->alphaPremultiplied = AVIF_FALSE;
+    rgb->maxThreads = 1;
+    rgb->normalize = AVIF_FALSE;
+    for (int c = 0; c < 4; ++c) {
+        rgb->mean[c] = 0.0f;
+        rgb->std[c] = 1.0f;
+    }
+}
+
+avifResult avifRGBPlanarImageAllocatePlanes(avifRGBPlanarImage * rgb, avifBool withAlpha)
+{
+    avifRGBPlanarImageFreePlanes(rgb);
+    uint32_t sampleSize = 1;
+    if (rgb->sampleType == AVIF_PLANAR_SAMPLE_UINT16) {
+        sampleSize = 2;
+    } else if (rgb->sampleType == AVIF_PLANAR_SAMPLE_FLOAT32) {
+        sampleSize = 4;
+    }
+    const int planeCount = withAlpha ? 4 : 3;
+    AVIF_CHECKERR(rgb->width != 0 && rgb->height != 0, AVIF_RESULT_INVALID_ARGUMENT);
+    AVIF_CHECKERR(rgb->width <= UINT32_MAX / sampleSize, AVIF_RESULT_INVALID_ARGUMENT);
+    const uint32_t rowBytes = rgb->width * sampleSize;
+    AVIF_CHECKERR(rgb->height <= SIZE_MAX / planeCount / rowBytes, AVIF_RESULT_INVALID_ARGUMENT);
+    const size_t planeSize = (size_t)rowBytes * rgb->height;
+    uint8_t * pixels = avifAlloc(planeSize * planeCount);
+    AVIF_CHECKERR(pixels, AVIF_RESULT_OUT_OF_MEMORY);
+    for (int c = 0; c < planeCount; ++c) {
+        rgb->planes[c] = pixels + c * planeSize;
+        rgb->rowBytes[c] = rowBytes;
+    }
+    return AVIF_RESULT_OK;
+}
+
+void avifRGBPlanarImageFreePlanes(avifRGBPlanarImage * rgb)
+{
+    if (rgb->planes[0]) {
+        avifFree(rgb->planes[0]);
+    }
+    for (int c = 0; c < 4; ++c) {
+        rgb->planes[c] = NULL;
+        rgb->rowBytes[c] = 0;
+    }
+}
+
 // ---------------------------------------------------------------------------
 // avifCropRect
 
@@ -91,149 +91,271 @@ static inline float lerp(float a, float b, float w)
 
 #define SDR_WHITE_NITS 203.0f
 
-avifResult avifRGBImageApplyGainMap(const avifRGBImage * baseImage,
-                                    avifTransferCharacteristics transferCharacteristics,
-                                    const avifGainMap * gainMap,
-                                    float hdrHeadroom,
-                                    avifTransferCharacteristics outputTransferCharacteristics,
-                                    avifRGBImage * toneMappedImage,
-                                    avifContentLightLevelInformationBox * clli,
-                                    avifDiagnostics * diag)
+// Upsamples a gain map to the size of the base image with bilinear interpolation. Both images cover the same area, so pixel
+// centers are mapped with a half pixel offset, like when scaling an image. Only the RGB gain map is kept in memory, at its
+// own size and depth, and its integer code values are sampled directly. Read-only once created, so it can be shared by
+// threads.
+typedef struct avifGainMapSampler
 {
-    avifDiagnosticsClearError(diag);
-
-    if (hdrHeadroom < 0.0f) {
-        avifDiagnosticsPrintf(diag, "hdrHeadroom should be >= 0, got %f", hdrHeadroom);
-        return AVIF_RESULT_INVALID_ARGUMENT;
-    }
-    if (baseImage == NULL || gainMap == NULL || toneMappedImage == NULL) {
-        avifDiagnosticsPrintf(diag, "NULL input image");
-        return AVIF_RESULT_INVALID_ARGUMENT;
+    // For each column of the base image, the two surrounding gain map columns and the weight of the second one.
+    uint32_t * x0;
+    uint32_t * x1;
+    float * wx;
+    // RGB code values of the gain map. Owned.
+    avifRGBImage gainMap;
+    avifRGBColorSpaceInfo gainMapInfo;
+    // For each channel, the linear multiplier of each gain map code value, plus a copy of the last one so that
+    // avifGainMapSamplerGetMultiplier() can always read two entries. Channels with the same metadata share their table.
+    float * multipliers[3];
+    float * multipliersStorage;
+} avifGainMapSampler;
+
+// Returns the two source positions surrounding the destination position dst and the weight of the second one.
+static void avifGainMapSamplePosition(uint32_t dst,
+                                      uint32_t dstSize,
+                                      uint32_t srcSize,
+                                      uint32_t * src0,
+                                      uint32_t * src1,
+                                      float * w)
+{
+    if (srcSize == dstSize) {
+        // Exactly the same sample, without any rounding error.
+        *src0 = dst;
+        *src1 = dst;
+        *w = 0.0f;
+        return;
+    }
+    // In double precision, float is not enough for large sizes.
+    const double pos = ((double)dst + 0.5) * (double)srcSize / (double)dstSize - 0.5;
+    if (pos <= 0.0) {
+        *src0 = 0;
+        *w = 0.0f;
+    } else {
+        *src0 = AVIF_MIN((uint32_t)pos, srcSize - 1);
+        *w = (float)(pos - (double)*src0);
+    }
+    *src1 = AVIF_MIN(*src0 + 1, srcSize - 1);
+    if (*src1 == *src0) {
+        *w = 0.0f;
     }
+}
 
-    avifGainMapMetadataDouble metadata;
-    if (!avifGainMapMetadataFractionsToDouble(&metadata, &gainMap->metadata)) {
-        avifDiagnosticsPrintf(diag, "Invalid gain map metadata, a denominator value is zero");
-        return AVIF_RESULT_INVALID_ARGUMENT;
+static void avifGainMapSamplerDestroy(avifGainMapSampler * sampler)
+{
+    avifFree(sampler->x0);
+    avifFree(sampler->x1);
+    avifFree(sampler->wx);
+    avifRGBImageFreePixels(&sampler->gainMap);
+    avifFree(sampler->multipliersStorage);
+}
+
+static avifResult avifGainMapSamplerCreate(avifGainMapSampler * sampler,
+                                           const avifImage * gainMapImage,
+                                           const avifGainMapMetadataDouble * metadata,
+                                           float weight,
+                                           uint32_t width)
+{
+    avifRGBImageSetDefaults(&sampler->gainMap, gainMapImage);
+    AVIF_CHECKRES(avifRGBImageAllocatePixels(&sampler->gainMap)); // Freed by avifGainMapSamplerDestroy().
+    AVIF_CHECKRES(avifImageYUVToRGB(gainMapImage, &sampler->gainMap));
+    AVIF_CHECKERR(avifGetRGBColorSpaceInfo(&sampler->gainMap, &sampler->gainMapInfo), AVIF_RESULT_NOT_IMPLEMENTED);
+    const uint32_t tableSize = (uint32_t)sampler->gainMapInfo.maxChannel + 2;
+    sampler->x0 = (uint32_t *)avifAlloc(width * sizeof(uint32_t));
+    sampler->x1 = (uint32_t *)avifAlloc(width * sizeof(uint32_t));
+    sampler->wx = (float *)avifAlloc(width * sizeof(float));
+    sampler->multipliersStorage = (float *)avifAlloc(tableSize * 3 * sizeof(float));
+    if (!sampler->x0 || !sampler->x1 || !sampler->wx || !sampler->multipliersStorage) {
+        return AVIF_RESULT_OUT_OF_MEMORY; // Freed by avifGainMapSamplerDestroy().
+    }
+    for (uint32_t i = 0; i < width; ++i) {
+        avifGainMapSamplePosition(i, width, sampler->gainMap.width, &sampler->x0[i], &sampler->x1[i], &sampler->wx[i]);
     }
-    for (int i = 0; i < 3; ++i) {
-        if (metadata.gainMapGamma[i] <= 0) {
-            avifDiagnosticsPrintf(diag, "Invalid gain map metadata, gamma should be strictly positive");
-            return AVIF_RESULT_INVALID_ARGUMENT;
+
+    for (int c = 0; c < 3; ++c) {
+        sampler->multipliers[c] = NULL;
+        for (int prev = 0; prev < c; ++prev) {
+            if ((metadata->gainMapMin[c] == metadata->gainMapMin[prev]) &&
+                (metadata->gainMapMax[c] == metadata->gainMapMax[prev]) &&
+                (metadata->gainMapGamma[c] == metadata->gainMapGamma[prev])) {
+                sampler->multipliers[c] = sampler->multipliers[prev];
+                break;
+            }
         }
+        if (sampler->multipliers[c] != NULL) {
+            continue;
+        }
+        float * table = &sampler->multipliersStorage[c * tableSize];
+        const float gainMapMin = (float)metadata->gainMapMin[c];
+        const float gainMapMax = (float)metadata->gainMapMax[c];
+        const float gammaInv = 1.0f / (float)metadata->gainMapGamma[c];
+        for (uint32_t v = 0; v + 1 < tableSize; ++v) {
+            // Undo gamma & affine transform; the result is in log2 space.
+            const float gainMapLog2 = lerp(gainMapMin, gainMapMax, powf(v / sampler->gainMapInfo.maxChannelF, gammaInv));
+            table[v] = exp2f(gainMapLog2 * weight);
+        }
+        table[tableSize - 1] = table[tableSize - 2];
+        sampler->multipliers[c] = table;
     }
+    return AVIF_RESULT_OK;
+}
 
-    const uint32_t width = baseImage->width;
-    const uint32_t height = baseImage->height;
-    avifImage * rescaledGainMap = NULL;
-    avifRGBImage rgbGainMap;
-    // Basic zero-initialization for now, avifRGBImageSetDefaults() is called later on.
-    memset(&rgbGainMap, 0, sizeof(rgbGainMap));
-
-    avifResult res = AVIF_RESULT_OK;
-    toneMappedImage->width = width;
-    toneMappedImage->height = height;
-    AVIF_CHECKRES(avifRGBImageAllocatePixels(toneMappedImage));
-
-    // --- After this point, the function should exit with 'goto cleanup' to free allocated pixels.
+// Returns the linear multiplier of the possibly interpolated gain map code value v of channel c.
+static inline float avifGainMapSamplerGetMultiplier(const avifGainMapSampler * sampler, int c, float v)
+{
+    const float * table = sampler->multipliers[c];
+    const uint32_t index = (uint32_t)v;
+    return table[index] + (v - (float)index) * (table[index + 1] - table[index]);
+}
 
-    const float weight = avifGetGainMapWeight(hdrHeadroom, &metadata);
+// Returns the code value of channel c of the gain map pixel x in row.
+static inline float avifGainMapSamplerGetCode(const avifGainMapSampler * sampler, const uint8_t * row, uint32_t x, int c)
+{
+    const avifRGBColorSpaceInfo * info = &sampler->gainMapInfo;
+    const uint32_t offsetBytes = (c == 0) ? info->offsetBytesR : ((c == 1) ? info->offsetBytesG : info->offsetBytesB);
+    const uint8_t * sample = &row[(size_t)x * info->pixelBytes + offsetBytes];
+    return (info->channelBytes > 1) ? (float)*(const uint16_t *)sample : (float)*sample;
+}
 
-    // Early exit if the gain map does not need to be applied and the pixel format is the same.
-    if (weight == 0.0f && outputTransferCharacteristics == transferCharacteristics && baseImage->format == toneMappedImage->format &&
-        baseImage->depth == toneMappedImage->depth && baseImage->isFloat == toneMappedImage->isFloat) {
-        assert(baseImage->rowBytes == toneMappedImage->rowBytes);
-        assert(baseImage->height == toneMappedImage->height);
-        // Copy the base image.
-        memcpy(toneMappedImage->pixels, baseImage->pixels, baseImage->rowBytes * baseImage->height);
-        goto cleanup;
-    }
+// Sets row0 and row1 to the gain map rows surrounding the row y of the base image, and wy to the weight of row1.
+static void avifGainMapSamplerGetRows(const avifGainMapSampler * sampler,
+                                      uint32_t y,
+                                      uint32_t height,
+                                      const uint8_t ** row0,
+                                      const uint8_t ** row1,
+                                      float * wy)
+{
+    uint32_t y0, y1;
+    avifGainMapSamplePosition(y, height, sampler->gainMap.height, &y0, &y1, wy);
+    *row0 = &sampler->gainMap.pixels[(size_t)y0 * sampler->gainMap.rowBytes];
+    *row1 = &sampler->gainMap.pixels[(size_t)y1 * sampler->gainMap.rowBytes];
+}
 
+// Everything needed to apply a gain map to rows of the base image. Rows can be applied concurrently, as long as they are
+// different.
+typedef struct avifGainMapApplier
+{
+    avifGainMapSampler sampler;
+    float baseOffset[3];
+    float alternateOffset[3];
+    avifTransferFunction gammaToLinear;
+    avifTransferFunction linearToGamma;
     avifRGBColorSpaceInfo baseRGBInfo;
-    avifRGBColorSpaceInfo toneMappedPixelRGBInfo;
-    if (!avifGetRGBColorSpaceInfo(baseImage, &baseRGBInfo) || !avifGetRGBColorSpaceInfo(toneMappedImage, &toneMappedPixelRGBInfo)) {
+    avifRGBImage * toneMappedImage;
+    avifRGBColorSpaceInfo toneMappedRGBInfo;
+    // For each row of the tone mapped image, the max tone mapped pixel value across R, G and B channels and the sum of
+    // max(r, g, b) for its pixels.
+    float * rowMaxLinear;
+    float * rowSumLinear;
+} avifGainMapApplier;
+
+static void avifGainMapApplierDestroy(avifGainMapApplier * applier)
+{
+    avifGainMapSamplerDestroy(&applier->sampler);
+    avifFree(applier->rowMaxLinear);
+    avifFree(applier->rowSumLinear);
+}
+
+// baseLayout is the format and depth of the base image rows given to avifGainMapApplierApplyRows().
+static avifResult avifGainMapApplierCreate(avifGainMapApplier * applier,
+                                           const avifGainMap * gainMap,
+                                           const avifGainMapMetadataDouble * metadata,
+                                           float weight,
+                                           const avifRGBImage * baseLayout,
+                                           avifTransferCharacteristics transferCharacteristics,
+                                           avifTransferCharacteristics outputTransferCharacteristics,
+                                           avifRGBImage * toneMappedImage,
+                                           avifDiagnostics * diag)
+{
+    applier->toneMappedImage = toneMappedImage;
+    if (!avifGetRGBColorSpaceInfo(baseLayout, &applier->baseRGBInfo) ||
+        !avifGetRGBColorSpaceInfo(toneMappedImage, &applier->toneMappedRGBInfo)) {
         avifDiagnosticsPrintf(diag, "Unsupported RGB color space");
-        res = AVIF_RESULT_NOT_IMPLEMENTED;
-        goto cleanup;
+        return AVIF_RESULT_NOT_IMPLEMENTED;
     }
-
-    const avifTransferFunction gammaToLinear = avifTransferCharacteristicsGetGammaToLinearFunction(transferCharacteristics);
-    const avifTransferFunction linearToGamma = avifTransferCharacteristicsGetLinearToGammaFunction(outputTransferCharacteristics);
-
-    // Early exit if the gain map does not need to be applied.
-    if (weight == 0.0f) {
-        // Just convert from one rgb format to another.
-        for (uint32_t j = 0; j < height; ++j) {
-            for (uint32_t i = 0; i < width; ++i) {
-                float basePixelRGBA[4];
-                avifGetRGBAPixel(baseImage, i, j, &baseRGBInfo, basePixelRGBA);
-                if (outputTransferCharacteristics != transferCharacteristics) {
-                    for (int c = 0; c < 3; ++c) {
-                        basePixelRGBA[c] = AVIF_CLAMP(linearToGamma(gammaToLinear(basePixelRGBA[c])), 0.0f, 1.0f);
-                    }
-                }
-                avifSetRGBAPixel(toneMappedImage, i, j, &toneMappedPixelRGBInfo, basePixelRGBA);
-            }
-        }
-        goto cleanup;
+    applier->gammaToLinear = avifTransferCharacteristicsGetGammaToLinearFunction(transferCharacteristics);
+    applier->linearToGamma = avifTransferCharacteristicsGetLinearToGammaFunction(outputTransferCharacteristics);
+    for (int c = 0; c < 3; ++c) {
+        applier->baseOffset[c] = (float)metadata->baseOffset[c];
+        applier->alternateOffset[c] = (float)metadata->alternateOffset[c];
     }
+    applier->rowMaxLinear = (float *)avifAlloc(toneMappedImage->height * sizeof(float));
+    applier->rowSumLinear = (float *)avifAlloc(toneMappedImage->height * sizeof(float));
+    AVIF_CHECKERR(applier->rowMaxLinear && applier->rowSumLinear, AVIF_RESULT_OUT_OF_MEMORY);
+
+    const uint32_t width = toneMappedImage->width;
+    const uint32_t height = toneMappedImage->height;
+    avifImage * rescaledGainMap = NULL;
+    avifResult res = AVIF_RESULT_OK;
 
-    if (gainMap->image->width != width || gainMap->image->height != height) {
+    // A gain map larger than the base image is downscaled first. A smaller one (the usual case) is upsampled on the fly with
+    // bilinear interpolation, so that no full resolution copy of it is needed.
+    if (gainMap->image->width > width || gainMap->image->height > height) {
         rescaledGainMap = avifImageCreateEmpty();
+        AVIF_CHECKERR(rescaledGainMap != NULL, AVIF_RESULT_OUT_OF_MEMORY);
         const avifCropRect rect = { 0, 0, gainMap->image->width, gainMap->image->height };
         res = avifImageSetViewRect(rescaledGainMap, gainMap->image, &rect);
         if (res != AVIF_RESULT_OK) {
             goto cleanup;
         }
-        res = avifImageScale(rescaledGainMap, width, height, diag);
+        const uint32_t scaledWidth = AVIF_MIN(gainMap->image->width, width);
+        const uint32_t scaledHeight = AVIF_MIN(gainMap->image->height, height);
+        res = avifImageScale(rescaledGainMap, scaledWidth, scaledHeight, diag);
         if (res != AVIF_RESULT_OK) {
             goto cleanup;
         }
     }
     const avifImage * const gainMapImage = (rescaledGainMap != NULL) ? rescaledGainMap : gainMap->image;
 
-    avifRGBImageSetDefaults(&rgbGainMap, gainMapImage);
-    res = avifRGBImageAllocatePixels(&rgbGainMap);
-    if (res != AVIF_RESULT_OK) {
-        goto cleanup;
-    }
-    res = avifImageYUVToRGB(gainMapImage, &rgbGainMap);
-    if (res != AVIF_RESULT_OK) {
-        goto cleanup;
-    }
-
-    avifRGBColorSpaceInfo gainMapRGBInfo;
-    if (!avifGetRGBColorSpaceInfo(&rgbGainMap, &gainMapRGBInfo)) {
+    res = avifGainMapSamplerCreate(&applier->sampler, gainMapImage, metadata, weight, width);
+    if (res == AVIF_RESULT_NOT_IMPLEMENTED) {
         avifDiagnosticsPrintf(diag, "Unsupported RGB color space");
-        res = AVIF_RESULT_NOT_IMPLEMENTED;
-        goto cleanup;
     }
 
-    float rgbMaxLinear = 0; // Max tone mapped pixel value across R, G and B channels.
-    float rgbSumLinear = 0; // Sum of max(r, g, b) for mapped pixels.
-    const float gammaInv[3] = { 1.0f / (float)metadata.gainMapGamma[0],
-                                1.0f / (float)metadata.gainMapGamma[1],
-                                1.0f / (float)metadata.gainMapGamma[2] };
+cleanup:
+    if (rescaledGainMap != NULL) {
+        avifImageDestroy(rescaledGainMap);
+    }
+    return res;
+}
 
-    for (uint32_t j = 0; j < height; ++j) {
+// Tone maps rowCount rows of base, starting at row baseY, into the tone mapped image starting at row y.
+static void avifGainMapApplierApplyRows(avifGainMapApplier * applier,
+                                        const avifRGBImage * base,
+                                        uint32_t baseY,
+                                        uint32_t rowCount,
+                                        uint32_t y)
+{
+    const avifGainMapSampler * sampler = &applier->sampler;
+    avifRGBImage * toneMappedImage = applier->toneMappedImage;
+    const uint32_t width = toneMappedImage->width;
+    for (uint32_t j = 0; j < rowCount; ++j) {
+        const uint8_t * gainMapRow0;
+        const uint8_t * gainMapRow1;
+        float wy;
+        avifGainMapSamplerGetRows(sampler, y + j, toneMappedImage->height, &gainMapRow0, &gainMapRow1, &wy);
+        float rgbMaxLinear = 0; // Max tone mapped pixel value across R, G and B channels.
+        float rgbSumLinear = 0; // Sum of max(r, g, b) for mapped pixels.
         for (uint32_t i = 0; i < width; ++i) {
             float basePixelRGBA[4];
-            avifGetRGBAPixel(baseImage, i, j, &baseRGBInfo, basePixelRGBA);
-            float gainMapRGBA[4];
-            avifGetRGBAPixel(&rgbGainMap, i, j, &gainMapRGBInfo, gainMapRGBA);
+            avifGetRGBAPixel(base, i, baseY + j, &applier->baseRGBInfo, basePixelRGBA);
+            const uint32_t x0 = sampler->x0[i];
+            const uint32_t x1 = sampler->x1[i];
+            const float wx = sampler->wx[i];
 
             // Apply gain map.
             float toneMappedPixelRGBA[4];
             float pixelRgbMaxLinear = 0.0f; //  = max(r, g, b) for this pixel
             for (int c = 0; c < 3; ++c) {
-                const float baseLinear = gammaToLinear(basePixelRGBA[c]);
-                const float gainMapValue = gainMapRGBA[c];
-
-                // Undo gamma & affine transform; the result is in log2 space.
-                const float gainMapLog2 =
-                    lerp((float)metadata.gainMapMin[c], (float)metadata.gainMapMax[c], powf(gainMapValue, gammaInv[c]));
-                const float toneMappedLinear = (baseLinear + (float)metadata.baseOffset[c]) * exp2f(gainMapLog2 * weight) -
-                                               (float)metadata.alternateOffset[c];
+                const float baseLinear = applier->gammaToLinear(basePixelRGBA[c]);
+                const float gainMapValue = lerp(lerp(avifGainMapSamplerGetCode(sampler, gainMapRow0, x0, c),
+                                                     avifGainMapSamplerGetCode(sampler, gainMapRow0, x1, c),
+                                                     wx),
+                                                lerp(avifGainMapSamplerGetCode(sampler, gainMapRow1, x0, c),
+                                                     avifGainMapSamplerGetCode(sampler, gainMapRow1, x1, c),
+                                                     wx),
+                                                wy);
+                const float multiplier = avifGainMapSamplerGetMultiplier(sampler, c, gainMapValue);
+                const float toneMappedLinear = (baseLinear + applier->baseOffset[c]) * multiplier - applier->alternateOffset[c];
 
                 if (toneMappedLinear > rgbMaxLinear) {
                     rgbMaxLinear = toneMappedLinear;
@@ -242,31 +364,151 @@ avifResult avifRGBImageApplyGainMap(const avifRGBImage * baseImage,
                     pixelRgbMaxLinear = toneMappedLinear;
                 }
 
-                const float toneMappedGamma = linearToGamma(toneMappedLinear);
+                const float toneMappedGamma = applier->linearToGamma(toneMappedLinear);
                 toneMappedPixelRGBA[c] = AVIF_CLAMP(toneMappedGamma, 0.0f, 1.0f);
             }
             toneMappedPixelRGBA[3] = basePixelRGBA[3]; // Alpha is unaffected by tone mapping.
             rgbSumLinear += pixelRgbMaxLinear;
-            avifSetRGBAPixel(toneMappedImage, i, j, &toneMappedPixelRGBInfo, toneMappedPixelRGBA);
+            avifSetRGBAPixel(toneMappedImage, i, y + j, &applier->toneMappedRGBInfo, toneMappedPixelRGBA);
         }
+        applier->rowMaxLinear[y + j] = rgbMaxLinear;
+        applier->rowSumLinear[y + j] = rgbSumLinear;
     }
-    if (clli != NULL) {
-        // For exact CLLI value definitions, see ISO/IEC 23008-2 section D.3.35
-        // at https://standards.iso.org/ittf/PubliclyAvailableStandards/index.html
-        // See also discussion in https://github.com/AOMediaCodec/libavif/issues/1727
+}
+
+// avifStoreRGBRowsFunc applying the gain map to the base image rows converted by avifImageYUVToRGBRows().
+static void avifGainMapApplierStoreRows(const avifRGBImage * strip, uint32_t stripY, uint32_t rowCount, void * data, uint32_t y)
+{
+    avifGainMapApplierApplyRows((avifGainMapApplier *)data, strip, stripY, rowCount, y);
+}
 
-        // Convert extended SDR (where 1.0 is SDR white) to nits.
-        clli->maxCLL = (uint16_t)AVIF_CLAMP(avifRoundf(rgbMaxLinear * SDR_WHITE_NITS), 0.0f, (float)UINT16_MAX);
-        const float rgbAverageLinear = rgbSumLinear / (width * height);
-        clli->maxPALL = (uint16_t)AVIF_CLAMP(avifRoundf(rgbAverageLinear * SDR_WHITE_NITS), 0.0f, (float)UINT16_MAX);
+static void avifGainMapApplierGetClli(const avifGainMapApplier * applier, avifContentLightLevelInformationBox * clli)
+{
+    // For exact CLLI value definitions, see ISO/IEC 23008-2 section D.3.35
+    // at https://standards.iso.org/ittf/PubliclyAvailableStandards/index.html
+    // See also discussion in https://github.com/AOMediaCodec/libavif/issues/1727
+    const uint32_t width = applier->toneMappedImage->width;
+    const uint32_t height = applier->toneMappedImage->height;
+    float rgbMaxLinear = 0;
+    float rgbSumLinear = 0;
+    for (uint32_t j = 0; j < height; ++j) {
+        rgbMaxLinear = AVIF_MAX(rgbMaxLinear, applier->rowMaxLinear[j]);
+        rgbSumLinear += applier->rowSumLinear[j];
     }
 
-cleanup:
-    avifRGBImageFreePixels(&rgbGainMap);
-    if (rescaledGainMap != NULL) {
-        avifImageDestroy(rescaledGainMap);
+    // Convert extended SDR (where 1.0 is SDR white) to nits.
+    clli->maxCLL = (uint16_t)AVIF_CLAMP(avifRoundf(rgbMaxLinear * SDR_WHITE_NITS), 0.0f, (float)UINT16_MAX);
+    const float rgbAverageLinear = rgbSumLinear / (width * height);
+    clli->maxPALL = (uint16_t)AVIF_CLAMP(avifRoundf(rgbAverageLinear * SDR_WHITE_NITS), 0.0f, (float)UINT16_MAX);
+}
+
+// Checks the arguments common to avifRGBImageApplyGainMap() and avifImageApplyGainMap(), and computes the weight of the gain
+// map.
+static avifResult avifGainMapValidateAndGetWeight(const avifGainMap * gainMap,
+                                                  float hdrHeadroom,
+                                                  avifGainMapMetadataDouble * metadata,
+                                                  float * weight,
+                                                  avifDiagnostics * diag)
+{
+    if (hdrHeadroom < 0.0f) {
+        avifDiagnosticsPrintf(diag, "hdrHeadroom should be >= 0, got %f", hdrHeadroom);
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    if (!avifGainMapMetadataFractionsToDouble(metadata, &gainMap->metadata)) {
+        avifDiagnosticsPrintf(diag, "Invalid gain map metadata, a denominator value is zero");
+        return AVIF_RESULT_INVALID_ARGUMENT;
     }
+    for (int i = 0; i < 3; ++i) {
+        if (metadata->gainMapGamma[i] <= 0) {
+            avifDiagnosticsPrintf(diag, "Invalid gain map metadata, gamma should be strictly positive");
+            return AVIF_RESULT_INVALID_ARGUMENT;
+        }
+    }
+    *weight = avifGetGainMapWeight(hdrHeadroom, metadata);
+    return AVIF_RESULT_OK;
+}
 
+avifResult avifRGBImageApplyGainMap(const avifRGBImage * baseImage,
+                                    avifTransferCharacteristics transferCharacteristics,
+                                    const avifGainMap * gainMap,
+                                    float hdrHeadroom,
+                                    avifTransferCharacteristics outputTransferCharacteristics,
+                                    avifRGBImage * toneMappedImage,
+                                    avifContentLightLevelInformationBox * clli,
+                                    avifDiagnostics * diag)
+{
+    avifDiagnosticsClearError(diag);
+
+    if (baseImage == NULL || gainMap == NULL || toneMappedImage == NULL) {
+        avifDiagnosticsPrintf(diag, "NULL input image");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    avifGainMapMetadataDouble metadata;
+    float weight;
+    AVIF_CHECKRES(avifGainMapValidateAndGetWeight(gainMap, hdrHeadroom, &metadata, &weight, diag));
+
+    const uint32_t width = baseImage->width;
+    const uint32_t height = baseImage->height;
+    toneMappedImage->width = width;
+    toneMappedImage->height = height;
+    AVIF_CHECKRES(avifRGBImageAllocatePixels(toneMappedImage));
+
+    // Early exit if the gain map does not need to be applied and the pixel format is the same.
+    if (weight == 0.0f && outputTransferCharacteristics == transferCharacteristics && baseImage->format == toneMappedImage->format &&
+        baseImage->depth == toneMappedImage->depth && baseImage->isFloat == toneMappedImage->isFloat) {
+        assert(baseImage->rowBytes == toneMappedImage->rowBytes);
+        assert(baseImage->height == toneMappedImage->height);
+        // Copy the base image.
+        memcpy(toneMappedImage->pixels, baseImage->pixels, baseImage->rowBytes * baseImage->height);
+        return AVIF_RESULT_OK;
+    }
+
+    // Early exit if the gain map does not need to be applied.
+    if (weight == 0.0f) {
+        avifRGBColorSpaceInfo baseRGBInfo;
+        avifRGBColorSpaceInfo toneMappedPixelRGBInfo;
+        if (!avifGetRGBColorSpaceInfo(baseImage, &baseRGBInfo) ||
+            !avifGetRGBColorSpaceInfo(toneMappedImage, &toneMappedPixelRGBInfo)) {
+            avifDiagnosticsPrintf(diag, "Unsupported RGB color space");
+            return AVIF_RESULT_NOT_IMPLEMENTED;
+        }
+        const avifTransferFunction gammaToLinear = avifTransferCharacteristicsGetGammaToLinearFunction(transferCharacteristics);
+        const avifTransferFunction linearToGamma =
+            avifTransferCharacteristicsGetLinearToGammaFunction(outputTransferCharacteristics);
+        // Just convert from one rgb format to another.
+        for (uint32_t j = 0; j < height; ++j) {
+            for (uint32_t i = 0; i < width; ++i) {
+                float basePixelRGBA[4];
+                avifGetRGBAPixel(baseImage, i, j, &baseRGBInfo, basePixelRGBA);
+                if (outputTransferCharacteristics != transferCharacteristics) {
+                    for (int c = 0; c < 3; ++c) {
+                        basePixelRGBA[c] = AVIF_CLAMP(linearToGamma(gammaToLinear(basePixelRGBA[c])), 0.0f, 1.0f);
+                    }
+                }
+                avifSetRGBAPixel(toneMappedImage, i, j, &toneMappedPixelRGBInfo, basePixelRGBA);
+            }
+        }
+        return AVIF_RESULT_OK;
+    }
+
+    avifGainMapApplier applier;
+    memset(&applier, 0, sizeof(applier));
+    avifResult res = avifGainMapApplierCreate(&applier,
+                                              gainMap,
+                                              &metadata,
+                                              weight,
+                                              baseImage,
+                                              transferCharacteristics,
+                                              outputTransferCharacteristics,
+                                              toneMappedImage,
+                                              diag);
+    if (res == AVIF_RESULT_OK) {
+        avifGainMapApplierApplyRows(&applier, baseImage, 0, height, 0);
+        if (clli != NULL) {
+            avifGainMapApplierGetClli(&applier, clli);
+        }
+    }
+    avifGainMapApplierDestroy(&applier);
     return res;
 }
 
@@ -280,26 +522,62 @@ avifResult avifImageApplyGainMap(const avifImage * baseImage,
 {
     avifDiagnosticsClearError(diag);
 
-    avifRGBImage baseImageRgb;
-    avifRGBImageSetDefaults(&baseImageRgb, baseImage);
-    AVIF_CHECKRES(avifRGBImageAllocatePixels(&baseImageRgb));
-    avifResult res = avifImageYUVToRGB(baseImage, &baseImageRgb);
-    if (res != AVIF_RESULT_OK) {
-        goto cleanup;
+    if (baseImage == NULL || gainMap == NULL || toneMappedImage == NULL) {
+        avifDiagnosticsPrintf(diag, "NULL input image");
+        return AVIF_RESULT_INVALID_ARGUMENT;
     }
+    avifGainMapMetadataDouble metadata;
+    float weight;
+    AVIF_CHECKRES(avifGainMapValidateAndGetWeight(gainMap, hdrHeadroom, &metadata, &weight, diag));
 
-    res = avifRGBImageApplyGainMap(&baseImageRgb,
-                                   baseImage->transferCharacteristics,
-                                   gainMap,
-                                   hdrHeadroom,
-                                   outputTransferCharacteristics,
-                                   toneMappedImage,
-                                   clli,
-                                   diag);
+    // The base image rows are converted to RGB with the same settings as a whole image avifImageYUVToRGB() would use.
+    avifRGBImage baseImageRgb;
+    avifRGBImageSetDefaults(&baseImageRgb, baseImage);
 
-cleanup:
-    avifRGBImageFreePixels(&baseImageRgb);
+    if (weight == 0.0f) {
+        // No tone mapping, only a conversion. The whole base image is converted first, to take the shortcuts of
+        // avifRGBImageApplyGainMap().
+        AVIF_CHECKRES(avifRGBImageAllocatePixels(&baseImageRgb));
+        avifResult res = avifImageYUVToRGB(baseImage, &baseImageRgb);
+        if (res == AVIF_RESULT_OK) {
+            res = avifRGBImageApplyGainMap(&baseImageRgb,
+                                           baseImage->transferCharacteristics,
+                                           gainMap,
+                                           hdrHeadroom,
+                                           outputTransferCharacteristics,
+                                           toneMappedImage,
+                                           clli,
+                                           diag);
+        }
+        avifRGBImageFreePixels(&baseImageRgb);
+        return res;
+    }
 
+    // Convert the base image to RGB and tone map it in a single pass, strip by strip, with up to toneMappedImage->maxThreads
+    // threads. No full size intermediate image is allocated.
+    toneMappedImage->width = baseImage->width;
+    toneMappedImage->height = baseImage->height;
+    AVIF_CHECKRES(avifRGBImageAllocatePixels(toneMappedImage));
+    baseImageRgb.maxThreads = toneMappedImage->maxThreads;
+
+    avifGainMapApplier applier;
+    memset(&applier, 0, sizeof(applier));
+    avifResult res = avifGainMapApplierCreate(&applier,
+                                              gainMap,
+                                              &metadata,
+                                              weight,
+                                              &baseImageRgb,
+                                              baseImage->transferCharacteristics,
+                                              outputTransferCharacteristics,
+                                              toneMappedImage,
+                                              diag);
+    if (res == AVIF_RESULT_OK) {
+        res = avifImageYUVToRGBRows(baseImage, &baseImageRgb, avifGainMapApplierStoreRows, &applier);
+    }
+    if (res == AVIF_RESULT_OK && clli != NULL) {
+        avifGainMapApplierGetClli(&applier, clli);
+    }
+    avifGainMapApplierDestroy(&applier);
     return res;
 }
 
@@ -166,3 +166,74 @@ avifIO * avifIOCreateFileReader(const char * filename)
     }
     return (avifIO *)reader;
 }
+
+// --------------------------------------------------------------------------------------
+// avifIOFileWriter
+
+typedef struct avifIOFileWriter
+{
+    avifIO io; // this must be the first member for easy casting to avifIO*
+    FILE * f;  // NULL once closed by AVIF_IO_WRITE_FLAG_FINISH.
+    uint64_t offset; // Current position in f.
+} avifIOFileWriter;
+
+static avifResult avifIOFileWriterWrite(struct avifIO * io,
+                                        uint32_t writeFlags,
+                                        uint64_t offset,
+                                        const uint8_t * data,
+                                        size_t size)
+{
+    avifIOFileWriter * writer = (avifIOFileWriter *)io;
+    if ((writeFlags & ~(uint32_t)AVIF_IO_WRITE_FLAG_FINISH) != 0 || !writer->f) {
+        // Unsupported writeFlags, or already finished
+        return AVIF_RESULT_IO_ERROR;
+    }
+
+    if (offset != writer->offset) {
+        if ((offset > LONG_MAX) || (fseek(writer->f, (long)offset, SEEK_SET) != 0)) {
+            return AVIF_RESULT_IO_ERROR;
+        }
+        writer->offset = offset;
+    }
+    if ((size > 0) && (fwrite(data, 1, size, writer->f) != size)) {
+        return AVIF_RESULT_IO_ERROR;
+    }
+    writer->offset += size;
+    if (writeFlags & AVIF_IO_WRITE_FLAG_FINISH) {
+        // Buffered data is only written now, so this is when a full disk or any other write error may show up.
+        const int closeResult = fclose(writer->f);
+        writer->f = NULL;
+        if (closeResult != 0) {
+            return AVIF_RESULT_IO_ERROR;
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+static void avifIOFileWriterDestroy(struct avifIO * io)
+{
+    avifIOFileWriter * writer = (avifIOFileWriter *)io;
+    if (writer->f) {
+        fclose(writer->f);
+    }
+    avifFree(io);
+}
+
+avifIO * avifIOCreateFileWriter(const char * filename)
+{
+    FILE * f = fopen(filename, "wb");
+    if (!f) {
+        return NULL;
+    }
+
+    avifIOFileWriter * writer = avifAlloc(sizeof(avifIOFileWriter));
+    if (!writer) {
+        fclose(f);
+        return NULL;
+    }
+    memset(writer, 0, sizeof(avifIOFileWriter));
+    writer->f = f;
+    writer->io.destroy = avifIOFileWriterDestroy;
+    writer->io.write = avifIOFileWriterWrite;
+    return (avifIO *)writer;
+}
@@ -147,6 +147,7 @@ struct avifMeta;
 typedef struct avifProperty
 {
     uint8_t type[4];
+    uint32_t fourcc; // type as returned by AVIF_FOURCC_FROM_BYTES(), for fast comparisons
     union
     {
         avifImageSpatialExtents ispe;
@@ -169,9 +170,10 @@ AVIF_ARRAY_DECLARE(avifPropertyArray, avifProperty, prop);
 // Finds the first property of a given type.
 static const avifProperty * avifPropertyArrayFind(const avifPropertyArray * properties, const char * type)
 {
+    const uint32_t fourcc = AVIF_FOURCC_FROM_BYTES(type);
     for (uint32_t propertyIndex = 0; propertyIndex < properties->count; ++propertyIndex) {
         avifProperty * prop = &properties->prop[propertyIndex];
-        if (!memcmp(prop->type, type, 4)) {
+        if (prop->fourcc == fourcc) {
             return prop;
         }
     }
@@ -709,6 +711,12 @@ typedef struct avifMeta
     // and are then further modified/updated as new information for an item's ID is parsed.
     avifDecoderItemArray items;
 
+    // Open addressing hash table indexing the items above by ID, so that looking up an item does not
+    // depend on the number of items. Each slot is either 0 (empty) or an index in items plus one.
+    // itemSlotCount is 0 or a power of two.
+    uint32_t * itemSlots;
+    uint32_t itemSlotCount;
+
     // Any ipco boxes explained above are populated into this array as a staging area, which are
     // then duplicated into the appropriate items upon encountering an item property association
     // (ipma) box.
@@ -767,6 +775,9 @@ static void avifMetaDestroy(avifMeta * meta)
         }
     }
     avifArrayDestroy(&meta->items);
+    if (meta->itemSlots) {
+        avifFree(meta->itemSlots);
+    }
     avifArrayDestroy(&meta->properties);
     avifRWDataFree(&meta->idat);
     avifFree(meta);
@@ -781,31 +792,83 @@ static avifResult avifCheckItemID(const char * boxFourcc, uint32_t itemID, avifD
     return AVIF_RESULT_OK;
 }
 
-static avifResult avifMetaFindOrCreateItem(avifMeta * meta, uint32_t itemID, avifDecoderItem ** item)
+// Returns the first slot of the probing sequence of itemID in meta->itemSlots.
+static uint32_t avifMetaItemSlotHash(const avifMeta * meta, uint32_t itemID)
 {
-    *item = NULL;
-    assert(itemID != 0);
+    // Fibonacci hashing: item IDs are often consecutive, multiply to spread them over all slots.
+    uint32_t hash = itemID * 2654435769u;
+    hash ^= hash >> 16;
+    return hash & (meta->itemSlotCount - 1);
+}
 
+// Inserts meta->items.item[itemIndex] into meta->itemSlots, which must have at least one empty slot.
+static void avifMetaInsertItemSlot(avifMeta * meta, uint32_t itemIndex)
+{
+    uint32_t slot = avifMetaItemSlotHash(meta, meta->items.item[itemIndex].id);
+    while (meta->itemSlots[slot] != 0) {
+        slot = (slot + 1) & (meta->itemSlotCount - 1);
+    }
+    meta->itemSlots[slot] = itemIndex + 1;
+}
+
+// Makes sure meta->itemSlots can index one more item while staying at most half full.
+static avifResult avifMetaReserveItemSlot(avifMeta * meta)
+{
+    if ((meta->items.count + 1) * 2 <= meta->itemSlotCount) {
+        return AVIF_RESULT_OK;
+    }
+    const uint32_t newSlotCount = meta->itemSlotCount ? meta->itemSlotCount * 2 : 16;
+    AVIF_CHECKERR(newSlotCount > meta->itemSlotCount, AVIF_RESULT_OUT_OF_MEMORY);
+    uint32_t * newSlots = (uint32_t *)avifAlloc(newSlotCount * sizeof(uint32_t));
+    AVIF_CHECKERR(newSlots != NULL, AVIF_RESULT_OUT_OF_MEMORY);
+    memset(newSlots, 0, newSlotCount * sizeof(uint32_t));
+    if (meta->itemSlots) {
+        avifFree(meta->itemSlots);
+    }
+    meta->itemSlots = newSlots;
+    meta->itemSlotCount = newSlotCount;
     for (uint32_t i = 0; i < meta->items.count; ++i) {
-        if (meta->items.item[i].id == itemID) {
-            *item = &meta->items.item[i];
-            return AVIF_RESULT_OK;
+        avifMetaInsertItemSlot(meta, i);
+    }
+    return AVIF_RESULT_OK;
+}
+
+// Returns the item of meta with the given itemID, or NULL if there is none. Does not modify meta.
+static avifDecoderItem * avifMetaFindItem(const avifMeta * meta, uint32_t itemID)
+{
+    if (meta->itemSlotCount != 0) {
+        for (uint32_t slot = avifMetaItemSlotHash(meta, itemID); meta->itemSlots[slot] != 0;
+             slot = (slot + 1) & (meta->itemSlotCount - 1)) {
+            avifDecoderItem * candidate = &meta->items.item[meta->itemSlots[slot] - 1];
+            if (candidate->id == itemID) {
+                return candidate;
+            }
         }
     }
+    return NULL;
+}
 
+static avifResult avifMetaFindOrCreateItem(avifMeta * meta, uint32_t itemID, avifDecoderItem ** item)
+{
+    assert(itemID != 0);
+    *item = avifMetaFindItem(meta, itemID);
+    if (*item != NULL) {
+        return AVIF_RESULT_OK;
+    }
+
+    AVIF_CHECKRES(avifMetaReserveItemSlot(meta));
     *item = (avifDecoderItem *)avifArrayPush(&meta->items);
     AVIF_CHECKERR(*item != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-    if (!avifArrayCreate(&(*item)->properties, sizeof(avifProperty), 16)) {
-        avifArrayPop(&meta->items);
-        return AVIF_RESULT_OUT_OF_MEMORY;
-    }
-    if (!avifArrayCreate(&(*item)->extents, sizeof(avifExtent), 1)) {
-        avifArrayDestroy(&(*item)->properties);
+    // The properties and extents arrays are empty until the item's ipma and iloc entries are parsed, which is when
+    // their sizes are known. This avoids allocating them for items that do not need them, and reallocating them.
+    if (!avifArrayCreate(&(*item)->properties, sizeof(avifProperty), /*initialCapacity=*/0) ||
+        !avifArrayCreate(&(*item)->extents, sizeof(avifExtent), /*initialCapacity=*/0)) {
         avifArrayPop(&meta->items);
         return AVIF_RESULT_OUT_OF_MEMORY;
     }
     (*item)->id = itemID;
     (*item)->meta = meta;
+    avifMetaInsertItemSlot(meta, meta->items.count - 1);
     return AVIF_RESULT_OK;
 }
 
@@ -1759,6 +1822,7 @@ static avifResult avifParseItemLocationBox(avifMeta * meta, const uint8_t * raw,
         AVIF_CHECKERR(avifROStreamReadUX8(&s, &baseOffset, baseOffsetSize), AVIF_RESULT_BMFF_PARSE_FAILED); //
         uint16_t extentCount;                                                                // unsigned int(16) extent_count;
         AVIF_CHECKERR(avifROStreamReadU16(&s, &extentCount), AVIF_RESULT_BMFF_PARSE_FAILED); //
+        AVIF_CHECKERR(avifArrayReserve(&item->extents, item->extents.count + extentCount), AVIF_RESULT_OUT_OF_MEMORY);
         for (int extentIter = 0; extentIter < extentCount; ++extentIter) {
             // If extent_index is ever supported, this spec must be implemented here:
             // ::  if (((version == 1) || (version == 2)) && (index_size > 0)) {
@@ -2232,46 +2296,63 @@ static avifResult avifParseItemPropertyContainerBox(avifPropertyArray * properti
         avifProperty * prop = avifArrayPush(properties);
         AVIF_CHECKERR(prop != NULL, AVIF_RESULT_OUT_OF_MEMORY);
         memcpy(prop->type, header.type, 4);
-        if (!memcmp(header.type, "ispe", 4)) {
-            AVIF_CHECKERR(avifParseImageSpatialExtentsProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "auxC", 4)) {
-            AVIF_CHECKERR(avifParseAuxiliaryTypeProperty(prop, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "colr", 4)) {
-            AVIF_CHECKERR(avifParseColourInformationBox(prop, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "av1C", 4)) {
-            AVIF_CHECKERR(avifParseCodecConfigurationBoxProperty(prop, avifROStreamCurrent(&s), header.size, "av1C", diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
+        prop->fourcc = AVIF_FOURCC_FROM_BYTES(header.type);
+        const uint8_t * content = avifROStreamCurrent(&s);
+        switch (prop->fourcc) {
+            case AVIF_FOURCC('i', 's', 'p', 'e'):
+                AVIF_CHECKERR(avifParseImageSpatialExtentsProperty(prop, content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('a', 'u', 'x', 'C'):
+                AVIF_CHECKERR(avifParseAuxiliaryTypeProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('c', 'o', 'l', 'r'):
+                AVIF_CHECKERR(avifParseColourInformationBox(prop, rawOffset + avifROStreamOffset(&s), content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('a', 'v', '1', 'C'):
+                AVIF_CHECKERR(avifParseCodecConfigurationBoxProperty(prop, content, header.size, "av1C", diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
 #if defined(AVIF_CODEC_AVM)
-        } else if (!memcmp(header.type, "av2C", 4)) {
-            AVIF_CHECKERR(avifParseCodecConfigurationBoxProperty(prop, avifROStreamCurrent(&s), header.size, "av2C", diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
+            case AVIF_FOURCC('a', 'v', '2', 'C'):
+                AVIF_CHECKERR(avifParseCodecConfigurationBoxProperty(prop, content, header.size, "av2C", diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
 #endif
-        } else if (!memcmp(header.type, "pasp", 4)) {
-            AVIF_CHECKERR(avifParsePixelAspectRatioBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "clap", 4)) {
-            AVIF_CHECKERR(avifParseCleanApertureBoxProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "irot", 4)) {
-            AVIF_CHECKERR(avifParseImageRotationProperty(prop, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "imir", 4)) {
-            AVIF_CHECKERR(avifParseImageMirrorProperty(prop, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "pixi", 4)) {
-            AVIF_CHECKERR(avifParsePixelInformationProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "a1op", 4)) {
-            AVIF_CHECKERR(avifParseOperatingPointSelectorProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "lsel", 4)) {
-            AVIF_CHECKERR(avifParseLayerSelectorProperty(prop, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "a1lx", 4)) {
-            AVIF_CHECKERR(avifParseAV1LayeredImageIndexingProperty(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "clli", 4)) {
-            AVIF_CHECKERR(avifParseContentLightLevelInformationBox(prop, avifROStreamCurrent(&s), header.size, diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
+            case AVIF_FOURCC('p', 'a', 's', 'p'):
+                AVIF_CHECKERR(avifParsePixelAspectRatioBoxProperty(prop, content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('c', 'l', 'a', 'p'):
+                AVIF_CHECKERR(avifParseCleanApertureBoxProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('i', 'r', 'o', 't'):
+                AVIF_CHECKERR(avifParseImageRotationProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('i', 'm', 'i', 'r'):
+                AVIF_CHECKERR(avifParseImageMirrorProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('p', 'i', 'x', 'i'):
+                AVIF_CHECKERR(avifParsePixelInformationProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('a', '1', 'o', 'p'):
+                AVIF_CHECKERR(avifParseOperatingPointSelectorProperty(prop, content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('l', 's', 'e', 'l'):
+                AVIF_CHECKERR(avifParseLayerSelectorProperty(prop, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('a', '1', 'l', 'x'):
+                AVIF_CHECKERR(avifParseAV1LayeredImageIndexingProperty(prop, content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('c', 'l', 'l', 'i'):
+                AVIF_CHECKERR(avifParseContentLightLevelInformationBox(prop, content, header.size, diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            default:
+                break;
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -2279,6 +2360,32 @@ static avifResult avifParseItemPropertyContainerBox(avifPropertyArray * properti
     return AVIF_RESULT_OK;
 }
 
+// Returns AVIF_TRUE if the property type is one of those parsed by avifParseItemPropertyContainerBox().
+static avifBool avifIsSupportedPropertyType(uint32_t fourcc)
+{
+    switch (fourcc) {
+        case AVIF_FOURCC('i', 's', 'p', 'e'):
+        case AVIF_FOURCC('a', 'u', 'x', 'C'):
+        case AVIF_FOURCC('c', 'o', 'l', 'r'):
+        case AVIF_FOURCC('a', 'v', '1', 'C'):
+#if defined(AVIF_CODEC_AVM)
+        case AVIF_FOURCC('a', 'v', '2', 'C'):
+#endif
+        case AVIF_FOURCC('p', 'a', 's', 'p'):
+        case AVIF_FOURCC('c', 'l', 'a', 'p'):
+        case AVIF_FOURCC('i', 'r', 'o', 't'):
+        case AVIF_FOURCC('i', 'm', 'i', 'r'):
+        case AVIF_FOURCC('p', 'i', 'x', 'i'):
+        case AVIF_FOURCC('a', '1', 'o', 'p'):
+        case AVIF_FOURCC('l', 's', 'e', 'l'):
+        case AVIF_FOURCC('a', '1', 'l', 'x'):
+        case AVIF_FOURCC('c', 'l', 'l', 'i'):
+            return AVIF_TRUE;
+        default:
+            return AVIF_FALSE;
+    }
+}
+
 static avifResult avifParseItemPropertyAssociation(avifMeta * meta, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag, uint32_t * outVersionAndFlags)
 {
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
@@ -2332,6 +2439,7 @@ static avifResult avifParseItemPropertyAssociation(avifMeta * meta, const uint8_
 
         uint8_t associationCount;
         AVIF_CHECKERR(avifROStreamRead(&s, &associationCount, 1), AVIF_RESULT_BMFF_PARSE_FAILED);
+        AVIF_CHECKERR(avifArrayReserve(&item->properties, item->properties.count + associationCount), AVIF_RESULT_OUT_OF_MEMORY);
         for (uint8_t associationIndex = 0; associationIndex < associationCount; ++associationIndex) {
             uint8_t essential;
             AVIF_CHECKERR(avifROStreamReadBits8(&s, &essential, /*bitCount=*/1), AVIF_RESULT_BMFF_PARSE_FAILED); // bit(1) essential;
@@ -2357,32 +2465,7 @@ static avifResult avifParseItemPropertyAssociation(avifMeta * meta, const uint8_
             // Copy property to item
             const avifProperty * srcProp = &meta->properties.prop[propertyIndex];
 
-            static const char * supportedTypes[] = {
-                "ispe",
-                "auxC",
-                "colr",
-                "av1C",
-#if defined(AVIF_CODEC_AVM)
-                "av2C",
-#endif
-                "pasp",
-                "clap",
-                "irot",
-                "imir",
-                "pixi",
-                "a1op",
-                "lsel",
-                "a1lx",
-                "clli"
-            };
-            size_t supportedTypesCount = sizeof(supportedTypes) / sizeof(supportedTypes[0]);
-            avifBool supportedType = AVIF_FALSE;
-            for (size_t i = 0; i < supportedTypesCount; ++i) {
-                if (!memcmp(srcProp->type, supportedTypes[i], 4)) {
-                    supportedType = AVIF_TRUE;
-                    break;
-                }
-            }
+            const avifBool supportedType = avifIsSupportedPropertyType(srcProp->fourcc);
             if (supportedType) {
                 if (essential) {
                     // Verify that it is legal for this property to be flagged as essential. Any
@@ -2652,6 +2735,7 @@ static avifResult avifParseItemReferenceBox(avifMeta * meta, const uint8_t * raw
     while (avifROStreamHasBytesLeft(&s, 1)) {
         avifBoxHeader irefHeader;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &irefHeader), AVIF_RESULT_BMFF_PARSE_FAILED);
+        const uint32_t irefType = AVIF_FOURCC_FROM_BYTES(irefHeader.type);
 
         uint32_t fromID = 0;
         if (version == 0) {
@@ -2690,21 +2774,30 @@ static avifResult avifParseItemReferenceBox(avifMeta * meta, const uint8_t * raw
                 avifDecoderItem * item;
                 AVIF_CHECKRES(avifMetaFindOrCreateItem(meta, fromID, &item));
 
-                if (!memcmp(irefHeader.type, "thmb", 4)) {
-                    item->thumbnailForID = toID;
-                } else if (!memcmp(irefHeader.type, "auxl", 4)) {
-                    item->auxForID = toID;
-                } else if (!memcmp(irefHeader.type, "cdsc", 4)) {
-                    item->descForID = toID;
-                } else if (!memcmp(irefHeader.type, "dimg", 4)) {
-                    // derived images refer in the opposite direction
-                    avifDecoderItem * dimg;
-                    AVIF_CHECKRES(avifMetaFindOrCreateItem(meta, toID, &dimg));
-
-                    dimg->dimgForID = fromID;
-                    dimg->dimgIdx = refIndex;
-                } else if (!memcmp(irefHeader.type, "prem", 4)) {
-                    item->premByID = toID;
+                switch (irefType) {
+                    case AVIF_FOURCC('t', 'h', 'm', 'b'):
+                        item->thumbnailForID = toID;
+                        break;
+                    case AVIF_FOURCC('a', 'u', 'x', 'l'):
+                        item->auxForID = toID;
+                        break;
+                    case AVIF_FOURCC('c', 'd', 's', 'c'):
+                        item->descForID = toID;
+                        break;
+                    case AVIF_FOURCC('d', 'i', 'm', 'g'): {
+                        // derived images refer in the opposite direction
+                        avifDecoderItem * dimg;
+                        AVIF_CHECKRES(avifMetaFindOrCreateItem(meta, toID, &dimg));
+
+                        dimg->dimgForID = fromID;
+                        dimg->dimgIdx = refIndex;
+                        break;
+                    }
+                    case AVIF_FOURCC('p', 'r', 'e', 'm'):
+                        item->premByID = toID;
+                        break;
+                    default:
+                        break;
                 }
             }
         }
@@ -2727,34 +2820,48 @@ static avifResult avifParseMetaBox(avifMeta * meta, uint64_t rawOffset, const ui
         avifBoxHeader header;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
+        const uint32_t boxType = AVIF_FOURCC_FROM_BYTES(header.type);
+        const uint8_t * content = avifROStreamCurrent(&s);
         if (firstBox) {
-            if (!memcmp(header.type, "hdlr", 4)) {
+            if (boxType == AVIF_FOURCC('h', 'd', 'l', 'r')) {
                 AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 0, "meta", "hdlr", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-                AVIF_CHECKERR(avifParseHandlerBox(avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKERR(avifParseHandlerBox(content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
                 firstBox = AVIF_FALSE;
             } else {
                 // hdlr must be the first box!
                 avifDiagnosticsPrintf(diag, "Box[meta] does not have a Box[hdlr] as its first child box");
                 return AVIF_RESULT_BMFF_PARSE_FAILED;
             }
-        } else if (!memcmp(header.type, "iloc", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 1, "meta", "iloc", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemLocationBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "pitm", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 2, "meta", "pitm", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKERR(avifParsePrimaryItemBox(meta, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "idat", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 3, "meta", "idat", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKERR(avifParseItemDataBox(meta, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "iprp", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 4, "meta", "iprp", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemPropertiesBox(meta, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iinf", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 5, "meta", "iinf", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemInfoBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iref", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 6, "meta", "iref", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemReferenceBox(meta, avifROStreamCurrent(&s), header.size, diag));
+        } else {
+            switch (boxType) {
+                case AVIF_FOURCC('i', 'l', 'o', 'c'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 1, "meta", "iloc", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKRES(avifParseItemLocationBox(meta, content, header.size, diag));
+                    break;
+                case AVIF_FOURCC('p', 'i', 't', 'm'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 2, "meta", "pitm", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKERR(avifParsePrimaryItemBox(meta, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    break;
+                case AVIF_FOURCC('i', 'd', 'a', 't'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 3, "meta", "idat", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKERR(avifParseItemDataBox(meta, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    break;
+                case AVIF_FOURCC('i', 'p', 'r', 'p'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 4, "meta", "iprp", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKRES(
+                        avifParseItemPropertiesBox(meta, rawOffset + avifROStreamOffset(&s), content, header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'i', 'n', 'f'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 5, "meta", "iinf", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKRES(avifParseItemInfoBox(meta, content, header.size, diag));
+                    break;
+                case AVIF_FOURCC('i', 'r', 'e', 'f'):
+                    AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 6, "meta", "iref", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                    AVIF_CHECKRES(avifParseItemReferenceBox(meta, content, header.size, diag));
+                    break;
+                default:
+                    break;
+            }
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -2863,6 +2970,22 @@ static avifBool avifParseMediaHeaderBox(avifTrack * track, const uint8_t * raw,
     return AVIF_TRUE;
 }
 
+// Skips entryCount entries of entrySize bytes in s with a single bounds check, and points entries to the first one.
+// Also returns AVIF_FALSE if they would not fit in an avifArray already holding arrayCount elements. Both are checked
+// before growing the array, so that a corrupted entry count cannot trigger a huge allocation.
+static avifBool avifROStreamReadEntries(avifROStream * s,
+                                        uint32_t arrayCount,
+                                        uint32_t entryCount,
+                                        size_t entrySize,
+                                        const uint8_t ** entries)
+{
+    if (entryCount > UINT32_MAX - arrayCount) {
+        avifDiagnosticsPrintf(s->diag, "%s: Too many entries [%u]", s->diagContext, entryCount);
+        return AVIF_FALSE;
+    }
+    return avifROStreamReadArray(s, entryCount, entrySize, entries);
+}
+
 static avifResult avifParseChunkOffsetBox(avifSampleTable * sampleTable, avifBool largeOffsets, const uint8_t * raw, size_t rawLen, avifDiagnostics * diag)
 {
     BEGIN_STREAM(s, raw, rawLen, diag, largeOffsets ? "Box[co64]" : "Box[stco]");
@@ -2871,20 +2994,22 @@ static avifResult avifParseChunkOffsetBox(avifSampleTable * sampleTable, avifBoo
 
     uint32_t entryCount;
     AVIF_CHECKERR(avifROStreamReadU32(&s, &entryCount), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) entry_count;
-    for (uint32_t i = 0; i < entryCount; ++i) {
-        uint64_t offset;
-        if (largeOffsets) {
-            AVIF_CHECKERR(avifROStreamReadU64(&s, &offset), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) chunk_offset;
-        } else {
-            uint32_t offset32;
-            AVIF_CHECKERR(avifROStreamReadU32(&s, &offset32), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) chunk_offset;
-            offset = (uint64_t)offset32;
+    avifSampleTableChunkArray * chunks = &sampleTable->chunks;
+    const size_t entrySize = largeOffsets ? sizeof(uint64_t) : sizeof(uint32_t);
+    const uint8_t * entries;
+    AVIF_CHECKERR(avifROStreamReadEntries(&s, chunks->count, entryCount, entrySize, &entries), AVIF_RESULT_BMFF_PARSE_FAILED);
+    AVIF_CHECKERR(avifArrayReserve(chunks, chunks->count + entryCount), AVIF_RESULT_OUT_OF_MEMORY);
+    avifSampleTableChunk * chunk = &chunks->chunk[chunks->count];
+    if (largeOffsets) {
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            chunk[i].offset = avifLoadU64BE(&entries[i * entrySize]); // unsigned int(64) chunk_offset;
+        }
+    } else {
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            chunk[i].offset = avifLoadU32BE(&entries[i * entrySize]); // unsigned int(32) chunk_offset;
         }
-
-        avifSampleTableChunk * chunk = (avifSampleTableChunk *)avifArrayPush(&sampleTable->chunks);
-        AVIF_CHECKERR(chunk != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-        chunk->offset = offset;
     }
+    chunks->count += entryCount;
     return AVIF_RESULT_OK;
 }
 
@@ -2896,14 +3021,23 @@ static avifResult avifParseSampleToChunkBox(avifSampleTable * sampleTable, const
 
     uint32_t entryCount;
     AVIF_CHECKERR(avifROStreamReadU32(&s, &entryCount), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) entry_count;
+    avifSampleTableSampleToChunkArray * sampleToChunks = &sampleTable->sampleToChunks;
+    const uint8_t * entries;
+    AVIF_CHECKERR(avifROStreamReadEntries(&s, sampleToChunks->count, entryCount, 3 * sizeof(uint32_t), &entries),
+                  AVIF_RESULT_BMFF_PARSE_FAILED);
+    AVIF_CHECKERR(avifArrayReserve(sampleToChunks, sampleToChunks->count + entryCount), AVIF_RESULT_OUT_OF_MEMORY);
+    avifSampleTableSampleToChunk * sampleToChunkEntries = &sampleToChunks->sampleToChunk[sampleToChunks->count];
+    sampleToChunks->count += entryCount;
     uint32_t prevFirstChunk = 0;
     for (uint32_t i = 0; i < entryCount; ++i) {
-        avifSampleTableSampleToChunk * sampleToChunk = (avifSampleTableSampleToChunk *)avifArrayPush(&sampleTable->sampleToChunks);
-        AVIF_CHECKERR(sampleToChunk != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &sampleToChunk->firstChunk), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) first_chunk;
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &sampleToChunk->samplesPerChunk), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) samples_per_chunk;
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &sampleToChunk->sampleDescriptionIndex),
-                      AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) sample_description_index;
+        avifSampleTableSampleToChunk * sampleToChunk = &sampleToChunkEntries[i];
+        const uint8_t * entry = &entries[(size_t)i * 3 * sizeof(uint32_t)];
+        // unsigned int(32) first_chunk;
+        // unsigned int(32) samples_per_chunk;
+        // unsigned int(32) sample_description_index;
+        sampleToChunk->firstChunk = avifLoadU32BE(entry);
+        sampleToChunk->samplesPerChunk = avifLoadU32BE(entry + sizeof(uint32_t));
+        sampleToChunk->sampleDescriptionIndex = avifLoadU32BE(entry + 2 * sizeof(uint32_t));
         // The first_chunk fields should start with 1 and be strictly increasing.
         if (i == 0) {
             if (sampleToChunk->firstChunk != 1) {
@@ -2934,11 +3068,16 @@ static avifResult avifParseSampleSizeBox(avifSampleTable * sampleTable, const ui
     if (allSamplesSize > 0) {
         sampleTable->allSamplesSize = allSamplesSize;
     } else {
+        avifSampleTableSampleSizeArray * sampleSizes = &sampleTable->sampleSizes;
+        const uint8_t * entries;
+        AVIF_CHECKERR(avifROStreamReadEntries(&s, sampleSizes->count, sampleCount, sizeof(uint32_t), &entries),
+                      AVIF_RESULT_BMFF_PARSE_FAILED);
+        AVIF_CHECKERR(avifArrayReserve(sampleSizes, sampleSizes->count + sampleCount), AVIF_RESULT_OUT_OF_MEMORY);
+        avifSampleTableSampleSize * sampleSize = &sampleSizes->sampleSize[sampleSizes->count];
         for (uint32_t i = 0; i < sampleCount; ++i) {
-            avifSampleTableSampleSize * sampleSize = (avifSampleTableSampleSize *)avifArrayPush(&sampleTable->sampleSizes);
-            AVIF_CHECKERR(sampleSize != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-            AVIF_CHECKERR(avifROStreamReadU32(&s, &sampleSize->size), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) entry_size;
+            sampleSize[i].size = avifLoadU32BE(&entries[i * sizeof(uint32_t)]); // unsigned int(32) entry_size;
         }
+        sampleSizes->count += sampleCount;
     }
     return AVIF_RESULT_OK;
 }
@@ -2952,13 +3091,16 @@ static avifResult avifParseSyncSampleBox(avifSampleTable * sampleTable, const ui
     uint32_t entryCount;
     AVIF_CHECKERR(avifROStreamReadU32(&s, &entryCount), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) entry_count;
 
+    avifSyncSampleArray * syncSamples = &sampleTable->syncSamples;
+    const uint8_t * entries;
+    AVIF_CHECKERR(avifROStreamReadEntries(&s, syncSamples->count, entryCount, sizeof(uint32_t), &entries),
+                  AVIF_RESULT_BMFF_PARSE_FAILED);
+    AVIF_CHECKERR(avifArrayReserve(syncSamples, syncSamples->count + entryCount), AVIF_RESULT_OUT_OF_MEMORY);
+    avifSyncSample * syncSample = &syncSamples->syncSample[syncSamples->count];
     for (uint32_t i = 0; i < entryCount; ++i) {
-        uint32_t sampleNumber = 0;
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &sampleNumber), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) sample_number;
-        avifSyncSample * syncSample = (avifSyncSample *)avifArrayPush(&sampleTable->syncSamples);
-        AVIF_CHECKERR(syncSample != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-        syncSample->sampleNumber = sampleNumber;
+        syncSample[i].sampleNumber = avifLoadU32BE(&entries[i * sizeof(uint32_t)]); // unsigned int(32) sample_number;
     }
+    syncSamples->count += entryCount;
     return AVIF_RESULT_OK;
 }
 
@@ -2971,12 +3113,18 @@ static avifResult avifParseTimeToSampleBox(avifSampleTable * sampleTable, const
     uint32_t entryCount;
     AVIF_CHECKERR(avifROStreamReadU32(&s, &entryCount), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) entry_count;
 
+    avifSampleTableTimeToSampleArray * timeToSamples = &sampleTable->timeToSamples;
+    const uint8_t * entries;
+    AVIF_CHECKERR(avifROStreamReadEntries(&s, timeToSamples->count, entryCount, 2 * sizeof(uint32_t), &entries),
+                  AVIF_RESULT_BMFF_PARSE_FAILED);
+    AVIF_CHECKERR(avifArrayReserve(timeToSamples, timeToSamples->count + entryCount), AVIF_RESULT_OUT_OF_MEMORY);
+    avifSampleTableTimeToSample * timeToSample = &timeToSamples->timeToSample[timeToSamples->count];
     for (uint32_t i = 0; i < entryCount; ++i) {
-        avifSampleTableTimeToSample * timeToSample = (avifSampleTableTimeToSample *)avifArrayPush(&sampleTable->timeToSamples);
-        AVIF_CHECKERR(timeToSample != NULL, AVIF_RESULT_OUT_OF_MEMORY);
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &timeToSample->sampleCount), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) sample_count;
-        AVIF_CHECKERR(avifROStreamReadU32(&s, &timeToSample->sampleDelta), AVIF_RESULT_BMFF_PARSE_FAILED); // unsigned int(32) sample_delta;
+        const uint8_t * entry = &entries[(size_t)i * 2 * sizeof(uint32_t)];
+        timeToSample[i].sampleCount = avifLoadU32BE(entry);                    // unsigned int(32) sample_count;
+        timeToSample[i].sampleDelta = avifLoadU32BE(entry + sizeof(uint32_t)); // unsigned int(32) sample_delta;
     }
+    timeToSamples->count += entryCount;
     return AVIF_RESULT_OK;
 }
 
@@ -3034,24 +3182,35 @@ static avifResult avifParseSampleTableBox(avifTrack * track, uint64_t rawOffset,
         avifBoxHeader header;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
-        if (!memcmp(header.type, "stco", 4)) {
-            AVIF_CHECKRES(avifParseChunkOffsetBox(track->sampleTable, AVIF_FALSE, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "co64", 4)) {
-            AVIF_CHECKRES(avifParseChunkOffsetBox(track->sampleTable, AVIF_TRUE, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsc", 4)) {
-            AVIF_CHECKRES(avifParseSampleToChunkBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsz", 4)) {
-            AVIF_CHECKRES(avifParseSampleSizeBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stss", 4)) {
-            AVIF_CHECKRES(avifParseSyncSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stts", 4)) {
-            AVIF_CHECKRES(avifParseTimeToSampleBox(track->sampleTable, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "stsd", 4)) {
-            AVIF_CHECKRES(avifParseSampleDescriptionBox(track->sampleTable,
-                                                        rawOffset + avifROStreamOffset(&s),
-                                                        avifROStreamCurrent(&s),
-                                                        header.size,
-                                                        diag));
+        const uint8_t * content = avifROStreamCurrent(&s);
+        switch (AVIF_FOURCC_FROM_BYTES(header.type)) {
+            case AVIF_FOURCC('s', 't', 'c', 'o'):
+                AVIF_CHECKRES(avifParseChunkOffsetBox(track->sampleTable, AVIF_FALSE, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('c', 'o', '6', '4'):
+                AVIF_CHECKRES(avifParseChunkOffsetBox(track->sampleTable, AVIF_TRUE, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'c'):
+                AVIF_CHECKRES(avifParseSampleToChunkBox(track->sampleTable, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'z'):
+                AVIF_CHECKRES(avifParseSampleSizeBox(track->sampleTable, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 's'):
+                AVIF_CHECKRES(avifParseSyncSampleBox(track->sampleTable, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 't', 's'):
+                AVIF_CHECKRES(avifParseTimeToSampleBox(track->sampleTable, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('s', 't', 's', 'd'):
+                AVIF_CHECKRES(avifParseSampleDescriptionBox(track->sampleTable,
+                                                            rawOffset + avifROStreamOffset(&s),
+                                                            content,
+                                                            header.size,
+                                                            diag));
+                break;
+            default:
+                break;
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -3068,7 +3227,8 @@ static avifResult avifParseMediaInformationBox(avifTrack * track, uint64_t rawOf
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
         if (!memcmp(header.type, "stbl", 4)) {
-            AVIF_CHECKRES(avifParseSampleTableBox(track, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag));
+            AVIF_CHECKRES(
+                avifParseSampleTableBox(track, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag));
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -3084,11 +3244,17 @@ static avifResult avifParseMediaBox(avifTrack * track, uint64_t rawOffset, const
         avifBoxHeader header;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
-        if (!memcmp(header.type, "mdhd", 4)) {
-            AVIF_CHECKERR(avifParseMediaHeaderBox(track, avifROStreamCurrent(&s), header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "minf", 4)) {
-            AVIF_CHECKRES(
-                avifParseMediaInformationBox(track, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag));
+        const uint8_t * content = avifROStreamCurrent(&s);
+        switch (AVIF_FOURCC_FROM_BYTES(header.type)) {
+            case AVIF_FOURCC('m', 'd', 'h', 'd'):
+                AVIF_CHECKERR(avifParseMediaHeaderBox(track, content, header.size, diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('m', 'i', 'n', 'f'):
+                AVIF_CHECKRES(
+                    avifParseMediaInformationBox(track, rawOffset + avifROStreamOffset(&s), content, header.size, diag));
+                break;
+            default:
+                break;
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -3104,18 +3270,24 @@ static avifBool avifTrackReferenceBox(avifTrack * track, const uint8_t * raw, si
         avifBoxHeader header;
         AVIF_CHECK(avifROStreamReadBoxHeader(&s, &header));
 
-        if (!memcmp(header.type, "auxl", 4)) {
-            uint32_t toID;
-            AVIF_CHECK(avifROStreamReadU32(&s, &toID));                       // unsigned int(32) track_IDs[];
-            AVIF_CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
-            track->auxForID = toID;
-        } else if (!memcmp(header.type, "prem", 4)) {
-            uint32_t byID;
-            AVIF_CHECK(avifROStreamReadU32(&s, &byID));                       // unsigned int(32) track_IDs[];
-            AVIF_CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
-            track->premByID = byID;
-        } else {
-            AVIF_CHECK(avifROStreamSkip(&s, header.size));
+        switch (AVIF_FOURCC_FROM_BYTES(header.type)) {
+            case AVIF_FOURCC('a', 'u', 'x', 'l'): {
+                uint32_t toID;
+                AVIF_CHECK(avifROStreamReadU32(&s, &toID));                       // unsigned int(32) track_IDs[];
+                AVIF_CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
+                track->auxForID = toID;
+                break;
+            }
+            case AVIF_FOURCC('p', 'r', 'e', 'm'): {
+                uint32_t byID;
+                AVIF_CHECK(avifROStreamReadU32(&s, &byID));                       // unsigned int(32) track_IDs[];
+                AVIF_CHECK(avifROStreamSkip(&s, header.size - sizeof(uint32_t))); // just take the first one
+                track->premByID = byID;
+                break;
+            }
+            default:
+                AVIF_CHECK(avifROStreamSkip(&s, header.size));
+                break;
         }
     }
     return AVIF_TRUE;
@@ -3203,23 +3375,33 @@ static avifResult avifParseTrackBox(avifDecoderData * data,
         avifBoxHeader header;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
-        if (!memcmp(header.type, "tkhd", 4)) {
-            AVIF_CHECKERR(avifParseTrackHeaderBox(track, avifROStreamCurrent(&s), header.size, imageSizeLimit, imageDimensionLimit, data->diag),
-                          AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "meta", 4)) {
-            AVIF_CHECKRES(
-                avifParseMetaBox(track->meta, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, data->diag));
-        } else if (!memcmp(header.type, "mdia", 4)) {
-            AVIF_CHECKRES(avifParseMediaBox(track, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, data->diag));
-        } else if (!memcmp(header.type, "tref", 4)) {
-            AVIF_CHECKERR(avifTrackReferenceBox(track, avifROStreamCurrent(&s), header.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-        } else if (!memcmp(header.type, "edts", 4)) {
-            if (edtsBoxSeen) {
-                avifDiagnosticsPrintf(data->diag, "More than one [edts] Box was found.");
-                return AVIF_RESULT_BMFF_PARSE_FAILED;
-            }
-            AVIF_CHECKERR(avifParseEditBox(track, avifROStreamCurrent(&s), header.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            edtsBoxSeen = AVIF_TRUE;
+        const uint8_t * content = avifROStreamCurrent(&s);
+        switch (AVIF_FOURCC_FROM_BYTES(header.type)) {
+            case AVIF_FOURCC('t', 'k', 'h', 'd'):
+                AVIF_CHECKERR(
+                    avifParseTrackHeaderBox(track, content, header.size, imageSizeLimit, imageDimensionLimit, data->diag),
+                    AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+                AVIF_CHECKRES(
+                    avifParseMetaBox(track->meta, rawOffset + avifROStreamOffset(&s), content, header.size, data->diag));
+                break;
+            case AVIF_FOURCC('m', 'd', 'i', 'a'):
+                AVIF_CHECKRES(avifParseMediaBox(track, rawOffset + avifROStreamOffset(&s), content, header.size, data->diag));
+                break;
+            case AVIF_FOURCC('t', 'r', 'e', 'f'):
+                AVIF_CHECKERR(avifTrackReferenceBox(track, content, header.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                break;
+            case AVIF_FOURCC('e', 'd', 't', 's'):
+                if (edtsBoxSeen) {
+                    avifDiagnosticsPrintf(data->diag, "More than one [edts] Box was found.");
+                    return AVIF_RESULT_BMFF_PARSE_FAILED;
+                }
+                AVIF_CHECKERR(avifParseEditBox(track, content, header.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                edtsBoxSeen = AVIF_TRUE;
+                break;
+            default:
+                break;
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -3296,22 +3478,34 @@ static avifResult avifParseExtendedMeta(avifMeta * meta, uint64_t rawOffset, con
         avifBoxHeader header;
         AVIF_CHECKERR(avifROStreamReadBoxHeader(&s, &header), AVIF_RESULT_BMFF_PARSE_FAILED);
 
-        if (!memcmp(header.type, "hdlr", 4) || !memcmp(header.type, "dinf", 4) || !memcmp(header.type, "idat", 4) ||
-            !memcmp(header.type, "pitm", 4)) {
-            avifDiagnosticsPrintf(diag, "Box[coni] shall have no Box[%.4s] in its extendedMeta field", (const char *)header.type);
-            return AVIF_RESULT_BMFF_PARSE_FAILED;
-        } else if (!memcmp(header.type, "iinf", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 5, "coni", "iinf", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemInfoBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iloc", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 1, "coni", "iloc", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemLocationBox(meta, avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iprp", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 4, "coni", "iprp", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemPropertiesBox(meta, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), header.size, diag));
-        } else if (!memcmp(header.type, "iref", 4)) {
-            AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 6, "coni", "iref", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseItemReferenceBox(meta, avifROStreamCurrent(&s), header.size, diag));
+        const uint8_t * content = avifROStreamCurrent(&s);
+        switch (AVIF_FOURCC_FROM_BYTES(header.type)) {
+            case AVIF_FOURCC('h', 'd', 'l', 'r'):
+            case AVIF_FOURCC('d', 'i', 'n', 'f'):
+            case AVIF_FOURCC('i', 'd', 'a', 't'):
+            case AVIF_FOURCC('p', 'i', 't', 'm'):
+                avifDiagnosticsPrintf(diag,
+                                      "Box[coni] shall have no Box[%.4s] in its extendedMeta field",
+                                      (const char *)header.type);
+                return AVIF_RESULT_BMFF_PARSE_FAILED;
+            case AVIF_FOURCC('i', 'i', 'n', 'f'):
+                AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 5, "coni", "iinf", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseItemInfoBox(meta, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('i', 'l', 'o', 'c'):
+                AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 1, "coni", "iloc", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseItemLocationBox(meta, content, header.size, diag));
+                break;
+            case AVIF_FOURCC('i', 'p', 'r', 'p'):
+                AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 4, "coni", "iprp", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseItemPropertiesBox(meta, rawOffset + avifROStreamOffset(&s), content, header.size, diag));
+                break;
+            case AVIF_FOURCC('i', 'r', 'e', 'f'):
+                AVIF_CHECKERR(uniqueBoxSeen(&uniqueBoxFlags, 6, "coni", "iref", diag), AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseItemReferenceBox(meta, content, header.size, diag));
+                break;
+            default:
+                break;
         }
 
         AVIF_CHECKERR(avifROStreamSkip(&s, header.size), AVIF_RESULT_BMFF_PARSE_FAILED);
@@ -3324,6 +3518,7 @@ static avifProperty * avifMetaCreateProperty(avifMeta * meta, const char * prope
     avifProperty * metaProperty = avifArrayPush(&meta->properties);
     AVIF_CHECK(metaProperty);
     memcpy(metaProperty->type, propertyType, 4);
+    metaProperty->fourcc = AVIF_FOURCC_FROM_BYTES(propertyType);
     return metaProperty;
 }
 
@@ -3628,7 +3823,8 @@ static avifResult avifParseCondensedImageBox(avifMeta * meta, uint64_t rawOffset
 
     if (hasExtendedMeta) {
         assert(avifROStreamHasBytesLeft(&s, extendedMetaSize));
-        AVIF_CHECKRES(avifParseExtendedMeta(meta, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), extendedMetaSize, diag));
+        AVIF_CHECKRES(
+            avifParseExtendedMeta(meta, rawOffset + avifROStreamOffset(&s), avifROStreamCurrent(&s), extendedMetaSize, diag));
     }
     return AVIF_RESULT_OK;
 }
@@ -3701,13 +3897,22 @@ static avifResult avifParse(avifDecoder * decoder)
         uint64_t boxOffset = 0;
         avifROData boxContents = AVIF_DATA_EMPTY;
 
-        // TODO: reorg this code to only do these memcmps once each
+        const uint32_t boxType = AVIF_FOURCC_FROM_BYTES(header.type);
+        avifBool isParsedBox;
+        switch (boxType) {
+            case AVIF_FOURCC('f', 't', 'y', 'p'):
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+            case AVIF_FOURCC('m', 'o', 'o', 'v'):
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
-        if (!memcmp(header.type, "ftyp", 4) || !memcmp(header.type, "meta", 4) || !memcmp(header.type, "moov", 4) ||
-            !memcmp(header.type, "coni", 4)) {
-#else
-        if (!memcmp(header.type, "ftyp", 4) || !memcmp(header.type, "meta", 4) || !memcmp(header.type, "moov", 4)) {
+            case AVIF_FOURCC('c', 'o', 'n', 'i'):
 #endif
+                isParsedBox = AVIF_TRUE;
+                break;
+            default:
+                isParsedBox = AVIF_FALSE;
+                break;
+        }
+        if (isParsedBox) {
             boxOffset = parseOffset;
             readResult = decoder->io->read(decoder->io, 0, parseOffset, header.size, &boxContents);
             if (readResult != AVIF_RESULT_OK) {
@@ -3722,39 +3927,53 @@ static avifResult avifParse(avifDecoder * decoder)
         }
         parseOffset += header.size;
 
-        if (!memcmp(header.type, "ftyp", 4)) {
-            AVIF_CHECKERR(!ftypSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            avifFileType ftyp;
-            AVIF_CHECKERR(avifParseFileTypeBox(&ftyp, boxContents.data, boxContents.size, data->diag), AVIF_RESULT_BMFF_PARSE_FAILED);
-            if (!avifFileTypeIsCompatible(&ftyp)) {
-                return AVIF_RESULT_INVALID_FTYP;
-            }
-            ftypSeen = AVIF_TRUE;
-            memcpy(data->majorBrand, ftyp.majorBrand, 4); // Remember the major brand for future AVIF_DECODER_SOURCE_AUTO decisions
-            needsMeta = avifFileTypeHasBrand(&ftyp, "avif");
-            needsMoov = avifFileTypeHasBrand(&ftyp, "avis");
+        switch (boxType) {
+            case AVIF_FOURCC('f', 't', 'y', 'p'): {
+                AVIF_CHECKERR(!ftypSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                avifFileType ftyp;
+                AVIF_CHECKERR(avifParseFileTypeBox(&ftyp, boxContents.data, boxContents.size, data->diag),
+                              AVIF_RESULT_BMFF_PARSE_FAILED);
+                if (!avifFileTypeIsCompatible(&ftyp)) {
+                    return AVIF_RESULT_INVALID_FTYP;
+                }
+                ftypSeen = AVIF_TRUE;
+                // Remember the major brand for future AVIF_DECODER_SOURCE_AUTO decisions
+                memcpy(data->majorBrand, ftyp.majorBrand, 4);
+                needsMeta = avifFileTypeHasBrand(&ftyp, "avif");
+                needsMoov = avifFileTypeHasBrand(&ftyp, "avis");
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
-            needsConi = avifFileTypeHasBrand(&ftyp, "avir");
-            if (needsConi && (needsMeta || needsMoov)) {
-                return AVIF_RESULT_INVALID_FTYP;
-            }
+                needsConi = avifFileTypeHasBrand(&ftyp, "avir");
+                if (needsConi && (needsMeta || needsMoov)) {
+                    return AVIF_RESULT_INVALID_FTYP;
+                }
 #endif // AVIF_ENABLE_EXPERIMENTAL_AVIR
-        } else if (!memcmp(header.type, "meta", 4)) {
-            AVIF_CHECKERR(!metaSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseMetaBox(data->meta, boxOffset, boxContents.data, boxContents.size, data->diag));
-            metaSeen = AVIF_TRUE;
-        } else if (!memcmp(header.type, "moov", 4)) {
-            AVIF_CHECKERR(!moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(
-                avifParseMovieBox(data, boxOffset, boxContents.data, boxContents.size, decoder->imageSizeLimit, decoder->imageDimensionLimit));
-            moovSeen = AVIF_TRUE;
-            decoder->imageSequenceTrackPresent = AVIF_TRUE;
+                break;
+            }
+            case AVIF_FOURCC('m', 'e', 't', 'a'):
+                AVIF_CHECKERR(!metaSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseMetaBox(data->meta, boxOffset, boxContents.data, boxContents.size, data->diag));
+                metaSeen = AVIF_TRUE;
+                break;
+            case AVIF_FOURCC('m', 'o', 'o', 'v'):
+                AVIF_CHECKERR(!moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseMovieBox(data,
+                                                boxOffset,
+                                                boxContents.data,
+                                                boxContents.size,
+                                                decoder->imageSizeLimit,
+                                                decoder->imageDimensionLimit));
+                moovSeen = AVIF_TRUE;
+                decoder->imageSequenceTrackPresent = AVIF_TRUE;
+                break;
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
-        } else if (!memcmp(header.type, "coni", 4)) {
-            AVIF_CHECKERR(!metaSeen && !moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
-            AVIF_CHECKRES(avifParseCondensedImageBox(data->meta, boxOffset, boxContents.data, boxContents.size, data->diag));
-            coniSeen = AVIF_TRUE;
+            case AVIF_FOURCC('c', 'o', 'n', 'i'):
+                AVIF_CHECKERR(!metaSeen && !moovSeen, AVIF_RESULT_BMFF_PARSE_FAILED);
+                AVIF_CHECKRES(avifParseCondensedImageBox(data->meta, boxOffset, boxContents.data, boxContents.size, data->diag));
+                coniSeen = AVIF_TRUE;
+                break;
 #endif // AVIF_ENABLE_EXPERIMENTAL_AVIR
+            default:
+                break;
         }
 
 #if defined(AVIF_ENABLE_EXPERIMENTAL_AVIR)
@@ -3977,6 +4196,101 @@ avifResult avifDecoderNthImageMaxExtent(const avifDecoder * decoder, uint32_t fr
     return AVIF_RESULT_OK;
 }
 
+// Number of reference frame slots of an AV1 decoder (NUM_REF_FRAMES in the AV1 specification).
+#define AVIF_AV1_NUM_REF_FRAMES 8
+// Upper bound of the border, in pixels, that the AV1 decoders add on each side of their frame buffers for motion vectors
+// pointing outside of the reference frames.
+#define AVIF_AV1_FRAME_BORDER 64
+
+// Returns the number of bytes of the planes of an image with the given characteristics. Each dimension is rounded up to
+// a multiple of 8 (the AV1 block size granularity) and extended by border pixels on each side.
+static uint64_t avifPlanesSize(uint32_t width,
+                               uint32_t height,
+                               uint32_t depth,
+                               avifPixelFormat yuvFormat,
+                               avifBool hasChroma,
+                               uint32_t border)
+{
+    const uint64_t paddedWidth = (((uint64_t)width + 7) & ~(uint64_t)7) + 2 * (uint64_t)border;
+    const uint64_t paddedHeight = (((uint64_t)height + 7) & ~(uint64_t)7) + 2 * (uint64_t)border;
+    const uint64_t bytesPerSample = (depth > 8) ? 2 : 1;
+    uint64_t sampleCount = paddedWidth * paddedHeight;
+    if (hasChroma) {
+        avifPixelFormatInfo formatInfo;
+        // The format may not be known yet. Assume the worst case.
+        avifGetPixelFormatInfo((yuvFormat == AVIF_PIXEL_FORMAT_NONE) ? AVIF_PIXEL_FORMAT_YUV444 : yuvFormat, &formatInfo);
+        if (!formatInfo.monochrome) {
+            sampleCount += 2 * (((paddedWidth + formatInfo.chromaShiftX) >> formatInfo.chromaShiftX) *
+                                ((paddedHeight + formatInfo.chromaShiftY) >> formatInfo.chromaShiftY));
+        }
+    }
+    return sampleCount * bytesPerSample;
+}
+
+avifResult avifDecoderEstimateMemoryUsage(const avifDecoder * decoder, uint64_t * outBytes)
+{
+    *outBytes = 0;
+    if (!decoder->data || !decoder->image) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+
+    uint64_t bytes = 0;
+    for (int c = AVIF_ITEM_COLOR; c < AVIF_ITEM_CATEGORY_COUNT; ++c) {
+        const avifTileInfo * info = &decoder->data->tileInfos[c];
+        if (info->tileCount == 0) {
+            continue;
+        }
+        const avifImage * image = decoder->image;
+#if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
+        if (c == AVIF_ITEM_GAIN_MAP) {
+            image = decoder->image->gainMap.image;
+            if (!image) {
+                continue;
+            }
+        }
+#endif
+        // The alpha auxiliary image is a monochrome AV1 stream.
+        const avifBool hasChroma = (c != AVIF_ITEM_ALPHA);
+
+        for (unsigned int tileIndex = 0; tileIndex < info->tileCount; ++tileIndex) {
+            const avifTile * tile = &decoder->data->tiles.tile[info->firstTileIndex + tileIndex];
+            // A single frame is enough for a still image. Image sequences and progressive images (layers) may refer to
+            // all the reference frames while decoding the current frame.
+            const uint64_t frameCount = (tile->input->samples.count > 1) ? AVIF_AV1_NUM_REF_FRAMES + 1 : 1;
+            bytes += frameCount *
+                     avifPlanesSize(tile->width, tile->height, image->depth, image->yuvFormat, hasChroma, AVIF_AV1_FRAME_BORDER);
+
+            // Encoded data that is not read in place (see avifDecoderItemRead() and avifDecoderPrepareSample()).
+            uint64_t maxSampleSize = 0;
+            for (uint32_t sampleIndex = 0; sampleIndex < tile->input->samples.count; ++sampleIndex) {
+                const avifDecodeSample * sample = &tile->input->samples.sample[sampleIndex];
+                if (sample->itemID) {
+                    // Only look the item up: estimating must not modify the decoder.
+                    const avifDecoderItem * item = avifMetaFindItem(decoder->data->meta, sample->itemID);
+                    AVIF_CHECKERR(item != NULL, AVIF_RESULT_BMFF_PARSE_FAILED);
+                    if (!item->idatStored && ((item->extents.count > 1) || !decoder->io->persistent)) {
+                        // All samples of a tile item share the same mergedExtents buffer.
+                        maxSampleSize = AVIF_MAX(maxSampleSize, (uint64_t)item->size);
+                    }
+                } else if (!decoder->io->persistent) {
+                    maxSampleSize = AVIF_MAX(maxSampleSize, (uint64_t)sample->size);
+                }
+            }
+            bytes += maxSampleSize;
+        }
+
+        if (info->tileCount > 1) {
+            // The tiles are copied into a canvas owned by the output image.
+            const uint32_t width = info->grid.outputWidth;
+            const uint32_t height = info->grid.outputHeight;
+            bytes += avifPlanesSize(width, height, image->depth, image->yuvFormat, hasChroma, /*border=*/0);
+        }
+    }
+    *outBytes = bytes;
+    return AVIF_RESULT_OK;
+}
+
 static avifResult avifDecoderPrepareSample(avifDecoder * decoder, avifDecodeSample * sample, size_t partialByteCount)
 {
     if (!sample->data.size || sample->partialData) {
@@ -4034,6 +4348,40 @@ static avifResult avifDecoderPrepareSample(avifDecoder * decoder, avifDecodeSamp
     return AVIF_RESULT_OK;
 }
 
+avifResult avifDecoderReadSample(avifDecoder * decoder,
+                                  avifItemCategory category,
+                                  uint32_t sampleIndex,
+                                  avifROData * sample,
+                                  avifBool * sync)
+{
+    if (!decoder->data) {
+        // Nothing has been parsed yet
+        return AVIF_RESULT_NO_CONTENT;
+    }
+    const avifTileInfo * info = &decoder->data->tileInfos[category];
+    if (info->tileCount == 0) {
+        return AVIF_RESULT_NO_CONTENT;
+    }
+    if (info->tileCount > 1) {
+        avifDiagnosticsPrintf(&decoder->diag, "Reading the samples of a grid is not supported");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+    avifTile * tile = &decoder->data->tiles.tile[info->firstTileIndex];
+    if ((decoder->data->source == AVIF_DECODER_SOURCE_PRIMARY_ITEM) && (tile->input->samples.count > 1)) {
+        avifDiagnosticsPrintf(&decoder->diag, "Reading the samples of a layered image is not supported");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+    if (sampleIndex >= tile->input->samples.count) {
+        return AVIF_RESULT_NO_IMAGES_REMAINING;
+    }
+
+    avifDecodeSample * decodeSample = &tile->input->samples.sample[sampleIndex];
+    AVIF_CHECKRES(avifDecoderPrepareSample(decoder, decodeSample, 0));
+    *sample = decodeSample->data;
+    *sync = decodeSample->sync;
+    return AVIF_RESULT_OK;
+}
+
 avifResult avifDecoderParse(avifDecoder * decoder)
 {
     avifDiagnosticsClearError(&decoder->diag);
@@ -4164,7 +4512,8 @@ static avifResult avifDecoderCreateCodecs(avifDecoder * decoder)
         AVIF_CHECKRES(avifCodecCreateInternal(decoder->codecChoice, &decoder->data->tiles.tile[0], &decoder->diag, &data->codec));
         data->tiles.tile[0].codec = data->codec;
         if (data->tiles.count > 1) {
-            AVIF_CHECKRES(avifCodecCreateInternal(decoder->codecChoice, &decoder->data->tiles.tile[1], &decoder->diag, &data->codecAlpha));
+            AVIF_CHECKRES(
+                avifCodecCreateInternal(decoder->codecChoice, &decoder->data->tiles.tile[1], &decoder->diag, &data->codecAlpha));
             data->tiles.tile[1].codec = data->codecAlpha;
         }
     } else {
@@ -4182,7 +4531,8 @@ static avifResult avifDecoderCreateCodecs(avifDecoder * decoder)
         avifBool canUseSingleCodecInstance = (data->tiles.count == 1) ||
                                              (decoder->imageCount == 1 && avifTilesCanBeDecodedWithSameCodecInstance(data));
         if (canUseSingleCodecInstance) {
-            AVIF_CHECKRES(avifCodecCreateInternal(decoder->codecChoice, &decoder->data->tiles.tile[0], &decoder->diag, &data->codec));
+            AVIF_CHECKRES(
+                avifCodecCreateInternal(decoder->codecChoice, &decoder->data->tiles.tile[0], &decoder->diag, &data->codec));
             for (unsigned int i = 0; i < decoder->data->tiles.count; ++i) {
                 decoder->data->tiles.tile[i].codec = data->codec;
             }
@@ -4222,6 +4572,26 @@ static avifDecoderItem * avifMetaFindColorItem(avifMeta * meta)
     return NULL;
 }
 
+// Returns the smallest thumbnail item of colorItem whose largest dimension is at least minSize, or NULL.
+static avifDecoderItem * avifMetaFindThumbnailItem(avifMeta * meta, const avifDecoderItem * colorItem, uint32_t minSize)
+{
+    avifDecoderItem * thumbnailItem = NULL;
+    uint32_t thumbnailSize = 0;
+    for (uint32_t itemIndex = 0; itemIndex < meta->items.count; ++itemIndex) {
+        avifDecoderItem * item = &meta->items.item[itemIndex];
+        if ((item->thumbnailForID != colorItem->id) || !item->size || item->hasUnsupportedEssentialProperty ||
+            (avifGetCodecType(item->type) == AVIF_CODEC_TYPE_UNKNOWN && memcmp(item->type, "grid", 4))) {
+            continue;
+        }
+        const uint32_t size = AVIF_MAX(item->width, item->height);
+        if ((size >= minSize) && (!thumbnailItem || (size < thumbnailSize))) {
+            thumbnailItem = item;
+            thumbnailSize = size;
+        }
+    }
+    return thumbnailItem;
+}
+
 // Returns AVIF_TRUE if item is an alpha auxiliary item of the parent color
 // item.
 static avifBool avifDecoderItemIsAlphaAux(avifDecoderItem * item, uint32_t colorItemId)
@@ -4506,6 +4876,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
     decoder->image = avifImageCreateEmpty();
     AVIF_CHECKERR(decoder->image, AVIF_RESULT_OUT_OF_MEMORY);
     decoder->progressiveState = AVIF_PROGRESSIVE_STATE_UNAVAILABLE;
+    decoder->thumbnailSelected = AVIF_FALSE;
     data->cicpSet = AVIF_FALSE;
 
     memset(&decoder->ioStats, 0, sizeof(decoder->ioStats));
@@ -4674,6 +5045,16 @@ avifResult avifDecoderReset(avifDecoder * decoder)
             avifDiagnosticsPrintf(&decoder->diag, "Primary item not found");
             return AVIF_RESULT_MISSING_IMAGE_ITEM;
         }
+        // Exif and XMP metadata are linked to the primary item, even when decoding one of its thumbnails.
+        const uint32_t primaryColorItemID = mainItems[AVIF_ITEM_COLOR]->id;
+        if (decoder->minThumbnailSize > 0) {
+            avifDecoderItem * thumbnailItem =
+                avifMetaFindThumbnailItem(data->meta, mainItems[AVIF_ITEM_COLOR], decoder->minThumbnailSize);
+            if (thumbnailItem) {
+                mainItems[AVIF_ITEM_COLOR] = thumbnailItem;
+                decoder->thumbnailSelected = AVIF_TRUE;
+            }
+        }
         AVIF_CHECKRES(avifDecoderItemReadAndParse(decoder,
                                                   mainItems[AVIF_ITEM_COLOR],
                                                   /*isItemInInput=*/AVIF_TRUE,
@@ -4699,12 +5080,16 @@ avifResult avifDecoderReset(avifDecoder * decoder)
         }
 
 #if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
-        avifDecoderItem * toneMappedImageItem;
-        const avifResult findGainMapResult = avifDecoderFindGainMapItem(decoder,
-                                                                        mainItems[AVIF_ITEM_COLOR],
-                                                                        &toneMappedImageItem,
-                                                                        &mainItems[AVIF_ITEM_GAIN_MAP],
-                                                                        &codecType[AVIF_ITEM_GAIN_MAP]);
+        avifDecoderItem * toneMappedImageItem = NULL;
+        avifResult findGainMapResult = AVIF_RESULT_OK;
+        if (!decoder->thumbnailSelected) {
+            // Thumbnails are not tone mapped.
+            findGainMapResult = avifDecoderFindGainMapItem(decoder,
+                                                           mainItems[AVIF_ITEM_COLOR],
+                                                           &toneMappedImageItem,
+                                                           &mainItems[AVIF_ITEM_GAIN_MAP],
+                                                           &codecType[AVIF_ITEM_GAIN_MAP]);
+        }
         if (!decoder->enableDecodingGainMap) {
             // When ignoring the gain map, we still report whether one is present or not,
             // but do not fail if there was any error with the gain map.
@@ -4731,7 +5116,7 @@ avifResult avifDecoderReset(avifDecoder * decoder)
 #endif // AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP
 
         // Find Exif and/or XMP metadata, if any
-        AVIF_CHECKRES(avifDecoderFindMetadata(decoder, data->meta, decoder->image, mainItems[AVIF_ITEM_COLOR]->id));
+        AVIF_CHECKRES(avifDecoderFindMetadata(decoder, data->meta, decoder->image, primaryColorItemID));
 
         // Set all counts and timing to safe-but-uninteresting values
         decoder->imageIndex = -1;
@@ -4926,6 +5311,17 @@ avifResult avifDecoderReset(avifDecoder * decoder)
 
     AVIF_CHECKRES(avifReadCodecConfigProperty(decoder->image, colorProperties, colorCodecType));
 
+    if (decoder->memoryLimit != 0) {
+        uint64_t memoryUsage;
+        AVIF_CHECKRES(avifDecoderEstimateMemoryUsage(decoder, &memoryUsage));
+        if (memoryUsage > decoder->memoryLimit) {
+            avifDiagnosticsPrintf(data->diag,
+                                  "Decoding may use up to %" PRIu64 " bytes, which exceeds the memory limit of %" PRIu64 " bytes",
+                                  memoryUsage,
+                                  decoder->memoryLimit);
+            return AVIF_RESULT_MEMORY_LIMIT_EXCEEDED;
+        }
+    }
     return AVIF_RESULT_OK;
 }
 
@@ -5054,6 +5450,8 @@ static avifResult avifDecoderDecodeTiles(avifDecoder * decoder, uint32_t nextIma
             if (avifImageScaleWithLimit(tile->image,
                                         tile->width,
                                         tile->height,
+                                        AVIF_SCALE_FILTER_AUTOMATIC,
+                                        decoder->maxThreads,
                                         decoder->imageSizeLimit,
                                         decoder->imageDimensionLimit,
                                         &decoder->diag) != AVIF_RESULT_OK) {
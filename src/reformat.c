@@ -7,13 +7,6 @@
 #include <math.h>
 #include <string.h>
 
-#if defined(_WIN32)
-#include <process.h>
-#include <windows.h>
-#else
-#include <pthread.h>
-#endif
-
 struct YUVBlock
 {
     float y;
@@ -32,6 +25,9 @@ avifBool avifGetRGBColorSpaceInfo(const avifRGBImage * rgb, avifRGBColorSpaceInf
     if (rgb->format == AVIF_RGB_FORMAT_RGB_565 && rgb->depth != 8) {
         return AVIF_FALSE;
     }
+    if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102 && rgb->depth != 10) {
+        return AVIF_FALSE;
+    }
     if (rgb->format < AVIF_RGB_FORMAT_RGB || rgb->format >= AVIF_RGB_FORMAT_COUNT) {
         return AVIF_FALSE;
     }
@@ -86,6 +82,13 @@ avifBool avifGetRGBColorSpaceInfo(const avifRGBImage * rgb, avifRGBColorSpaceInf
             info->offsetBytesB = 0;
             info->offsetBytesA = 0;
             break;
+        case AVIF_RGB_FORMAT_RGBA1010102:
+            // Same as RGB_565, the entire pixel is a single uint32_t.
+            info->offsetBytesR = 0;
+            info->offsetBytesG = 0;
+            info->offsetBytesB = 0;
+            info->offsetBytesA = 0;
+            break;
 
         case AVIF_RGB_FORMAT_COUNT:
             return AVIF_FALSE;
@@ -171,6 +174,8 @@ static avifBool avifPrepareReformatState(const avifImage * image, const avifRGBI
     AVIF_CHECK(avifGetYUVColorSpaceInfo(image, &state->yuv));
 
     state->yuv.mode = AVIF_REFORMAT_MODE_YUV_COEFFICIENTS;
+    state->toRGBAlphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+    state->toRGBHalfFloat = AVIF_FALSE;
 
     if (image->matrixCoefficients == AVIF_MATRIX_COEFFICIENTS_IDENTITY) {
         state->yuv.mode = AVIF_REFORMAT_MODE_IDENTITY;
@@ -222,27 +227,387 @@ static int avifYUVColorSpaceInfoUVToUNorm(avifYUVColorSpaceInfo * info, float v)
     return AVIF_CLAMP(unorm, 0, info->maxChannel);
 }
 
-avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb)
+// Lossless-friendly RGB->YUV fast paths for 4:4:4 AVIF_REFORMAT_MODE_IDENTITY, AVIF_REFORMAT_MODE_YCGCO and
+// AVIF_REFORMAT_MODE_YCGCO_RE/RO, without alpha (un)multiply. They give exactly the same output as the generic loop in
+// avifImageRGBToYUV(), but no chroma averaging is ever needed so the planes are written directly, row by row.
+//
+// yuv16 and rgb16 are always passed as constants so that the compiler can specialize the inner loops.
+static inline uint16_t avifLoadRGBSample(const uint8_t * ptr, avifBool rgb16)
 {
-    if (!rgb->pixels || rgb->format == AVIF_RGB_FORMAT_RGB_565) {
-        return AVIF_RESULT_REFORMAT_FAILED;
+    return rgb16 ? *(const uint16_t *)ptr : *ptr;
+}
+
+static inline void avifStoreYUVSample(uint8_t * row, uint32_t x, avifBool yuv16, int v)
+{
+    if (yuv16) {
+        ((uint16_t *)row)[x] = (uint16_t)v;
+    } else {
+        row[x] = (uint8_t)v;
     }
+}
 
-    avifReformatState state;
-    if (!avifPrepareReformatState(image, rgb, &state)) {
-        return AVIF_RESULT_REFORMAT_FAILED;
+static inline avifResult avifImageRGBAnyToIdentityAny444(avifImage * image,
+                                                         const avifRGBImage * rgb,
+                                                         avifReformatState * state,
+                                                         avifBool yuv16,
+                                                         avifBool rgb16)
+{
+    // Identity is a plain per-channel remapping, so precompute it for every possible RGB sample value.
+    const uint32_t rgbMaxChannel = state->rgb.maxChannel;
+    const float rgbMaxChannelF = state->rgb.maxChannelF;
+    uint16_t * rgbToUNorm = avifAlloc(((size_t)rgbMaxChannel + 1) * sizeof(uint16_t));
+    AVIF_CHECKERR(rgbToUNorm, AVIF_RESULT_OUT_OF_MEMORY);
+    for (uint32_t v = 0; v <= rgbMaxChannel; ++v) {
+        rgbToUNorm[v] = (uint16_t)avifYUVColorSpaceInfoYToUNorm(&state->yuv, v / rgbMaxChannelF);
     }
 
-    if (rgb->isFloat) {
-        return AVIF_RESULT_NOT_IMPLEMENTED;
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    for (uint32_t j = 0; j < image->height; ++j) {
+        const uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        const uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        const uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+        uint8_t * ptrY = &image->yuvPlanes[AVIF_CHAN_Y][j * image->yuvRowBytes[AVIF_CHAN_Y]];
+        uint8_t * ptrU = &image->yuvPlanes[AVIF_CHAN_U][j * image->yuvRowBytes[AVIF_CHAN_U]];
+        uint8_t * ptrV = &image->yuvPlanes[AVIF_CHAN_V][j * image->yuvRowBytes[AVIF_CHAN_V]];
+        for (uint32_t i = 0; i < image->width; ++i) {
+            const uint16_t R = avifLoadRGBSample(ptrR, rgb16);
+            const uint16_t G = avifLoadRGBSample(ptrG, rgb16);
+            const uint16_t B = avifLoadRGBSample(ptrB, rgb16);
+            if (rgb16 && ((R > rgbMaxChannel) || (G > rgbMaxChannel) || (B > rgbMaxChannel))) {
+                // Out-of-range samples are not in the table.
+                avifStoreYUVSample(ptrY, i, yuv16, avifYUVColorSpaceInfoYToUNorm(&state->yuv, G / rgbMaxChannelF));
+                avifStoreYUVSample(ptrU, i, yuv16, avifYUVColorSpaceInfoYToUNorm(&state->yuv, B / rgbMaxChannelF));
+                avifStoreYUVSample(ptrV, i, yuv16, avifYUVColorSpaceInfoYToUNorm(&state->yuv, R / rgbMaxChannelF));
+            } else {
+                // Formulas 41,42,43 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+                avifStoreYUVSample(ptrY, i, yuv16, rgbToUNorm[G]);
+                avifStoreYUVSample(ptrU, i, yuv16, rgbToUNorm[B]);
+                avifStoreYUVSample(ptrV, i, yuv16, rgbToUNorm[R]);
+            }
+            ptrR += rgbPixelBytes;
+            ptrG += rgbPixelBytes;
+            ptrB += rgbPixelBytes;
+        }
+    }
+    avifFree(rgbToUNorm);
+    return AVIF_RESULT_OK;
+}
+
+static inline avifResult avifImageRGBAnyToYCgCoAny444(avifImage * image,
+                                                      const avifRGBImage * rgb,
+                                                      avifReformatState * state,
+                                                      avifBool yuv16,
+                                                      avifBool rgb16)
+{
+#if defined(AVIF_ENABLE_EXPERIMENTAL_YCGCO_R)
+    const avifBool reversible = (state->yuv.mode == AVIF_REFORMAT_MODE_YCGCO_RE) ||
+                                (state->yuv.mode == AVIF_REFORMAT_MODE_YCGCO_RO);
+#else
+    const avifBool reversible = AVIF_FALSE;
+#endif
+    const int rgbMaxChannel = (int)state->rgb.maxChannel;
+    const float rgbMaxChannelF = state->rgb.maxChannelF;
+    const int yuvMaxChannel = (int)state->yuv.maxChannel;
+    const int biasUV = 1 << (image->depth - 1);
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    for (uint32_t j = 0; j < image->height; ++j) {
+        const uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        const uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        const uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+        uint8_t * ptrY = &image->yuvPlanes[AVIF_CHAN_Y][j * image->yuvRowBytes[AVIF_CHAN_Y]];
+        uint8_t * ptrU = &image->yuvPlanes[AVIF_CHAN_U][j * image->yuvRowBytes[AVIF_CHAN_U]];
+        uint8_t * ptrV = &image->yuvPlanes[AVIF_CHAN_V][j * image->yuvRowBytes[AVIF_CHAN_V]];
+        if (reversible) {
+            for (uint32_t i = 0; i < image->width; ++i) {
+                // Formulas from JVET-U0093, in integers. The YUV range is always full.
+                const int R = AVIF_MIN(avifLoadRGBSample(ptrR, rgb16), rgbMaxChannel);
+                const int G = AVIF_MIN(avifLoadRGBSample(ptrG, rgb16), rgbMaxChannel);
+                const int B = AVIF_MIN(avifLoadRGBSample(ptrB, rgb16), rgbMaxChannel);
+                const int Co = R - B;
+                const int t = B + (Co >> 1);
+                const int Cg = G - t;
+                avifStoreYUVSample(ptrY, i, yuv16, AVIF_CLAMP(t + (Cg >> 1), 0, yuvMaxChannel));
+                avifStoreYUVSample(ptrU, i, yuv16, AVIF_CLAMP(Cg + biasUV, 0, yuvMaxChannel));
+                avifStoreYUVSample(ptrV, i, yuv16, AVIF_CLAMP(Co + biasUV, 0, yuvMaxChannel));
+                ptrR += rgbPixelBytes;
+                ptrG += rgbPixelBytes;
+                ptrB += rgbPixelBytes;
+            }
+        } else {
+            for (uint32_t i = 0; i < image->width; ++i) {
+                const float R = avifLoadRGBSample(ptrR, rgb16) / rgbMaxChannelF;
+                const float G = avifLoadRGBSample(ptrG, rgb16) / rgbMaxChannelF;
+                const float B = avifLoadRGBSample(ptrB, rgb16) / rgbMaxChannelF;
+                // Formulas 44,45,46 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+                avifStoreYUVSample(ptrY, i, yuv16, avifYUVColorSpaceInfoYToUNorm(&state->yuv, 0.5f * G + 0.25f * (R + B)));
+                avifStoreYUVSample(ptrU, i, yuv16, avifYUVColorSpaceInfoUVToUNorm(&state->yuv, 0.5f * G - 0.25f * (R + B)));
+                avifStoreYUVSample(ptrV, i, yuv16, avifYUVColorSpaceInfoUVToUNorm(&state->yuv, 0.5f * (R - B)));
+                ptrR += rgbPixelBytes;
+                ptrG += rgbPixelBytes;
+                ptrB += rgbPixelBytes;
+            }
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+// Returns AVIF_RESULT_NOT_IMPLEMENTED if there is no fast path for the combination of image and rgb.
+static avifResult avifImageRGBToYUV444NonCoefficients(avifImage * image, const avifRGBImage * rgb, avifReformatState * state)
+{
+    const avifBool yuv16 = image->depth > 8;
+    const avifBool rgb16 = rgb->depth > 8;
+    if (state->yuv.mode == AVIF_REFORMAT_MODE_IDENTITY) {
+        if (yuv16) {
+            return rgb16 ? avifImageRGBAnyToIdentityAny444(image, rgb, state, AVIF_TRUE, AVIF_TRUE)
+                         : avifImageRGBAnyToIdentityAny444(image, rgb, state, AVIF_TRUE, AVIF_FALSE);
+        }
+        return rgb16 ? avifImageRGBAnyToIdentityAny444(image, rgb, state, AVIF_FALSE, AVIF_TRUE)
+                     : avifImageRGBAnyToIdentityAny444(image, rgb, state, AVIF_FALSE, AVIF_FALSE);
+    }
+    if (state->yuv.mode != AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) {
+        // AVIF_REFORMAT_MODE_YCGCO, AVIF_REFORMAT_MODE_YCGCO_RE or AVIF_REFORMAT_MODE_YCGCO_RO.
+        if (yuv16) {
+            return rgb16 ? avifImageRGBAnyToYCgCoAny444(image, rgb, state, AVIF_TRUE, AVIF_TRUE)
+                         : avifImageRGBAnyToYCgCoAny444(image, rgb, state, AVIF_TRUE, AVIF_FALSE);
+        }
+        return rgb16 ? avifImageRGBAnyToYCgCoAny444(image, rgb, state, AVIF_FALSE, AVIF_TRUE)
+                     : avifImageRGBAnyToYCgCoAny444(image, rgb, state, AVIF_FALSE, AVIF_FALSE);
     }
+    return AVIF_RESULT_NOT_IMPLEMENTED;
+}
+
+// Returns AVIF_TRUE if the conversion between image and rgb can be done by the fixed-point routines
+// (see avifRGBImage::fixedPoint). The alpha (un)multiply, if any, must be doable as a separate step.
+static avifBool avifFixedPointSupported(const avifImage * image,
+                                        const avifRGBImage * rgb,
+                                        const avifReformatState * state,
+                                        avifAlphaMultiplyMode alphaMultiplyMode)
+{
+    return (state->yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) && (image->depth <= 12) && (rgb->depth <= 12) &&
+           ((alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) || avifRGBFormatHasAlpha(rgb->format));
+}
+
+// Fixed-point RGB->YUV for AVIF_REFORMAT_MODE_YUV_COEFFICIENTS, used when avifRGBImage::fixedPoint is set or for
+// AVIF_CHROMA_DOWNSAMPLING_FASTEST, when all depths are at most 12 bits and no alpha (un)multiply is needed.
+//
+// The coefficients are scaled by 2^AVIF_RGB_TO_YUV_FIXED_POINT_BITS and rounded in double precision, with the green
+// coefficients adjusted so that each row of the matrix still sums to its exact scaled value (gray stays gray, white
+// stays white).
+// Chroma is computed from integer sums of the 1, 2 or 4 RGB samples of each block, so every output sample is
+// round((sum of coefficient * sample) / (number of samples)) and is within 1 of the float path.
+//
+// Each pair of rows is processed in tiles of AVIF_RGB_TO_YUV_TILE_WIDTH pixels: Y is written while the chroma sums of the
+// tile are accumulated, then U and V are written from the sums. All intermediate data stays in a few small arrays,
+// no matter how wide the image is.
+#define AVIF_RGB_TO_YUV_FIXED_POINT_BITS 15
+#define AVIF_RGB_TO_YUV_TILE_WIDTH 256
+
+typedef struct avifRGBToYUVFixedPoint
+{
+    int32_t yr, yg, yb;
+    int32_t ur, ug, ub;
+    int32_t vr, vg, vb;
+    int32_t biasY, biasUV; // Already scaled.
+} avifRGBToYUVFixedPoint;
+
+static void avifPrepareRGBToYUVFixedPoint(const avifReformatState * state, avifRGBToYUVFixedPoint * fp)
+{
+    // Computed in double precision from the coefficients, so that the results only depend on state->yuv.kr/kb.
+    const double one = (double)(1 << AVIF_RGB_TO_YUV_FIXED_POINT_BITS);
+    const double kr = state->yuv.kr;
+    const double kb = state->yuv.kb;
+    const double scaleY = (double)state->yuv.rangeY / state->rgb.maxChannel * one;
+    const double scaleUV = (double)state->yuv.rangeUV / state->rgb.maxChannel * one;
+
+    fp->yr = (int32_t)floor(kr * scaleY + 0.5);
+    fp->yb = (int32_t)floor(kb * scaleY + 0.5);
+    fp->yg = (int32_t)floor(scaleY + 0.5) - fp->yr - fp->yb;
+    // U = (B - Y) / (2 * (1 - kb))
+    fp->ur = (int32_t)floor(-kr / (2 * (1 - kb)) * scaleUV + 0.5);
+    fp->ub = (int32_t)floor(0.5 * scaleUV + 0.5);
+    fp->ug = -fp->ur - fp->ub;
+    // V = (R - Y) / (2 * (1 - kr))
+    fp->vr = (int32_t)floor(0.5 * scaleUV + 0.5);
+    fp->vb = (int32_t)floor(-kb / (2 * (1 - kr)) * scaleUV + 0.5);
+    fp->vg = -fp->vr - fp->vb;
+
+    fp->biasY = (int32_t)state->yuv.biasY << AVIF_RGB_TO_YUV_FIXED_POINT_BITS;
+    fp->biasUV = (int32_t)state->yuv.biasUV << AVIF_RGB_TO_YUV_FIXED_POINT_BITS;
+}
+
+// Computes round((acc + (bias << sumBits)) / 2^(AVIF_RGB_TO_YUV_FIXED_POINT_BITS + sumBits)), clamped to [0:maxChannel].
+static inline int avifRGBToYUVFixedPointToUNorm(int32_t acc, int32_t bias, uint32_t sumBits, int maxChannel)
+{
+    const uint32_t shift = AVIF_RGB_TO_YUV_FIXED_POINT_BITS + sumBits;
+    const int32_t unorm = (acc + (bias << sumBits) + (1 << (shift - 1))) >> shift;
+    return AVIF_CLAMP(unorm, 0, maxChannel);
+}
+
+static inline avifResult avifImageRGBAnyToYUVAnyFixedPoint(avifImage * image,
+                                                           const avifRGBImage * rgb,
+                                                           const avifReformatState * state,
+                                                           avifBool yuv16,
+                                                           avifBool rgb16)
+{
+    avifRGBToYUVFixedPoint fp;
+    avifPrepareRGBToYUVFixedPoint(state, &fp);
+
+    const uint16_t rgbMaxChannel = (uint16_t)state->rgb.maxChannel;
+    const int yuvMaxChannel = (int)state->yuv.maxChannel;
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    const avifBool hasChroma = (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400);
+    const uint32_t chromaShiftX = hasChroma ? state->yuv.formatInfo.chromaShiftX : 0;
+    const uint32_t chromaShiftY = hasChroma ? state->yuv.formatInfo.chromaShiftY : 0;
+
+    int32_t sumR[AVIF_RGB_TO_YUV_TILE_WIDTH];
+    int32_t sumG[AVIF_RGB_TO_YUV_TILE_WIDTH];
+    int32_t sumB[AVIF_RGB_TO_YUV_TILE_WIDTH];
+
+    for (uint32_t uvJ = 0; (uvJ << chromaShiftY) < image->height; ++uvJ) {
+        const uint32_t firstJ = uvJ << chromaShiftY;
+        const uint32_t blockH = AVIF_MIN(1u << chromaShiftY, image->height - firstJ);
+        for (uint32_t tileI = 0; tileI < image->width; tileI += AVIF_RGB_TO_YUV_TILE_WIDTH) {
+            const uint32_t tileW = AVIF_MIN(AVIF_RGB_TO_YUV_TILE_WIDTH, image->width - tileI);
+            const uint32_t tileUVW = (tileW + (1u << chromaShiftX) - 1) >> chromaShiftX;
+            if (hasChroma) {
+                memset(sumR, 0, tileUVW * sizeof(sumR[0]));
+                memset(sumG, 0, tileUVW * sizeof(sumG[0]));
+                memset(sumB, 0, tileUVW * sizeof(sumB[0]));
+            }
+
+            // Luma, and chroma sums.
+            for (uint32_t j = firstJ; j < firstJ + blockH; ++j) {
+                const uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (tileI * rgbPixelBytes) + (j * rgb->rowBytes)];
+                const uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (tileI * rgbPixelBytes) + (j * rgb->rowBytes)];
+                const uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (tileI * rgbPixelBytes) + (j * rgb->rowBytes)];
+                uint8_t * ptrY = &image->yuvPlanes[AVIF_CHAN_Y][j * image->yuvRowBytes[AVIF_CHAN_Y]];
+                for (uint32_t i = 0; i < tileW; ++i) {
+                    const int32_t R = AVIF_MIN(avifLoadRGBSample(ptrR, rgb16), rgbMaxChannel);
+                    const int32_t G = AVIF_MIN(avifLoadRGBSample(ptrG, rgb16), rgbMaxChannel);
+                    const int32_t B = AVIF_MIN(avifLoadRGBSample(ptrB, rgb16), rgbMaxChannel);
+                    const int32_t accY = fp.yr * R + fp.yg * G + fp.yb * B;
+                    avifStoreYUVSample(ptrY, tileI + i, yuv16, avifRGBToYUVFixedPointToUNorm(accY, fp.biasY, 0, yuvMaxChannel));
+                    if (hasChroma) {
+                        sumR[i >> chromaShiftX] += R;
+                        sumG[i >> chromaShiftX] += G;
+                        sumB[i >> chromaShiftX] += B;
+                    }
+                    ptrR += rgbPixelBytes;
+                    ptrG += rgbPixelBytes;
+                    ptrB += rgbPixelBytes;
+                }
+            }
+
+            if (!hasChroma) {
+                continue;
+            }
+            // Chroma. The number of summed samples is a power of two, except that it is smaller on the right and bottom
+            // edges of odd-sized images.
+            uint8_t * ptrU = &image->yuvPlanes[AVIF_CHAN_U][uvJ * image->yuvRowBytes[AVIF_CHAN_U]];
+            uint8_t * ptrV = &image->yuvPlanes[AVIF_CHAN_V][uvJ * image->yuvRowBytes[AVIF_CHAN_V]];
+            const uint32_t sumBitsY = (blockH == 2) ? 1 : 0;
+            const uint32_t tileUVI = tileI >> chromaShiftX;
+            for (uint32_t uvI = 0; uvI < tileUVW; ++uvI) {
+                const uint32_t blockW = AVIF_MIN(1u << chromaShiftX, tileW - (uvI << chromaShiftX));
+                const uint32_t sumBits = sumBitsY + ((blockW == 2) ? 1 : 0);
+                const int32_t accU = fp.ur * sumR[uvI] + fp.ug * sumG[uvI] + fp.ub * sumB[uvI];
+                const int32_t accV = fp.vr * sumR[uvI] + fp.vg * sumG[uvI] + fp.vb * sumB[uvI];
+                avifStoreYUVSample(ptrU,
+                                   tileUVI + uvI,
+                                   yuv16,
+                                   avifRGBToYUVFixedPointToUNorm(accU, fp.biasUV, sumBits, yuvMaxChannel));
+                avifStoreYUVSample(ptrV,
+                                   tileUVI + uvI,
+                                   yuv16,
+                                   avifRGBToYUVFixedPointToUNorm(accV, fp.biasUV, sumBits, yuvMaxChannel));
+            }
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+static avifResult avifImageRGBToYUVFixedPoint(avifImage * image, const avifRGBImage * rgb, const avifReformatState * state)
+{
+    assert(state->yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS);
+    assert((image->depth <= 12) && (rgb->depth <= 12));
+    if (image->depth > 8) {
+        return (rgb->depth > 8) ? avifImageRGBAnyToYUVAnyFixedPoint(image, rgb, state, AVIF_TRUE, AVIF_TRUE)
+                                : avifImageRGBAnyToYUVAnyFixedPoint(image, rgb, state, AVIF_TRUE, AVIF_FALSE);
+    }
+    return (rgb->depth > 8) ? avifImageRGBAnyToYUVAnyFixedPoint(image, rgb, state, AVIF_FALSE, AVIF_TRUE)
+                            : avifImageRGBAnyToYUVAnyFixedPoint(image, rgb, state, AVIF_FALSE, AVIF_FALSE);
+}
 
+// Returns AVIF_TRUE if the pixels of rgb are stored in a way that the conversion kernels do not handle. Such images are
+// converted strip by strip through an unpacked avifRGBImage, see avifImageRGBToYUVUnpacked() and avifImageYUVToRGBStrips().
+static avifBool avifRGBImageNeedsUnpacking(const avifRGBImage * rgb, avifBool toRGB)
+{
+    if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        return AVIF_TRUE;
+    }
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        // The kernels write undithered RGB_565 directly.
+        return !toRGB || rgb->ditherRGB565;
+    }
+    // The kernels write half floats but only read integers.
+    return !toRGB && rgb->isFloat;
+}
+
+// Copies rgb into unpacked, with a layout the conversion kernels handle: AVIF_RGB_FORMAT_RGB for RGB_565,
+// AVIF_RGB_FORMAT_RGBA for RGBA1010102, both at the same depth, and 16-bit integers for floats. The pixels are neither
+// copied nor allocated.
+static void avifRGBImageSetUnpackedLayout(const avifRGBImage * rgb, avifRGBImage * unpacked)
+{
+    *unpacked = *rgb;
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        unpacked->format = AVIF_RGB_FORMAT_RGB;
+    } else if (rgb->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        unpacked->format = AVIF_RGB_FORMAT_RGBA;
+    } else if (rgb->isFloat) {
+        unpacked->depth = 16;
+        unpacked->isFloat = AVIF_FALSE;
+        unpacked->isLinear = AVIF_FALSE;
+    }
+    unpacked->maxThreads = 1;
+    unpacked->ditherRGB565 = AVIF_FALSE;
+    unpacked->pixels = NULL;
+    unpacked->rowBytes = 0;
+}
+
+// Checks that rgb can be converted to image and allocates the planes of image. state is prepared for the pixels read by
+// the conversion kernels, which are those of the unpacked layout if rgb needs unpacking.
+static avifResult avifImageRGBToYUVPrepare(avifImage * image, const avifRGBImage * rgb, avifReformatState * state)
+{
+    if (!rgb->pixels) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    if (rgb->isFloat && (((rgb->depth != 16) && (rgb->depth != 32)) || (rgb->format == AVIF_RGB_FORMAT_RGB_565) ||
+                         (rgb->format == AVIF_RGB_FORMAT_RGBA1010102))) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    avifRGBImage layout = *rgb;
+    if (avifRGBImageNeedsUnpacking(rgb, AVIF_FALSE)) {
+        avifRGBImageSetUnpackedLayout(rgb, &layout);
+    }
+    if (!avifPrepareReformatState(image, &layout, state)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
     const avifBool hasAlpha = avifRGBFormatHasAlpha(rgb->format) && !rgb->ignoreAlpha;
-    avifResult allocationResult = avifImageAllocatePlanes(image, hasAlpha ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
-    if (allocationResult != AVIF_RESULT_OK) {
-        return allocationResult;
+    return avifImageAllocatePlanes(image, hasAlpha ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+}
+
+static avifResult avifImageRGBToYUVUnpacked(avifImage * image, const avifRGBImage * rgb);
+
+static avifResult avifImageRGBToYUVImpl(avifImage * image, const avifRGBImage * rgb)
+{
+    avifReformatState state;
+    AVIF_CHECKRES(avifImageRGBToYUVPrepare(image, rgb, &state));
+
+    if (avifRGBImageNeedsUnpacking(rgb, AVIF_FALSE)) {
+        return avifImageRGBToYUVUnpacked(image, rgb);
     }
 
+    const avifBool hasAlpha = avifRGBFormatHasAlpha(rgb->format) && !rgb->ignoreAlpha;
     avifAlphaMultiplyMode alphaMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
     if (hasAlpha) {
         if (!rgb->alphaPremultiplied && image->alphaPremultiplied) {
@@ -254,8 +619,17 @@ avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb)
 
     avifBool converted = AVIF_FALSE;
 
-    // Try converting with libsharpyuv.
-    if ((rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV) && (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420)) {
+    if (rgb->fixedPoint) {
+        // The alpha (un)multiply would have to happen before the conversion, in floating point.
+        if ((alphaMode != AVIF_ALPHA_MULTIPLY_MODE_NO_OP) || !avifFixedPointSupported(image, rgb, &state, alphaMode) ||
+            (rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV)) {
+            return AVIF_RESULT_NOT_IMPLEMENTED;
+        }
+        AVIF_CHECKRES(avifImageRGBToYUVFixedPoint(image, rgb, &state));
+        converted = AVIF_TRUE;
+    } else if ((rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV) &&
+               (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420)) {
+        // Try converting with libsharpyuv.
         const avifResult libSharpYUVResult = avifImageRGBToYUVLibSharpYUV(image, rgb, &state);
         if (libSharpYUVResult != AVIF_RESULT_OK) {
             // Return the error if sharpyuv was requested but failed for any reason, including libsharpyuv not being available.
@@ -273,6 +647,23 @@ avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb)
         }
     }
 
+    if (!converted && (rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_FASTEST) &&
+        (alphaMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) && (state.yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) &&
+        (image->depth <= 12) && (rgb->depth <= 12)) {
+        // Tiled fixed-point conversion, see avifImageRGBToYUVFixedPoint().
+        AVIF_CHECKRES(avifImageRGBToYUVFixedPoint(image, rgb, &state));
+        converted = AVIF_TRUE;
+    }
+
+    if (!converted && (alphaMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) && (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444)) {
+        const avifResult fastResult = avifImageRGBToYUV444NonCoefficients(image, rgb, &state);
+        if (fastResult == AVIF_RESULT_OK) {
+            converted = AVIF_TRUE;
+        } else if (fastResult != AVIF_RESULT_NOT_IMPLEMENTED) {
+            return fastResult;
+        }
+    }
+
     if (!converted) {
         const float kr = state.yuv.kr;
         const float kg = state.yuv.kg;
@@ -581,6 +972,259 @@ static void avifGetRGB565(const uint8_t * ptrR, uint8_t * R, uint8_t * G, uint8_
     *B = (uint8_t)((b5 << 3) | (b5 >> 2));
 }
 
+// This constant comes from libyuv. For details, see here:
+// https://chromium.googlesource.com/libyuv/libyuv/+/2f87e9a7/source/row_common.cc#3537
+#define F16_MULTIPLIER 1.9259299444e-34f
+
+typedef union avifF16
+{
+    float f;
+    uint32_t u32;
+} avifF16;
+
+static inline uint16_t avifFloatToF16(float v)
+{
+    avifF16 f16;
+    f16.f = v * F16_MULTIPLIER;
+    return (uint16_t)(f16.u32 >> 13);
+}
+
+static inline float avifF16ToFloat(uint16_t v)
+{
+    avifF16 f16;
+    f16.u32 = v << 13;
+    return f16.f / F16_MULTIPLIER;
+}
+
+#define RGBA1010102(R, G, B, A) ((uint32_t)(R) | ((uint32_t)(G) << 10) | ((uint32_t)(B) << 20) | ((uint32_t)(A) << 30))
+
+// 4x4 Bayer matrix. Each threshold is scaled down to less than one quantization step when dithering to RGB_565.
+static const uint8_t avifBayer4x4[4][4] = { { 0, 8, 2, 10 }, { 12, 4, 14, 6 }, { 3, 11, 1, 9 }, { 15, 7, 13, 5 } };
+
+// Number of rows converted at once by avifImageRGBToYUVUnpacked() and avifImageYUVToRGBStrips().
+#define AVIF_RGB_STRIP_HEIGHT 64
+
+// Unpacks one row of width float samples into 16-bit integers. Values outside of [0, 1] (and NaNs) are clamped. If
+// toGamma is not NULL, the color samples are linear and encoded with it first; alpha samples never are.
+static void avifUnpackFloatRow(const avifRGBImage * rgb, const uint8_t * srcRow, uint16_t * dst16, avifTransferFunction toGamma)
+{
+    const uint32_t channelCount = avifRGBFormatChannelCount(rgb->format);
+    const avifBool hasAlpha = avifRGBFormatHasAlpha(rgb->format);
+    const uint32_t alphaIndex = ((rgb->format == AVIF_RGB_FORMAT_ARGB) || (rgb->format == AVIF_RGB_FORMAT_ABGR)) ? 0 : 3;
+    const uint16_t * src16 = (const uint16_t *)srcRow;
+    const float * src32 = (const float *)srcRow;
+    for (uint32_t i = 0; i < rgb->width * channelCount; ++i) {
+        float v;
+        if (rgb->depth == 16) {
+            // avifF16ToFloat() ignores the sign bit. All negative values are clamped to 0 anyway.
+            v = (src16[i] & 0x8000) ? 0.0f : avifF16ToFloat(src16[i]);
+        } else {
+            v = src32[i];
+        }
+        if (toGamma && (!hasAlpha || ((i % channelCount) != alphaIndex))) {
+            v = toGamma(v);
+        }
+        v = (v > 0.0f) ? AVIF_MIN(v, 1.0f) : 0.0f;
+        dst16[i] = (uint16_t)(v * 65535.0f + 0.5f);
+    }
+}
+
+// Unpacks rowCount rows of rgb, starting at row y, into the first rows of unpacked. See avifRGBImageSetUnpackedLayout().
+static void avifUnpackRGBRows(const avifRGBImage * rgb,
+                              uint32_t y,
+                              uint32_t rowCount,
+                              avifRGBImage * unpacked,
+                              avifTransferFunction toGamma)
+{
+    for (uint32_t j = 0; j < rowCount; ++j) {
+        const uint8_t * srcRow = &rgb->pixels[(size_t)(y + j) * rgb->rowBytes];
+        uint8_t * dstRow = &unpacked->pixels[(size_t)j * unpacked->rowBytes];
+        if (rgb->isFloat) {
+            avifUnpackFloatRow(rgb, srcRow, (uint16_t *)dstRow, toGamma);
+        } else if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+            for (uint32_t i = 0; i < rgb->width; ++i) {
+                avifGetRGB565(&srcRow[i * 2], &dstRow[i * 3 + 0], &dstRow[i * 3 + 1], &dstRow[i * 3 + 2]);
+            }
+        } else {
+            const uint32_t * src32 = (const uint32_t *)srcRow;
+            uint16_t * dst16 = (uint16_t *)dstRow;
+            for (uint32_t i = 0; i < rgb->width; ++i) {
+                const uint32_t pixel = src32[i];
+                dst16[i * 4 + 0] = (uint16_t)(pixel & 0x3FF);
+                dst16[i * 4 + 1] = (uint16_t)((pixel >> 10) & 0x3FF);
+                dst16[i * 4 + 2] = (uint16_t)((pixel >> 20) & 0x3FF);
+                dst16[i * 4 + 3] = (uint16_t)((pixel >> 30) * 341); // 3 * 341 = 1023
+            }
+        }
+    }
+}
+
+// Packs rowCount rows of unpacked, starting at row unpackedY, into the avifRGBImage rgbData starting at row y.
+static void avifPackRGBRows(const avifRGBImage * unpacked, uint32_t unpackedY, uint32_t rowCount, void * rgbData, uint32_t y)
+{
+    avifRGBImage * rgb = (avifRGBImage *)rgbData;
+    for (uint32_t j = 0; j < rowCount; ++j) {
+        const uint8_t * srcRow = &unpacked->pixels[(size_t)(unpackedY + j) * unpacked->rowBytes];
+        uint8_t * dstRow = &rgb->pixels[(size_t)(y + j) * rgb->rowBytes];
+        if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+            // Only reached with rgb->ditherRGB565. The thresholds are in [0, 7] for the 5-bit channels and in [0, 3] for the
+            // 6-bit channel. The dither pattern is anchored to the rows of rgb.
+            const uint8_t * thresholds = avifBayer4x4[(y + j) & 3];
+            uint16_t * dst16 = (uint16_t *)dstRow;
+            for (uint32_t i = 0; i < rgb->width; ++i) {
+                const int threshold = thresholds[i & 3];
+                const int R = AVIF_MIN(srcRow[i * 3 + 0] + (threshold >> 1), 255);
+                const int G = AVIF_MIN(srcRow[i * 3 + 1] + (threshold >> 2), 255);
+                const int B = AVIF_MIN(srcRow[i * 3 + 2] + (threshold >> 1), 255);
+                dst16[i] = RGB565(R, G, B);
+            }
+        } else {
+            const uint16_t * src16 = (const uint16_t *)srcRow;
+            uint32_t * dst32 = (uint32_t *)dstRow;
+            for (uint32_t i = 0; i < rgb->width; ++i) {
+                const uint32_t A = rgb->ignoreAlpha ? 3 : ((src16[i * 4 + 3] * 3u + 511u) / 1023u);
+                dst32[i] = RGBA1010102(src16[i * 4 + 0], src16[i * 4 + 1], src16[i * 4 + 2], A);
+            }
+        }
+    }
+}
+
+// Converts rgb to image strip by strip through an unpacked avifRGBImage. The planes of image are already allocated.
+static avifResult avifImageRGBToYUVUnpacked(avifImage * image, const avifRGBImage * rgb)
+{
+    // Strips have an even height so 2x2 chroma blocks never straddle two strips and the result is the same as a whole image
+    // conversion. libsharpyuv looks at the whole image, so it gets a single strip.
+    const uint32_t stripHeight =
+        (rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV) ? rgb->height : AVIF_RGB_STRIP_HEIGHT;
+    avifTransferFunction toGamma = NULL;
+    if (rgb->isFloat && rgb->isLinear) {
+        toGamma = avifTransferCharacteristicsGetLinearToGammaFunction(image->transferCharacteristics);
+    }
+
+    avifRGBImage unpacked;
+    avifRGBImageSetUnpackedLayout(rgb, &unpacked);
+    unpacked.height = AVIF_MIN(stripHeight, rgb->height);
+    AVIF_CHECKRES(avifRGBImageAllocatePixels(&unpacked));
+    avifImage view;
+    memset(&view, 0, sizeof(view));
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t y = 0; (result == AVIF_RESULT_OK) && (y < rgb->height); y += stripHeight) {
+        const avifCropRect rect = { 0, y, rgb->width, AVIF_MIN(stripHeight, rgb->height - y) };
+        result = avifImageSetViewRect(&view, image, &rect);
+        if (result == AVIF_RESULT_OK) {
+            avifUnpackRGBRows(rgb, y, rect.height, &unpacked, toGamma);
+            unpacked.height = rect.height;
+            result = avifImageRGBToYUVImpl(&view, &unpacked);
+            // The planes of the view belong to image, whatever avifImageAllocatePlanes() said.
+            view.imageOwnsYUVPlanes = AVIF_FALSE;
+            view.imageOwnsAlphaPlane = AVIF_FALSE;
+        }
+    }
+    avifRGBImageFreePixels(&unpacked);
+    return result;
+}
+
+static avifResult avifImageYUVToRGBImpl(const avifImage * image,
+                                        avifRGBImage * rgb,
+                                        avifReformatState * state,
+                                        avifAlphaMultiplyMode alphaMultiplyMode);
+
+// Converts rowCount rows of image, starting at row firstRow, strip by strip into an avifRGBImage with the format, depth and
+// settings of layout, and passes each strip to storeRows(). The strips stay in cache until they are stored in the layout the
+// caller actually wants.
+static avifResult avifImageYUVToRGBStrips(const avifImage * image,
+                                          const avifRGBImage * layout,
+                                          avifAlphaMultiplyMode alphaMultiplyMode,
+                                          avifStoreRGBRowsFunc storeRows,
+                                          void * storeData,
+                                          uint32_t firstRow,
+                                          uint32_t rowCount)
+{
+    // Bilinear upsampling of 4:2:0 reads the chroma rows above and below. Each strip is converted with one chroma row of
+    // context on both sides, and only its inner rows are stored, so that the result is the same as a whole image conversion.
+    // The context rows may be outside of [firstRow, firstRow + rowCount).
+    const uint32_t context = (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420) ? 2 : 0;
+    avifRGBImage strip = *layout;
+    strip.width = image->width;
+    strip.height = AVIF_MIN(AVIF_RGB_STRIP_HEIGHT + 2 * context, image->height);
+    strip.maxThreads = 1;
+    strip.pixels = NULL;
+    strip.rowBytes = 0;
+    AVIF_CHECKRES(avifRGBImageAllocatePixels(&strip));
+    avifResult result = AVIF_RESULT_OK;
+    avifReformatState state;
+    if (!avifPrepareReformatState(image, &strip, &state)) {
+        result = AVIF_RESULT_REFORMAT_FAILED;
+    }
+    avifImage view;
+    memset(&view, 0, sizeof(view));
+    const uint32_t endRow = firstRow + rowCount;
+    for (uint32_t y = firstRow; (result == AVIF_RESULT_OK) && (y < endRow); y += AVIF_RGB_STRIP_HEIGHT) {
+        const uint32_t stripRowCount = AVIF_MIN(AVIF_RGB_STRIP_HEIGHT, endRow - y);
+        const uint32_t above = AVIF_MIN(context, y);
+        const uint32_t below = AVIF_MIN(context, image->height - y - stripRowCount);
+        const avifCropRect rect = { 0, y - above, image->width, above + stripRowCount + below };
+        result = avifImageSetViewRect(&view, image, &rect);
+        if (result == AVIF_RESULT_OK) {
+            strip.height = rect.height;
+            result = avifImageYUVToRGBImpl(&view, &strip, &state, alphaMultiplyMode);
+        }
+        if (result == AVIF_RESULT_OK) {
+            storeRows(&strip, above, stripRowCount, storeData, y);
+        }
+    }
+    avifRGBImageFreePixels(&strip);
+    return result;
+}
+
+static avifResult avifRGBImageToF16(avifRGBImage * rgb)
+{
+    avifResult libyuvResult = AVIF_RESULT_NOT_IMPLEMENTED;
+    if (!rgb->avoidLibYUV) {
+        libyuvResult = avifRGBImageToF16LibYUV(rgb);
+    }
+    if (libyuvResult != AVIF_RESULT_NOT_IMPLEMENTED) {
+        return libyuvResult;
+    }
+    const uint32_t channelCount = avifRGBFormatChannelCount(rgb->format);
+    const float scale = 1.0f / ((1 << rgb->depth) - 1);
+    const float multiplier = F16_MULTIPLIER * scale;
+    uint16_t * pixelRowBase = (uint16_t *)rgb->pixels;
+    const uint32_t stride = rgb->rowBytes >> 1;
+    for (uint32_t j = 0; j < rgb->height; ++j) {
+        uint16_t * pixel = pixelRowBase;
+        for (uint32_t i = 0; i < rgb->width * channelCount; ++i, ++pixel) {
+            avifF16 f16;
+            f16.f = *pixel * multiplier;
+            *pixel = (uint16_t)(f16.u32 >> 13);
+        }
+        pixelRowBase += stride;
+    }
+    return AVIF_RESULT_OK;
+}
+
+// Applies the post-processing steps requested in state (see avifReformatState::toRGBAlphaMultiplyMode and
+// avifReformatState::toRGBHalfFloat) to row j of rgb, while it is still hot in the cache. Every step is per-pixel, so the
+// result is the same as running each of them once over the whole image.
+static avifResult avifRGBImageFinishRow(avifRGBImage * rgb, const avifReformatState * state, uint32_t j)
+{
+    if ((state->toRGBAlphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) && !state->toRGBHalfFloat) {
+        return AVIF_RESULT_OK;
+    }
+    avifRGBImage row = *rgb;
+    row.pixels = rgb->pixels + (size_t)j * rgb->rowBytes;
+    row.height = 1;
+    if (state->toRGBAlphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY) {
+        AVIF_CHECKRES(avifRGBImagePremultiplyAlpha(&row));
+    } else if (state->toRGBAlphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_UNMULTIPLY) {
+        AVIF_CHECKRES(avifRGBImageUnpremultiplyAlpha(&row));
+    }
+    if (state->toRGBHalfFloat) {
+        AVIF_CHECKRES(avifRGBImageToF16(&row));
+    }
+    return AVIF_RESULT_OK;
+}
+
 // Note: This function handles alpha (un)multiply.
 static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
                                               avifRGBImage * rgb,
@@ -617,7 +1261,8 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
     // to clang's analyzer.
     assert((alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) || aPlane);
 
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         // uvJ is used only when hasColor is true.
         const uint32_t uvJ = hasColor ? (j >> state->yuv.formatInfo.chromaShiftY) : 0;
         const uint8_t * ptrY8 = &yPlane[j * yRowBytes];
@@ -868,9 +1513,10 @@ static avifResult avifImageYUVAnyToRGBAnySlow(const avifImage * image,
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV16ToRGB16Color(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -885,7 +1531,8 @@ static avifResult avifImageYUV16ToRGB16Color(const avifImage * image, avifRGBIma
 
     const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint32_t uvJ = j >> state->yuv.formatInfo.chromaShiftY;
         const uint16_t * const ptrY = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         const uint16_t * const ptrU = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
@@ -922,9 +1569,10 @@ static avifResult avifImageYUV16ToRGB16Color(const avifImage * image, avifRGBIma
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV16ToRGB16Mono(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -938,7 +1586,8 @@ static avifResult avifImageYUV16ToRGB16Mono(const avifImage * image, avifRGBImag
 
     const uint16_t maxChannel = (uint16_t)state->yuv.maxChannel;
     const float maxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint16_t * const ptrY = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
         uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
@@ -968,9 +1617,10 @@ static avifResult avifImageYUV16ToRGB16Mono(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, NULL);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV16ToRGB8Color(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -985,7 +1635,8 @@ static avifResult avifImageYUV16ToRGB8Color(const avifImage * image, avifRGBImag
 
     const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint32_t uvJ = j >> state->yuv.formatInfo.chromaShiftY;
         const uint16_t * const ptrY = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         const uint16_t * const ptrU = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
@@ -1026,9 +1677,10 @@ static avifResult avifImageYUV16ToRGB8Color(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV16ToRGB8Mono(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -1042,7 +1694,8 @@ static avifResult avifImageYUV16ToRGB8Mono(const avifImage * image, avifRGBImage
 
     const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint16_t * const ptrY = (uint16_t *)&image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
         uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
@@ -1076,9 +1729,10 @@ static avifResult avifImageYUV16ToRGB8Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, NULL);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV8ToRGB16Color(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -1092,7 +1746,8 @@ static avifResult avifImageYUV8ToRGB16Color(const avifImage * image, avifRGBImag
     AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV, image->depth, state), AVIF_RESULT_OUT_OF_MEMORY);
 
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint32_t uvJ = j >> state->yuv.formatInfo.chromaShiftY;
         const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         const uint8_t * const ptrU = &image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
@@ -1124,9 +1779,10 @@ static avifResult avifImageYUV8ToRGB16Color(const avifImage * image, avifRGBImag
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV8ToRGB16Mono(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -1139,7 +1795,8 @@ static avifResult avifImageYUV8ToRGB16Mono(const avifImage * image, avifRGBImage
     AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, NULL, image->depth, state), AVIF_RESULT_OUT_OF_MEMORY);
 
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
         uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
@@ -1166,15 +1823,17 @@ static avifResult avifImageYUV8ToRGB16Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, NULL);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageIdentity8ToRGB8ColorFullRange(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
 {
     const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         const uint8_t * const ptrU = &image->yuvPlanes[AVIF_CHAN_U][(j * image->yuvRowBytes[AVIF_CHAN_U])];
         const uint8_t * const ptrV = &image->yuvPlanes[AVIF_CHAN_V][(j * image->yuvRowBytes[AVIF_CHAN_V])];
@@ -1200,8 +1859,9 @@ static avifResult avifImageIdentity8ToRGB8ColorFullRange(const avifImage * image
                 ptrB += rgbPixelBytes;
             }
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV8ToRGB8Color(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -1215,7 +1875,8 @@ static avifResult avifImageYUV8ToRGB8Color(const avifImage * image, avifRGBImage
     AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV, image->depth, state), AVIF_RESULT_OUT_OF_MEMORY);
 
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint32_t uvJ = j >> state->yuv.formatInfo.chromaShiftY;
         const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         const uint8_t * const ptrU = &image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
@@ -1251,9 +1912,10 @@ static avifResult avifImageYUV8ToRGB8Color(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
 static avifResult avifImageYUV8ToRGB8Mono(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
@@ -1266,7 +1928,8 @@ static avifResult avifImageYUV8ToRGB8Mono(const avifImage * image, avifRGBImage
     AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, NULL, image->depth, state), AVIF_RESULT_OUT_OF_MEMORY);
 
     const float rgbMaxChannelF = state->rgb.maxChannelF;
-    for (uint32_t j = 0; j < image->height; ++j) {
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
         const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
         uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
         uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
@@ -1297,56 +1960,573 @@ static avifResult avifImageYUV8ToRGB8Mono(const avifImage * image, avifRGBImage
             ptrG += rgbPixelBytes;
             ptrB += rgbPixelBytes;
         }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
     avifFreeYUVToRGBLookUpTables(&unormFloatTableY, NULL);
-    return AVIF_RESULT_OK;
+    return result;
 }
 
-// This constant comes from libyuv. For details, see here:
-// https://chromium.googlesource.com/libyuv/libyuv/+/2f87e9a7/source/row_common.cc#3537
-#define F16_MULTIPLIER 1.9259299444e-34f
+// Bilinear chroma upsampling (4:2:0 and 4:2:2) for AVIF_REFORMAT_MODE_YUV_COEFFICIENTS.
+//
+// This produces exactly the same output as the bilinear branch of avifImageYUVAnyToRGBAnySlow(): the same four nearest UV
+// samples are used with the same 9/16, 3/16, 3/16, 1/16 weights, and all float operations are evaluated in the same order.
+// The per-pixel edge checks are hoisted out of the inner loop by noticing that two horizontally adjacent pixels (2k+1, 2k+2)
+// always share the same two UV columns (k, k+1) with mirrored weights, so each UV sample is looked up once per pixel pair.
+//
+// yuv16, rgb16 and rgb565 are always passed as constants by the wrappers below, so that the compiler can specialize this
+// function for each combination of YUV depth, RGB depth and RGB format.
+static inline uint16_t avifLoadUNorm(const uint8_t * row, uint32_t x, avifBool yuv16, uint16_t yuvMaxChannel)
+{
+    if (yuv16) {
+        // clamp incoming data to protect against bad LUT lookups
+        return AVIF_MIN(((const uint16_t *)row)[x], yuvMaxChannel);
+    }
+    // no clamp necessary, the full uint8_t range is a legal lookup
+    return row[x];
+}
 
-typedef union avifF16
+static inline void avifStoreBilinearRGBPixel(float Y,
+                                             float Cb,
+                                             float Cr,
+                                             const avifReformatState * state,
+                                             float rgbMaxChannelF,
+                                             avifBool rgb16,
+                                             avifBool rgb565,
+                                             uint8_t * ptrR,
+                                             uint8_t * ptrG,
+                                             uint8_t * ptrB)
 {
-    float f;
-    uint32_t u32;
-} avifF16;
+    const float kr = state->yuv.kr;
+    const float kg = state->yuv.kg;
+    const float kb = state->yuv.kb;
 
-static avifResult avifRGBImageToF16(avifRGBImage * rgb)
+    const float R = Y + (2 * (1 - kr)) * Cr;
+    const float B = Y + (2 * (1 - kb)) * Cb;
+    const float G = Y - ((2 * ((kr * (1 - kr) * Cr) + (kb * (1 - kb) * Cb))) / kg);
+    const float Rc = AVIF_CLAMP(R, 0.0f, 1.0f);
+    const float Gc = AVIF_CLAMP(G, 0.0f, 1.0f);
+    const float Bc = AVIF_CLAMP(B, 0.0f, 1.0f);
+
+    if (rgb16) {
+        *((uint16_t *)ptrR) = (uint16_t)(0.5f + (Rc * rgbMaxChannelF));
+        *((uint16_t *)ptrG) = (uint16_t)(0.5f + (Gc * rgbMaxChannelF));
+        *((uint16_t *)ptrB) = (uint16_t)(0.5f + (Bc * rgbMaxChannelF));
+    } else if (rgb565) {
+        *(uint16_t *)ptrR = RGB565((uint8_t)(0.5f + (Rc * rgbMaxChannelF)),
+                                   (uint8_t)(0.5f + (Gc * rgbMaxChannelF)),
+                                   (uint8_t)(0.5f + (Bc * rgbMaxChannelF)));
+    } else {
+        *ptrR = (uint8_t)(0.5f + (Rc * rgbMaxChannelF));
+        *ptrG = (uint8_t)(0.5f + (Gc * rgbMaxChannelF));
+        *ptrB = (uint8_t)(0.5f + (Bc * rgbMaxChannelF));
+    }
+}
+
+static inline avifResult avifImageYUVAnyToRGBAnyBilinear(const avifImage * image,
+                                                         avifRGBImage * rgb,
+                                                         const avifReformatState * state,
+                                                         avifBool yuv16,
+                                                         avifBool rgb16,
+                                                         avifBool rgb565)
 {
-    avifResult libyuvResult = AVIF_RESULT_NOT_IMPLEMENTED;
-    if (!rgb->avoidLibYUV) {
-        libyuvResult = avifRGBImageToF16LibYUV(rgb);
+    float * unormFloatTableY = NULL;
+    float * unormFloatTableUV = NULL;
+    AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV, image->depth, state), AVIF_RESULT_OUT_OF_MEMORY);
+
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
+    const float rgbMaxChannelF = state->rgb.maxChannelF;
+    const uint32_t uRowBytes = image->yuvRowBytes[AVIF_CHAN_U];
+    const uint32_t vRowBytes = image->yuvRowBytes[AVIF_CHAN_V];
+    const avifBool is422 = (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV422);
+
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
+        // Closest UV row and adjacent UV row (see avifImageYUVAnyToRGBAnySlow() for the full explanation).
+        const uint32_t uvJ = j >> state->yuv.formatInfo.chromaShiftY;
+        uint32_t uvJAdj = uvJ;
+        if (!is422 && (j != 0) && !((j == (image->height - 1)) && ((j % 2) != 0))) {
+            uvJAdj = ((j % 2) != 0) ? (uvJ + 1) : (uvJ - 1);
+        }
+        const uint8_t * ptrY = &image->yuvPlanes[AVIF_CHAN_Y][j * image->yuvRowBytes[AVIF_CHAN_Y]];
+        const uint8_t * ptrU0 = &image->yuvPlanes[AVIF_CHAN_U][uvJ * uRowBytes];
+        const uint8_t * ptrV0 = &image->yuvPlanes[AVIF_CHAN_V][uvJ * vRowBytes];
+        const uint8_t * ptrU1 = &image->yuvPlanes[AVIF_CHAN_U][uvJAdj * uRowBytes];
+        const uint8_t * ptrV1 = &image->yuvPlanes[AVIF_CHAN_V][uvJAdj * vRowBytes];
+        uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+
+        uint32_t i = 0;
+        while (i < image->width) {
+            const uint32_t uvI = i >> 1;
+            const float Y0 = unormFloatTableY[avifLoadUNorm(ptrY, i, yuv16, yuvMaxChannel)];
+
+            // Closest UV column (k) samples for the closest and adjacent UV rows.
+            const float u00 = unormFloatTableUV[avifLoadUNorm(ptrU0, uvI, yuv16, yuvMaxChannel)];
+            const float v00 = unormFloatTableUV[avifLoadUNorm(ptrV0, uvI, yuv16, yuvMaxChannel)];
+            const float u01 = unormFloatTableUV[avifLoadUNorm(ptrU1, uvI, yuv16, yuvMaxChannel)];
+            const float v01 = unormFloatTableUV[avifLoadUNorm(ptrV1, uvI, yuv16, yuvMaxChannel)];
+
+            if ((i == 0) || ((i + 1) == image->width)) {
+                // First column, or last column of an even width: the adjacent column is the closest column.
+                const float Cb = (u00 * (9.0f / 16.0f)) + (u00 * (3.0f / 16.0f)) + (u01 * (3.0f / 16.0f)) + (u01 * (1.0f / 16.0f));
+                const float Cr = (v00 * (9.0f / 16.0f)) + (v00 * (3.0f / 16.0f)) + (v01 * (3.0f / 16.0f)) + (v01 * (1.0f / 16.0f));
+                avifStoreBilinearRGBPixel(Y0, Cb, Cr, state, rgbMaxChannelF, rgb16, rgb565, ptrR, ptrG, ptrB);
+                ptrR += rgbPixelBytes;
+                ptrG += rgbPixelBytes;
+                ptrB += rgbPixelBytes;
+                ++i;
+                continue;
+            }
+
+            // Odd pixel i = 2k+1 and even pixel i+1 = 2k+2 both use UV columns k and k+1.
+            const float Y1 = unormFloatTableY[avifLoadUNorm(ptrY, i + 1, yuv16, yuvMaxChannel)];
+            const float u10 = unormFloatTableUV[avifLoadUNorm(ptrU0, uvI + 1, yuv16, yuvMaxChannel)];
+            const float v10 = unormFloatTableUV[avifLoadUNorm(ptrV0, uvI + 1, yuv16, yuvMaxChannel)];
+            const float u11 = unormFloatTableUV[avifLoadUNorm(ptrU1, uvI + 1, yuv16, yuvMaxChannel)];
+            const float v11 = unormFloatTableUV[avifLoadUNorm(ptrV1, uvI + 1, yuv16, yuvMaxChannel)];
+
+            const float Cb0 = (u00 * (9.0f / 16.0f)) + (u10 * (3.0f / 16.0f)) + (u01 * (3.0f / 16.0f)) + (u11 * (1.0f / 16.0f));
+            const float Cr0 = (v00 * (9.0f / 16.0f)) + (v10 * (3.0f / 16.0f)) + (v01 * (3.0f / 16.0f)) + (v11 * (1.0f / 16.0f));
+            avifStoreBilinearRGBPixel(Y0, Cb0, Cr0, state, rgbMaxChannelF, rgb16, rgb565, ptrR, ptrG, ptrB);
+            ptrR += rgbPixelBytes;
+            ptrG += rgbPixelBytes;
+            ptrB += rgbPixelBytes;
+
+            const float Cb1 = (u10 * (9.0f / 16.0f)) + (u00 * (3.0f / 16.0f)) + (u11 * (3.0f / 16.0f)) + (u01 * (1.0f / 16.0f));
+            const float Cr1 = (v10 * (9.0f / 16.0f)) + (v00 * (3.0f / 16.0f)) + (v11 * (3.0f / 16.0f)) + (v01 * (1.0f / 16.0f));
+            avifStoreBilinearRGBPixel(Y1, Cb1, Cr1, state, rgbMaxChannelF, rgb16, rgb565, ptrR, ptrG, ptrB);
+            ptrR += rgbPixelBytes;
+            ptrG += rgbPixelBytes;
+            ptrB += rgbPixelBytes;
+            i += 2;
+        }
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
-    if (libyuvResult != AVIF_RESULT_NOT_IMPLEMENTED) {
-        return libyuvResult;
+    avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
+    return result;
+}
+
+static avifResult avifImageYUV16ToRGB16ColorBilinear(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_TRUE, /*rgb16=*/AVIF_TRUE, /*rgb565=*/AVIF_FALSE);
+}
+
+static avifResult avifImageYUV16ToRGB8ColorBilinear(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_TRUE, /*rgb16=*/AVIF_FALSE, /*rgb565=*/AVIF_TRUE);
     }
-    const uint32_t channelCount = avifRGBFormatChannelCount(rgb->format);
-    const float scale = 1.0f / ((1 << rgb->depth) - 1);
-    const float multiplier = F16_MULTIPLIER * scale;
-    uint16_t * pixelRowBase = (uint16_t *)rgb->pixels;
-    const uint32_t stride = rgb->rowBytes >> 1;
-    for (uint32_t j = 0; j < rgb->height; ++j) {
-        uint16_t * pixel = pixelRowBase;
-        for (uint32_t i = 0; i < rgb->width * channelCount; ++i, ++pixel) {
-            avifF16 f16;
-            f16.f = *pixel * multiplier;
-            *pixel = (uint16_t)(f16.u32 >> 13);
+    return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_TRUE, /*rgb16=*/AVIF_FALSE, /*rgb565=*/AVIF_FALSE);
+}
+
+static avifResult avifImageYUV8ToRGB16ColorBilinear(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_FALSE, /*rgb16=*/AVIF_TRUE, /*rgb565=*/AVIF_FALSE);
+}
+
+static avifResult avifImageYUV8ToRGB8ColorBilinear(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_FALSE, /*rgb16=*/AVIF_FALSE, /*rgb565=*/AVIF_TRUE);
+    }
+    return avifImageYUVAnyToRGBAnyBilinear(image, rgb, state, /*yuv16=*/AVIF_FALSE, /*rgb16=*/AVIF_FALSE, /*rgb565=*/AVIF_FALSE);
+}
+
+// Fast paths for AVIF_REFORMAT_MODE_IDENTITY (4:4:4) and AVIF_REFORMAT_MODE_YCGCO, AVIF_REFORMAT_MODE_YCGCO_RE/RO
+// (nearest or no chroma upsampling) at any YUV and RGB depth. Like the other built-in routines, they give exactly the same
+// output as avifImageYUVAnyToRGBAnySlow().
+//
+// yuv16, rgb16 and rgb565 are always passed as constants by avifImageIdentityToRGBColor() and avifImageYCgCoToRGBColor(),
+// so that the compiler can specialize the inner loops.
+static inline void avifStoreRGBAnyPixel(uint16_t R,
+                                        uint16_t G,
+                                        uint16_t B,
+                                        avifBool rgb16,
+                                        avifBool rgb565,
+                                        uint8_t * ptrR,
+                                        uint8_t * ptrG,
+                                        uint8_t * ptrB)
+{
+    if (rgb16) {
+        *((uint16_t *)ptrR) = R;
+        *((uint16_t *)ptrG) = G;
+        *((uint16_t *)ptrB) = B;
+    } else if (rgb565) {
+        *(uint16_t *)ptrR = RGB565((uint8_t)R, (uint8_t)G, (uint8_t)B);
+    } else {
+        *ptrR = (uint8_t)R;
+        *ptrG = (uint8_t)G;
+        *ptrB = (uint8_t)B;
+    }
+}
+
+static inline avifResult avifImageIdentityAnyToRGBAnyColor(const avifImage * image,
+                                                           avifRGBImage * rgb,
+                                                           const avifReformatState * state,
+                                                           avifBool yuv16,
+                                                           avifBool rgb16,
+                                                           avifBool rgb565)
+{
+    // Identity (GBR) is a plain per-channel remapping, so precompute it for every possible YUV sample value.
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
+    const float rgbMaxChannelF = state->rgb.maxChannelF;
+    uint16_t * unormToRGB = avifAlloc(((size_t)yuvMaxChannel + 1) * sizeof(uint16_t));
+    AVIF_CHECKERR(unormToRGB, AVIF_RESULT_OUT_OF_MEMORY);
+    for (uint32_t cp = 0; cp <= yuvMaxChannel; ++cp) {
+        const float v = ((float)cp - state->yuv.biasY) / state->yuv.rangeY;
+        unormToRGB[cp] = (uint16_t)(0.5f + (AVIF_CLAMP(v, 0.0f, 1.0f) * rgbMaxChannelF));
+    }
+
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
+        const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
+        const uint8_t * const ptrU = &image->yuvPlanes[AVIF_CHAN_U][(j * image->yuvRowBytes[AVIF_CHAN_U])];
+        const uint8_t * const ptrV = &image->yuvPlanes[AVIF_CHAN_V][(j * image->yuvRowBytes[AVIF_CHAN_V])];
+        uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+        for (uint32_t i = 0; i < image->width; ++i) {
+            // Formulas 41,42,43 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+            avifStoreRGBAnyPixel(unormToRGB[avifLoadUNorm(ptrV, i, yuv16, yuvMaxChannel)],
+                                 unormToRGB[avifLoadUNorm(ptrY, i, yuv16, yuvMaxChannel)],
+                                 unormToRGB[avifLoadUNorm(ptrU, i, yuv16, yuvMaxChannel)],
+                                 rgb16,
+                                 rgb565,
+                                 ptrR,
+                                 ptrG,
+                                 ptrB);
+            ptrR += rgbPixelBytes;
+            ptrG += rgbPixelBytes;
+            ptrB += rgbPixelBytes;
         }
-        pixelRowBase += stride;
+        result = avifRGBImageFinishRow(rgb, state, j);
     }
-    return AVIF_RESULT_OK;
+    avifFree(unormToRGB);
+    return result;
+}
+
+static inline avifResult avifImageYCgCoAnyToRGBAnyColor(const avifImage * image,
+                                                        avifRGBImage * rgb,
+                                                        const avifReformatState * state,
+                                                        avifBool yuv16,
+                                                        avifBool rgb16,
+                                                        avifBool rgb565)
+{
+#if defined(AVIF_ENABLE_EXPERIMENTAL_YCGCO_R)
+    const avifBool reversible = (state->yuv.mode == AVIF_REFORMAT_MODE_YCGCO_RE) ||
+                                (state->yuv.mode == AVIF_REFORMAT_MODE_YCGCO_RO);
+#else
+    const avifBool reversible = AVIF_FALSE;
+#endif
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
+    const int rgbMaxChannel = (int)state->rgb.maxChannel;
+    const float rgbMaxChannelF = state->rgb.maxChannelF;
+    const int biasUV = 1 << (image->depth - 1);
+    const uint32_t chromaShiftX = state->yuv.formatInfo.chromaShiftX;
+    const uint32_t chromaShiftY = state->yuv.formatInfo.chromaShiftY;
+
+    float * unormFloatTableY = NULL;
+    float * unormFloatTableUV = NULL;
+    if (!reversible) {
+        AVIF_CHECKERR(avifCreateYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV, image->depth, state),
+                      AVIF_RESULT_OUT_OF_MEMORY);
+    }
+
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
+        const uint32_t uvJ = j >> chromaShiftY;
+        const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
+        const uint8_t * const ptrU = &image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
+        const uint8_t * const ptrV = &image->yuvPlanes[AVIF_CHAN_V][(uvJ * image->yuvRowBytes[AVIF_CHAN_V])];
+        uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+        if (reversible) {
+            for (uint32_t i = 0; i < image->width; ++i) {
+                // Formulas from JVET-U0093, in integers. The YUV range is always full.
+                const uint32_t uvI = i >> chromaShiftX;
+                const int Y = avifLoadUNorm(ptrY, i, yuv16, yuvMaxChannel);
+                const int Cg = avifLoadUNorm(ptrU, uvI, yuv16, yuvMaxChannel) - biasUV;
+                const int Co = avifLoadUNorm(ptrV, uvI, yuv16, yuvMaxChannel) - biasUV;
+                const int t = Y - (Cg >> 1);
+                const int G = AVIF_CLAMP(t + Cg, 0, rgbMaxChannel);
+                const int B = AVIF_CLAMP(t - (Co >> 1), 0, rgbMaxChannel);
+                const int R = AVIF_CLAMP(B + Co, 0, rgbMaxChannel);
+                avifStoreRGBAnyPixel((uint16_t)R, (uint16_t)G, (uint16_t)B, rgb16, rgb565, ptrR, ptrG, ptrB);
+                ptrR += rgbPixelBytes;
+                ptrG += rgbPixelBytes;
+                ptrB += rgbPixelBytes;
+            }
+        } else {
+            for (uint32_t i = 0; i < image->width; ++i) {
+                // YCgCo: Formulas 47,48,49,50 from https://www.itu.int/rec/T-REC-H.273-201612-I/en
+                const uint32_t uvI = i >> chromaShiftX;
+                const float Y = unormFloatTableY[avifLoadUNorm(ptrY, i, yuv16, yuvMaxChannel)];
+                const float Cb = unormFloatTableUV[avifLoadUNorm(ptrU, uvI, yuv16, yuvMaxChannel)];
+                const float Cr = unormFloatTableUV[avifLoadUNorm(ptrV, uvI, yuv16, yuvMaxChannel)];
+                const float t = Y - Cb;
+                const float G = Y + Cb;
+                const float B = t - Cr;
+                const float R = t + Cr;
+                avifStoreRGBAnyPixel((uint16_t)(0.5f + (AVIF_CLAMP(R, 0.0f, 1.0f) * rgbMaxChannelF)),
+                                     (uint16_t)(0.5f + (AVIF_CLAMP(G, 0.0f, 1.0f) * rgbMaxChannelF)),
+                                     (uint16_t)(0.5f + (AVIF_CLAMP(B, 0.0f, 1.0f) * rgbMaxChannelF)),
+                                     rgb16,
+                                     rgb565,
+                                     ptrR,
+                                     ptrG,
+                                     ptrB);
+                ptrR += rgbPixelBytes;
+                ptrG += rgbPixelBytes;
+                ptrB += rgbPixelBytes;
+            }
+        }
+        result = avifRGBImageFinishRow(rgb, state, j);
+    }
+    if (!reversible) {
+        avifFreeYUVToRGBLookUpTables(&unormFloatTableY, &unormFloatTableUV);
+    }
+    return result;
+}
+
+static avifResult avifImageIdentityToRGBColor(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    const avifBool yuv16 = image->depth > 8;
+    if (rgb->depth > 8) {
+        return yuv16 ? avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_TRUE, AVIF_FALSE)
+                     : avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_TRUE, AVIF_FALSE);
+    }
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        return yuv16 ? avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_TRUE)
+                     : avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_TRUE);
+    }
+    return yuv16 ? avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_FALSE)
+                 : avifImageIdentityAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_FALSE);
+}
+
+static avifResult avifImageYCgCoToRGBColor(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    const avifBool yuv16 = image->depth > 8;
+    if (rgb->depth > 8) {
+        return yuv16 ? avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_TRUE, AVIF_FALSE)
+                     : avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_TRUE, AVIF_FALSE);
+    }
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        return yuv16 ? avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_TRUE)
+                     : avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_TRUE);
+    }
+    return yuv16 ? avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_FALSE)
+                 : avifImageYCgCoAnyToRGBAnyColor(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_FALSE);
+}
+
+// Fixed-point YUV->RGB for AVIF_REFORMAT_MODE_YUV_COEFFICIENTS, used when avifRGBImage::fixedPoint is set. Depths are at
+// most 12 bits. With P = 25 - rgb->depth, every output sample is computed with 32-bit integers only, as follows:
+//
+//   Y' = Y - biasY                                   (biasY = 16 << (depth - 8) for limited range, 0 for full range)
+//   U16 = 16 * U                                     (nearest or no chroma upsampling)
+//   U16 = 9 * U[0][0] + 3 * U[1][0] + 3 * U[0][1] + U[1][1]   (bilinear, same samples as avifImageYUVAnyToRGBAnySlow())
+//   U' = U16 - 16 * biasUV                           (same for V', biasUV = 1 << (depth - 1))
+//   R = (16 * cY * Y' + cRV * V' + 2^(P+3)) >> (P+4)
+//   G = (16 * cY * Y' + cGU * U' + cGV * V' + 2^(P+3)) >> (P+4)
+//   B = (16 * cY * Y' + cBU * U' + 2^(P+3)) >> (P+4)
+//
+// clamped to [0:rgbMaxChannel] (a negative sum gives 0). The coefficients are the float ones rounded to the nearest
+// integer after multiplication by rgbMaxChannel * 2^P / rangeY or rgbMaxChannel * 2^P / rangeUV (computed in double
+// precision): cY = 1, cRV = 2 * (1 - kr), cGU = -2 * kb * (1 - kb) / kg, cGV = -2 * kr * (1 - kr) / kg,
+// cBU = 2 * (1 - kb). No intermediate value exceeds 2^31 in magnitude.
+//
+// If alpha has to be (un)multiplied, each of R, G and B is then replaced by (with A the alpha sample, already in rgb)
+//
+//   premultiply:   (C * A + (rgbMaxChannel - 1) / 2) / rgbMaxChannel
+//   unpremultiply: min((C * rgbMaxChannel + A / 2) / A, rgbMaxChannel)   (0 if A is 0)
+//
+// which is the rounding of avifRGBImagePremultiplyAlpha() and avifRGBImageUnpremultiplyAlpha() without libyuv.
+typedef struct avifYUVToRGBFixedPoint
+{
+    int32_t y, rv, gu, gv, bu;
+    int32_t biasY, biasUV;
+    uint32_t shift; // P + 4
+} avifYUVToRGBFixedPoint;
+
+static void avifPrepareYUVToRGBFixedPoint(const avifRGBImage * rgb, const avifReformatState * state, avifYUVToRGBFixedPoint * fp)
+{
+    const uint32_t precision = 25 - rgb->depth;
+    const double kr = state->yuv.kr;
+    const double kg = state->yuv.kg;
+    const double kb = state->yuv.kb;
+    const double scaleY = state->rgb.maxChannel * (double)(1 << precision) / state->yuv.rangeY;
+    const double scaleUV = state->rgb.maxChannel * (double)(1 << precision) / state->yuv.rangeUV;
+    fp->y = (int32_t)floor(scaleY + 0.5);
+    fp->rv = (int32_t)floor(2 * (1 - kr) * scaleUV + 0.5);
+    fp->gu = (int32_t)floor(-2 * kb * (1 - kb) / kg * scaleUV + 0.5);
+    fp->gv = (int32_t)floor(-2 * kr * (1 - kr) / kg * scaleUV + 0.5);
+    fp->bu = (int32_t)floor(2 * (1 - kb) * scaleUV + 0.5);
+    fp->biasY = (int32_t)state->yuv.biasY;
+    fp->biasUV = (int32_t)state->yuv.biasUV;
+    fp->shift = precision + 4;
+}
+
+static inline uint16_t avifYUVToRGBFixedPointToUNorm(int32_t acc, uint32_t shift, int32_t maxChannel)
+{
+    if (acc < 0) {
+        return 0;
+    }
+    const int32_t unorm = acc >> shift;
+    return (uint16_t)AVIF_MIN(unorm, maxChannel);
+}
+
+static inline uint16_t avifFixedPointMultiplyAlpha(uint16_t c,
+                                                   uint32_t a,
+                                                   avifAlphaMultiplyMode alphaMultiplyMode,
+                                                   uint32_t maxChannel)
+{
+    if (a >= maxChannel) {
+        return c;
+    }
+    if (alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY) {
+        return (uint16_t)((c * a + (maxChannel - 1) / 2) / maxChannel);
+    }
+    if (a == 0) {
+        return 0;
+    }
+    return (uint16_t)AVIF_MIN((c * maxChannel + a / 2) / a, maxChannel);
+}
+
+static inline avifResult avifImageYUVAnyToRGBAnyFixedPoint(const avifImage * image,
+                                                           avifRGBImage * rgb,
+                                                           const avifReformatState * state,
+                                                           avifBool yuv16,
+                                                           avifBool rgb16,
+                                                           avifBool rgb565)
+{
+    avifYUVToRGBFixedPoint fp;
+    avifPrepareYUVToRGBFixedPoint(rgb, state, &fp);
+
+    const uint16_t yuvMaxChannel = (uint16_t)state->yuv.maxChannel;
+    const int32_t rgbMaxChannel = (int32_t)state->rgb.maxChannel;
+    const uint32_t rgbPixelBytes = state->rgb.pixelBytes;
+    const avifBool hasColor = (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400);
+    const uint32_t chromaShiftX = hasColor ? state->yuv.formatInfo.chromaShiftX : 0;
+    const uint32_t chromaShiftY = hasColor ? state->yuv.formatInfo.chromaShiftY : 0;
+    const avifBool bilinear = hasColor && ((chromaShiftX != 0) || (chromaShiftY != 0)) &&
+                              (rgb->chromaUpsampling != AVIF_CHROMA_UPSAMPLING_FASTEST) &&
+                              (rgb->chromaUpsampling != AVIF_CHROMA_UPSAMPLING_NEAREST);
+    const int32_t round = 1 << (fp.shift - 1);
+    const uint32_t uvWidth = (image->width + chromaShiftX) >> chromaShiftX;
+    const uint32_t uvHeight = (image->height + chromaShiftY) >> chromaShiftY;
+    // The alpha (un)multiply is done below in integers, not by avifRGBImageFinishRow().
+    const avifAlphaMultiplyMode alphaMultiplyMode = state->toRGBAlphaMultiplyMode;
+    avifReformatState finishState = *state;
+    finishState.toRGBAlphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t j = 0; (j < image->height) && (result == AVIF_RESULT_OK); ++j) {
+        const uint32_t uvJ = j >> chromaShiftY;
+        // Adjacent UV row for bilinear upsampling, as in avifImageYUVAnyToRGBAnySlow().
+        uint32_t uvJAdj = uvJ;
+        if ((chromaShiftY != 0) && (j != 0) && !((j == image->height - 1) && ((j % 2) != 0))) {
+            uvJAdj = ((j % 2) != 0) ? AVIF_MIN(uvJ + 1, uvHeight - 1) : uvJ - 1;
+        }
+        const uint8_t * const ptrY = &image->yuvPlanes[AVIF_CHAN_Y][(j * image->yuvRowBytes[AVIF_CHAN_Y])];
+        const uint8_t * ptrU0 = NULL;
+        const uint8_t * ptrV0 = NULL;
+        const uint8_t * ptrU1 = NULL;
+        const uint8_t * ptrV1 = NULL;
+        if (hasColor) {
+            ptrU0 = &image->yuvPlanes[AVIF_CHAN_U][(uvJ * image->yuvRowBytes[AVIF_CHAN_U])];
+            ptrV0 = &image->yuvPlanes[AVIF_CHAN_V][(uvJ * image->yuvRowBytes[AVIF_CHAN_V])];
+            ptrU1 = &image->yuvPlanes[AVIF_CHAN_U][(uvJAdj * image->yuvRowBytes[AVIF_CHAN_U])];
+            ptrV1 = &image->yuvPlanes[AVIF_CHAN_V][(uvJAdj * image->yuvRowBytes[AVIF_CHAN_V])];
+        }
+        uint8_t * ptrR = &rgb->pixels[state->rgb.offsetBytesR + (j * rgb->rowBytes)];
+        uint8_t * ptrG = &rgb->pixels[state->rgb.offsetBytesG + (j * rgb->rowBytes)];
+        uint8_t * ptrB = &rgb->pixels[state->rgb.offsetBytesB + (j * rgb->rowBytes)];
+        const uint8_t * ptrA = &rgb->pixels[state->rgb.offsetBytesA + (j * rgb->rowBytes)];
+
+        for (uint32_t i = 0; i < image->width; ++i) {
+            const int32_t accY = 16 * fp.y * ((int32_t)avifLoadUNorm(ptrY, i, yuv16, yuvMaxChannel) - fp.biasY) + round;
+            int32_t U16 = 0;
+            int32_t V16 = 0;
+            if (hasColor) {
+                const uint32_t uvI = i >> chromaShiftX;
+                if (bilinear) {
+                    // Adjacent UV column, as in avifImageYUVAnyToRGBAnySlow().
+                    uint32_t uvIAdj = uvI;
+                    if ((chromaShiftX != 0) && (i != 0) && !((i == image->width - 1) && ((i % 2) != 0))) {
+                        uvIAdj = ((i % 2) != 0) ? AVIF_MIN(uvI + 1, uvWidth - 1) : uvI - 1;
+                    }
+                    U16 = 9 * avifLoadUNorm(ptrU0, uvI, yuv16, yuvMaxChannel) +
+                          3 * avifLoadUNorm(ptrU0, uvIAdj, yuv16, yuvMaxChannel) +
+                          3 * avifLoadUNorm(ptrU1, uvI, yuv16, yuvMaxChannel) +
+                          avifLoadUNorm(ptrU1, uvIAdj, yuv16, yuvMaxChannel);
+                    V16 = 9 * avifLoadUNorm(ptrV0, uvI, yuv16, yuvMaxChannel) +
+                          3 * avifLoadUNorm(ptrV0, uvIAdj, yuv16, yuvMaxChannel) +
+                          3 * avifLoadUNorm(ptrV1, uvI, yuv16, yuvMaxChannel) +
+                          avifLoadUNorm(ptrV1, uvIAdj, yuv16, yuvMaxChannel);
+                } else {
+                    U16 = 16 * avifLoadUNorm(ptrU0, uvI, yuv16, yuvMaxChannel);
+                    V16 = 16 * avifLoadUNorm(ptrV0, uvI, yuv16, yuvMaxChannel);
+                }
+                U16 -= 16 * fp.biasUV;
+                V16 -= 16 * fp.biasUV;
+            }
+            uint16_t R = avifYUVToRGBFixedPointToUNorm(accY + fp.rv * V16, fp.shift, rgbMaxChannel);
+            uint16_t G = avifYUVToRGBFixedPointToUNorm(accY + fp.gu * U16 + fp.gv * V16, fp.shift, rgbMaxChannel);
+            uint16_t B = avifYUVToRGBFixedPointToUNorm(accY + fp.bu * U16, fp.shift, rgbMaxChannel);
+            if (alphaMultiplyMode != AVIF_ALPHA_MULTIPLY_MODE_NO_OP) {
+                const uint32_t A = rgb16 ? *((const uint16_t *)ptrA) : *ptrA;
+                R = avifFixedPointMultiplyAlpha(R, A, alphaMultiplyMode, (uint32_t)rgbMaxChannel);
+                G = avifFixedPointMultiplyAlpha(G, A, alphaMultiplyMode, (uint32_t)rgbMaxChannel);
+                B = avifFixedPointMultiplyAlpha(B, A, alphaMultiplyMode, (uint32_t)rgbMaxChannel);
+            }
+            avifStoreRGBAnyPixel(R, G, B, rgb16, rgb565, ptrR, ptrG, ptrB);
+            ptrR += rgbPixelBytes;
+            ptrG += rgbPixelBytes;
+            ptrB += rgbPixelBytes;
+            ptrA += rgbPixelBytes;
+        }
+        result = avifRGBImageFinishRow(rgb, &finishState, j);
+    }
+    return result;
+}
+
+static avifResult avifImageYUVToRGBFixedPoint(const avifImage * image, avifRGBImage * rgb, avifReformatState * state)
+{
+    assert(state->yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS);
+    assert((image->depth <= 12) && (rgb->depth <= 12));
+    const avifBool yuv16 = image->depth > 8;
+    if (rgb->depth > 8) {
+        return yuv16 ? avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_TRUE, AVIF_TRUE, AVIF_FALSE)
+                     : avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_FALSE, AVIF_TRUE, AVIF_FALSE);
+    }
+    if (rgb->format == AVIF_RGB_FORMAT_RGB_565) {
+        return yuv16 ? avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_TRUE)
+                     : avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_TRUE);
+    }
+    return yuv16 ? avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_TRUE, AVIF_FALSE, AVIF_FALSE)
+                 : avifImageYUVAnyToRGBAnyFixedPoint(image, rgb, state, AVIF_FALSE, AVIF_FALSE, AVIF_FALSE);
 }
 
 static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage * rgb, avifReformatState * state, avifAlphaMultiplyMode alphaMultiplyMode)
 {
+    if (avifRGBImageNeedsUnpacking(rgb, AVIF_TRUE)) {
+        avifRGBImage unpacked;
+        avifRGBImageSetUnpackedLayout(rgb, &unpacked);
+        return avifImageYUVToRGBStrips(image, &unpacked, alphaMultiplyMode, avifPackRGBRows, rgb, 0, image->height);
+    }
+
     avifBool convertedWithLibYUV = AVIF_FALSE;
     // Reformat alpha, if user asks for it, or (un)multiply processing needs it.
     avifBool reformatAlpha = avifRGBFormatHasAlpha(rgb->format) &&
                              (!rgb->ignoreAlpha || (alphaMultiplyMode != AVIF_ALPHA_MULTIPLY_MODE_NO_OP));
     // This value is used only when reformatAlpha is true.
     avifBool alphaReformattedWithLibYUV = AVIF_FALSE;
-    if (!rgb->avoidLibYUV && ((alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) || avifRGBFormatHasAlpha(rgb->format))) {
+    if (!rgb->avoidLibYUV && !rgb->fixedPoint &&
+        ((alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP) || avifRGBFormatHasAlpha(rgb->format))) {
         avifResult libyuvResult = avifImageYUVToRGBLibYUV(image, rgb, reformatAlpha, &alphaReformattedWithLibYUV);
         if (libyuvResult == AVIF_RESULT_OK) {
             convertedWithLibYUV = AVIF_TRUE;
@@ -1391,23 +2571,55 @@ static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage *
 
         const avifBool hasColor =
             (image->yuvRowBytes[AVIF_CHAN_U] && image->yuvRowBytes[AVIF_CHAN_V] && (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400));
-
-        if ((!hasColor || (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) ||
-             ((rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_FASTEST) || (rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST))) &&
-            (alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP || avifRGBFormatHasAlpha(rgb->format))) {
-            // Explanations on the above conditional:
-            // * None of these fast paths currently support bilinear upsampling, so avoid all of them
-            //   unless the YUV data isn't subsampled or they explicitly requested AVIF_CHROMA_UPSAMPLING_NEAREST.
-            // * None of these fast paths currently handle alpha (un)multiply, so avoid all of them
-            //   if we can't do alpha (un)multiply as a separated post step (destination format doesn't have alpha).
+        const avifBool nearestOrNoUpsampling =
+            !hasColor || (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) ||
+            ((rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_FASTEST) || (rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_NEAREST));
+        // None of the fast paths currently handle alpha (un)multiply, so avoid all of them if we can't do alpha (un)multiply as
+        // a separated post step (destination format doesn't have alpha).
+        const avifBool alphaMultiplyAsPostStep = (alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_NO_OP || avifRGBFormatHasAlpha(rgb->format));
+
+        // The built-in routines finish each row (alpha (un)multiply, half float conversion) right after converting it, so
+        // that the whole avifRGBImage is only traversed once.
+        avifReformatState builtInState = *state;
+        builtInState.toRGBAlphaMultiplyMode = alphaMultiplyAsPostStep ? alphaMultiplyMode : AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+        builtInState.toRGBHalfFloat = rgb->isFloat;
+
+        if (rgb->fixedPoint) {
+            // Checked by avifImageYUVToRGB().
+            assert(alphaMultiplyAsPostStep);
+            convertResult = avifImageYUVToRGBFixedPoint(image, rgb, &builtInState);
+        } else if (!nearestOrNoUpsampling && alphaMultiplyAsPostStep &&
+                   (state->yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS)) {
+            // 4:2:0 or 4:2:2 with bilinear upsampling.
+            if (image->depth > 8) {
+                if (rgb->depth > 8) {
+                    convertResult = avifImageYUV16ToRGB16ColorBilinear(image, rgb, &builtInState);
+                } else {
+                    convertResult = avifImageYUV16ToRGB8ColorBilinear(image, rgb, &builtInState);
+                }
+            } else {
+                if (rgb->depth > 8) {
+                    convertResult = avifImageYUV8ToRGB16ColorBilinear(image, rgb, &builtInState);
+                } else {
+                    convertResult = avifImageYUV8ToRGB8ColorBilinear(image, rgb, &builtInState);
+                }
+            }
+        } else if (nearestOrNoUpsampling && alphaMultiplyAsPostStep) {
+            // The following fast paths do not support bilinear upsampling, so avoid all of them unless the YUV data isn't
+            // subsampled or they explicitly requested AVIF_CHROMA_UPSAMPLING_NEAREST.
 
             if (state->yuv.mode == AVIF_REFORMAT_MODE_IDENTITY) {
                 if ((image->depth == 8) && (rgb->depth == 8) && (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV444) &&
                     (image->yuvRange == AVIF_RANGE_FULL)) {
-                    convertResult = avifImageIdentity8ToRGB8ColorFullRange(image, rgb, state);
+                    convertResult = avifImageIdentity8ToRGB8ColorFullRange(image, rgb, &builtInState);
+                } else if (hasColor) {
+                    convertResult = avifImageIdentityToRGBColor(image, rgb, &builtInState);
+                }
+            } else if (state->yuv.mode != AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) {
+                // AVIF_REFORMAT_MODE_YCGCO, AVIF_REFORMAT_MODE_YCGCO_RE or AVIF_REFORMAT_MODE_YCGCO_RO.
+                if (hasColor) {
+                    convertResult = avifImageYCgCoToRGBColor(image, rgb, &builtInState);
                 }
-
-                // TODO: Add more fast paths for identity
             } else if (state->yuv.mode == AVIF_REFORMAT_MODE_YUV_COEFFICIENTS) {
                 if (image->depth > 8) {
                     // yuv:u16
@@ -1416,17 +2628,17 @@ static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage *
                         // yuv:u16, rgb:u16
 
                         if (hasColor) {
-                            convertResult = avifImageYUV16ToRGB16Color(image, rgb, state);
+                            convertResult = avifImageYUV16ToRGB16Color(image, rgb, &builtInState);
                         } else {
-                            convertResult = avifImageYUV16ToRGB16Mono(image, rgb, state);
+                            convertResult = avifImageYUV16ToRGB16Mono(image, rgb, &builtInState);
                         }
                     } else {
                         // yuv:u16, rgb:u8
 
                         if (hasColor) {
-                            convertResult = avifImageYUV16ToRGB8Color(image, rgb, state);
+                            convertResult = avifImageYUV16ToRGB8Color(image, rgb, &builtInState);
                         } else {
-                            convertResult = avifImageYUV16ToRGB8Mono(image, rgb, state);
+                            convertResult = avifImageYUV16ToRGB8Mono(image, rgb, &builtInState);
                         }
                     }
                 } else {
@@ -1436,17 +2648,17 @@ static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage *
                         // yuv:u8, rgb:u16
 
                         if (hasColor) {
-                            convertResult = avifImageYUV8ToRGB16Color(image, rgb, state);
+                            convertResult = avifImageYUV8ToRGB16Color(image, rgb, &builtInState);
                         } else {
-                            convertResult = avifImageYUV8ToRGB16Mono(image, rgb, state);
+                            convertResult = avifImageYUV8ToRGB16Mono(image, rgb, &builtInState);
                         }
                     } else {
                         // yuv:u8, rgb:u8
 
                         if (hasColor) {
-                            convertResult = avifImageYUV8ToRGB8Color(image, rgb, state);
+                            convertResult = avifImageYUV8ToRGB8Color(image, rgb, &builtInState);
                         } else {
-                            convertResult = avifImageYUV8ToRGB8Mono(image, rgb, state);
+                            convertResult = avifImageYUV8ToRGB8Mono(image, rgb, &builtInState);
                         }
                     }
                 }
@@ -1455,18 +2667,14 @@ static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage *
 
         if (convertResult == AVIF_RESULT_NOT_IMPLEMENTED) {
             // If we get here, there is no fast path for this combination. Time to be slow!
-            convertResult = avifImageYUVAnyToRGBAnySlow(image, rgb, state, alphaMultiplyMode);
-
-            // The slow path also handles alpha (un)multiply, so forget the operation here.
-            alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
-        }
-
-        if (convertResult != AVIF_RESULT_OK) {
-            return convertResult;
+            // The slow path handles alpha (un)multiply by itself.
+            builtInState.toRGBAlphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+            convertResult = avifImageYUVAnyToRGBAnySlow(image, rgb, &builtInState, alphaMultiplyMode);
         }
+        return convertResult;
     }
 
-    // Process alpha premultiplication, if necessary
+    // Process alpha premultiplication, if necessary. libyuv converts whole images, so this is done in separate passes.
     if (alphaMultiplyMode == AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY) {
         avifResult result = avifRGBImagePremultiplyAlpha(rgb);
         if (result != AVIF_RESULT_OK) {
@@ -1487,121 +2695,123 @@ static avifResult avifImageYUVToRGBImpl(const avifImage * image, avifRGBImage *
     return AVIF_RESULT_OK;
 }
 
+// Destination of avifImageYUVToRGBPlanar(), filled from the strips of avifImageYUVToRGBStrips().
+typedef struct avifRGBPlanarRows
+{
+    const avifRGBPlanarImage * planar;
+    // Only used with AVIF_PLANAR_SAMPLE_FLOAT32: sample = stripSample * scale[c] + offset[c].
+    float scale[4];
+    float offset[4];
+} avifRGBPlanarRows;
+
+// Deinterleaves rowCount rows of strip, starting at row stripY, into the planes of the avifRGBPlanarRows rowsData.
+static void avifStoreRGBPlanarRows(const avifRGBImage * strip, uint32_t stripY, uint32_t rowCount, void * rowsData, uint32_t y)
+{
+    const avifRGBPlanarRows * rows = (const avifRGBPlanarRows *)rowsData;
+    const avifRGBPlanarImage * planar = rows->planar;
+    const uint32_t channelCount = avifRGBFormatChannelCount(strip->format);
+    for (uint32_t j = 0; j < rowCount; ++j) {
+        const uint8_t * srcRow = &strip->pixels[(size_t)(stripY + j) * strip->rowBytes];
+        const size_t dstRowIndex = (size_t)y + j;
+        for (uint32_t c = 0; c < channelCount; ++c) {
+            uint8_t * dstRow = &planar->planes[c][dstRowIndex * planar->rowBytes[c]];
+            if (planar->sampleType == AVIF_PLANAR_SAMPLE_UINT8) {
+                for (uint32_t i = 0; i < strip->width; ++i) {
+                    dstRow[i] = srcRow[i * channelCount + c];
+                }
+            } else if (planar->sampleType == AVIF_PLANAR_SAMPLE_UINT16) {
+                const uint16_t * src16 = (const uint16_t *)srcRow;
+                uint16_t * dst16 = (uint16_t *)dstRow;
+                for (uint32_t i = 0; i < strip->width; ++i) {
+                    dst16[i] = src16[i * channelCount + c];
+                }
+            } else {
+                const uint16_t * src16 = (const uint16_t *)srcRow;
+                float * dstF = (float *)dstRow;
+                const float scale = rows->scale[c];
+                const float offset = rows->offset[c];
+                for (uint32_t i = 0; i < strip->width; ++i) {
+                    dstF[i] = src16[i * channelCount + c] * scale + offset;
+                }
+            }
+        }
+    }
+}
+
 typedef struct
 {
-#if defined(_WIN32)
-    HANDLE thread;
-#else
-    pthread_t thread;
-#endif
+    avifThread * thread;
+    // Converts rgb into image if toYUV is true, image into rgb otherwise.
+    avifBool toYUV;
     avifImage image;
     avifRGBImage rgb;
+    // If storeRows is not NULL, rgb only describes the layout of the strips that are passed to it, and the rows of image
+    // are converted from the whole image wholeImage, where they start at row firstRow.
+    avifStoreRGBRowsFunc storeRows;
+    void * storeData;
+    const avifImage * wholeImage;
+    uint32_t firstRow;
     avifReformatState * state;
     avifAlphaMultiplyMode alphaMultiplyMode;
     avifResult result;
-    avifBool threadCreated;
-} YUVToRGBThreadData;
-
-#if defined(_WIN32)
-static unsigned int __stdcall avifImageYUVToRGBThreadWorker(void * arg)
-#else
-static void * avifImageYUVToRGBThreadWorker(void * arg)
-#endif
-{
-    YUVToRGBThreadData * data = (YUVToRGBThreadData *)arg;
-    data->result = avifImageYUVToRGBImpl(&data->image, &data->rgb, data->state, data->alphaMultiplyMode);
-#if defined(_WIN32)
-    return 0;
-#else
-    return NULL;
-#endif
-}
+} avifReformatThreadData;
 
-static avifBool avifCreateYUVToRGBThread(YUVToRGBThreadData * tdata)
+static avifResult avifReformatJob(avifReformatThreadData * data)
 {
-#if defined(_WIN32)
-    tdata->thread = (HANDLE)_beginthreadex(/*security=*/NULL,
-                                           /*stack_size=*/0,
-                                           &avifImageYUVToRGBThreadWorker,
-                                           tdata,
-                                           /*initflag=*/0,
-                                           /*thrdaddr=*/NULL);
-    return tdata->thread != NULL;
-#else
-    // TODO: Set the thread name for ease of debugging.
-    return pthread_create(&tdata->thread, NULL, &avifImageYUVToRGBThreadWorker, tdata) == 0;
-#endif
+    if (data->toYUV) {
+        const avifResult result = avifImageRGBToYUVImpl(&data->image, &data->rgb);
+        // The planes of the view belong to the whole image, whatever avifImageAllocatePlanes() said.
+        data->image.imageOwnsYUVPlanes = AVIF_FALSE;
+        data->image.imageOwnsAlphaPlane = AVIF_FALSE;
+        return result;
+    }
+    if (data->storeRows) {
+        return avifImageYUVToRGBStrips(data->wholeImage,
+                                       &data->rgb,
+                                       data->alphaMultiplyMode,
+                                       data->storeRows,
+                                       data->storeData,
+                                       data->firstRow,
+                                       data->image.height);
+    }
+    return avifImageYUVToRGBImpl(&data->image, &data->rgb, data->state, data->alphaMultiplyMode);
 }
 
-static avifBool avifJoinYUVToRGBThread(YUVToRGBThreadData * tdata)
+static void avifReformatThreadWorker(void * arg)
 {
-#if defined(_WIN32)
-    return WaitForSingleObject(tdata->thread, INFINITE) == WAIT_OBJECT_0 && CloseHandle(tdata->thread) != 0;
-#else
-    return pthread_join(tdata->thread, NULL) == 0;
-#endif
+    avifReformatThreadData * data = (avifReformatThreadData *)arg;
+    data->result = avifReformatJob(data);
 }
 
-avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
+// Splits the conversion between image and rgb into up to jobs horizontal bands converted in parallel. Each band is converted
+// as described by jobTemplate, with views of image and rgb. Bands have an even height so that no 2x2 chroma block straddles
+// two of them.
+static avifResult avifReformatInBands(const avifImage * image,
+                                      const avifRGBImage * rgb,
+                                      uint32_t jobs,
+                                      const avifReformatThreadData * jobTemplate)
 {
-    // It is okay for rgb->maxThreads to be equal to zero in order to allow clients to zero initialize the avifRGBImage struct
-    // with memset.
-    if (!image->yuvPlanes[AVIF_CHAN_Y] || rgb->maxThreads < 0) {
-        return AVIF_RESULT_REFORMAT_FAILED;
-    }
-
-    avifReformatState state;
-    if (!avifPrepareReformatState(image, rgb, &state)) {
-        return AVIF_RESULT_REFORMAT_FAILED;
-    }
-
-    avifAlphaMultiplyMode alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
-    if (image->alphaPlane) {
-        if (!avifRGBFormatHasAlpha(rgb->format) || rgb->ignoreAlpha) {
-            // if we are converting some image with alpha into a format without alpha, we should do 'premultiply alpha' before
-            // discarding alpha plane. This has the same effect of rendering this image on a black background, which makes sense.
-            if (!image->alphaPremultiplied) {
-                alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY;
-            }
-        } else {
-            if (!image->alphaPremultiplied && rgb->alphaPremultiplied) {
-                alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY;
-            } else if (image->alphaPremultiplied && !rgb->alphaPremultiplied) {
-                alphaMultiplyMode = AVIF_ALPHA_MULTIPLY_MODE_UNMULTIPLY;
-            }
-        }
-    }
-
-    // In practice, we rarely need more than 8 threads for YUV to RGB conversion.
-    uint32_t jobs = AVIF_CLAMP(rgb->maxThreads, 1, 8);
-
-    // When yuv format is 420 and chromaUpsampling could be BILINEAR, there is a dependency across the horizontal borders of each
-    // job. So we disallow multithreading in that case.
-    if (image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420 && (rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_AUTOMATIC ||
-                                                         rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BEST_QUALITY ||
-                                                         rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR)) {
-        jobs = 1;
-    }
-
-    // Each thread worker needs at least 2 Y rows (to account for potential U/V subsampling).
-    if (jobs == 1 || (image->height / 2) < jobs) {
-        return avifImageYUVToRGBImpl(image, rgb, &state, alphaMultiplyMode);
-    }
-
-    AVIF_ARRAY_DECLARE(YUVToRGBThreadDataArray, YUVToRGBThreadData, threadData);
-    YUVToRGBThreadDataArray tdArray;
-    if (!avifArrayCreate(&tdArray, sizeof(YUVToRGBThreadData), jobs)) {
+    AVIF_ARRAY_DECLARE(avifReformatThreadDataArray, avifReformatThreadData, threadData);
+    avifReformatThreadDataArray tdArray;
+    if (!avifArrayCreate(&tdArray, sizeof(avifReformatThreadData), jobs)) {
         return AVIF_RESULT_OUT_OF_MEMORY;
     }
     int rowsPerJob = image->height / jobs;
     if (rowsPerJob % 2) {
         ++rowsPerJob;
     }
+    if (!jobTemplate->toYUV && (rgb->format == AVIF_RGB_FORMAT_RGB_565) && rgb->ditherRGB565 && (rowsPerJob % 4)) {
+        // Keep the dither pattern aligned across jobs, so that the output does not depend on the number of threads.
+        rowsPerJob += 2;
+    }
+    // Rounding rowsPerJob up may leave nothing for the last jobs.
+    jobs = AVIF_MIN(jobs, (image->height + rowsPerJob - 1) / rowsPerJob);
     const int rowsForLastJob = image->height - rowsPerJob * (jobs - 1);
     int startRow = 0;
     uint32_t i;
     for (i = 0; i < jobs; ++i, startRow += rowsPerJob) {
-        YUVToRGBThreadData * tdata = &tdArray.threadData[i];
+        avifReformatThreadData * tdata = &tdArray.threadData[i];
+        tdata->toYUV = jobTemplate->toYUV;
         const avifCropRect rect = { .x = 0, .y = startRow, .width = image->width, .height = (i == jobs - 1) ? rowsForLastJob : rowsPerJob };
         if (avifImageSetViewRect(&tdata->image, image, &rect) != AVIF_RESULT_OK) {
             tdata->result = AVIF_RESULT_REFORMAT_FAILED;
@@ -1609,15 +2819,21 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
         }
 
         tdata->rgb = *rgb;
-        tdata->rgb.pixels += startRow * (size_t)rgb->rowBytes;
+        if (rgb->pixels) {
+            tdata->rgb.pixels += startRow * (size_t)rgb->rowBytes;
+        }
         tdata->rgb.height = tdata->image.height;
+        tdata->storeRows = jobTemplate->storeRows;
+        tdata->storeData = jobTemplate->storeData;
+        tdata->wholeImage = image;
+        tdata->firstRow = startRow;
 
-        tdata->state = &state;
-        tdata->alphaMultiplyMode = alphaMultiplyMode;
+        tdata->state = jobTemplate->state;
+        tdata->alphaMultiplyMode = jobTemplate->alphaMultiplyMode;
 
         if (i > 0) {
-            tdata->threadCreated = avifCreateYUVToRGBThread(tdata);
-            if (!tdata->threadCreated) {
+            tdata->thread = avifThreadCreate(&avifReformatThreadWorker, tdata);
+            if (!tdata->thread) {
                 tdata->result = AVIF_RESULT_REFORMAT_FAILED;
                 break;
             }
@@ -1625,12 +2841,12 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
     }
     // If above loop ran successfully, Run the first job in the current thread.
     if (i == jobs) {
-        avifImageYUVToRGBThreadWorker(&tdArray.threadData[0]);
+        avifReformatThreadWorker(&tdArray.threadData[0]);
     }
     avifResult result = AVIF_RESULT_OK;
     for (i = 0; i < jobs; ++i) {
-        YUVToRGBThreadData * tdata = &tdArray.threadData[i];
-        if (tdata->threadCreated && !avifJoinYUVToRGBThread(tdata)) {
+        avifReformatThreadData * tdata = &tdArray.threadData[i];
+        if (tdata->thread && !avifThreadJoin(tdata->thread)) {
             result = AVIF_RESULT_REFORMAT_FAILED;
         }
         if (tdata->result != AVIF_RESULT_OK) {
@@ -1641,6 +2857,203 @@ avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
     return result;
 }
 
+// Returns how alpha has to be (un)multiplied when converting image to rgb.
+static avifAlphaMultiplyMode avifGetYUVToRGBAlphaMultiplyMode(const avifImage * image, const avifRGBImage * rgb)
+{
+    if (image->alphaPlane) {
+        if (!avifRGBFormatHasAlpha(rgb->format) || rgb->ignoreAlpha) {
+            // if we are converting some image with alpha into a format without alpha, we should do 'premultiply alpha' before
+            // discarding alpha plane. This has the same effect of rendering this image on a black background, which makes sense.
+            if (!image->alphaPremultiplied) {
+                return AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY;
+            }
+        } else {
+            if (!image->alphaPremultiplied && rgb->alphaPremultiplied) {
+                return AVIF_ALPHA_MULTIPLY_MODE_MULTIPLY;
+            } else if (image->alphaPremultiplied && !rgb->alphaPremultiplied) {
+                return AVIF_ALPHA_MULTIPLY_MODE_UNMULTIPLY;
+            }
+        }
+    }
+    return AVIF_ALPHA_MULTIPLY_MODE_NO_OP;
+}
+
+// Splits the conversion of image into horizontal bands converted in parallel, up to rgb->maxThreads. If storeRows is not
+// NULL, the output goes to storeRows() and rgb only describes the layout of the intermediate strips.
+static avifResult avifImageYUVToRGBThreaded(const avifImage * image,
+                                            avifRGBImage * rgb,
+                                            avifStoreRGBRowsFunc storeRows,
+                                            void * storeData,
+                                            avifReformatState * state,
+                                            avifAlphaMultiplyMode alphaMultiplyMode)
+{
+    // In practice, we rarely need more than 8 threads for YUV to RGB conversion.
+    uint32_t jobs = AVIF_CLAMP(rgb->maxThreads, 1, 8);
+
+    // When yuv format is 420 and chromaUpsampling could be BILINEAR, there is a dependency across the horizontal borders of each
+    // job. So we disallow multithreading in that case, unless the conversion goes through avifImageYUVToRGBStrips(), which
+    // reads the rows across the borders.
+    if (!storeRows && image->yuvFormat == AVIF_PIXEL_FORMAT_YUV420 &&
+        (rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_AUTOMATIC ||
+         rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BEST_QUALITY ||
+         rgb->chromaUpsampling == AVIF_CHROMA_UPSAMPLING_BILINEAR)) {
+        jobs = 1;
+    }
+
+    // Each thread worker needs at least 2 Y rows (to account for potential U/V subsampling).
+    if (jobs == 1 || (image->height / 2) < jobs) {
+        if (storeRows) {
+            return avifImageYUVToRGBStrips(image, rgb, alphaMultiplyMode, storeRows, storeData, 0, image->height);
+        }
+        return avifImageYUVToRGBImpl(image, rgb, state, alphaMultiplyMode);
+    }
+
+    avifReformatThreadData jobTemplate;
+    memset(&jobTemplate, 0, sizeof(jobTemplate));
+    jobTemplate.toYUV = AVIF_FALSE;
+    jobTemplate.storeRows = storeRows;
+    jobTemplate.storeData = storeData;
+    jobTemplate.state = state;
+    jobTemplate.alphaMultiplyMode = alphaMultiplyMode;
+    return avifReformatInBands(image, rgb, jobs, &jobTemplate);
+}
+
+avifResult avifImageRGBToYUV(avifImage * image, const avifRGBImage * rgb)
+{
+    // Same as for avifImageYUVToRGB(), rgb->maxThreads may be zero.
+    if (rgb->maxThreads < 0) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    uint32_t jobs = AVIF_CLAMP(rgb->maxThreads, 1, 8);
+    // libsharpyuv looks at the whole image. Each job needs at least 2 rows, for the 2x2 chroma blocks.
+    if ((rgb->chromaDownsampling == AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV) || (rgb->height / 2) < jobs) {
+        jobs = 1;
+    }
+    if (jobs == 1) {
+        return avifImageRGBToYUVImpl(image, rgb);
+    }
+
+    // Allocate the planes of the whole image once, before the jobs write into views of them.
+    avifReformatState state;
+    AVIF_CHECKRES(avifImageRGBToYUVPrepare(image, rgb, &state));
+    avifReformatThreadData jobTemplate;
+    memset(&jobTemplate, 0, sizeof(jobTemplate));
+    jobTemplate.toYUV = AVIF_TRUE;
+    return avifReformatInBands(image, rgb, jobs, &jobTemplate);
+}
+
+avifResult avifImageYUVToRGB(const avifImage * image, avifRGBImage * rgb)
+{
+    // It is okay for rgb->maxThreads to be equal to zero in order to allow clients to zero initialize the avifRGBImage struct
+    // with memset.
+    if (!image->yuvPlanes[AVIF_CHAN_Y] || rgb->maxThreads < 0) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+
+    avifReformatState state;
+    avifAlphaMultiplyMode alphaMultiplyMode;
+    AVIF_CHECKRES(avifImageYUVToRGBPrepare(image, rgb, &state, &alphaMultiplyMode));
+    return avifImageYUVToRGBThreaded(image, rgb, NULL, NULL, &state, alphaMultiplyMode);
+}
+
+avifResult avifImageYUVToRGBPrepare(const avifImage * image,
+                                    const avifRGBImage * rgb,
+                                    avifReformatState * state,
+                                    avifAlphaMultiplyMode * alphaMultiplyMode)
+{
+    if (!avifPrepareReformatState(image, rgb, state)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    *alphaMultiplyMode = avifGetYUVToRGBAlphaMultiplyMode(image, rgb);
+    if (rgb->fixedPoint && !avifFixedPointSupported(image, rgb, state, *alphaMultiplyMode)) {
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+    return AVIF_RESULT_OK;
+}
+
+avifResult avifImageYUVToRGBWithState(const avifImage * image,
+                                      avifRGBImage * rgb,
+                                      avifReformatState * state,
+                                      avifAlphaMultiplyMode alphaMultiplyMode)
+{
+    return avifImageYUVToRGBImpl(image, rgb, state, alphaMultiplyMode);
+}
+
+avifResult avifImageYUVToRGBPlanar(const avifImage * image, avifRGBPlanarImage * rgb)
+{
+    if (!image->yuvPlanes[AVIF_CHAN_Y] || rgb->maxThreads < 0 || (rgb->width != image->width) || (rgb->height != image->height)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (!rgb->planes[c] || !rgb->rowBytes[c]) {
+            return AVIF_RESULT_REFORMAT_FAILED;
+        }
+    }
+    if ((rgb->sampleType == AVIF_PLANAR_SAMPLE_UINT8) && (rgb->depth != 8)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    if (rgb->normalize && (rgb->sampleType != AVIF_PLANAR_SAMPLE_FLOAT32)) {
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
+    // The interleaved layout of the strips. Float samples are computed from 16-bit integers.
+    avifRGBImage layout;
+    avifRGBImageSetDefaults(&layout, image);
+    layout.format = rgb->planes[3] ? AVIF_RGB_FORMAT_RGBA : AVIF_RGB_FORMAT_RGB;
+    if (rgb->sampleType == AVIF_PLANAR_SAMPLE_UINT8) {
+        layout.depth = 8;
+    } else if (rgb->sampleType == AVIF_PLANAR_SAMPLE_UINT16) {
+        layout.depth = rgb->depth;
+    } else if (rgb->sampleType == AVIF_PLANAR_SAMPLE_FLOAT32) {
+        layout.depth = 16;
+    } else {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    layout.chromaUpsampling = rgb->chromaUpsampling;
+    layout.avoidLibYUV = rgb->avoidLibYUV;
+    layout.alphaPremultiplied = rgb->alphaPremultiplied;
+    layout.maxThreads = rgb->maxThreads;
+
+    avifReformatState state;
+    if (!avifPrepareReformatState(image, &layout, &state)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+
+    avifRGBPlanarRows rows;
+    rows.planar = rgb;
+    for (int c = 0; c < 4; ++c) {
+        const float std = rgb->normalize ? rgb->std[c] : 1.0f;
+        if (std == 0.0f) {
+            return AVIF_RESULT_INVALID_ARGUMENT;
+        }
+        rows.scale[c] = 1.0f / (state.rgb.maxChannelF * std);
+        rows.offset[c] = rgb->normalize ? -rgb->mean[c] / std : 0.0f;
+    }
+    const avifAlphaMultiplyMode alphaMultiplyMode = avifGetYUVToRGBAlphaMultiplyMode(image, &layout);
+    return avifImageYUVToRGBThreaded(image, &layout, avifStoreRGBPlanarRows, &rows, &state, alphaMultiplyMode);
+}
+
+avifResult avifImageYUVToRGBRows(const avifImage * image,
+                                 const avifRGBImage * layout,
+                                 avifStoreRGBRowsFunc storeRows,
+                                 void * storeData)
+{
+    if (!image->yuvPlanes[AVIF_CHAN_Y] || layout->maxThreads < 0) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    avifRGBImage strips = *layout;
+    strips.width = image->width;
+    strips.height = image->height;
+    strips.pixels = NULL;
+    strips.rowBytes = 0;
+    avifReformatState state;
+    if (!avifPrepareReformatState(image, &strips, &state)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    const avifAlphaMultiplyMode alphaMultiplyMode = avifGetYUVToRGBAlphaMultiplyMode(image, &strips);
+    return avifImageYUVToRGBThreaded(image, &strips, storeRows, storeData, &state, alphaMultiplyMode);
+}
+
 // Limited -> Full
 // Plan: subtract limited offset, then multiply by ratio of FULLSIZE/LIMITEDSIZE (rounding), then clamp.
 // RATIO = (FULLY - 0) / (MAXLIMITEDY - MINLIMITEDY)
@@ -1733,28 +3146,21 @@ int avifFullToLimitedUV(uint32_t depth, int v)
     return v;
 }
 
-static inline uint16_t avifFloatToF16(float v)
-{
-    avifF16 f16;
-    f16.f = v * F16_MULTIPLIER;
-    return (uint16_t)(f16.u32 >> 13);
-}
-
-static inline float avifF16ToFloat(uint16_t v)
-{
-    avifF16 f16;
-    f16.u32 = v << 13;
-    return f16.f / F16_MULTIPLIER;
-}
-
 void avifGetRGBAPixel(const avifRGBImage * src, uint32_t x, uint32_t y, const avifRGBColorSpaceInfo * info, float rgbaPixel[4])
 {
     assert(src != NULL);
     assert(!src->isFloat || src->depth == 16);
     assert(src->format != AVIF_RGB_FORMAT_RGB_565 || src->depth == 8);
+    assert(src->format != AVIF_RGB_FORMAT_RGBA1010102 || src->depth == 10);
 
     const uint8_t * const srcPixel = &src->pixels[y * src->rowBytes + x * info->pixelBytes];
-    if (info->channelBytes > 1) {
+    if (src->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        const uint32_t pixel = *((const uint32_t *)srcPixel);
+        rgbaPixel[0] = (pixel & 0x3FF) / info->maxChannelF;
+        rgbaPixel[1] = ((pixel >> 10) & 0x3FF) / info->maxChannelF;
+        rgbaPixel[2] = ((pixel >> 20) & 0x3FF) / info->maxChannelF;
+        rgbaPixel[3] = (pixel >> 30) / 3.0f;
+    } else if (info->channelBytes > 1) {
         uint16_t r = *((uint16_t *)(&srcPixel[info->offsetBytesR]));
         uint16_t g = *((uint16_t *)(&srcPixel[info->offsetBytesG]));
         uint16_t b = *((uint16_t *)(&srcPixel[info->offsetBytesB]));
@@ -1792,8 +3198,16 @@ void avifSetRGBAPixel(const avifRGBImage * dst, uint32_t x, uint32_t y, const av
     assert(dst != NULL);
     assert(!dst->isFloat || dst->depth == 16);
     assert(dst->format != AVIF_RGB_FORMAT_RGB_565 || dst->depth == 8);
+    assert(dst->format != AVIF_RGB_FORMAT_RGBA1010102 || dst->depth == 10);
 
     uint8_t * const dstPixel = &dst->pixels[y * dst->rowBytes + x * info->pixelBytes];
+    if (dst->format == AVIF_RGB_FORMAT_RGBA1010102) {
+        *((uint32_t *)dstPixel) = RGBA1010102((uint32_t)(0.5f + (rgbaPixel[0] * info->maxChannelF)),
+                                              (uint32_t)(0.5f + (rgbaPixel[1] * info->maxChannelF)),
+                                              (uint32_t)(0.5f + (rgbaPixel[2] * info->maxChannelF)),
+                                              (uint32_t)(0.5f + (rgbaPixel[3] * 3.0f)));
+        return;
+    }
 
     uint8_t * const ptrR = &dstPixel[info->offsetBytesR];
     uint8_t * const ptrG = &dstPixel[info->offsetBytesG];
@@ -283,6 +283,7 @@ avifResult avifImageRGBToYUVLibYUV8bpc(avifImage * image, const avifRGBImage * r
                                                                ARGBToI400, // BGRA
                                                                NULL,       // ABGR
                                                                NULL,       // RGB_565
+                                                               NULL,       // RGBA1010102
                                                            },
                                                            // AVIF_RANGE_FULL
                                                            {
@@ -293,7 +294,8 @@ avifResult avifImageRGBToYUVLibYUV8bpc(avifImage * image, const avifRGBImage * r
                                                                RGB24ToJ400, // BGR
                                                                ARGBToJ400,  // BGRA
                                                                RGBAToJ400,  // ABGR
-                                                               NULL         // RGB_565
+                                                               NULL,        // RGB_565
+                                                               NULL,        // RGBA1010102
                                                            }
             };
             RGBtoY rgbToY = lutRgbToY[image->yuvRange][rgb->format];
@@ -322,7 +324,8 @@ avifResult avifImageRGBToYUVLibYUV8bpc(avifImage * image, const avifRGBImage * r
                     { NULL, avifRGB24ToI444, avifRGB24ToI422, RGB24ToI420, NULL }, // BGR
                     { NULL, ARGBToI444, ARGBToI422, ARGBToI420, NULL },            // BGRA
                     { NULL, avifRGBAToI444, avifRGBAToI422, RGBAToI420, NULL },    // ABGR
-                    { NULL, NULL, NULL, NULL, NULL }                               // RGB_565
+                    { NULL, NULL, NULL, NULL, NULL },                              // RGB_565
+                    { NULL, NULL, NULL, NULL, NULL },                              // RGBA1010102
                 },
                 // AVIF_RANGE_FULL
                 {
@@ -333,7 +336,8 @@ avifResult avifImageRGBToYUVLibYUV8bpc(avifImage * image, const avifRGBImage * r
                     { NULL, NULL, avifRGB24ToJ422, RGB24ToJ420, NULL },   // BGR
                     { NULL, NULL, ARGBToJ422, ARGBToJ420, NULL },         // BGRA
                     { NULL, NULL, avifRGBAToJ422, avifRGBAToJ420, NULL }, // ABGR
-                    { NULL, NULL, NULL, NULL, NULL }                      // RGB_565
+                    { NULL, NULL, NULL, NULL, NULL },                     // RGB_565
+                    { NULL, NULL, NULL, NULL, NULL },                     // RGBA1010102
                 }
             };
             RGBtoYUV rgbToYuv = lutRgbToYuv[image->yuvRange][rgb->format][image->yuvFormat];
@@ -385,6 +389,8 @@ avifResult avifImageRGBToYUVLibYUV8bpc(avifImage * image, const avifRGBImage * r
 // AVIF_RGB_FORMAT_BGRA      *ToARGBMatrix    matrixYUV
 // AVIF_RGB_FORMAT_ABGR      n/a              n/a
 // AVIF_RGB_FORMAT_RGB_565   n/a              n/a
+//
+// AVIF_RGB_FORMAT_RGBA1010102 is never converted with libyuv.
 
 // Lookup table for isYVU. If the entry in this table is AVIF_TRUE, then it
 // means that we are using a libyuv function with R and B channels swapped,
@@ -398,6 +404,7 @@ static const avifBool lutIsYVU[AVIF_RGB_FORMAT_COUNT] = {
     AVIF_FALSE, // BGRA
     AVIF_FALSE, // ABGR
     AVIF_FALSE, // RGB_565
+    AVIF_FALSE, // RGBA1010102
 };
 
 typedef int (*YUV400ToRGBMatrix)(const uint8_t *, int, uint8_t *, int, const struct YuvConstants *, int, int);
@@ -535,6 +542,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
         I400ToARGBMatrix, // BGRA
         NULL,             // ABGR
         NULL,             // RGB_565
+        NULL,             // RGBA1010102
     };
 
     // Lookup table for 8-bit YUV To 8-bit RGB Matrix (with filter).
@@ -547,6 +555,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
         { NULL, NULL, I422ToARGBMatrixFilter, I420ToARGBMatrixFilter, NULL },   // BGRA
         { NULL, NULL, NULL, NULL, NULL },                                       // ABGR
         { NULL, NULL, NULL, NULL, NULL },                                       // RGB_565
+        { NULL, NULL, NULL, NULL, NULL },                                       // RGBA1010102
     };
 
     // Lookup table for 8-bit YUVA To 8-bit RGB Matrix (with filter).
@@ -559,6 +568,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
         { NULL, NULL, I422AlphaToARGBMatrixFilter, I420AlphaToARGBMatrixFilter, NULL }, // BGRA
         { NULL, NULL, NULL, NULL, NULL },                                               // ABGR
         { NULL, NULL, NULL, NULL, NULL },                                               // RGB_565
+        { NULL, NULL, NULL, NULL, NULL },                                               // RGBA1010102
     };
 
     // Lookup table for 8-bit YUV To 8-bit RGB Matrix (4:4:4 or nearest-neighbor filter).
@@ -571,6 +581,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
         { NULL, I444ToARGBMatrix, I422ToARGBMatrix, I420ToARGBMatrix, NULL }, // BGRA
         { NULL, NULL, I422ToRGBAMatrix, I420ToRGBAMatrix, NULL },             // ABGR
         { NULL, NULL, I422ToRGB565Matrix, I420ToRGB565Matrix, NULL },         // RGB_565
+        { NULL, NULL, NULL, NULL, NULL },                                     // RGBA1010102
     };
 
     // Lookup table for 8-bit YUVA To 8-bit RGB Matrix (4:4:4 or nearest-neighbor filter).
@@ -583,6 +594,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
         { NULL, I444AlphaToARGBMatrix, I422AlphaToARGBMatrix, I420AlphaToARGBMatrix, NULL }, // BGRA
         { NULL, NULL, NULL, NULL, NULL },                                                    // ABGR
         { NULL, NULL, NULL, NULL, NULL },                                                    // RGB_565
+        { NULL, NULL, NULL, NULL, NULL },                                                    // RGBA1010102
     };
 
     // Lookup table for YUV To RGB Matrix (with filter).  First dimension is for the YUV bit depth.
@@ -597,6 +609,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, I210ToARGBMatrixFilter, I010ToARGBMatrixFilter, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL },                                     // ABGR
             { NULL, NULL, NULL, NULL, NULL },                                     // RGB_565
+            { NULL, NULL, NULL, NULL, NULL },                                     // RGBA1010102
         },
         // 12bpc
         {
@@ -608,6 +621,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, NULL, NULL, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL }, // ABGR
             { NULL, NULL, NULL, NULL, NULL }, // RGB_565
+            { NULL, NULL, NULL, NULL, NULL }, // RGBA1010102
         },
     };
 
@@ -623,6 +637,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, I210AlphaToARGBMatrixFilter, I010AlphaToARGBMatrixFilter, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL },                                               // ABGR
             { NULL, NULL, NULL, NULL, NULL },                                               // RGB_565
+            { NULL, NULL, NULL, NULL, NULL },                                               // RGBA1010102
         },
         // 12bpc
         {
@@ -634,6 +649,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, NULL, NULL, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL }, // ABGR
             { NULL, NULL, NULL, NULL, NULL }, // RGB_565
+            { NULL, NULL, NULL, NULL, NULL }, // RGBA1010102
         },
     };
 
@@ -649,6 +665,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, I410ToARGBMatrix, I210ToARGBMatrix, I010ToARGBMatrix, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL },                                     // ABGR
             { NULL, NULL, NULL, NULL, NULL },                                     // RGB_565
+            { NULL, NULL, NULL, NULL, NULL },                                     // RGBA1010102
         },
         // 12bpc
         {
@@ -660,6 +677,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, NULL, I012ToARGBMatrix, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL },             // ABGR
             { NULL, NULL, NULL, NULL, NULL },             // RGB_565
+            { NULL, NULL, NULL, NULL, NULL },             // RGBA1010102
         },
     };
 
@@ -675,6 +693,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, I410AlphaToARGBMatrix, I210AlphaToARGBMatrix, I010AlphaToARGBMatrix, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL },                                                    // ABGR
             { NULL, NULL, NULL, NULL, NULL },                                                    // RGB_565
+            { NULL, NULL, NULL, NULL, NULL },                                                    // RGBA1010102
         },
         // 12bpc
         {
@@ -686,6 +705,7 @@ static avifBool getLibYUVConversionFunction(avifPixelFormat yuvFormat,
             { NULL, NULL, NULL, NULL, NULL }, // BGRA
             { NULL, NULL, NULL, NULL, NULL }, // ABGR
             { NULL, NULL, NULL, NULL, NULL }, // RGB_565
+            { NULL, NULL, NULL, NULL, NULL }, // RGBA1010102
         },
     };
 
@@ -3,6 +3,8 @@
 
 #include "avif/internal.h"
 #include <limits.h>
+#include <math.h>
+#include <string.h>
 
 #if defined(__clang__)
 #pragma clang diagnostic push
@@ -18,12 +20,374 @@
 #pragma clang diagnostic pop
 #endif
 
-// This should be configurable and/or smarter. kFilterBox has the highest quality but is the slowest.
-#define AVIF_LIBYUV_FILTER_MODE kFilterBox
+// A simple conservative limit to avoid integer overflows in libyuv's ScalePlane() and ScalePlane_12() functions.
+// Larger planes are scaled by the built-in resampler.
+#define AVIF_LIBYUV_MAX_SCALE_DIMENSION 16384
+
+// The built-in resampler splits each plane into bands of at least that many destination rows, one band per job.
+#define AVIF_SCALE_MIN_ROWS_PER_JOB 16
+
+// Lanczos window size, in source samples when upscaling and in destination samples when downscaling.
+#define AVIF_LANCZOS_LOBES 3
+
+// ---------------------------------------------------------------------------
+// Built-in separable resampler
+
+// Filter weights along one axis. Each destination sample is the weighted sum of the 'taps' consecutive source samples
+// starting at first[i]. Samples outside of the source are clamped to the edge, so first[i] + taps <= source size.
+typedef struct avifScaleContributions
+{
+    uint32_t taps;
+    uint32_t * first;
+    float * weights; // taps weights per destination sample
+} avifScaleContributions;
+
+static double avifSinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    const double pix = 3.14159265358979323846 * x;
+    return sin(pix) / pix;
+}
+
+// Returns the weight of the source sample covering [x - 0.5, x + 0.5] (relative to the destination sample center, in
+// source samples), for a destination sample spanning 'scale' source samples.
+static double avifScaleWeight(avifScaleFilter filter, double x, double scale)
+{
+    if (filter == AVIF_SCALE_FILTER_BOX && scale > 1.0) {
+        // Exact area coverage.
+        const double lo = AVIF_MAX(x - 0.5, -scale / 2);
+        const double hi = AVIF_MIN(x + 0.5, scale / 2);
+        return (hi > lo) ? (hi - lo) : 0.0;
+    }
+    const double stretch = AVIF_MAX(scale, 1.0);
+    x = fabs(x) / stretch;
+    if (filter == AVIF_SCALE_FILTER_LANCZOS) {
+        return (x < AVIF_LANCZOS_LOBES) ? avifSinc(x) * avifSinc(x / AVIF_LANCZOS_LOBES) : 0.0;
+    }
+    // Bilinear, and box when upscaling (same as libyuv).
+    return (x < 1.0) ? (1.0 - x) : 0.0;
+}
+
+static void avifScaleContributionsDestroy(avifScaleContributions * c)
+{
+    avifFree(c->first);
+    avifFree(c->weights);
+    memset(c, 0, sizeof(*c));
+}
+
+static avifResult avifScaleContributionsCreate(avifScaleContributions * c,
+                                               avifScaleFilter filter,
+                                               uint32_t srcSize,
+                                               uint32_t dstSize)
+{
+    memset(c, 0, sizeof(*c));
+    const double scale = (double)srcSize / dstSize;
+    double radius;
+    if (filter == AVIF_SCALE_FILTER_NEAREST) {
+        radius = 0.0;
+    } else if (filter == AVIF_SCALE_FILTER_LANCZOS) {
+        radius = AVIF_LANCZOS_LOBES * AVIF_MAX(scale, 1.0);
+    } else if (filter == AVIF_SCALE_FILTER_BOX && scale > 1.0) {
+        radius = scale / 2 + 0.5;
+    } else {
+        radius = AVIF_MAX(scale, 1.0);
+    }
+    c->taps = (filter == AVIF_SCALE_FILTER_NEAREST) ? 1 : AVIF_MIN((uint32_t)ceil(2 * radius) + 1, srcSize);
+
+    c->first = (uint32_t *)avifAlloc(sizeof(uint32_t) * dstSize);
+    c->weights = (float *)avifAlloc(sizeof(float) * c->taps * dstSize);
+    if (!c->first || !c->weights) {
+        avifScaleContributionsDestroy(c);
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        // Center of the destination sample, in source sample coordinates (source sample s is centered on s).
+        const double center = (i + 0.5) * scale - 0.5;
+        float * weights = &c->weights[i * c->taps];
+        if (filter == AVIF_SCALE_FILTER_NEAREST) {
+            c->first[i] = AVIF_MIN((uint32_t)((i + 0.5) * scale), srcSize - 1);
+            weights[0] = 1.0f;
+            continue;
+        }
+
+        const int64_t start = (int64_t)floor(center - radius);
+        const uint32_t first = (uint32_t)AVIF_CLAMP(start, 0, (int64_t)(srcSize - c->taps));
+        c->first[i] = first;
+        memset(weights, 0, sizeof(float) * c->taps);
+        double sum = 0.0;
+        for (int64_t s = start; s < start + (int64_t)ceil(2 * radius) + 1; ++s) {
+            const double w = avifScaleWeight(filter, (double)s - center, scale);
+            if (w == 0.0) {
+                continue;
+            }
+            const uint32_t clamped = (uint32_t)AVIF_CLAMP(s, 0, (int64_t)srcSize - 1);
+            weights[clamped - first] += (float)w;
+            sum += w;
+        }
+        if (sum != 0.0) {
+            for (uint32_t k = 0; k < c->taps; ++k) {
+                weights[k] = (float)(weights[k] / sum);
+            }
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Planes and jobs
+
+typedef struct avifScalePlane
+{
+    const uint8_t * src;
+    uint32_t srcRowBytes;
+    uint32_t srcWidth;
+    uint32_t srcHeight;
+    uint8_t * dst;
+    uint32_t dstRowBytes;
+    uint32_t dstWidth;
+    uint32_t dstHeight;
+    avifBool useLibYUV;
+    // Built-in resampler only.
+    avifScaleContributions horizontal;
+    avifScaleContributions vertical;
+} avifScalePlane;
+
+typedef struct avifScaleJob
+{
+    const avifScalePlane * plane;
+    uint32_t firstRow; // Built-in resampler only. libyuv jobs scale whole planes.
+    uint32_t rowCount;
+    int libyuvFailure;
+} avifScaleJob;
+
+static int avifScalePlaneLibYUV(const avifScalePlane * p, uint32_t depth, avifScaleFilter filter)
+{
+    const enum FilterMode mode = (filter == AVIF_SCALE_FILTER_NEAREST)    ? kFilterNone
+                                 : (filter == AVIF_SCALE_FILTER_BILINEAR) ? kFilterBilinear
+                                                                          : kFilterBox;
+    const int srcW = (int)p->srcWidth;
+    const int srcH = (int)p->srcHeight;
+    const int dstW = (int)p->dstWidth;
+    const int dstH = (int)p->dstHeight;
+    if (depth > 8) {
+        uint16_t * const srcPlane = (uint16_t *)p->src;
+        uint16_t * const dstPlane = (uint16_t *)p->dst;
+        const int srcStride = (int)(p->srcRowBytes / 2);
+        const int dstStride = (int)(p->dstRowBytes / 2);
+#if LIBYUV_VERSION >= 1880
+        return ScalePlane_12(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, mode);
+#elif LIBYUV_VERSION >= 1774
+        ScalePlane_12(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, mode);
+#else
+        ScalePlane_16(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, mode);
+#endif
+    } else {
+#if LIBYUV_VERSION >= 1880
+        return ScalePlane(p->src, (int)p->srcRowBytes, srcW, srcH, p->dst, (int)p->dstRowBytes, dstW, dstH, mode);
+#else
+        ScalePlane(p->src, (int)p->srcRowBytes, srcW, srcH, p->dst, (int)p->dstRowBytes, dstW, dstH, mode);
+#endif
+    }
+    return 0;
+}
+
+// Scales the destination rows [firstRow:firstRow+rowCount[ of a plane with the built-in resampler, and writes them
+// starting at dst (p->dstRowBytes apart). Each destination row is filtered vertically into 'row' (srcWidth floats),
+// then horizontally. Both inner loops run over contiguous samples with a constant number of taps so that compilers can
+// vectorize them.
+static void avifScalePlaneRows(const avifScalePlane * p,
+                               uint32_t depth,
+                               uint32_t firstRow,
+                               uint32_t rowCount,
+                               uint8_t * dst,
+                               float * row)
+{
+    const float maxValue = (float)((1 << depth) - 1);
+    const uint32_t vTaps = p->vertical.taps;
+    const uint32_t hTaps = p->horizontal.taps;
+    for (uint32_t j = firstRow; j < firstRow + rowCount; ++j) {
+        const float * const vWeights = &p->vertical.weights[j * vTaps];
+        memset(row, 0, sizeof(float) * p->srcWidth);
+        for (uint32_t k = 0; k < vTaps; ++k) {
+            const float w = vWeights[k];
+            if (w == 0.0f) {
+                continue;
+            }
+            const uint8_t * const srcRow = &p->src[(size_t)(p->vertical.first[j] + k) * p->srcRowBytes];
+            if (depth > 8) {
+                const uint16_t * const src16 = (const uint16_t *)srcRow;
+                for (uint32_t i = 0; i < p->srcWidth; ++i) {
+                    row[i] += w * src16[i];
+                }
+            } else {
+                for (uint32_t i = 0; i < p->srcWidth; ++i) {
+                    row[i] += w * srcRow[i];
+                }
+            }
+        }
+
+        uint8_t * const dstRow = &dst[(size_t)(j - firstRow) * p->dstRowBytes];
+        for (uint32_t i = 0; i < p->dstWidth; ++i) {
+            const float * const hWeights = &p->horizontal.weights[i * hTaps];
+            const float * const src = &row[p->horizontal.first[i]];
+            float v = 0.0f;
+            for (uint32_t k = 0; k < hTaps; ++k) {
+                v += hWeights[k] * src[k];
+            }
+            v = AVIF_CLAMP(v + 0.5f, 0.0f, maxValue);
+            if (depth > 8) {
+                ((uint16_t *)dstRow)[i] = (uint16_t)v;
+            } else {
+                dstRow[i] = (uint8_t)v;
+            }
+        }
+    }
+}
+
+typedef struct
+{
+    avifThread * thread;
+    avifScaleJob * jobs;
+    uint32_t jobCount;
+    uint32_t firstJob; // This thread runs the jobs firstJob, firstJob+jobStep, firstJob+2*jobStep etc.
+    uint32_t jobStep;
+    uint32_t depth;
+    avifScaleFilter filter;
+    uint32_t maxSrcWidth;
+    avifResult result;
+} avifScaleThreadData;
+
+static void avifScaleThreadWorker(void * arg)
+{
+    avifScaleThreadData * data = (avifScaleThreadData *)arg;
+    float * row = NULL;
+    data->result = AVIF_RESULT_OK;
+    for (uint32_t i = data->firstJob; i < data->jobCount; i += data->jobStep) {
+        avifScaleJob * job = &data->jobs[i];
+        if (job->plane->useLibYUV) {
+            job->libyuvFailure = avifScalePlaneLibYUV(job->plane, data->depth, data->filter);
+            continue;
+        }
+        if (!row) {
+            row = (float *)avifAlloc(sizeof(float) * data->maxSrcWidth);
+            if (!row) {
+                data->result = AVIF_RESULT_OUT_OF_MEMORY;
+                break;
+            }
+        }
+        uint8_t * const dst = &job->plane->dst[(size_t)job->firstRow * job->plane->dstRowBytes];
+        avifScalePlaneRows(job->plane, data->depth, job->firstRow, job->rowCount, dst, row);
+    }
+    avifFree(row);
+}
+
+// Scales all planes, splitting the work across up to maxThreads threads (the current one included).
+static avifResult avifScalePlanes(avifScalePlane * planes,
+                                  uint32_t planeCount,
+                                  uint32_t depth,
+                                  avifScaleFilter filter,
+                                  int maxThreads,
+                                  avifDiagnostics * diag)
+{
+    const uint32_t threadCount = (uint32_t)AVIF_CLAMP(maxThreads, 1, 64);
+    avifResult result = AVIF_RESULT_OK;
+
+    uint32_t maxJobCount = 0;
+    uint32_t maxSrcWidth = 0;
+    for (uint32_t p = 0; p < planeCount; ++p) {
+        avifScalePlane * plane = &planes[p];
+        plane->useLibYUV = (filter != AVIF_SCALE_FILTER_LANCZOS) && (plane->srcWidth <= AVIF_LIBYUV_MAX_SCALE_DIMENSION) &&
+                           (plane->srcHeight <= AVIF_LIBYUV_MAX_SCALE_DIMENSION);
+        if (plane->useLibYUV) {
+            ++maxJobCount;
+            continue;
+        }
+        maxJobCount += threadCount;
+        maxSrcWidth = AVIF_MAX(maxSrcWidth, plane->srcWidth);
+        AVIF_CHECKRES(avifScaleContributionsCreate(&plane->horizontal, filter, plane->srcWidth, plane->dstWidth));
+        AVIF_CHECKRES(avifScaleContributionsCreate(&plane->vertical, filter, plane->srcHeight, plane->dstHeight));
+    }
+
+    avifScaleJob * jobs = (avifScaleJob *)avifAlloc(sizeof(avifScaleJob) * maxJobCount);
+    avifScaleThreadData * threads = (avifScaleThreadData *)avifAlloc(sizeof(avifScaleThreadData) * threadCount);
+    if (!jobs || !threads) {
+        avifFree(jobs);
+        avifFree(threads);
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+
+    // One job per libyuv plane, and bands of rows for the other planes.
+    uint32_t jobCount = 0;
+    for (uint32_t p = 0; p < planeCount; ++p) {
+        const avifScalePlane * plane = &planes[p];
+        const uint32_t bandCount =
+            plane->useLibYUV ? 1 : AVIF_CLAMP(plane->dstHeight / AVIF_SCALE_MIN_ROWS_PER_JOB, 1, threadCount);
+        const uint32_t rowsPerBand = (plane->dstHeight + bandCount - 1) / bandCount;
+        for (uint32_t firstRow = 0; firstRow < plane->dstHeight; firstRow += rowsPerBand) {
+            avifScaleJob * job = &jobs[jobCount++];
+            job->plane = plane;
+            job->firstRow = firstRow;
+            job->rowCount = AVIF_MIN(rowsPerBand, plane->dstHeight - firstRow);
+            job->libyuvFailure = 0;
+        }
+    }
+
+    const uint32_t usedThreadCount = AVIF_MIN(threadCount, jobCount);
+    uint32_t i;
+    for (i = 0; i < usedThreadCount; ++i) {
+        avifScaleThreadData * tdata = &threads[i];
+        tdata->jobs = jobs;
+        tdata->jobCount = jobCount;
+        tdata->firstJob = i;
+        tdata->jobStep = usedThreadCount;
+        tdata->depth = depth;
+        tdata->filter = filter;
+        tdata->maxSrcWidth = maxSrcWidth;
+        tdata->result = AVIF_RESULT_OK;
+        tdata->thread = NULL;
+        if (i > 0) {
+            tdata->thread = avifThreadCreate(&avifScaleThreadWorker, tdata);
+            if (!tdata->thread) {
+                result = AVIF_RESULT_UNKNOWN_ERROR;
+                break;
+            }
+        }
+    }
+    // If above loop ran successfully, run the first thread's jobs in the current thread.
+    if (i == usedThreadCount) {
+        avifScaleThreadWorker(&threads[0]);
+    }
+    for (uint32_t t = 0; t < i; ++t) {
+        avifScaleThreadData * tdata = &threads[t];
+        if (tdata->thread && !avifThreadJoin(tdata->thread)) {
+            result = AVIF_RESULT_UNKNOWN_ERROR;
+        }
+        if ((result == AVIF_RESULT_OK) && (tdata->result != AVIF_RESULT_OK)) {
+            result = tdata->result;
+        }
+    }
+    for (uint32_t j = 0; (j < jobCount) && (result == AVIF_RESULT_OK); ++j) {
+        if (jobs[j].libyuvFailure) {
+            avifDiagnosticsPrintf(diag, "%s() failed (%d)", (depth > 8) ? "ScalePlane_12" : "ScalePlane", jobs[j].libyuvFailure);
+            result = (jobs[j].libyuvFailure == 1) ? AVIF_RESULT_OUT_OF_MEMORY : AVIF_RESULT_UNKNOWN_ERROR;
+        }
+    }
+
+    avifFree(jobs);
+    avifFree(threads);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
 
 avifResult avifImageScaleWithLimit(avifImage * image,
                                    uint32_t dstWidth,
                                    uint32_t dstHeight,
+                                   avifScaleFilter filter,
+                                   int maxThreads,
                                    uint32_t imageSizeLimit,
                                    uint32_t imageDimensionLimit,
                                    avifDiagnostics * diag)
@@ -41,6 +405,15 @@ avifResult avifImageScaleWithLimit(avifImage * image,
         avifDiagnosticsPrintf(diag, "avifImageScaleWithLimit requested dst dimensions that are too large [%ux%u]", dstWidth, dstHeight);
         return AVIF_RESULT_NOT_IMPLEMENTED;
     }
+    if ((filter < AVIF_SCALE_FILTER_AUTOMATIC) || (filter > AVIF_SCALE_FILTER_LANCZOS) || (maxThreads < 0)) {
+        avifDiagnosticsPrintf(diag, "avifImageScaleWithLimit requested invalid filter (%d) or maxThreads (%d)", (int)filter,
+                              maxThreads);
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    if (filter == AVIF_SCALE_FILTER_AUTOMATIC) {
+        // Same as BOX, whether the planes end up scaled by libyuv or by the built-in resampler.
+        filter = AVIF_SCALE_FILTER_BOX;
+    }
 
     uint8_t * srcYUVPlanes[AVIF_PLANE_COUNT_YUV];
     uint32_t srcYUVRowBytes[AVIF_PLANE_COUNT_YUV];
@@ -67,22 +440,11 @@ avifResult avifImageScaleWithLimit(avifImage * image,
     image->width = dstWidth;
     image->height = dstHeight;
 
-    avifResult result = AVIF_RESULT_OK;
-    if (srcYUVPlanes[0] || srcAlphaPlane) {
-        // A simple conservative check to avoid integer overflows in libyuv's ScalePlane() and
-        // ScalePlane_12() functions.
-        if (srcWidth > 16384) {
-            avifDiagnosticsPrintf(diag, "avifImageScaleWithLimit requested invalid width scale for libyuv [%u -> %u]", srcWidth, dstWidth);
-            result = AVIF_RESULT_NOT_IMPLEMENTED;
-            goto cleanup;
-        }
-        if (srcHeight > 16384) {
-            avifDiagnosticsPrintf(diag, "avifImageScaleWithLimit requested invalid height scale for libyuv [%u -> %u]", srcHeight, dstHeight);
-            result = AVIF_RESULT_NOT_IMPLEMENTED;
-            goto cleanup;
-        }
-    }
+    avifScalePlane planes[AVIF_PLANE_COUNT_YUV + 1];
+    memset(planes, 0, sizeof(planes));
+    uint32_t planeCount = 0;
 
+    avifResult result = AVIF_RESULT_OK;
     if (srcYUVPlanes[0]) {
         const avifResult allocationResult = avifImageAllocatePlanes(image, AVIF_PLANES_YUV);
         if (allocationResult != AVIF_RESULT_OK) {
@@ -95,45 +457,15 @@ avifResult avifImageScaleWithLimit(avifImage * image,
             if (!srcYUVPlanes[i]) {
                 continue;
             }
-
-            const uint32_t srcW = (i == AVIF_CHAN_Y) ? srcWidth : srcUVWidth;
-            const uint32_t srcH = (i == AVIF_CHAN_Y) ? srcHeight : srcUVHeight;
-            const uint32_t dstW = avifImagePlaneWidth(image, i);
-            const uint32_t dstH = avifImagePlaneHeight(image, i);
-            if (image->depth > 8) {
-                uint16_t * const srcPlane = (uint16_t *)srcYUVPlanes[i];
-                const uint32_t srcStride = srcYUVRowBytes[i] / 2;
-                uint16_t * const dstPlane = (uint16_t *)image->yuvPlanes[i];
-                const uint32_t dstStride = image->yuvRowBytes[i] / 2;
-#if LIBYUV_VERSION >= 1880
-                const int failure =
-                    ScalePlane_12(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, AVIF_LIBYUV_FILTER_MODE);
-                if (failure) {
-                    avifDiagnosticsPrintf(diag, "ScalePlane_12() failed (%d)", failure);
-                    result = (failure == 1) ? AVIF_RESULT_OUT_OF_MEMORY : AVIF_RESULT_UNKNOWN_ERROR;
-                    goto cleanup;
-                }
-#elif LIBYUV_VERSION >= 1774
-                ScalePlane_12(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, AVIF_LIBYUV_FILTER_MODE);
-#else
-                ScalePlane_16(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, AVIF_LIBYUV_FILTER_MODE);
-#endif
-            } else {
-                uint8_t * const srcPlane = srcYUVPlanes[i];
-                const uint32_t srcStride = srcYUVRowBytes[i];
-                uint8_t * const dstPlane = image->yuvPlanes[i];
-                const uint32_t dstStride = image->yuvRowBytes[i];
-#if LIBYUV_VERSION >= 1880
-                const int failure = ScalePlane(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, AVIF_LIBYUV_FILTER_MODE);
-                if (failure) {
-                    avifDiagnosticsPrintf(diag, "ScalePlane() failed (%d)", failure);
-                    result = (failure == 1) ? AVIF_RESULT_OUT_OF_MEMORY : AVIF_RESULT_UNKNOWN_ERROR;
-                    goto cleanup;
-                }
-#else
-                ScalePlane(srcPlane, srcStride, srcW, srcH, dstPlane, dstStride, dstW, dstH, AVIF_LIBYUV_FILTER_MODE);
-#endif
-            }
+            avifScalePlane * plane = &planes[planeCount++];
+            plane->src = srcYUVPlanes[i];
+            plane->srcRowBytes = srcYUVRowBytes[i];
+            plane->srcWidth = (i == AVIF_CHAN_Y) ? srcWidth : srcUVWidth;
+            plane->srcHeight = (i == AVIF_CHAN_Y) ? srcHeight : srcUVHeight;
+            plane->dst = image->yuvPlanes[i];
+            plane->dstRowBytes = image->yuvRowBytes[i];
+            plane->dstWidth = avifImagePlaneWidth(image, i);
+            plane->dstHeight = avifImagePlaneHeight(image, i);
         }
     }
 
@@ -141,47 +473,27 @@ avifResult avifImageScaleWithLimit(avifImage * image,
         const avifResult allocationResult = avifImageAllocatePlanes(image, AVIF_PLANES_A);
         if (allocationResult != AVIF_RESULT_OK) {
             avifDiagnosticsPrintf(diag, "Allocation of alpha plane failed: %s", avifResultToString(allocationResult));
-            return AVIF_RESULT_OUT_OF_MEMORY;
-        }
-
-        if (image->depth > 8) {
-            uint16_t * const srcPlane = (uint16_t *)srcAlphaPlane;
-            const uint32_t srcStride = srcAlphaRowBytes / 2;
-            uint16_t * const dstPlane = (uint16_t *)image->alphaPlane;
-            const uint32_t dstStride = image->alphaRowBytes / 2;
-#if LIBYUV_VERSION >= 1880
-            const int failure =
-                ScalePlane_12(srcPlane, srcStride, srcWidth, srcHeight, dstPlane, dstStride, dstWidth, dstHeight, AVIF_LIBYUV_FILTER_MODE);
-            if (failure) {
-                avifDiagnosticsPrintf(diag, "ScalePlane_12() failed (%d)", failure);
-                result = (failure == 1) ? AVIF_RESULT_OUT_OF_MEMORY : AVIF_RESULT_UNKNOWN_ERROR;
-                goto cleanup;
-            }
-#elif LIBYUV_VERSION >= 1774
-            ScalePlane_12(srcPlane, srcStride, srcWidth, srcHeight, dstPlane, dstStride, dstWidth, dstHeight, AVIF_LIBYUV_FILTER_MODE);
-#else
-            ScalePlane_16(srcPlane, srcStride, srcWidth, srcHeight, dstPlane, dstStride, dstWidth, dstHeight, AVIF_LIBYUV_FILTER_MODE);
-#endif
-        } else {
-            uint8_t * const srcPlane = srcAlphaPlane;
-            const uint32_t srcStride = srcAlphaRowBytes;
-            uint8_t * const dstPlane = image->alphaPlane;
-            const uint32_t dstStride = image->alphaRowBytes;
-#if LIBYUV_VERSION >= 1880
-            const int failure =
-                ScalePlane(srcPlane, srcStride, srcWidth, srcHeight, dstPlane, dstStride, dstWidth, dstHeight, AVIF_LIBYUV_FILTER_MODE);
-            if (failure) {
-                avifDiagnosticsPrintf(diag, "ScalePlane() failed (%d)", failure);
-                result = (failure == 1) ? AVIF_RESULT_OUT_OF_MEMORY : AVIF_RESULT_UNKNOWN_ERROR;
-                goto cleanup;
-            }
-#else
-            ScalePlane(srcPlane, srcStride, srcWidth, srcHeight, dstPlane, dstStride, dstWidth, dstHeight, AVIF_LIBYUV_FILTER_MODE);
-#endif
+            result = AVIF_RESULT_OUT_OF_MEMORY;
+            goto cleanup;
         }
+        avifScalePlane * plane = &planes[planeCount++];
+        plane->src = srcAlphaPlane;
+        plane->srcRowBytes = srcAlphaRowBytes;
+        plane->srcWidth = srcWidth;
+        plane->srcHeight = srcHeight;
+        plane->dst = image->alphaPlane;
+        plane->dstRowBytes = image->alphaRowBytes;
+        plane->dstWidth = dstWidth;
+        plane->dstHeight = dstHeight;
     }
 
+    result = avifScalePlanes(planes, planeCount, image->depth, filter, maxThreads, diag);
+
 cleanup:
+    for (uint32_t i = 0; i < planeCount; ++i) {
+        avifScaleContributionsDestroy(&planes[i].horizontal);
+        avifScaleContributionsDestroy(&planes[i].vertical);
+    }
     if (srcYUVPlanes[0] && srcImageOwnsYUVPlanes) {
         for (int i = 0; i < AVIF_PLANE_COUNT_YUV; ++i) {
             avifFree(srcYUVPlanes[i]);
@@ -194,7 +506,213 @@ cleanup:
 }
 
 avifResult avifImageScale(avifImage * image, uint32_t dstWidth, uint32_t dstHeight, avifDiagnostics * diag)
+{
+    return avifImageScaleWithFilter(image, dstWidth, dstHeight, AVIF_SCALE_FILTER_AUTOMATIC, /*maxThreads=*/1, diag);
+}
+
+avifResult avifImageScaleWithFilter(avifImage * image,
+                                    uint32_t dstWidth,
+                                    uint32_t dstHeight,
+                                    avifScaleFilter filter,
+                                    int maxThreads,
+                                    avifDiagnostics * diag)
 {
     avifDiagnosticsClearError(diag);
-    return avifImageScaleWithLimit(image, dstWidth, dstHeight, AVIF_DEFAULT_IMAGE_SIZE_LIMIT, AVIF_DEFAULT_IMAGE_DIMENSION_LIMIT, diag);
+    return avifImageScaleWithLimit(image,
+                                   dstWidth,
+                                   dstHeight,
+                                   filter,
+                                   maxThreads,
+                                   AVIF_DEFAULT_IMAGE_SIZE_LIMIT,
+                                   AVIF_DEFAULT_IMAGE_DIMENSION_LIMIT,
+                                   diag);
+}
+
+// ---------------------------------------------------------------------------
+// Scaled YUV to RGB conversion
+
+// Number of rows of the scaled image that are resampled and converted at once by avifImageYUVToRGBScaled().
+#define AVIF_SCALE_STRIP_HEIGHT 32
+
+typedef struct avifYUVToRGBScaledThreadData
+{
+    avifThread * thread;
+    const avifImage * image;
+    const avifScalePlane * planes;
+    uint32_t planeCount;
+    avifRGBImage * rgb;
+    avifImage * strip; // Owned. The resampled rows of the strip being converted, as a 4:4:4 (or 4:0:0) image.
+    uint8_t * stripPlanes[AVIF_PLANE_COUNT_YUV + 1]; // The planes of strip, in the order of planes.
+    float * row;                                       // Owned. maxSrcWidth floats.
+    avifReformatState state;
+    avifAlphaMultiplyMode alphaMultiplyMode;
+    uint32_t stripHeight;
+    uint32_t firstStrip; // This thread converts the strips firstStrip, firstStrip+stripStep, firstStrip+2*stripStep etc.
+    uint32_t stripStep;
+    avifResult result;
+} avifYUVToRGBScaledThreadData;
+
+static void avifYUVToRGBScaledThreadWorker(void * arg)
+{
+    avifYUVToRGBScaledThreadData * data = (avifYUVToRGBScaledThreadData *)arg;
+    const avifRGBImage * rgb = data->rgb;
+    data->result = AVIF_RESULT_OK;
+    for (uint32_t s = data->firstStrip; (data->result == AVIF_RESULT_OK) && (s * data->stripHeight < rgb->height);
+         s += data->stripStep) {
+        const uint32_t firstRow = s * data->stripHeight;
+        const uint32_t rowCount = AVIF_MIN(data->stripHeight, rgb->height - firstRow);
+        for (uint32_t p = 0; p < data->planeCount; ++p) {
+            avifScalePlaneRows(&data->planes[p], data->image->depth, firstRow, rowCount, data->stripPlanes[p], data->row);
+        }
+        data->strip->height = rowCount;
+        avifRGBImage rgbStrip = *rgb;
+        rgbStrip.pixels += (size_t)firstRow * rgb->rowBytes;
+        rgbStrip.height = rowCount;
+        data->result = avifImageYUVToRGBWithState(data->strip, &rgbStrip, &data->state, data->alphaMultiplyMode);
+    }
+}
+
+avifResult avifImageYUVToRGBScaled(const avifImage * image, avifRGBImage * rgb, avifScaleFilter filter)
+{
+    if (!image->yuvPlanes[AVIF_CHAN_Y] || !rgb->pixels || (rgb->width == 0) || (rgb->height == 0) || (rgb->maxThreads < 0)) {
+        return AVIF_RESULT_REFORMAT_FAILED;
+    }
+    if ((filter < AVIF_SCALE_FILTER_AUTOMATIC) || (filter > AVIF_SCALE_FILTER_LANCZOS)) {
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+    if (filter == AVIF_SCALE_FILTER_AUTOMATIC) {
+        filter = AVIF_SCALE_FILTER_BOX;
+    }
+    if ((rgb->width == image->width) && (rgb->height == image->height)) {
+        return avifImageYUVToRGB(image, rgb);
+    }
+
+    // The chroma planes are resampled straight to the output dimensions, which upsamples them at the same time. Each
+    // strip is thus a 4:4:4 (or 4:0:0) image, converted like avifImageYUVToRGB() does with a state prepared only once.
+    // The strips are split between up to rgb->maxThreads threads (the current one included), each with its own strip
+    // buffers. The resampling contributions are shared.
+    const avifBool hasColor = (image->yuvFormat != AVIF_PIXEL_FORMAT_YUV400) && image->yuvPlanes[AVIF_CHAN_U] &&
+                              image->yuvPlanes[AVIF_CHAN_V];
+    const avifBool hasAlpha = (image->alphaPlane != NULL);
+    const uint32_t stripHeight = AVIF_MIN(AVIF_SCALE_STRIP_HEIGHT, rgb->height);
+    const uint32_t stripCount = (rgb->height + stripHeight - 1) / stripHeight;
+    const uint32_t threadCount = AVIF_MIN((uint32_t)AVIF_CLAMP(rgb->maxThreads, 1, 64), stripCount);
+
+    avifScalePlane planes[AVIF_PLANE_COUNT_YUV + 1];
+    memset(planes, 0, sizeof(planes));
+    uint32_t planeCount = 0;
+    uint32_t maxSrcWidth = 0;
+    uint32_t t = 0;
+    avifYUVToRGBScaledThreadData * threads =
+        (avifYUVToRGBScaledThreadData *)avifAlloc(sizeof(avifYUVToRGBScaledThreadData) * threadCount);
+    if (!threads) {
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+    memset(threads, 0, sizeof(avifYUVToRGBScaledThreadData) * threadCount);
+
+    avifResult result = AVIF_RESULT_OK;
+    for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_A; ++c) {
+        const avifBool isChroma = (c == AVIF_CHAN_U) || (c == AVIF_CHAN_V);
+        if ((isChroma && !hasColor) || ((c == AVIF_CHAN_A) && !hasAlpha)) {
+            continue;
+        }
+        avifScalePlane * plane = &planes[planeCount++];
+        plane->src = avifImagePlane(image, c);
+        plane->srcRowBytes = avifImagePlaneRowBytes(image, c);
+        plane->srcWidth = avifImagePlaneWidth(image, c);
+        plane->srcHeight = avifImagePlaneHeight(image, c);
+        plane->dstWidth = rgb->width;
+        plane->dstHeight = rgb->height;
+        maxSrcWidth = AVIF_MAX(maxSrcWidth, plane->srcWidth);
+        result = avifScaleContributionsCreate(&plane->horizontal, filter, plane->srcWidth, plane->dstWidth);
+        if (result == AVIF_RESULT_OK) {
+            result = avifScaleContributionsCreate(&plane->vertical, filter, plane->srcHeight, plane->dstHeight);
+        }
+        if (result != AVIF_RESULT_OK) {
+            goto cleanup;
+        }
+    }
+
+    for (t = 0; t < threadCount; ++t) {
+        avifYUVToRGBScaledThreadData * data = &threads[t];
+        const avifPixelFormat stripFormat = hasColor ? AVIF_PIXEL_FORMAT_YUV444 : AVIF_PIXEL_FORMAT_YUV400;
+        data->strip = avifImageCreate(rgb->width, stripHeight, image->depth, stripFormat);
+        data->row = (float *)avifAlloc(sizeof(float) * maxSrcWidth);
+        if (!data->strip || !data->row) {
+            result = AVIF_RESULT_OUT_OF_MEMORY;
+            goto cleanup;
+        }
+        data->strip->yuvRange = image->yuvRange;
+        data->strip->colorPrimaries = image->colorPrimaries;
+        data->strip->transferCharacteristics = image->transferCharacteristics;
+        data->strip->matrixCoefficients = image->matrixCoefficients;
+        data->strip->alphaPremultiplied = image->alphaPremultiplied;
+        result = avifImageAllocatePlanes(data->strip, hasAlpha ? AVIF_PLANES_ALL : AVIF_PLANES_YUV);
+        if (result != AVIF_RESULT_OK) {
+            goto cleanup;
+        }
+        // The strips of all threads have the same dimensions and thus the same row strides.
+        uint32_t p = 0;
+        for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_A; ++c) {
+            if (avifImagePlane(data->strip, c)) {
+                planes[p].dstRowBytes = avifImagePlaneRowBytes(data->strip, c);
+                data->stripPlanes[p++] = avifImagePlane(data->strip, c);
+            }
+        }
+        // All strips share the same properties, so the conversion only has to be prepared once.
+        if (t == 0) {
+            result = avifImageYUVToRGBPrepare(data->strip, rgb, &data->state, &data->alphaMultiplyMode);
+            if (result != AVIF_RESULT_OK) {
+                goto cleanup;
+            }
+        } else {
+            data->state = threads[0].state;
+            data->alphaMultiplyMode = threads[0].alphaMultiplyMode;
+        }
+        data->image = image;
+        data->planes = planes;
+        data->planeCount = planeCount;
+        data->rgb = rgb;
+        data->stripHeight = stripHeight;
+        data->firstStrip = t;
+        data->stripStep = threadCount;
+    }
+
+    // The first thread's strips are converted in the current thread.
+    for (t = 1; t < threadCount; ++t) {
+        threads[t].thread = avifThreadCreate(&avifYUVToRGBScaledThreadWorker, &threads[t]);
+        if (!threads[t].thread) {
+            result = AVIF_RESULT_UNKNOWN_ERROR;
+            break;
+        }
+    }
+    if (result == AVIF_RESULT_OK) {
+        avifYUVToRGBScaledThreadWorker(&threads[0]);
+        result = threads[0].result;
+    }
+    for (t = 1; t < threadCount; ++t) {
+        if (threads[t].thread) {
+            if (!avifThreadJoin(threads[t].thread) && (result == AVIF_RESULT_OK)) {
+                result = AVIF_RESULT_UNKNOWN_ERROR;
+            }
+            if (result == AVIF_RESULT_OK) {
+                result = threads[t].result;
+            }
+        }
+    }
+
+cleanup:
+    for (t = 0; t < threadCount; ++t) {
+        avifFree(threads[t].row);
+        if (threads[t].strip) {
+            threads[t].strip->height = stripHeight;
+            avifImageDestroy(threads[t].strip);
+        }
+    }
+    avifFree(threads);
+    for (uint32_t p = 0; p < planeCount; ++p) {
+        avifScaleContributionsDestroy(&planes[p].horizontal);
+        avifScaleContributionsDestroy(&planes[p].vertical);
+    }
+    return result;
 }
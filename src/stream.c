@@ -147,6 +147,22 @@ avifBool avifROStreamReadU64(avifROStream * stream, uint64_t * v)
     return AVIF_TRUE;
 }
 
+avifBool avifROStreamReadArray(avifROStream * stream, size_t count, size_t elementSize, const uint8_t ** data)
+{
+    assert(stream->numUsedBitsInPartialByte == 0); // Byte alignment is required.
+    if (count > avifROStreamRemainingBytes(stream) / elementSize) {
+        avifDiagnosticsPrintf(stream->diag,
+                              "%s: Failed to read %zu values of %zu bytes, truncated data?",
+                              stream->diagContext,
+                              count,
+                              elementSize);
+        return AVIF_FALSE;
+    }
+    *data = stream->raw->data + stream->offset;
+    stream->offset += count * elementSize;
+    return AVIF_TRUE;
+}
+
 // Override of avifROStreamReadBits() for convenient uint8_t output.
 avifBool avifROStreamReadBits8(avifROStream * stream, uint8_t * v, size_t bitCount)
 {
@@ -316,14 +332,18 @@ avifBool avifROStreamReadAndEnforceVersion(avifROStream * stream, uint8_t enforc
 // ---------------------------------------------------------------------------
 // avifRWStream
 
-#define AVIF_STREAM_BUFFER_INCREMENT (1024 * 1024)
+// Smallest allocation made for a stream. Larger buffers grow geometrically so that writing N bytes costs O(N) copies.
+#define AVIF_STREAM_BUFFER_MIN_SIZE 4096
 static avifResult makeRoom(avifRWStream * stream, size_t size)
 {
-    size_t neededSize = stream->offset + size;
-    size_t newSize = stream->raw->size;
-    while (newSize < neededSize) {
-        newSize += AVIF_STREAM_BUFFER_INCREMENT;
+    AVIF_CHECKERR(size <= SIZE_MAX - stream->offset, AVIF_RESULT_OUT_OF_MEMORY);
+    const size_t neededSize = stream->offset + size;
+    if (neededSize <= stream->raw->size) {
+        return AVIF_RESULT_OK;
     }
+    size_t newSize = (stream->raw->size <= SIZE_MAX / 2) ? stream->raw->size * 2 : SIZE_MAX;
+    newSize = AVIF_MAX(newSize, AVIF_STREAM_BUFFER_MIN_SIZE);
+    newSize = AVIF_MAX(newSize, neededSize);
     return avifRWDataRealloc(stream->raw, newSize);
 }
 
@@ -347,6 +367,16 @@ void avifRWStreamSetOffset(avifRWStream * stream, size_t offset)
     }
 }
 
+avifResult avifRWStreamReserve(avifRWStream * stream, size_t size)
+{
+    AVIF_CHECKERR(size <= SIZE_MAX - stream->offset, AVIF_RESULT_OUT_OF_MEMORY);
+    const size_t neededSize = stream->offset + size;
+    if (neededSize <= stream->raw->size) {
+        return AVIF_RESULT_OK;
+    }
+    return avifRWDataRealloc(stream->raw, neededSize);
+}
+
 void avifRWStreamFinishWrite(avifRWStream * stream)
 {
     if (stream->raw->size != stream->offset) {
@@ -0,0 +1,75 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include "avif/internal.h"
+
+#if defined(_WIN32)
+#include <process.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+struct avifThread
+{
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    avifThreadFunc func;
+    void * arg;
+};
+
+#if defined(_WIN32)
+static unsigned int __stdcall avifThreadStart(void * arg)
+#else
+static void * avifThreadStart(void * arg)
+#endif
+{
+    avifThread * thread = (avifThread *)arg;
+    thread->func(thread->arg);
+#if defined(_WIN32)
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+avifThread * avifThreadCreate(avifThreadFunc func, void * arg)
+{
+    avifThread * thread = (avifThread *)avifAlloc(sizeof(avifThread));
+    if (!thread) {
+        return NULL;
+    }
+    thread->func = func;
+    thread->arg = arg;
+#if defined(_WIN32)
+    thread->handle = (HANDLE)_beginthreadex(/*security=*/NULL,
+                                            /*stack_size=*/0,
+                                            &avifThreadStart,
+                                            thread,
+                                            /*initflag=*/0,
+                                            /*thrdaddr=*/NULL);
+    const avifBool created = (thread->handle != NULL);
+#else
+    // TODO: Set the thread name for ease of debugging.
+    const avifBool created = (pthread_create(&thread->handle, NULL, &avifThreadStart, thread) == 0);
+#endif
+    if (!created) {
+        avifFree(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+avifBool avifThreadJoin(avifThread * thread)
+{
+#if defined(_WIN32)
+    const avifBool joined = WaitForSingleObject(thread->handle, INFINITE) == WAIT_OBJECT_0 && CloseHandle(thread->handle) != 0;
+#else
+    const avifBool joined = (pthread_join(thread->handle, NULL) == 0);
+#endif
+    avifFree(thread);
+    return joined;
+}
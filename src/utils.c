@@ -88,14 +88,30 @@ avifBool avifArrayCreate(void * arrayStruct, uint32_t elementSize, uint32_t init
     avifArrayInternal * arr = (avifArrayInternal *)arrayStruct;
     arr->elementSize = elementSize ? elementSize : 1;
     arr->count = 0;
-    arr->capacity = initialCapacity;
-    size_t byteCount = (size_t)arr->elementSize * arr->capacity;
-    arr->ptr = (uint8_t *)avifAlloc(byteCount);
-    if (!arr->ptr) {
-        arr->capacity = 0;
+    arr->capacity = 0;
+    arr->ptr = NULL;
+    return avifArrayReserve(arr, initialCapacity);
+}
+
+avifBool avifArrayReserve(void * arrayStruct, uint32_t capacity)
+{
+    avifArrayInternal * arr = (avifArrayInternal *)arrayStruct;
+    if (capacity <= arr->capacity) {
+        return AVIF_TRUE;
+    }
+    const size_t oldByteCount = (size_t)arr->elementSize * arr->capacity;
+    const size_t newByteCount = (size_t)arr->elementSize * capacity;
+    uint8_t * newPtr = (uint8_t *)avifAlloc(newByteCount);
+    if (newPtr == NULL) {
         return AVIF_FALSE;
     }
-    memset(arr->ptr, 0, byteCount);
+    if (arr->ptr) {
+        memcpy(newPtr, arr->ptr, oldByteCount);
+        avifFree(arr->ptr);
+    }
+    memset(newPtr + oldByteCount, 0, newByteCount - oldByteCount);
+    arr->ptr = newPtr;
+    arr->capacity = capacity;
     return AVIF_TRUE;
 }
 
@@ -103,16 +119,9 @@ void * avifArrayPush(void * arrayStruct)
 {
     avifArrayInternal * arr = (avifArrayInternal *)arrayStruct;
     if (arr->count == arr->capacity) {
-        uint8_t * oldPtr = arr->ptr;
-        size_t oldByteCount = (size_t)arr->elementSize * arr->capacity;
-        arr->ptr = (uint8_t *)avifAlloc(oldByteCount * 2);
-        if (arr->ptr == NULL) {
+        if (!avifArrayReserve(arr, arr->capacity ? arr->capacity * 2 : 1)) {
             return NULL;
         }
-        memset(arr->ptr + oldByteCount, 0, oldByteCount);
-        memcpy(arr->ptr, oldPtr, oldByteCount);
-        arr->capacity *= 2;
-        avifFree(oldPtr);
     }
     ++arr->count;
     return &arr->ptr[(arr->count - 1) * (size_t)arr->elementSize];
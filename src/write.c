@@ -182,6 +182,13 @@ typedef struct avifEncoderItem
 
     uint16_t dimgFromID; // if non-zero, make an iref from dimgFromID -> this id
 
+    // if non-zero, this item is a thumbnail of the primary item (or the alpha auxiliary item of such a thumbnail),
+    // scaled down to these dimensions
+    uint32_t thumbnailWidth;
+    uint32_t thumbnailHeight;
+
+    uint16_t duplicateOfID; // if non-zero, this grid cell has the same pixels as this earlier cell and was not encoded
+
     struct ipmaArray ipma;
 } avifEncoderItem;
 AVIF_ARRAY_DECLARE(avifEncoderItemArray, avifEncoderItem, item);
@@ -234,8 +241,10 @@ typedef struct avifEncoderData
     avifEncoderItemIdArray alternativeItemIDs; // list of item ids for an 'altr' box (group of alternatives to each other)
     avifBool singleImage; // if true, the AVIF_ADD_IMAGE_FLAG_SINGLE flag was set on the first call to avifEncoderAddImage()
     avifBool alphaPresent;
+    avifBool encodedInput; // if true, the samples were given to avifEncoderAddEncodedImage() and items have no codec
     size_t gainMapSizeBytes;
     // Fields specific to AV1/AV2
+    avifCodecType codecType;
     const char * imageItemType;  // "av01" for AV1 ("av02" for AV2 if AVIF_CODEC_AVM)
     const char * configPropName; // "av1C" for AV1 ("av2C" for AV2 if AVIF_CODEC_AVM)
 } avifEncoderData;
@@ -1116,9 +1125,11 @@ static avifResult avifEncoderAddImageItems(avifEncoder * encoder,
         avifEncoderItem * item =
             avifEncoderDataCreateItem(encoder->data, encoder->data->imageItemType, infeName, infeNameSize, cellIndex);
         AVIF_CHECKERR(item, AVIF_RESULT_OUT_OF_MEMORY);
-        AVIF_CHECKRES(avifCodecCreate(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE, &item->codec));
-        item->codec->csOptions = encoder->csOptions;
-        item->codec->diag = &encoder->diag;
+        if (!encoder->data->encodedInput) {
+            AVIF_CHECKRES(avifCodecCreate(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE, &item->codec));
+            item->codec->csOptions = encoder->csOptions;
+            item->codec->diag = &encoder->diag;
+        }
         item->itemCategory = itemCategory;
         item->extraLayerCount = encoder->extraLayerCount;
 
@@ -1132,6 +1143,55 @@ static avifResult avifEncoderAddImageItems(avifEncoder * encoder,
     return AVIF_RESULT_OK;
 }
 
+// Outputs the dimensions of a thumbnail of image whose largest dimension is thumbnailSize, keeping the aspect ratio.
+static void avifGetThumbnailDimensions(const avifImage * image, uint32_t thumbnailSize, uint32_t * width, uint32_t * height)
+{
+    if (image->width >= image->height) {
+        *width = thumbnailSize;
+        *height = (uint32_t)AVIF_MAX(((uint64_t)image->height * thumbnailSize + image->width / 2) / image->width, 1);
+    } else {
+        *width = (uint32_t)AVIF_MAX(((uint64_t)image->width * thumbnailSize + image->height / 2) / image->height, 1);
+        *height = thumbnailSize;
+    }
+}
+
+// Adds a thumbnail item of the primary item for each entry of encoder->thumbnailSizes, with an alpha auxiliary item
+// if alpha is present. The samples of these items are encoded by avifEncoderEncodeThumbnails().
+static avifResult avifEncoderAddThumbnailItems(avifEncoder * encoder, const avifImage * image)
+{
+    for (int i = 0; i < AVIF_MAX_THUMBNAIL_COUNT; ++i) {
+        const uint32_t thumbnailSize = encoder->thumbnailSizes[i];
+        if ((thumbnailSize == 0) || (thumbnailSize >= AVIF_MAX(image->width, image->height))) {
+            continue;
+        }
+        uint32_t thumbnailWidth, thumbnailHeight;
+        avifGetThumbnailDimensions(image, thumbnailSize, &thumbnailWidth, &thumbnailHeight);
+
+        uint16_t thumbnailItemID;
+        AVIF_CHECKRES(
+            avifEncoderAddImageItems(encoder, 1, 1, thumbnailWidth, thumbnailHeight, AVIF_ITEM_COLOR, &thumbnailItemID));
+        avifEncoderItem * thumbnailItem = avifEncoderDataFindItemByID(encoder->data, thumbnailItemID);
+        assert(thumbnailItem);
+        thumbnailItem->thumbnailWidth = thumbnailWidth;
+        thumbnailItem->thumbnailHeight = thumbnailHeight;
+        thumbnailItem->irefType = "thmb";
+        thumbnailItem->irefToID = encoder->data->primaryItemID;
+
+        if (encoder->data->alphaPresent) {
+            uint16_t alphaItemID;
+            AVIF_CHECKRES(
+                avifEncoderAddImageItems(encoder, 1, 1, thumbnailWidth, thumbnailHeight, AVIF_ITEM_ALPHA, &alphaItemID));
+            avifEncoderItem * alphaItem = avifEncoderDataFindItemByID(encoder->data, alphaItemID);
+            assert(alphaItem);
+            alphaItem->thumbnailWidth = thumbnailWidth;
+            alphaItem->thumbnailHeight = thumbnailHeight;
+            alphaItem->irefType = "auxl";
+            alphaItem->irefToID = thumbnailItemID;
+        }
+    }
+    return AVIF_RESULT_OK;
+}
+
 static avifCodecType avifEncoderGetCodecType(const avifEncoder * encoder)
 {
     // TODO(yguyon): Rework when AVIF_CODEC_CHOICE_AUTO can be AVM
@@ -1140,6 +1200,20 @@ static avifCodecType avifEncoderGetCodecType(const avifEncoder * encoder)
     return avifCodecTypeFromChoice(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE);
 }
 
+// Same as avifEncoderGetCodecType() but for samples given to avifEncoderAddEncodedImage(), which do not need
+// any encoder to be available.
+static avifCodecType avifEncoderGetEncodedInputCodecType(const avifEncoder * encoder)
+{
+#if defined(AVIF_CODEC_AVM)
+    if (encoder->codecChoice == AVIF_CODEC_CHOICE_AVM) {
+        return AVIF_CODEC_TYPE_AV2;
+    }
+#else
+    (void)encoder;
+#endif
+    return AVIF_CODEC_TYPE_AV1;
+}
+
 // This function is called after every color frame is encoded. It returns AVIF_TRUE if a keyframe needs to be forced for the next
 // alpha frame to be encoded, AVIF_FALSE otherwise.
 static avifBool avifEncoderDataShouldForceKeyframeForAlpha(const avifEncoderData * data,
@@ -1174,6 +1248,39 @@ static avifResult avifGetErrorForItemCategory(avifItemCategory itemCategory)
     return (itemCategory == AVIF_ITEM_ALPHA) ? AVIF_RESULT_ENCODE_ALPHA_FAILED : AVIF_RESULT_ENCODE_COLOR_FAILED;
 }
 
+// Checks that the sequence header in the first sample given to avifEncoderAddEncodedImage() exists and is
+// consistent with the image properties that will be written to the container.
+static avifResult avifValidateEncodedSample(avifEncoder * encoder,
+                                            const avifImage * image,
+                                            const avifROData * sample,
+                                            avifCodecType codecType,
+                                            avifItemCategory itemCategory)
+{
+    const char * categoryName = (itemCategory == AVIF_ITEM_ALPHA) ? "alpha" : "color";
+    avifSequenceHeader sequenceHeader;
+    if (!avifSequenceHeaderParse(&sequenceHeader, sample, codecType)) {
+        avifDiagnosticsPrintf(&encoder->diag, "the first encoded %s sample must contain a sequence header", categoryName);
+        return avifGetErrorForItemCategory(itemCategory);
+    }
+    if ((sequenceHeader.bitDepth != image->depth) ||
+        ((itemCategory == AVIF_ITEM_COLOR) && (sequenceHeader.yuvFormat != image->yuvFormat)) ||
+        (sequenceHeader.maxWidth < image->width) || (sequenceHeader.maxHeight < image->height)) {
+        avifDiagnosticsPrintf(&encoder->diag,
+                              "the encoded %s sample (%ux%u, %u-bit, %s) does not match the image (%ux%u, %u-bit, %s)",
+                              categoryName,
+                              sequenceHeader.maxWidth,
+                              sequenceHeader.maxHeight,
+                              sequenceHeader.bitDepth,
+                              avifPixelFormatToString(sequenceHeader.yuvFormat),
+                              image->width,
+                              image->height,
+                              image->depth,
+                              avifPixelFormatToString(image->yuvFormat));
+        return AVIF_RESULT_INCOMPATIBLE_IMAGE;
+    }
+    return AVIF_RESULT_OK;
+}
+
 static avifResult avifValidateImageBasicProperties(const avifImage * avifImage)
 {
     if ((avifImage->depth != 8) && (avifImage->depth != 10) && (avifImage->depth != 12)) {
@@ -1273,17 +1380,182 @@ static avifResult avifValidateGrid(uint32_t gridCols,
     return AVIF_RESULT_OK;
 }
 
+// Returns the image encoded as the cell item, before any padding.
+static const avifImage * avifEncoderItemGetCellImage(const avifEncoderItem * item, const avifImage * const * cellImages)
+{
+    const avifImage * cellImage = cellImages[item->cellIndex];
+#if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
+    if (item->itemCategory == AVIF_ITEM_GAIN_MAP) {
+        cellImage = cellImage->gainMap.image;
+        assert(cellImage);
+    }
+#endif
+    return cellImage;
+}
+
+// Returns AVIF_TRUE if the plane of the given channel is encoded in an item of the given category.
+static avifBool avifItemCategoryEncodesChannel(avifItemCategory itemCategory, int channel)
+{
+    return (itemCategory == AVIF_ITEM_ALPHA) == (channel == AVIF_CHAN_A);
+}
+
+// Returns a 64-bit FNV-1a hash of the dimensions and of the samples of image encoded in an item of the given category.
+static uint64_t avifImageHashCellPlanes(const avifImage * image, avifItemCategory itemCategory)
+{
+    const uint64_t prime = 0x100000001b3;
+    uint64_t hash = 0xcbf29ce484222325;
+    hash = (hash ^ image->width) * prime;
+    hash = (hash ^ image->height) * prime;
+    const size_t bytesPerSample = avifImageUsesU16(image) ? 2 : 1;
+    for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_A; ++c) {
+        const uint8_t * plane = avifImagePlane(image, c);
+        if (!plane || !avifItemCategoryEncodesChannel(itemCategory, c)) {
+            continue;
+        }
+        const uint32_t rowBytes = avifImagePlaneRowBytes(image, c);
+        const size_t widthBytes = avifImagePlaneWidth(image, c) * bytesPerSample;
+        const uint32_t height = avifImagePlaneHeight(image, c);
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint8_t * row = &plane[(size_t)y * rowBytes];
+            // Hash 8 bytes at a time. This is not the canonical FNV-1a but it is as good at telling cells apart, and faster.
+            size_t x = 0;
+            for (; x + sizeof(uint64_t) <= widthBytes; x += sizeof(uint64_t)) {
+                uint64_t word;
+                memcpy(&word, &row[x], sizeof(word));
+                hash = (hash ^ word) * prime;
+            }
+            for (; x < widthBytes; ++x) {
+                hash = (hash ^ row[x]) * prime;
+            }
+        }
+    }
+    return hash;
+}
+
+// Returns AVIF_TRUE if image1 and image2 have the same dimensions and the same samples in the planes encoded in an item
+// of the given category.
+static avifBool avifImageCellPlanesEqual(const avifImage * image1, const avifImage * image2, avifItemCategory itemCategory)
+{
+    if ((image1->width != image2->width) || (image1->height != image2->height)) {
+        return AVIF_FALSE;
+    }
+    const size_t bytesPerSample = avifImageUsesU16(image1) ? 2 : 1;
+    for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_A; ++c) {
+        const uint8_t * plane1 = avifImagePlane(image1, c);
+        const uint8_t * plane2 = avifImagePlane(image2, c);
+        if (!avifItemCategoryEncodesChannel(itemCategory, c) || (!plane1 && !plane2)) {
+            continue;
+        }
+        if (!plane1 || !plane2) {
+            return AVIF_FALSE;
+        }
+        const uint32_t rowBytes1 = avifImagePlaneRowBytes(image1, c);
+        const uint32_t rowBytes2 = avifImagePlaneRowBytes(image2, c);
+        const size_t widthBytes = avifImagePlaneWidth(image1, c) * bytesPerSample;
+        const uint32_t height = avifImagePlaneHeight(image1, c);
+        for (uint32_t y = 0; y < height; ++y) {
+            if (memcmp(&plane1[(size_t)y * rowBytes1], &plane2[(size_t)y * rowBytes2], widthBytes)) {
+                return AVIF_FALSE;
+            }
+        }
+    }
+    return AVIF_TRUE;
+}
+
+// Sets the duplicateOfID field of each cell item of a still grid whose pixels are identical to the ones of an earlier
+// cell item of the same category, so that only distinct cells are encoded.
+static avifResult avifEncoderFindDuplicateCells(avifEncoder * encoder, const avifImage * const * cellImages)
+{
+    avifEncoderData * data = encoder->data;
+    uint64_t * hashes = (uint64_t *)avifAlloc(sizeof(uint64_t) * data->items.count);
+    AVIF_CHECKERR(hashes, AVIF_RESULT_OUT_OF_MEMORY);
+    for (uint32_t itemIndex = 0; itemIndex < data->items.count; ++itemIndex) {
+        avifEncoderItem * item = &data->items.item[itemIndex];
+        item->duplicateOfID = 0;
+        if (!item->codec || (item->thumbnailWidth != 0) || (item->dimgFromID == 0) ||
+            memcmp(avifEncoderDataFindItemByID(data, item->dimgFromID)->type, "grid", 4)) {
+            hashes[itemIndex] = 0;
+            continue; // Not a grid cell.
+        }
+        const avifImage * cellImage = avifEncoderItemGetCellImage(item, cellImages);
+        hashes[itemIndex] = avifImageHashCellPlanes(cellImage, item->itemCategory);
+        for (uint32_t previousIndex = 0; previousIndex < itemIndex; ++previousIndex) {
+            const avifEncoderItem * previousItem = &data->items.item[previousIndex];
+            if ((hashes[previousIndex] == hashes[itemIndex]) && (previousItem->duplicateOfID == 0) &&
+                (previousItem->dimgFromID == item->dimgFromID) && (previousItem->itemCategory == item->itemCategory) &&
+                avifImageCellPlanesEqual(avifEncoderItemGetCellImage(previousItem, cellImages), cellImage, item->itemCategory)) {
+                item->duplicateOfID = previousItem->id;
+                break;
+            }
+        }
+    }
+    avifFree(hashes);
+    return AVIF_RESULT_OK;
+}
+
+// Encodes the samples of the items created by avifEncoderAddThumbnailItems(). Each thumbnail is scaled down from image
+// once and shared by the color and alpha items of that thumbnail.
+static avifResult avifEncoderEncodeThumbnails(avifEncoder * encoder,
+                                              const avifImage * image,
+                                              avifEncoderChanges encoderChanges,
+                                              avifAddImageFlags addImageFlags)
+{
+    for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
+        const avifEncoderItem * thumbnailItem = &encoder->data->items.item[itemIndex];
+        if ((thumbnailItem->thumbnailWidth == 0) || (thumbnailItem->itemCategory != AVIF_ITEM_COLOR)) {
+            continue;
+        }
+
+        avifImage * thumbnail = avifImageCreateEmpty();
+        AVIF_CHECKERR(thumbnail, AVIF_RESULT_OUT_OF_MEMORY);
+        avifResult result = avifImageCopy(thumbnail, image, AVIF_PLANES_ALL);
+        if (result == AVIF_RESULT_OK) {
+            result = avifImageScale(thumbnail, thumbnailItem->thumbnailWidth, thumbnailItem->thumbnailHeight, &encoder->diag);
+        }
+        for (uint32_t i = 0; (i < encoder->data->items.count) && (result == AVIF_RESULT_OK); ++i) {
+            avifEncoderItem * item = &encoder->data->items.item[i];
+            const avifBool isAlpha = (item->itemCategory == AVIF_ITEM_ALPHA);
+            if ((item != thumbnailItem) && !(isAlpha && (item->thumbnailWidth != 0) && (item->irefToID == thumbnailItem->id))) {
+                continue;
+            }
+            // Thumbnails are small enough to not need any tiling.
+            result = item->codec->encodeImage(item->codec,
+                                              encoder,
+                                              thumbnail,
+                                              isAlpha,
+                                              /*tileRowsLog2=*/0,
+                                              /*tileColsLog2=*/0,
+                                              isAlpha ? encoder->data->quantizerAlpha : encoder->data->quantizer,
+                                              encoderChanges,
+                                              /*disableLaggedOutput=*/encoder->data->alphaPresent,
+                                              addImageFlags,
+                                              item->encodeOutput);
+            if (result == AVIF_RESULT_UNKNOWN_ERROR) {
+                result = avifGetErrorForItemCategory(item->itemCategory);
+            }
+        }
+        avifImageDestroy(thumbnail);
+        AVIF_CHECKRES(result);
+    }
+    return AVIF_RESULT_OK;
+}
+
+// If encodedColor is not NULL, cellImages contains a single image whose planes are ignored, and the samples
+// encodedColor and encodedAlpha (optional) are used as is instead of encoding that image.
 static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
                                               uint32_t gridCols,
                                               uint32_t gridRows,
                                               const avifImage * const * cellImages,
+                                              const avifROData * encodedColor,
+                                              const avifROData * encodedAlpha,
                                               uint64_t durationInTimescales,
                                               avifAddImageFlags addImageFlags)
 {
     // -----------------------------------------------------------------------
     // Verify encoding is possible
 
-    if (!avifCodecName(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE)) {
+    const avifBool encodedInput = (encodedColor != NULL);
+    if (!encodedInput && !avifCodecName(encoder->codecChoice, AVIF_CODEC_FLAG_CAN_ENCODE)) {
         return AVIF_RESULT_NO_CODEC_AVAILABLE;
     }
 
@@ -1302,12 +1574,16 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
 
     const avifImage * firstCell = cellImages[0];
     const avifImage * bottomRightCell = cellImages[cellCount - 1];
+    const avifBool hasAlpha = encodedInput ? (encodedAlpha != NULL) : (firstCell->alphaPlane != NULL);
     AVIF_CHECKRES(avifValidateImageBasicProperties(firstCell));
     if (!firstCell->width || !firstCell->height || !bottomRightCell->width || !bottomRightCell->height) {
         return AVIF_RESULT_NO_CONTENT;
     }
 
-    AVIF_CHECKRES(avifValidateGrid(gridCols, gridRows, cellImages, /*validateGainMap=*/AVIF_FALSE, &encoder->diag));
+    if (!encodedInput) {
+        // Encoded input is a single cell without planes.
+        AVIF_CHECKRES(avifValidateGrid(gridCols, gridRows, cellImages, /*validateGainMap=*/AVIF_FALSE, &encoder->diag));
+    }
 
 #if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
     const avifBool hasGainMap = (firstCell->gainMap.image != NULL);
@@ -1350,6 +1626,11 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         }
     }
 
+    if (hasGainMap && encodedInput) {
+        avifDiagnosticsPrintf(&encoder->diag, "gain maps are not supported with avifEncoderAddEncodedImage()");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+
     if (hasGainMap) {
         AVIF_CHECKRES(avifValidateImageBasicProperties(firstCell->gainMap.image));
         AVIF_CHECKRES(avifValidateGrid(gridCols, gridRows, cellImages, /*validateGainMap=*/AVIF_TRUE, &encoder->diag));
@@ -1379,10 +1660,31 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         }
     }
 
+    avifBool hasThumbnails = AVIF_FALSE;
+    for (int i = 0; i < AVIF_MAX_THUMBNAIL_COUNT; ++i) {
+        hasThumbnails = hasThumbnails || (encoder->thumbnailSizes[i] != 0);
+    }
+    if (hasThumbnails) {
+        if (!(addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE)) {
+            avifDiagnosticsPrintf(&encoder->diag, "thumbnails are only supported for still images (AVIF_ADD_IMAGE_FLAG_SINGLE)");
+            return AVIF_RESULT_INVALID_ARGUMENT;
+        }
+        if ((cellCount > 1) || encodedInput || (hasAlpha && firstCell->alphaPremultiplied)) {
+            avifDiagnosticsPrintf(&encoder->diag, "thumbnails are not supported for grids, encoded input or premultiplied alpha");
+            return AVIF_RESULT_NOT_IMPLEMENTED;
+        }
+    }
+
+    if ((encoder->data->items.count > 0) && (encoder->data->encodedInput != encodedInput)) {
+        avifDiagnosticsPrintf(&encoder->diag, "avifEncoderAddEncodedImage() cannot be mixed with avifEncoderAddImage() calls");
+        return AVIF_RESULT_INVALID_ARGUMENT;
+    }
+
     // -----------------------------------------------------------------------
     // Choose AV1 or AV2
 
-    const avifCodecType codecType = avifEncoderGetCodecType(encoder);
+    const avifCodecType codecType =
+        encodedInput ? avifEncoderGetEncodedInputCodecType(encoder) : avifEncoderGetCodecType(encoder);
     switch (codecType) {
         case AVIF_CODEC_TYPE_AV1:
             encoder->data->imageItemType = "av01";
@@ -1397,6 +1699,15 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         default:
             return AVIF_RESULT_NO_CODEC_AVAILABLE;
     }
+    encoder->data->codecType = codecType;
+
+    if (encodedInput && (encoder->data->frames.count == 0)) {
+        // The configuration property is harvested from the first sample in avifEncoderFinish(). Fail early instead.
+        AVIF_CHECKRES(avifValidateEncodedSample(encoder, firstCell, encodedColor, codecType, AVIF_ITEM_COLOR));
+        if (encodedAlpha) {
+            AVIF_CHECKRES(avifValidateEncodedSample(encoder, firstCell, encodedAlpha, codecType, AVIF_ITEM_ALPHA));
+        }
+    }
 
     // -----------------------------------------------------------------------
     // Map quality and qualityAlpha to quantizer and quantizerAlpha
@@ -1442,14 +1753,15 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         }
 
         // Prepare all AV1 items
+        encoder->data->encodedInput = encodedInput;
         uint16_t colorItemID;
         const uint32_t gridWidth = avifGridWidth(gridCols, firstCell, bottomRightCell);
         const uint32_t gridHeight = avifGridHeight(gridRows, firstCell, bottomRightCell);
         AVIF_CHECKRES(avifEncoderAddImageItems(encoder, gridCols, gridRows, gridWidth, gridHeight, AVIF_ITEM_COLOR, &colorItemID));
         encoder->data->primaryItemID = colorItemID;
 
-        encoder->data->alphaPresent = (firstCell->alphaPlane != NULL);
-        if (encoder->data->alphaPresent && (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE)) {
+        encoder->data->alphaPresent = hasAlpha;
+        if (encoder->data->alphaPresent && !encodedInput && (addImageFlags & AVIF_ADD_IMAGE_FLAG_SINGLE)) {
             // If encoding a single image in which the alpha plane exists but is entirely opaque,
             // simply skip writing an alpha AV1 payload entirely, as it'll be interpreted as opaque
             // and is less bytes.
@@ -1548,6 +1860,10 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
                 return result;
             }
         }
+
+        if (hasThumbnails) {
+            AVIF_CHECKRES(avifEncoderAddThumbnailItems(encoder, firstCell));
+        }
     } else {
         // Another frame in an image sequence, or layer in a layered image
 
@@ -1569,7 +1885,7 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
             (imageMetadata->transferCharacteristics != firstCell->transferCharacteristics) ||
             (imageMetadata->matrixCoefficients != firstCell->matrixCoefficients) ||
             (imageMetadata->alphaPremultiplied != firstCell->alphaPremultiplied) ||
-            (encoder->data->alphaPresent && !firstCell->alphaPlane)) {
+            (encoder->data->alphaPresent && !hasAlpha)) {
             return AVIF_RESULT_INCOMPATIBLE_IMAGE;
         }
     }
@@ -1596,9 +1912,26 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
     // -----------------------------------------------------------------------
     // Encode AV1 OBUs
 
+    if ((cellCount > 1) && (encoder->extraLayerCount == 0) && !encodedInput) {
+        // Identical cells of a still grid are encoded once. The samples are shared in avifEncoderFinish().
+        AVIF_CHECKRES(avifEncoderFindDuplicateCells(encoder, cellImages));
+    }
+
     for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
         avifEncoderItem * item = &encoder->data->items.item[itemIndex];
-        if (item->codec) {
+        if (encodedInput && !memcmp(item->type, encoder->data->imageItemType, 4)) {
+            // There is no grid nor gain map, so this is either the color or the alpha item.
+            const avifROData * sample = (item->itemCategory == AVIF_ITEM_ALPHA) ? encodedAlpha : encodedColor;
+            assert(sample != NULL); // The presence of alpha was checked against the first frame above.
+            // Without a codec there is no way to know whether a frame is a keyframe other than the caller telling so.
+            const avifBool sync =
+                (encoder->data->frames.count == 0) || ((addImageFlags & AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME) != 0);
+            AVIF_CHECKRES(avifCodecEncodeOutputAddSample(item->encodeOutput, sample->data, sample->size, sync));
+        } else if (item->codec && (item->duplicateOfID != 0)) {
+            // There is nothing to encode and flush.
+            avifCodecDestroy(item->codec);
+            item->codec = NULL;
+        } else if (item->codec && (item->thumbnailWidth == 0)) {
             const avifImage * cellImage = cellImages[item->cellIndex];
             const avifImage * firstCellImage = firstCell;
 #if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
@@ -1651,6 +1984,10 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
         }
     }
 
+    if (hasThumbnails) {
+        AVIF_CHECKRES(avifEncoderEncodeThumbnails(encoder, firstCell, encoderChanges, addImageFlags));
+    }
+
     avifCodecSpecificOptionsClear(encoder->csOptions);
     avifEncoderFrame * frame = (avifEncoderFrame *)avifArrayPush(&encoder->data->frames);
     AVIF_CHECKERR(frame != NULL, AVIF_RESULT_OUT_OF_MEMORY);
@@ -1661,7 +1998,66 @@ static avifResult avifEncoderAddImageInternal(avifEncoder * encoder,
 avifResult avifEncoderAddImage(avifEncoder * encoder, const avifImage * image, uint64_t durationInTimescales, avifAddImageFlags addImageFlags)
 {
     avifDiagnosticsClearError(&encoder->diag);
-    return avifEncoderAddImageInternal(encoder, 1, 1, &image, durationInTimescales, addImageFlags);
+    return avifEncoderAddImageInternal(encoder, 1, 1, &image, NULL, NULL, durationInTimescales, addImageFlags);
+}
+
+avifResult avifEncoderAddEncodedImage(avifEncoder * encoder,
+                                      const avifImage * image,
+                                      const avifROData * colorOBUs,
+                                      const avifROData * alphaOBUs,
+                                      uint64_t durationInTimescales,
+                                      avifAddImageFlags addImageFlags)
+{
+    avifDiagnosticsClearError(&encoder->diag);
+    AVIF_CHECKERR(colorOBUs != NULL && colorOBUs->size > 0, AVIF_RESULT_INVALID_ARGUMENT);
+    if (alphaOBUs != NULL && alphaOBUs->size == 0) {
+        alphaOBUs = NULL;
+    }
+    return avifEncoderAddImageInternal(encoder, 1, 1, &image, colorOBUs, alphaOBUs, durationInTimescales, addImageFlags);
+}
+
+avifResult avifEncoderRemux(avifEncoder * encoder, avifDecoder * decoder)
+{
+    avifDiagnosticsClearError(&encoder->diag);
+    AVIF_CHECKERR(decoder->image != NULL && decoder->imageCount > 0, AVIF_RESULT_NO_CONTENT);
+#if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
+    if (decoder->gainMapPresent) {
+        avifDiagnosticsPrintf(&encoder->diag, "remuxing images with a gain map is not supported");
+        return AVIF_RESULT_NOT_IMPLEMENTED;
+    }
+#endif
+
+    encoder->timescale = decoder->timescale;
+    encoder->repetitionCount =
+        (decoder->repetitionCount == AVIF_REPETITION_COUNT_UNKNOWN) ? AVIF_REPETITION_COUNT_INFINITE : decoder->repetitionCount;
+    for (uint32_t frameIndex = 0; frameIndex < (uint32_t)decoder->imageCount; ++frameIndex) {
+        avifROData color;
+        avifROData alpha = AVIF_DATA_EMPTY;
+        avifBool sync;
+        avifBool alphaSync;
+        avifResult result = avifDecoderReadSample(decoder, AVIF_ITEM_COLOR, frameIndex, &color, &sync);
+        if ((result == AVIF_RESULT_OK) && decoder->alphaPresent) {
+            result = avifDecoderReadSample(decoder, AVIF_ITEM_ALPHA, frameIndex, &alpha, &alphaSync);
+        }
+        if (result != AVIF_RESULT_OK) {
+            avifDiagnosticsPrintf(&encoder->diag, "failed to read frame %u: %s", frameIndex, decoder->diag.error);
+            return result;
+        }
+
+        avifImageTiming timing;
+        AVIF_CHECKRES(avifDecoderNthImageTiming(decoder, frameIndex, &timing));
+        avifAddImageFlags addImageFlags = (decoder->imageCount == 1) ? AVIF_ADD_IMAGE_FLAG_SINGLE : AVIF_ADD_IMAGE_FLAG_NONE;
+        if (sync) {
+            addImageFlags |= AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME;
+        }
+        AVIF_CHECKRES(avifEncoderAddEncodedImage(encoder,
+                                                 decoder->image,
+                                                 &color,
+                                                 decoder->alphaPresent ? &alpha : NULL,
+                                                 timing.durationInTimescales,
+                                                 addImageFlags));
+    }
+    return AVIF_RESULT_OK;
 }
 
 avifResult avifEncoderAddImageGrid(avifEncoder * encoder,
@@ -1677,7 +2073,7 @@ avifResult avifEncoderAddImageGrid(avifEncoder * encoder,
     if (encoder->extraLayerCount == 0) {
         addImageFlags |= AVIF_ADD_IMAGE_FLAG_SINGLE; // image grids cannot be image sequences
     }
-    return avifEncoderAddImageInternal(encoder, gridCols, gridRows, cellImages, 1, addImageFlags);
+    return avifEncoderAddImageInternal(encoder, gridCols, gridRows, cellImages, NULL, NULL, 1, addImageFlags);
 }
 
 static size_t avifEncoderFindExistingChunk(avifRWStream * s, size_t mdatStartOffset, const uint8_t * data, size_t size)
@@ -1696,8 +2092,115 @@ static size_t avifEncoderFindExistingChunk(avifRWStream * s, size_t mdatStartOff
     return 0;
 }
 
+AVIF_ARRAY_DECLARE(avifRODataArray, avifROData, data);
+
+// Destination of the chunks of the mdat box. They are either copied to the output stream, or only referenced by
+// segments if it is not NULL (see avifEncoderFinishSegmented()).
+typedef struct avifMediaDataWriter
+{
+    avifRWStream * s;
+    avifRODataArray * segments;
+    size_t mdatStartOffset; // Offset of the mdat payload in the file.
+    size_t payloadSize;     // Number of bytes of mdat payload written so far.
+} avifMediaDataWriter;
+
+// Returns AVIF_TRUE if the size bytes starting at offset in segments->data[segmentIndex] and continuing in the following
+// segments are equal to data. The caller guarantees that there are enough bytes left in the segments.
+static avifBool avifSegmentsEqual(const avifRODataArray * segments,
+                                  uint32_t segmentIndex,
+                                  size_t offset,
+                                  const uint8_t * data,
+                                  size_t size)
+{
+    while (size > 0) {
+        const avifROData * segment = &segments->data[segmentIndex];
+        const size_t compareSize = AVIF_MIN(size, segment->size - offset);
+        if (memcmp(&segment->data[offset], data, compareSize)) {
+            return AVIF_FALSE;
+        }
+        data += compareSize;
+        size -= compareSize;
+        ++segmentIndex;
+        offset = 0;
+    }
+    return AVIF_TRUE;
+}
+
+// Same as avifEncoderFindExistingChunk() but for the chunks written so far by writer, wherever they are.
+static size_t avifMediaDataFindExistingChunk(const avifMediaDataWriter * writer, const uint8_t * data, size_t size)
+{
+    if (!writer->segments) {
+        return avifEncoderFindExistingChunk(writer->s, writer->mdatStartOffset, data, size);
+    }
+    // Search the concatenation of the segments byte by byte, exactly as avifEncoderFindExistingChunk() does in the stream,
+    // so that both outputs are identical.
+    size_t segmentStartOffset = 0; // Offset of the current segment in the mdat payload.
+    for (uint32_t segmentIndex = 0; segmentIndex < writer->segments->count; ++segmentIndex) {
+        const avifROData * segment = &writer->segments->data[segmentIndex];
+        for (size_t offset = 0; offset < segment->size; ++offset) {
+            if (writer->payloadSize - (segmentStartOffset + offset) < size) {
+                return 0;
+            }
+            if (avifSegmentsEqual(writer->segments, segmentIndex, offset, data, size)) {
+                return writer->mdatStartOffset + segmentStartOffset + offset;
+            }
+        }
+        segmentStartOffset += segment->size;
+    }
+    return 0;
+}
+
+// Returns the offset in the file of the next chunk written with avifMediaDataWriteChunk().
+static size_t avifMediaDataOffset(const avifMediaDataWriter * writer)
+{
+    return writer->mdatStartOffset + writer->payloadSize;
+}
+
+// Appends a chunk to the mdat payload.
+static avifResult avifMediaDataWriteChunk(avifMediaDataWriter * writer, const uint8_t * data, size_t size)
+{
+    if (writer->segments) {
+        avifROData * segment = (avifROData *)avifArrayPush(writer->segments);
+        AVIF_CHECKERR(segment != NULL, AVIF_RESULT_OUT_OF_MEMORY);
+        segment->data = data;
+        segment->size = size;
+    } else {
+        AVIF_CHECKRES(avifRWStreamWrite(writer->s, data, size));
+    }
+    writer->payloadSize += size;
+    return AVIF_RESULT_OK;
+}
+
+// Returns an upper bound of the payload of the mdat box written by avifEncoderWriteMediaDataBox(). It is exact unless some
+// chunks happen to be deduplicated at write time. Returns AVIF_FALSE on overflow.
+static avifBool avifEncoderGetMediaDataPayloadSize(const avifEncoder * encoder, size_t * payloadSize)
+{
+    size_t size = 0;
+    for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
+        const avifEncoderItem * item = &encoder->data->items.item[itemIndex];
+        if (item->duplicateOfID != 0) {
+            // Always deduplicated with the samples of the cell it is a copy of.
+            continue;
+        }
+        if (item->encodeOutput->samples.count > 0) {
+            for (uint32_t sampleIndex = 0; sampleIndex < item->encodeOutput->samples.count; ++sampleIndex) {
+                const size_t sampleSize = item->encodeOutput->samples.sample[sampleIndex].data.size;
+                AVIF_CHECK(sampleSize <= SIZE_MAX - size);
+                size += sampleSize;
+            }
+        } else {
+            AVIF_CHECK(item->metadataPayload.size <= SIZE_MAX - size);
+            size += item->metadataPayload.size;
+        }
+    }
+    *payloadSize = size;
+    return AVIF_TRUE;
+}
+
+// If segments is not NULL, the chunks are not copied to s but appended to segments instead.
 static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
                                                avifRWStream * s,
+                                               avifRODataArray * segments,
                                                avifEncoderItemReferenceArray * layeredColorItems,
                                                avifEncoderItemReferenceArray * layeredAlphaItems)
 {
@@ -1705,12 +2208,21 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
     encoder->ioStats.alphaOBUSize = 0;
     encoder->data->gainMapSizeBytes = 0;
 
+    if (!segments) {
+        // All other boxes are already written. Allocate the rest of the output at once rather than growing it for each chunk.
+        size_t payloadSize;
+        AVIF_CHECKERR(avifEncoderGetMediaDataPayloadSize(encoder, &payloadSize), AVIF_RESULT_OUT_OF_MEMORY);
+        const size_t mdatHeaderSize = 8; // size (4 bytes) + type (4 bytes)
+        AVIF_CHECKERR(payloadSize <= SIZE_MAX - mdatHeaderSize, AVIF_RESULT_OUT_OF_MEMORY);
+        AVIF_CHECKRES(avifRWStreamReserve(s, mdatHeaderSize + payloadSize));
+    }
+
     avifBoxMarker mdat;
     AVIF_CHECKRES(avifRWStreamWriteBox(s, "mdat", AVIF_BOX_SIZE_TBD, &mdat));
-    const size_t mdatStartOffset = avifRWStreamOffset(s);
+    avifMediaDataWriter writer = { s, segments, avifRWStreamOffset(s), 0 };
     for (uint32_t itemPasses = 0; itemPasses < 3; ++itemPasses) {
         // Use multiple passes to pack in the following order:
-        //   * Pass 0: metadata (Exif/XMP)
+        //   * Pass 0: metadata (Exif/XMP), thumbnails (AV1)
         //   * Pass 1: alpha, gain map (AV1)
         //   * Pass 2: all other item data (AV1 color)
         //
@@ -1721,6 +2233,9 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
         // by avifDecoderParse() before it returns AVIF_RESULT_OK, unless ignoreXMP
         // and ignoreExif are enabled.
         //
+        // Thumbnails are tiny and packed early too, so that they can be displayed
+        // from the beginning of the file.
+        //
         const avifBool metadataPass = (itemPasses == 0);
         const avifBool alphaAndGainMapPass = (itemPasses == 1);
 
@@ -1731,11 +2246,12 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
                 continue;
             }
             const avifBool isMetadata = !memcmp(item->type, "mime", 4) || !memcmp(item->type, "Exif", 4);
-            if (metadataPass != isMetadata) {
-                // only process metadata (XMP/Exif) payloads when metadataPass is true
+            const avifBool isThumbnail = (item->thumbnailWidth != 0);
+            if (metadataPass != (isMetadata || isThumbnail)) {
+                // only process metadata (XMP/Exif) and thumbnail payloads when metadataPass is true
                 continue;
             }
-            avifBool isAlphaOrGainMap = item->itemCategory == AVIF_ITEM_ALPHA;
+            avifBool isAlphaOrGainMap = !isThumbnail && item->itemCategory == AVIF_ITEM_ALPHA;
 #if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
             isAlphaOrGainMap = isAlphaOrGainMap || item->itemCategory == AVIF_ITEM_GAIN_MAP;
 #endif
@@ -1761,20 +2277,22 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
             // Deduplication - See if an identical chunk to this has already been written
             if (item->encodeOutput->samples.count > 0) {
                 avifEncodeSample * sample = &item->encodeOutput->samples.sample[0];
-                chunkOffset = avifEncoderFindExistingChunk(s, mdatStartOffset, sample->data.data, sample->data.size);
+                chunkOffset = avifMediaDataFindExistingChunk(&writer, sample->data.data, sample->data.size);
             } else {
-                chunkOffset = avifEncoderFindExistingChunk(s, mdatStartOffset, item->metadataPayload.data, item->metadataPayload.size);
+                chunkOffset = avifMediaDataFindExistingChunk(&writer, item->metadataPayload.data, item->metadataPayload.size);
             }
 
             if (!chunkOffset) {
                 // We've never seen this chunk before; write it out
-                chunkOffset = avifRWStreamOffset(s);
+                chunkOffset = avifMediaDataOffset(&writer);
                 if (item->encodeOutput->samples.count > 0) {
                     for (uint32_t sampleIndex = 0; sampleIndex < item->encodeOutput->samples.count; ++sampleIndex) {
                         avifEncodeSample * sample = &item->encodeOutput->samples.sample[sampleIndex];
-                        AVIF_CHECKRES(avifRWStreamWrite(s, sample->data.data, sample->data.size));
+                        AVIF_CHECKRES(avifMediaDataWriteChunk(&writer, sample->data.data, sample->data.size));
 
-                        if (item->itemCategory == AVIF_ITEM_ALPHA) {
+                        if (isThumbnail) {
+                            // Not part of the primary image.
+                        } else if (item->itemCategory == AVIF_ITEM_ALPHA) {
                             encoder->ioStats.alphaOBUSize += sample->data.size;
                         } else if (item->itemCategory == AVIF_ITEM_COLOR) {
                             encoder->ioStats.colorOBUSize += sample->data.size;
@@ -1785,7 +2303,7 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
                         }
                     }
                 } else {
-                    AVIF_CHECKRES(avifRWStreamWrite(s, item->metadataPayload.data, item->metadataPayload.size));
+                    AVIF_CHECKRES(avifMediaDataWriteChunk(&writer, item->metadataPayload.data, item->metadataPayload.size));
                 }
             }
 
@@ -1826,11 +2344,11 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
                         hasMoreSample = AVIF_TRUE;
                     }
                     avifRWData * data = &item->encodeOutput->samples.sample[layerIndex].data;
-                    size_t chunkOffset = avifEncoderFindExistingChunk(s, mdatStartOffset, data->data, data->size);
+                    size_t chunkOffset = avifMediaDataFindExistingChunk(&writer, data->data, data->size);
                     if (!chunkOffset) {
                         // We've never seen this chunk before; write it out
-                        chunkOffset = avifRWStreamOffset(s);
-                        AVIF_CHECKRES(avifRWStreamWrite(s, data->data, data->size));
+                        chunkOffset = avifMediaDataOffset(&writer);
+                        AVIF_CHECKRES(avifMediaDataWriteChunk(&writer, data->data, data->size));
                         if (samplePass == 0) {
                             encoder->ioStats.alphaOBUSize += data->size;
                         } else {
@@ -1849,7 +2367,17 @@ static avifResult avifEncoderWriteMediaDataBox(avifEncoder * encoder,
 
         assert(layerIndex <= AVIF_MAX_AV1_LAYER_COUNT);
     }
-    avifRWStreamFinishBox(s, mdat);
+    if (segments) {
+        // The payload is not in s. Only the box header is.
+        const size_t mdatSize = (avifRWStreamOffset(s) - mdat) + writer.payloadSize;
+        AVIF_CHECKERR(mdatSize <= UINT32_MAX, AVIF_RESULT_INVALID_ARGUMENT);
+        const size_t mdatEndOffset = avifRWStreamOffset(s);
+        avifRWStreamSetOffset(s, mdat);
+        AVIF_CHECKRES(avifRWStreamWriteU32(s, (uint32_t)mdatSize));
+        avifRWStreamSetOffset(s, mdatEndOffset);
+    } else {
+        avifRWStreamFinishBox(s, mdat);
+    }
     return AVIF_RESULT_OK;
 }
 
@@ -2148,8 +2676,10 @@ static avifResult avifRWStreamWriteProperties(avifItemPropertyDedup * const dedu
         avifEncoderItem * item = &encoder->data->items.item[itemIndex];
         const avifBool isGrid = (item->gridCols > 0);
         const avifBool isToneMappedImage = !memcmp(item->type, "tmap", 4);
+        // Coded image items have a codec, unless their samples were given to avifEncoderAddEncodedImage().
+        const avifBool isCodedImage = !memcmp(item->type, encoder->data->imageItemType, 4);
         memset(&item->ipma, 0, sizeof(item->ipma));
-        if (!item->codec && !isGrid && !isToneMappedImage) {
+        if (!isCodedImage && !isGrid && !isToneMappedImage) {
             // No ipma to write for this item
             continue;
         }
@@ -2185,6 +2715,16 @@ static avifResult avifRWStreamWriteProperties(avifItemPropertyDedup * const dedu
             assert(itemMetadata);
         }
 #endif
+        avifImage thumbnailMetadata;
+        if (item->thumbnailWidth != 0) {
+            // A thumbnail shares the properties of the primary item except for its dimensions. The clean aperture is
+            // expressed in pixels of the primary item so it is dropped.
+            thumbnailMetadata = *itemMetadata;
+            thumbnailMetadata.width = item->thumbnailWidth;
+            thumbnailMetadata.height = item->thumbnailHeight;
+            thumbnailMetadata.transformFlags &= ~AVIF_TRANSFORM_CLAP;
+            itemMetadata = &thumbnailMetadata;
+        }
         uint32_t imageWidth = itemMetadata->width;
         uint32_t imageHeight = itemMetadata->height;
         if (isGrid) {
@@ -2212,7 +2752,7 @@ static avifResult avifRWStreamWriteProperties(avifItemPropertyDedup * const dedu
         avifRWStreamFinishBox(&dedup->s, pixi);
         AVIF_CHECKRES(avifItemPropertyDedupFinish(dedup, s, &item->ipma, AVIF_FALSE));
 
-        if (item->codec) {
+        if (isCodedImage) {
             avifItemPropertyDedupStart(dedup);
             AVIF_CHECKRES(writeConfigBox(&dedup->s, &item->av1C, encoder->data->configPropName));
             AVIF_CHECKRES(avifItemPropertyDedupFinish(dedup, s, &item->ipma, AVIF_TRUE));
@@ -2287,14 +2827,16 @@ static avifResult avifRWStreamWriteProperties(avifItemPropertyDedup * const dedu
     return AVIF_RESULT_OK;
 }
 
-avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
+// If segments is not NULL, output only receives the boxes and the mdat box header, and segments references the chunks of
+// the mdat payload. Otherwise output is the whole file.
+static avifResult avifEncoderFinishInternal(avifEncoder * encoder, avifRWData * output, avifRODataArray * segments)
 {
     avifDiagnosticsClearError(&encoder->diag);
     if (encoder->data->items.count == 0) {
         return AVIF_RESULT_NO_CONTENT;
     }
 
-    const avifCodecType codecType = avifEncoderGetCodecType(encoder);
+    const avifCodecType codecType = encoder->data->codecType;
     if (codecType == AVIF_CODEC_TYPE_UNKNOWN) {
         return AVIF_RESULT_NO_CODEC_AVAILABLE;
     }
@@ -2312,15 +2854,31 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
             if (item->encodeOutput->samples.count != encoder->data->frames.count) {
                 return avifGetErrorForItemCategory(item->itemCategory);
             }
+        }
 
-            if ((item->extraLayerCount > 0) && (item->encodeOutput->samples.count != item->extraLayerCount + 1)) {
-                // Check whether user has sent enough frames to encoder.
-                avifDiagnosticsPrintf(&encoder->diag,
-                                      "Expected %u frames given to avifEncoderAddImage() to encode this layered image according to extraLayerCount, but got %u frames.",
-                                      item->extraLayerCount + 1,
-                                      item->encodeOutput->samples.count);
-                return AVIF_RESULT_INVALID_ARGUMENT;
-            }
+        // Only items holding samples have a non-zero extraLayerCount.
+        if ((item->extraLayerCount > 0) && (item->encodeOutput->samples.count != item->extraLayerCount + 1)) {
+            // Check whether user has sent enough frames to encoder.
+            avifDiagnosticsPrintf(&encoder->diag,
+                                  "Expected %u frames given to avifEncoderAddImage() to encode this layered image according to extraLayerCount, but got %u frames.",
+                                  item->extraLayerCount + 1,
+                                  item->encodeOutput->samples.count);
+            return AVIF_RESULT_INVALID_ARGUMENT;
+        }
+    }
+
+    // Grid cells that are identical to an earlier cell were not encoded. They get a copy of the samples of that cell,
+    // which avifEncoderWriteMediaDataBox() deduplicates into a single chunk.
+    for (uint32_t itemIndex = 0; itemIndex < encoder->data->items.count; ++itemIndex) {
+        avifEncoderItem * item = &encoder->data->items.item[itemIndex];
+        if (item->duplicateOfID == 0) {
+            continue;
+        }
+        const avifEncoderItem * encodedItem = avifEncoderDataFindItemByID(encoder->data, item->duplicateOfID);
+        assert(encodedItem && (encodedItem->duplicateOfID == 0) && (item->encodeOutput->samples.count == 0));
+        for (uint32_t sampleIndex = 0; sampleIndex < encodedItem->encodeOutput->samples.count; ++sampleIndex) {
+            const avifEncodeSample * sample = &encodedItem->encodeOutput->samples.sample[sampleIndex];
+            AVIF_CHECKRES(avifCodecEncodeOutputAddSample(item->encodeOutput, sample->data.data, sample->data.size, sample->sync));
         }
     }
 
@@ -2960,7 +3518,7 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
         result = AVIF_RESULT_OUT_OF_MEMORY;
     }
     if (result == AVIF_RESULT_OK) {
-        result = avifEncoderWriteMediaDataBox(encoder, &s, &layeredColorItems, &layeredAlphaItems);
+        result = avifEncoderWriteMediaDataBox(encoder, &s, segments, &layeredColorItems, &layeredAlphaItems);
     }
     avifArrayDestroy(&layeredColorItems);
     avifArrayDestroy(&layeredAlphaItems);
@@ -2970,14 +3528,86 @@ avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
     // Finish up stream
 
     avifRWStreamFinishWrite(&s);
+    return AVIF_RESULT_OK;
+}
 
+avifResult avifEncoderFinish(avifEncoder * encoder, avifRWData * output)
+{
+    AVIF_CHECKRES(avifEncoderFinishInternal(encoder, output, /*segments=*/NULL));
 #if defined(AVIF_ENABLE_COMPLIANCE_WARDEN)
     AVIF_CHECKRES(avifIsCompliant(output->data, output->size));
 #endif
+    return AVIF_RESULT_OK;
+}
 
+void avifEncoderSegmentsFree(avifEncoderSegments * output)
+{
+    avifFree(output->segments);
+    avifRWDataFree(&output->header);
+    memset(output, 0, sizeof(*output));
+}
+
+avifResult avifEncoderFinishSegmented(avifEncoder * encoder, avifEncoderSegments * output)
+{
+    avifEncoderSegmentsFree(output);
+    avifRODataArray segments;
+    AVIF_CHECKERR(avifArrayCreate(&segments, sizeof(avifROData), 0), AVIF_RESULT_OUT_OF_MEMORY);
+    avifResult result = avifEncoderFinishInternal(encoder, &output->header, &segments);
+    // Prepend the header, which is only complete once the chunks of the mdat payload are known.
+    if ((result == AVIF_RESULT_OK) && (avifArrayPush(&segments) == NULL)) {
+        result = AVIF_RESULT_OUT_OF_MEMORY;
+    }
+    if (result != AVIF_RESULT_OK) {
+        avifArrayDestroy(&segments);
+        avifRWDataFree(&output->header);
+        return result;
+    }
+    memmove(&segments.data[1], &segments.data[0], (segments.count - 1) * sizeof(avifROData));
+    segments.data[0].data = output->header.data;
+    segments.data[0].size = output->header.size;
+    output->segments = segments.data;
+    output->segmentCount = segments.count;
+    for (uint32_t i = 0; i < segments.count; ++i) {
+        output->size += segments.data[i].size;
+    }
+#if defined(AVIF_ENABLE_COMPLIANCE_WARDEN)
+    avifRWData file = AVIF_DATA_EMPTY;
+    result = avifRWDataRealloc(&file, output->size);
+    if (result == AVIF_RESULT_OK) {
+        size_t offset = 0;
+        for (uint32_t i = 0; i < output->segmentCount; ++i) {
+            memcpy(file.data + offset, output->segments[i].data, output->segments[i].size);
+            offset += output->segments[i].size;
+        }
+        result = avifIsCompliant(file.data, file.size);
+    }
+    avifRWDataFree(&file);
+    if (result != AVIF_RESULT_OK) {
+        avifEncoderSegmentsFree(output);
+        return result;
+    }
+#endif
     return AVIF_RESULT_OK;
 }
 
+avifResult avifEncoderFinishToIO(avifEncoder * encoder, avifIO * io)
+{
+    AVIF_CHECKERR(io != NULL && io->write != NULL, AVIF_RESULT_INVALID_ARGUMENT);
+    avifEncoderSegments output;
+    memset(&output, 0, sizeof(output));
+    avifResult result = avifEncoderFinishSegmented(encoder, &output);
+    uint64_t offset = 0;
+    for (uint32_t i = 0; (result == AVIF_RESULT_OK) && (i < output.segmentCount); ++i) {
+        result = io->write(io, AVIF_IO_WRITE_FLAG_NONE, offset, output.segments[i].data, output.segments[i].size);
+        offset += output.segments[i].size;
+    }
+    if (result == AVIF_RESULT_OK) {
+        result = io->write(io, AVIF_IO_WRITE_FLAG_FINISH, offset, NULL, 0);
+    }
+    avifEncoderSegmentsFree(&output);
+    return result;
+}
+
 avifResult avifEncoderWrite(avifEncoder * encoder, const avifImage * image, avifRWData * output)
 {
     avifResult addImageResult = avifEncoderAddImage(encoder, image, 1, AVIF_ADD_IMAGE_FLAG_SINGLE);
@@ -2987,6 +3617,210 @@ avifResult avifEncoderWrite(avifEncoder * encoder, const avifImage * image, avif
     return avifEncoderFinish(encoder, output);
 }
 
+// ---------------------------------------------------------------------------
+// Multi-resolution encoding
+
+// Copies the settings of src to dst, which must not have started encoding.
+static avifResult avifEncoderCopySettings(avifEncoder * dst, const avifEncoder * src)
+{
+    dst->codecChoice = src->codecChoice;
+    dst->maxThreads = src->maxThreads;
+    dst->speed = src->speed;
+    dst->keyframeInterval = src->keyframeInterval;
+    dst->timescale = src->timescale;
+    dst->repetitionCount = src->repetitionCount;
+    dst->extraLayerCount = src->extraLayerCount;
+    dst->quality = src->quality;
+    dst->qualityAlpha = src->qualityAlpha;
+    dst->minQuantizer = src->minQuantizer;
+    dst->maxQuantizer = src->maxQuantizer;
+    dst->minQuantizerAlpha = src->minQuantizerAlpha;
+    dst->maxQuantizerAlpha = src->maxQuantizerAlpha;
+    dst->tileRowsLog2 = src->tileRowsLog2;
+    dst->tileColsLog2 = src->tileColsLog2;
+    dst->autoTiling = src->autoTiling;
+    dst->scalingMode = src->scalingMode;
+    dst->headerFormat = src->headerFormat;
+#if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
+    dst->qualityGainMap = src->qualityGainMap;
+#endif
+    memcpy(dst->thumbnailSizes, src->thumbnailSizes, sizeof(dst->thumbnailSizes));
+    for (uint32_t i = 0; i < src->csOptions->count; ++i) {
+        const avifCodecSpecificOption * entry = &src->csOptions->entries[i];
+        AVIF_CHECKRES(avifCodecSpecificOptionsSet(dst->csOptions, entry->key, entry->value));
+    }
+    return AVIF_RESULT_OK;
+}
+
+typedef struct avifMultiResolutionJob
+{
+    avifEncoder * encoder;
+    const avifImage * image; // Either the input image or one level of the downscale pyramid
+    avifRWData * output;
+    avifResult result;
+} avifMultiResolutionJob;
+
+typedef struct
+{
+    avifThread * thread;
+    avifMultiResolutionJob * jobs;
+    uint32_t jobCount;
+    uint32_t firstJob; // This thread runs the jobs firstJob, firstJob+jobStep, firstJob+2*jobStep etc.
+    uint32_t jobStep;
+} avifMultiResolutionThreadData;
+
+static void avifMultiResolutionThreadWorker(void * arg)
+{
+    avifMultiResolutionThreadData * data = (avifMultiResolutionThreadData *)arg;
+    for (uint32_t i = data->firstJob; i < data->jobCount; i += data->jobStep) {
+        avifMultiResolutionJob * job = &data->jobs[i];
+        job->result = avifEncoderWrite(job->encoder, job->image, job->output);
+    }
+}
+
+// Runs the jobs on up to threadCount threads (the current one included).
+static avifResult avifRunMultiResolutionJobs(avifMultiResolutionJob * jobs, uint32_t jobCount, uint32_t threadCount)
+{
+    avifMultiResolutionThreadData * tdata =
+        (avifMultiResolutionThreadData *)avifAlloc(sizeof(avifMultiResolutionThreadData) * threadCount);
+    AVIF_CHECKERR(tdata, AVIF_RESULT_OUT_OF_MEMORY);
+    memset(tdata, 0, sizeof(avifMultiResolutionThreadData) * threadCount);
+    avifResult result = AVIF_RESULT_OK;
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        tdata[i].jobs = jobs;
+        tdata[i].jobCount = jobCount;
+        tdata[i].firstJob = i;
+        tdata[i].jobStep = threadCount;
+        // The first set of jobs is run by the current thread, after the other threads are started.
+        if (i > 0) {
+            tdata[i].thread = avifThreadCreate(&avifMultiResolutionThreadWorker, &tdata[i]);
+            if (!tdata[i].thread) {
+                result = AVIF_RESULT_UNKNOWN_ERROR;
+                break;
+            }
+        }
+    }
+    if (result == AVIF_RESULT_OK) {
+        avifMultiResolutionThreadWorker(&tdata[0]);
+    }
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        if (tdata[i].thread && !avifThreadJoin(tdata[i].thread)) {
+            result = AVIF_RESULT_UNKNOWN_ERROR;
+        }
+    }
+    avifFree(tdata);
+    return result;
+}
+
+avifResult avifEncoderWriteMultiResolution(avifEncoder * encoder,
+                                           const avifImage * image,
+                                           const uint32_t * widths,
+                                           uint32_t count,
+                                           avifRWData * outputs)
+{
+    avifDiagnosticsClearError(&encoder->diag);
+    AVIF_CHECKERR(count > 0 && widths != NULL && outputs != NULL, AVIF_RESULT_INVALID_ARGUMENT);
+    AVIF_CHECKERR(image->width > 0 && image->height > 0, AVIF_RESULT_NO_CONTENT);
+    for (uint32_t i = 0; i < count; ++i) {
+        if ((widths[i] == 0) || (widths[i] > image->width)) {
+            avifDiagnosticsPrintf(&encoder->diag, "width [%u] must be in [1-%u]", widths[i], image->width);
+            return AVIF_RESULT_INVALID_ARGUMENT;
+        }
+    }
+
+    avifMultiResolutionJob * jobs = (avifMultiResolutionJob *)avifAlloc(sizeof(avifMultiResolutionJob) * count);
+    AVIF_CHECKERR(jobs, AVIF_RESULT_OUT_OF_MEMORY);
+    memset(jobs, 0, sizeof(avifMultiResolutionJob) * count);
+    // Levels of the downscale pyramid, owned by the jobs they were created for.
+    avifImage ** levels = (avifImage **)avifAlloc(sizeof(avifImage *) * count);
+    if (!levels) {
+        avifFree(jobs);
+        return AVIF_RESULT_OUT_OF_MEMORY;
+    }
+    memset(levels, 0, sizeof(avifImage *) * count);
+
+    // The outputs are encoded concurrently and share the thread budget of the encoder.
+    const int maxThreads = AVIF_MAX(encoder->maxThreads, 1);
+    const uint32_t threadCount = AVIF_MIN((uint32_t)maxThreads, count);
+    avifResult result = AVIF_RESULT_OK;
+
+    // Build the downscale pyramid, from the largest to the smallest width. Each level is scaled from the previous one
+    // rather than from the input image, which is cheaper.
+    const avifImage * previousLevel = image;
+    uint32_t previousWidth = 0;
+    for (uint32_t level = 0; (level < count) && (result == AVIF_RESULT_OK); ++level) {
+        // Selection sort of the job indices by decreasing width, count is small.
+        uint32_t jobIndex = count;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!jobs[i].image && ((jobIndex == count) || (widths[i] > widths[jobIndex]))) {
+                jobIndex = i;
+            }
+        }
+        avifMultiResolutionJob * job = &jobs[jobIndex];
+        if (widths[jobIndex] == image->width) {
+            job->image = image;
+        } else if (widths[jobIndex] == previousWidth) {
+            job->image = previousLevel;
+        } else {
+            const uint32_t height =
+                (uint32_t)AVIF_MAX(((uint64_t)image->height * widths[jobIndex] + image->width / 2) / image->width, 1);
+            levels[jobIndex] = avifImageCreateEmpty();
+            if (!levels[jobIndex]) {
+                result = AVIF_RESULT_OUT_OF_MEMORY;
+                break;
+            }
+            result = avifImageCopy(levels[jobIndex], previousLevel, AVIF_PLANES_ALL);
+            if (result == AVIF_RESULT_OK) {
+                result = avifImageScaleWithFilter(levels[jobIndex],
+                                                  widths[jobIndex],
+                                                  height,
+                                                  AVIF_SCALE_FILTER_AUTOMATIC,
+                                                  maxThreads,
+                                                  &encoder->diag);
+            }
+            job->image = levels[jobIndex];
+        }
+        previousLevel = job->image;
+        previousWidth = widths[jobIndex];
+
+        job->output = &outputs[jobIndex];
+        job->encoder = avifEncoderCreate();
+        if (!job->encoder) {
+            result = AVIF_RESULT_OUT_OF_MEMORY;
+            break;
+        }
+        if (result == AVIF_RESULT_OK) {
+            result = avifEncoderCopySettings(job->encoder, encoder);
+        }
+        job->encoder->maxThreads = AVIF_MAX(maxThreads / (int)threadCount, 1);
+    }
+
+    if (result == AVIF_RESULT_OK) {
+        result = avifRunMultiResolutionJobs(jobs, count, threadCount);
+    }
+    for (uint32_t i = 0; (i < count) && (result == AVIF_RESULT_OK); ++i) {
+        if (jobs[i].result != AVIF_RESULT_OK) {
+            result = jobs[i].result;
+            avifDiagnosticsPrintf(&encoder->diag, "failed to encode width %u: %s", widths[i], jobs[i].encoder->diag.error);
+        }
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (jobs[i].encoder) {
+            avifEncoderDestroy(jobs[i].encoder);
+        }
+        if (levels[i]) {
+            avifImageDestroy(levels[i]);
+        }
+        if (result != AVIF_RESULT_OK) {
+            avifRWDataFree(&outputs[i]);
+        }
+    }
+    avifFree(levels);
+    avifFree(jobs);
+    return result;
+}
+
 // Implementation of section 2.3.3 of AV1 Codec ISO Media File Format Binding specification v1.2.0.
 // See https://aomediacodec.github.io/av1-isobmff/v1.2.0.html#av1codecconfigurationbox-syntax.
 static avifResult writeCodecConfig(avifRWStream * s, const avifCodecConfigurationBox * cfg)
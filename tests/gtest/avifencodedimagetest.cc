@@ -0,0 +1,333 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "avif/avif.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+std::vector<uint8_t> ReadFile(const std::string& file_name) {
+  std::ifstream file(std::string(data_path) + file_name, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+// Parses the given file and returns the bytes of its frame at frame_index,
+// without decoding them. No codec is needed.
+DecoderPtr ParseAndGetSample(const uint8_t* data, size_t size,
+                             uint32_t frame_index,
+                             std::vector<uint8_t>& sample) {
+  DecoderPtr decoder(avifDecoderCreate());
+  if (decoder == nullptr ||
+      avifDecoderSetIOMemory(decoder.get(), data, size) != AVIF_RESULT_OK ||
+      avifDecoderParse(decoder.get()) != AVIF_RESULT_OK) {
+    return nullptr;
+  }
+  avifExtent extent;
+  if (avifDecoderNthImageMaxExtent(decoder.get(), frame_index, &extent) !=
+          AVIF_RESULT_OK ||
+      extent.offset + extent.size > size) {
+    return nullptr;
+  }
+  sample.assign(data + extent.offset, data + extent.offset + extent.size);
+  return decoder;
+}
+
+class EncodedImageTest : public testing::TestWithParam<const char*> {};
+
+TEST_P(EncodedImageTest, Rewrap) {
+  const std::vector<uint8_t> file = ReadFile(GetParam());
+  ASSERT_FALSE(file.empty());
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_FALSE(decoder->alphaPresent);
+  const avifImage* image = decoder->image;
+
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  const avifROData color = {obus.data(), obus.size()};
+  ASSERT_EQ(avifEncoderAddEncodedImage(encoder.get(), image, &color,
+                                       /*alphaOBUs=*/nullptr, 1,
+                                       AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_OK);
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+
+  std::vector<uint8_t> rewrapped_obus;
+  DecoderPtr rewrapped = ParseAndGetSample(encoded.data, encoded.size, 0,
+                                           rewrapped_obus);
+  ASSERT_NE(rewrapped, nullptr);
+  EXPECT_EQ(rewrapped_obus, obus);
+  EXPECT_FALSE(rewrapped->alphaPresent);
+  const avifImage* result = rewrapped->image;
+  EXPECT_EQ(result->width, image->width);
+  EXPECT_EQ(result->height, image->height);
+  EXPECT_EQ(result->depth, image->depth);
+  EXPECT_EQ(result->yuvFormat, image->yuvFormat);
+  EXPECT_EQ(result->yuvRange, image->yuvRange);
+  EXPECT_EQ(result->colorPrimaries, image->colorPrimaries);
+  EXPECT_EQ(result->transferCharacteristics, image->transferCharacteristics);
+  EXPECT_EQ(result->matrixCoefficients, image->matrixCoefficients);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(result->icc, image->icc));
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(result->exif, image->exif));
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(result->xmp, image->xmp));
+}
+
+INSTANTIATE_TEST_SUITE_P(Files, EncodedImageTest,
+                         testing::Values("white_1x1.avif",
+                                         "paris_icc_exif_xmp.avif"));
+
+TEST(EncodedImageTest, Alpha) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+
+  // Any AV1 sample with the same bit depth is a valid alpha sample.
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  const avifROData data = {obus.data(), obus.size()};
+  ASSERT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image, &data,
+                                       &data, 1, AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_OK);
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+
+  DecoderPtr rewrapped(avifDecoderCreate());
+  ASSERT_NE(rewrapped, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(rewrapped.get(), encoded.data,
+                                   encoded.size),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(rewrapped.get()), AVIF_RESULT_OK);
+  EXPECT_TRUE(rewrapped->alphaPresent);
+}
+
+TEST(EncodedImageTest, Sequence) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  const avifROData data = {obus.data(), obus.size()};
+  const avifAddImageFlags flags[] = {AVIF_ADD_IMAGE_FLAG_NONE,
+                                     AVIF_ADD_IMAGE_FLAG_NONE,
+                                     AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME};
+  for (avifAddImageFlags frame_flags : flags) {
+    ASSERT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image, &data,
+                                         nullptr, 1, frame_flags),
+              AVIF_RESULT_OK);
+  }
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+
+  DecoderPtr rewrapped(avifDecoderCreate());
+  ASSERT_NE(rewrapped, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(rewrapped.get(), encoded.data,
+                                   encoded.size),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(rewrapped.get()), AVIF_RESULT_OK);
+  ASSERT_EQ(rewrapped->imageCount, 3);
+  EXPECT_TRUE(avifDecoderIsKeyframe(rewrapped.get(), 0));
+  EXPECT_FALSE(avifDecoderIsKeyframe(rewrapped.get(), 1));
+  EXPECT_TRUE(avifDecoderIsKeyframe(rewrapped.get(), 2));
+}
+
+TEST(EncodedImageTest, InvalidInput) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+  const avifROData data = {obus.data(), obus.size()};
+
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image, nullptr,
+                                       nullptr, 1, AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_INVALID_ARGUMENT);
+
+  // No sequence header.
+  const uint8_t garbage[] = {0x12, 0x00, 0x0A, 0x00};
+  const avifROData garbage_data = {garbage, sizeof(garbage)};
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image,
+                                       &garbage_data, nullptr, 1,
+                                       AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_ENCODE_COLOR_FAILED);
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image, &data,
+                                       &garbage_data, 1,
+                                       AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_ENCODE_ALPHA_FAILED);
+
+  // The sequence header does not match the image.
+  ImagePtr image(avifImageCreateEmpty());
+  ASSERT_NE(image, nullptr);
+  ASSERT_EQ(avifImageCopy(image.get(), decoder->image, 0), AVIF_RESULT_OK);
+  image->depth = (image->depth == 8) ? 10 : 8;
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(avifEncoderAddEncodedImage(encoder.get(), image.get(), &data,
+                                       nullptr, 1, AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_INCOMPATIBLE_IMAGE);
+  image->depth = decoder->image->depth;
+  image->width *= 2;
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  EXPECT_EQ(avifEncoderAddEncodedImage(encoder.get(), image.get(), &data,
+                                       nullptr, 1, AVIF_ADD_IMAGE_FLAG_SINGLE),
+            AVIF_RESULT_INCOMPATIBLE_IMAGE);
+
+  // Encoded images cannot be mixed with images to encode.
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_EQ(avifEncoderAddEncodedImage(encoder.get(), decoder->image, &data,
+                                       nullptr, 1, AVIF_ADD_IMAGE_FLAG_NONE),
+            AVIF_RESULT_OK);
+  EXPECT_NE(avifEncoderAddImage(encoder.get(), decoder->image, 1,
+                                AVIF_ADD_IMAGE_FLAG_NONE),
+            AVIF_RESULT_OK);
+}
+
+//------------------------------------------------------------------------------
+
+// Returns the file parsed by decoder, remuxed after calling modify(decoder).
+template <typename Modifier>
+testutil::AvifRwData Remux(const std::vector<uint8_t>& file,
+                           Modifier modify) {
+  testutil::AvifRwData remuxed;
+  DecoderPtr decoder(avifDecoderCreate());
+  EncoderPtr encoder(avifEncoderCreate());
+  if (decoder == nullptr || encoder == nullptr ||
+      avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()) !=
+          AVIF_RESULT_OK) {
+    return remuxed;
+  }
+  modify(decoder.get());
+  if (avifEncoderRemux(encoder.get(), decoder.get()) != AVIF_RESULT_OK ||
+      avifEncoderFinish(encoder.get(), &remuxed) != AVIF_RESULT_OK) {
+    avifRWDataFree(&remuxed);
+  }
+  return remuxed;
+}
+
+TEST(RemuxTest, StillImage) {
+  const std::vector<uint8_t> file = ReadFile("paris_icc_exif_xmp.avif");
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_GT(decoder->image->exif.size, 0u);
+  ASSERT_GT(decoder->image->xmp.size, 0u);
+
+  // The file was written by libavif so remuxing it as is changes nothing.
+  testutil::AvifRwData remuxed = Remux(file, [](avifDecoder* d) {
+    ASSERT_EQ(avifDecoderParse(d), AVIF_RESULT_OK);
+  });
+  ASSERT_NE(remuxed.data, nullptr);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(remuxed.data, remuxed.size,
+                                              file.data(), file.size()));
+
+  testutil::AvifRwData stripped = Remux(file, [](avifDecoder* d) {
+    d->ignoreExif = AVIF_TRUE;
+    d->ignoreXMP = AVIF_TRUE;
+    ASSERT_EQ(avifDecoderParse(d), AVIF_RESULT_OK);
+    d->image->transformFlags |= AVIF_TRANSFORM_IROT;
+    d->image->irot.angle = 1;
+  });
+  ASSERT_NE(stripped.data, nullptr);
+  std::vector<uint8_t> stripped_obus;
+  DecoderPtr result =
+      ParseAndGetSample(stripped.data, stripped.size, 0, stripped_obus);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(stripped_obus, obus);
+  EXPECT_EQ(result->image->exif.size, 0u);
+  EXPECT_EQ(result->image->xmp.size, 0u);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(result->image->icc,
+                                              decoder->image->icc));
+  EXPECT_TRUE(result->image->transformFlags & AVIF_TRANSFORM_IROT);
+  EXPECT_EQ(result->image->irot.angle, 1);
+}
+
+TEST(RemuxTest, Sequence) {
+  const std::vector<uint8_t> file = ReadFile("colors-animated-8bpc.avif");
+  testutil::AvifRwData remuxed = Remux(file, [](avifDecoder* d) {
+    ASSERT_EQ(avifDecoderParse(d), AVIF_RESULT_OK);
+  });
+  ASSERT_NE(remuxed.data, nullptr);
+
+  std::vector<uint8_t> obus;
+  DecoderPtr decoder = ParseAndGetSample(file.data(), file.size(), 0, obus);
+  ASSERT_NE(decoder, nullptr);
+  DecoderPtr result(avifDecoderCreate());
+  ASSERT_NE(result, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(result.get(), remuxed.data, remuxed.size),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(result.get()), AVIF_RESULT_OK);
+  ASSERT_EQ(result->imageCount, decoder->imageCount);
+  EXPECT_EQ(result->timescale, decoder->timescale);
+  EXPECT_EQ(result->repetitionCount, decoder->repetitionCount);
+  for (int i = 0; i < decoder->imageCount; ++i) {
+    const uint32_t frame_index = static_cast<uint32_t>(i);
+    EXPECT_EQ(avifDecoderIsKeyframe(result.get(), frame_index),
+              avifDecoderIsKeyframe(decoder.get(), frame_index));
+    avifImageTiming timing, result_timing;
+    ASSERT_EQ(avifDecoderNthImageTiming(decoder.get(), frame_index, &timing),
+              AVIF_RESULT_OK);
+    ASSERT_EQ(avifDecoderNthImageTiming(result.get(), frame_index,
+                                        &result_timing),
+              AVIF_RESULT_OK);
+    EXPECT_EQ(result_timing.durationInTimescales, timing.durationInTimescales);
+  }
+  // Samples are copied as is.
+  std::vector<uint8_t> last_obus, last_remuxed_obus;
+  const uint32_t last = static_cast<uint32_t>(decoder->imageCount - 1);
+  ASSERT_NE(ParseAndGetSample(file.data(), file.size(), last, last_obus),
+            nullptr);
+  ASSERT_NE(ParseAndGetSample(remuxed.data, remuxed.size, last,
+                              last_remuxed_obus),
+            nullptr);
+  EXPECT_EQ(last_remuxed_obus, last_obus);
+}
+
+TEST(RemuxTest, Grid) {
+  const std::vector<uint8_t> file = ReadFile("sofa_grid1x5_420.avif");
+  DecoderPtr decoder(avifDecoderCreate());
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  EXPECT_EQ(avifEncoderRemux(encoder.get(), decoder.get()),
+            AVIF_RESULT_NOT_IMPLEMENTED);
+}
+
+}  // namespace
+}  // namespace avif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  avif::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,403 @@
+// Copyright 2024 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <tuple>
+
+#include "avif/avif.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+using ::testing::Combine;
+using ::testing::Values;
+
+namespace avif {
+namespace {
+
+//------------------------------------------------------------------------------
+
+// Deterministic content, so that the pinned checksums below only change if the
+// fixed-point pipeline changes. See also testutil::FillRgbPattern().
+uint32_t NextSample(uint32_t* seed, uint32_t max_value) {
+  *seed = *seed * 1103515245u + 12345u;
+  return (*seed >> 8) % (max_value + 1);
+}
+
+void FillYuvPattern(avifImage* image) {
+  uint32_t seed = 1;
+  const uint32_t max_value = (1u << image->depth) - 1;
+  for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_A; ++c) {
+    if (avifImagePlane(image, c) == nullptr) continue;
+    const uint32_t width = avifImagePlaneWidth(image, c);
+    const uint32_t height = avifImagePlaneHeight(image, c);
+    for (uint32_t y = 0; y < height; ++y) {
+      uint8_t* row =
+          avifImagePlane(image, c) + y * avifImagePlaneRowBytes(image, c);
+      for (uint32_t x = 0; x < width; ++x) {
+        // Half smooth gradient, half noise.
+        const uint32_t value = (x < width / 2)
+                                   ? ((x + y) * max_value / (width + height))
+                                   : NextSample(&seed, max_value);
+        if (image->depth > 8) {
+          reinterpret_cast<uint16_t*>(row)[x] = static_cast<uint16_t>(value);
+        } else {
+          row[x] = static_cast<uint8_t>(value);
+        }
+      }
+    }
+  }
+}
+
+// 32-bit FNV-1a of the visible bytes of each row.
+uint32_t Fnv1a(const uint8_t* data, uint32_t row_bytes, uint32_t width_bytes,
+               uint32_t height, uint32_t hash = 2166136261u) {
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width_bytes; ++x) {
+      hash = (hash ^ data[y * row_bytes + x]) * 16777619u;
+    }
+  }
+  return hash;
+}
+
+uint32_t HashRgb(const avifRGBImage& rgb) {
+  return Fnv1a(rgb.pixels, rgb.rowBytes,
+               rgb.width * avifRGBImagePixelSize(&rgb), rgb.height);
+}
+
+uint32_t HashYuv(const avifImage& image) {
+  uint32_t hash = 2166136261u;
+  const uint32_t sample_bytes = (image.depth > 8) ? 2 : 1;
+  for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_V; ++c) {
+    if (image.yuvPlanes[c] == nullptr) continue;
+    hash = Fnv1a(image.yuvPlanes[c], image.yuvRowBytes[c],
+                 avifImagePlaneWidth(&image, c) * sample_bytes,
+                 avifImagePlaneHeight(&image, c), hash);
+  }
+  return hash;
+}
+
+uint32_t GetSample(const uint8_t* row, uint32_t x, uint32_t depth) {
+  return (depth > 8) ? reinterpret_cast<const uint16_t*>(row)[x] : row[x];
+}
+
+// Returns the maximum absolute difference between two RGB images.
+int MaxRgbDiff(const avifRGBImage& a, const avifRGBImage& b) {
+  int max_diff = 0;
+  const uint32_t samples = a.width * avifRGBFormatChannelCount(a.format);
+  for (uint32_t y = 0; y < a.height; ++y) {
+    for (uint32_t x = 0; x < samples; ++x) {
+      const int diff = std::abs(
+          static_cast<int>(GetSample(a.pixels + y * a.rowBytes, x, a.depth)) -
+          static_cast<int>(GetSample(b.pixels + y * b.rowBytes, x, b.depth)));
+      max_diff = std::max(max_diff, diff);
+    }
+  }
+  return max_diff;
+}
+
+// Returns the maximum absolute difference between the YUV planes of two
+// images.
+int MaxYuvDiff(const avifImage& a, const avifImage& b) {
+  int max_diff = 0;
+  for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_V; ++c) {
+    if (a.yuvPlanes[c] == nullptr) continue;
+    for (uint32_t y = 0; y < avifImagePlaneHeight(&a, c); ++y) {
+      for (uint32_t x = 0; x < avifImagePlaneWidth(&a, c); ++x) {
+        const int diff = std::abs(
+            static_cast<int>(GetSample(
+                a.yuvPlanes[c] + y * a.yuvRowBytes[c], x, a.depth)) -
+            static_cast<int>(GetSample(
+                b.yuvPlanes[c] + y * b.yuvRowBytes[c], x, b.depth)));
+        max_diff = std::max(max_diff, diff);
+      }
+    }
+  }
+  return max_diff;
+}
+
+//------------------------------------------------------------------------------
+
+class FixedPointYUVToRGBTest
+    : public testing::TestWithParam<
+          std::tuple</*yuv_depth=*/int, /*rgb_depth=*/int, avifPixelFormat,
+                     avifRange, avifChromaUpsampling>> {};
+
+TEST_P(FixedPointYUVToRGBTest, WithinOneOfFloat) {
+  const int yuv_depth = std::get<0>(GetParam());
+  const int rgb_depth = std::get<1>(GetParam());
+  const avifPixelFormat yuv_format = std::get<2>(GetParam());
+  const avifRange yuv_range = std::get<3>(GetParam());
+  const avifChromaUpsampling upsampling = std::get<4>(GetParam());
+
+  ImagePtr image =
+      testutil::CreateImage(/*width=*/67, /*height=*/33, yuv_depth, yuv_format,
+                            AVIF_PLANES_YUV, yuv_range);
+  ASSERT_NE(image, nullptr);
+  image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT601;
+  FillYuvPattern(image.get());
+
+  testutil::AvifRgbImage reference(image.get(), rgb_depth, AVIF_RGB_FORMAT_RGB);
+  reference.chromaUpsampling = upsampling;
+  reference.avoidLibYUV = AVIF_TRUE;
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &reference), AVIF_RESULT_OK);
+
+  testutil::AvifRgbImage rgb(image.get(), rgb_depth, AVIF_RGB_FORMAT_RGB);
+  rgb.chromaUpsampling = upsampling;
+  rgb.fixedPoint = AVIF_TRUE;
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &rgb), AVIF_RESULT_OK);
+  EXPECT_LE(MaxRgbDiff(rgb, reference), 1);
+
+  // Multithreading must not change the output.
+  testutil::AvifRgbImage threaded(image.get(), rgb_depth, AVIF_RGB_FORMAT_RGB);
+  threaded.chromaUpsampling = upsampling;
+  threaded.fixedPoint = AVIF_TRUE;
+  threaded.maxThreads = 4;
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &threaded), AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(rgb, threaded));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, FixedPointYUVToRGBTest,
+    Combine(/*yuv_depth=*/Values(8, 10, 12), /*rgb_depth=*/Values(8, 10, 12),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV422,
+                   AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV400),
+            Values(AVIF_RANGE_FULL, AVIF_RANGE_LIMITED),
+            Values(AVIF_CHROMA_UPSAMPLING_NEAREST,
+                   AVIF_CHROMA_UPSAMPLING_BILINEAR)));
+
+class FixedPointRGBToYUVTest
+    : public testing::TestWithParam<std::tuple<
+          /*rgb_depth=*/int, /*yuv_depth=*/int, avifPixelFormat, avifRange>> {};
+
+TEST_P(FixedPointRGBToYUVTest, WithinOneOfFloat) {
+  const int rgb_depth = std::get<0>(GetParam());
+  const int yuv_depth = std::get<1>(GetParam());
+  const avifPixelFormat yuv_format = std::get<2>(GetParam());
+  const avifRange yuv_range = std::get<3>(GetParam());
+
+  ImagePtr reference = testutil::CreateImage(
+      /*width=*/67, /*height=*/33, yuv_depth, yuv_format, AVIF_PLANES_YUV,
+      yuv_range);
+  ASSERT_NE(reference, nullptr);
+  reference->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+  ImagePtr image =
+      testutil::CreateImage(/*width=*/67, /*height=*/33, yuv_depth, yuv_format,
+                            AVIF_PLANES_YUV, yuv_range);
+  ASSERT_NE(image, nullptr);
+  image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+
+  testutil::AvifRgbImage rgb(reference.get(), rgb_depth, AVIF_RGB_FORMAT_BGR);
+  testutil::FillRgbPattern(&rgb);
+  rgb.avoidLibYUV = AVIF_TRUE;
+  ASSERT_EQ(avifImageRGBToYUV(reference.get(), &rgb), AVIF_RESULT_OK);
+  rgb.fixedPoint = AVIF_TRUE;
+  ASSERT_EQ(avifImageRGBToYUV(image.get(), &rgb), AVIF_RESULT_OK);
+  EXPECT_LE(MaxYuvDiff(*image, *reference), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, FixedPointRGBToYUVTest,
+    Combine(/*rgb_depth=*/Values(8, 10, 12), /*yuv_depth=*/Values(8, 10, 12),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV422,
+                   AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV400),
+            Values(AVIF_RANGE_FULL, AVIF_RANGE_LIMITED)));
+
+//------------------------------------------------------------------------------
+
+TEST(FixedPointTest, GraysAreExact) {
+  for (int depth : {8, 10, 12}) {
+    for (avifRange range : {AVIF_RANGE_FULL, AVIF_RANGE_LIMITED}) {
+      const uint32_t max_value = (1u << depth) - 1;
+      const uint32_t bias_y =
+          (range == AVIF_RANGE_FULL) ? 0 : 16u << (depth - 8);
+      const uint32_t range_y =
+          (range == AVIF_RANGE_FULL) ? max_value : 219u << (depth - 8);
+      // Limited range cannot represent every full range gray level exactly.
+      const uint32_t mid_gray =
+          (range == AVIF_RANGE_FULL) ? max_value / 2 : max_value;
+      for (uint32_t gray : {0u, mid_gray, max_value}) {
+        ImagePtr image = testutil::CreateImage(/*width=*/4, /*height=*/4, depth,
+                                               AVIF_PIXEL_FORMAT_YUV420,
+                                               AVIF_PLANES_YUV, range);
+        ASSERT_NE(image, nullptr);
+        const uint32_t y = bias_y + gray * range_y / max_value;
+        const uint32_t yuva[] = {y, 1u << (depth - 1), 1u << (depth - 1), 0};
+        testutil::FillImagePlain(image.get(), yuva);
+
+        testutil::AvifRgbImage rgb(image.get(), depth, AVIF_RGB_FORMAT_RGB);
+        rgb.fixedPoint = AVIF_TRUE;
+        ASSERT_EQ(avifImageYUVToRGB(image.get(), &rgb), AVIF_RESULT_OK);
+        for (uint32_t x = 0; x < 3 * rgb.width; ++x) {
+          ASSERT_EQ(GetSample(rgb.pixels, x, depth), gray)
+              << "depth " << depth << " range " << range;
+        }
+
+        // And back.
+        ImagePtr back = testutil::CreateImage(/*width=*/4, /*height=*/4, depth,
+                                              AVIF_PIXEL_FORMAT_YUV420,
+                                              AVIF_PLANES_YUV, range);
+        ASSERT_NE(back, nullptr);
+        ASSERT_EQ(avifImageRGBToYUV(back.get(), &rgb), AVIF_RESULT_OK);
+        EXPECT_TRUE(testutil::AreImagesEqual(*image, *back));
+      }
+    }
+  }
+}
+
+TEST(FixedPointTest, UnsupportedCombinations) {
+  ImagePtr image = testutil::CreateImage(/*width=*/4, /*height=*/4, /*depth=*/8,
+                                         AVIF_PIXEL_FORMAT_YUV444,
+                                         AVIF_PLANES_ALL, AVIF_RANGE_FULL);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+
+  {
+    testutil::AvifRgbImage rgb(image.get(), /*rgbDepth=*/16,
+                               AVIF_RGB_FORMAT_RGBA);
+    rgb.fixedPoint = AVIF_TRUE;
+    EXPECT_EQ(avifImageYUVToRGB(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+  }
+  {
+    // Alpha multiply into a format without alpha.
+    testutil::AvifRgbImage rgb(image.get(), /*rgbDepth=*/8,
+                               AVIF_RGB_FORMAT_RGB);
+    rgb.fixedPoint = AVIF_TRUE;
+    EXPECT_EQ(avifImageYUVToRGB(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+  }
+  {
+    testutil::AvifRgbImage rgb(image.get(), /*rgbDepth=*/8,
+                               AVIF_RGB_FORMAT_RGBA);
+    rgb.fixedPoint = AVIF_TRUE;
+    rgb.alphaPremultiplied = AVIF_TRUE;
+    // Premultiplying after the conversion is supported.
+    EXPECT_EQ(avifImageYUVToRGB(image.get(), &rgb), AVIF_RESULT_OK);
+    // Unpremultiplying before the conversion is not.
+    EXPECT_EQ(avifImageRGBToYUV(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+  }
+  {
+    testutil::AvifRgbImage rgb(image.get(), /*rgbDepth=*/8,
+                               AVIF_RGB_FORMAT_RGBA);
+    rgb.fixedPoint = AVIF_TRUE;
+    rgb.chromaDownsampling = AVIF_CHROMA_DOWNSAMPLING_SHARP_YUV;
+    EXPECT_EQ(avifImageRGBToYUV(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+  }
+  image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_IDENTITY;
+  {
+    testutil::AvifRgbImage rgb(image.get(), /*rgbDepth=*/8,
+                               AVIF_RGB_FORMAT_RGBA);
+    rgb.fixedPoint = AVIF_TRUE;
+    EXPECT_EQ(avifImageYUVToRGB(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+    EXPECT_EQ(avifImageRGBToYUV(image.get(), &rgb),
+              AVIF_RESULT_NOT_IMPLEMENTED);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Conformance: the fixed-point outputs are pinned. Any change to these values
+// is a breaking change of the documented fixed-point arithmetic.
+
+struct PinnedCase {
+  int yuv_depth;
+  int rgb_depth;
+  avifPixelFormat yuv_format;
+  avifRange yuv_range;
+  avifMatrixCoefficients matrix_coefficients;
+  avifChromaUpsampling upsampling;
+  uint32_t yuv_to_rgb_hash;
+  uint32_t rgb_to_yuv_hash;
+  // If different, the alpha plane is filled and alpha is (un)multiplied by
+  // avifImageYUVToRGB(). avifImageRGBToYUV() does not support it.
+  bool yuv_premultiplied = false;
+  bool rgb_premultiplied = false;
+};
+
+constexpr PinnedCase kPinnedCases[] = {
+    {8, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     2332121216u, 2656477910u},
+    {8, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT709, AVIF_CHROMA_UPSAMPLING_NEAREST,
+     2478549040u, 116312035u},
+    {8, 8, AVIF_PIXEL_FORMAT_YUV444, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     3750782327u, 1589118086u},
+    {8, 8, AVIF_PIXEL_FORMAT_YUV400, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     1894173732u, 2127405187u},
+    {10, 8, AVIF_PIXEL_FORMAT_YUV422, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT709, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     1234956512u, 3384784402u},
+    {10, 10, AVIF_PIXEL_FORMAT_YUV420, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT2020_NCL, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     3096454946u, 167071349u},
+    {10, 12, AVIF_PIXEL_FORMAT_YUV444, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT2020_NCL, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     2898767317u, 1937872096u},
+    {12, 12, AVIF_PIXEL_FORMAT_YUV420, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT2020_NCL, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     2461198035u, 2917971848u},
+    {12, 8, AVIF_PIXEL_FORMAT_YUV444, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     1454316105u, 3602072428u},
+    // Premultiply.
+    {8, 8, AVIF_PIXEL_FORMAT_YUV420, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     3373890151u, 0u, /*yuv_premultiplied=*/false, /*rgb_premultiplied=*/true},
+    {10, 12, AVIF_PIXEL_FORMAT_YUV444, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT2020_NCL, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     832572693u, 0u, /*yuv_premultiplied=*/false, /*rgb_premultiplied=*/true},
+    // Unpremultiply.
+    {8, 8, AVIF_PIXEL_FORMAT_YUV444, AVIF_RANGE_FULL,
+     AVIF_MATRIX_COEFFICIENTS_BT601, AVIF_CHROMA_UPSAMPLING_AUTOMATIC,
+     677001520u, 0u, /*yuv_premultiplied=*/true, /*rgb_premultiplied=*/false},
+    {12, 10, AVIF_PIXEL_FORMAT_YUV422, AVIF_RANGE_LIMITED,
+     AVIF_MATRIX_COEFFICIENTS_BT709, AVIF_CHROMA_UPSAMPLING_BILINEAR,
+     2530653553u, 0u, /*yuv_premultiplied=*/true, /*rgb_premultiplied=*/false},
+};
+
+TEST(FixedPointTest, PinnedOutputs) {
+  for (const PinnedCase& c : kPinnedCases) {
+    SCOPED_TRACE(testing::Message()
+                 << c.yuv_depth << "-bit "
+                 << avifPixelFormatToString(c.yuv_format)
+                 << " <-> " << c.rgb_depth << "-bit RGBA, range " << c.yuv_range
+                 << ", MC " << c.matrix_coefficients << ", premultiplied "
+                 << c.yuv_premultiplied << " <-> " << c.rgb_premultiplied);
+
+    const bool alpha_multiply = c.yuv_premultiplied != c.rgb_premultiplied;
+    ImagePtr image = testutil::CreateImage(
+        /*width=*/67, /*height=*/33, c.yuv_depth, c.yuv_format,
+        alpha_multiply ? AVIF_PLANES_ALL : AVIF_PLANES_YUV, c.yuv_range);
+    ASSERT_NE(image, nullptr);
+    image->matrixCoefficients = c.matrix_coefficients;
+    image->alphaPremultiplied = c.yuv_premultiplied;
+    FillYuvPattern(image.get());
+    testutil::AvifRgbImage rgb(image.get(), c.rgb_depth, AVIF_RGB_FORMAT_RGBA);
+    rgb.chromaUpsampling = c.upsampling;
+    rgb.alphaPremultiplied = c.rgb_premultiplied;
+    rgb.fixedPoint = AVIF_TRUE;
+    ASSERT_EQ(avifImageYUVToRGB(image.get(), &rgb), AVIF_RESULT_OK);
+    EXPECT_EQ(HashRgb(rgb), c.yuv_to_rgb_hash);
+
+    testutil::FillRgbPattern(&rgb);
+    if (alpha_multiply) {
+      EXPECT_EQ(avifImageRGBToYUV(image.get(), &rgb),
+                AVIF_RESULT_NOT_IMPLEMENTED);
+      continue;
+    }
+    ASSERT_EQ(avifImageRGBToYUV(image.get(), &rgb), AVIF_RESULT_OK);
+    EXPECT_EQ(HashYuv(*image), c.rgb_to_yuv_hash);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+}  // namespace
+}  // namespace avif
@@ -1,6 +1,7 @@
 // Copyright 2023 Google LLC
 // SPDX-License-Identifier: BSD-2-Clause
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -976,6 +977,191 @@ void ToneMapImageAndCompareToReference(
   //     .write(reinterpret_cast<char*>(encoded.data), encoded.size);
 }
 
+// Tone maps 'image' with its gain map and returns the result in YUV 4:4:4.
+ImagePtr ToneMap(const avifImage* image, const avifGainMap& gain_map) {
+  testutil::AvifRgbImage rgb(image, /*rgbDepth=*/10, AVIF_RGB_FORMAT_RGB);
+  ImagePtr tone_mapped(avifImageCreate(image->width, image->height, 10,
+                                       AVIF_PIXEL_FORMAT_YUV444));
+  avifDiagnostics diag;
+  if (tone_mapped == nullptr ||
+      avifImageApplyGainMap(image, &gain_map, /*hdrHeadroom=*/3.0f,
+                            AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084, &rgb,
+                            /*clli=*/nullptr, &diag) != AVIF_RESULT_OK ||
+      avifImageRGBToYUV(tone_mapped.get(), &rgb) != AVIF_RESULT_OK) {
+    return nullptr;
+  }
+  return tone_mapped;
+}
+
+// A gain map smaller than the base image is upsampled on the fly. The result
+// must be close to tone mapping with a gain map upscaled beforehand.
+TEST(GainMapTest, ToneMapWithSmallGainMap) {
+  ImagePtr image = CreateTestImageWithGainMap(/*base_rendition_is_hdr=*/false);
+  ASSERT_NE(image, nullptr);
+  ASSERT_LT(image->gainMap.image->width, image->width);
+
+  ImagePtr upscaled(avifImageCreateEmpty());
+  ASSERT_NE(upscaled, nullptr);
+  ASSERT_EQ(avifImageCopy(upscaled.get(), image->gainMap.image,
+                          AVIF_PLANES_ALL),
+            AVIF_RESULT_OK);
+  avifDiagnostics diag;
+  ASSERT_EQ(
+      avifImageScale(upscaled.get(), image->width, image->height, &diag),
+      AVIF_RESULT_OK);
+  avifGainMap upscaled_gain_map = image->gainMap;
+  upscaled_gain_map.image = upscaled.get();
+
+  ImagePtr expected = ToneMap(image.get(), upscaled_gain_map);
+  ImagePtr tone_mapped = ToneMap(image.get(), image->gainMap);
+  ASSERT_NE(expected, nullptr);
+  ASSERT_NE(tone_mapped, nullptr);
+  EXPECT_GT(testutil::GetPsnr(*expected, *tone_mapped), 45.0);
+
+  // Interpolating a uniform gain map is exact.
+  for (avifImage* gain_map : {image->gainMap.image, upscaled.get()}) {
+    for (int c = AVIF_CHAN_Y; c <= AVIF_CHAN_V; ++c) {
+      for (uint32_t y = 0; y < avifImagePlaneHeight(gain_map, c); ++y) {
+        uint8_t* row = avifImagePlane(gain_map, c) +
+                       y * avifImagePlaneRowBytes(gain_map, c);
+        std::fill(row, row + avifImagePlaneWidth(gain_map, c), 100 + c * 20);
+      }
+    }
+  }
+  expected = ToneMap(image.get(), upscaled_gain_map);
+  tone_mapped = ToneMap(image.get(), image->gainMap);
+  ASSERT_NE(expected, nullptr);
+  ASSERT_NE(tone_mapped, nullptr);
+  EXPECT_TRUE(testutil::AreImagesEqual(*expected, *tone_mapped));
+}
+
+// The gain is looked up in a table per channel. It must match the formula of
+// the specification, evaluated for each pixel.
+TEST(GainMapTest, ToneMapSameAsFormula) {
+  ImagePtr image = CreateTestImageWithGainMap(/*base_rendition_is_hdr=*/false);
+  ASSERT_NE(image, nullptr);
+  // Same size as the base image, so that there is no interpolation.
+  ImagePtr gain_map =
+      testutil::CreateImage(image->width, image->height, /*depth=*/10,
+                            AVIF_PIXEL_FORMAT_YUV444, AVIF_PLANES_YUV);
+  ASSERT_NE(gain_map, nullptr);
+  testutil::FillImageGradient(gain_map.get());
+  avifImageDestroy(image->gainMap.image);
+  image->gainMap.image = gain_map.release();
+  const float hdr_headroom = 2.0f;
+
+  testutil::AvifRgbImage tone_mapped(image.get(), 16, AVIF_RGB_FORMAT_RGB);
+  avifDiagnostics diag;
+  ASSERT_EQ(avifImageApplyGainMap(image.get(), &image->gainMap, hdr_headroom,
+                                  AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084,
+                                  &tone_mapped, /*clli=*/nullptr, &diag),
+            AVIF_RESULT_OK);
+
+  testutil::AvifRgbImage base(image.get(), image->depth, AVIF_RGB_FORMAT_RGBA);
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &base), AVIF_RESULT_OK);
+  testutil::AvifRgbImage gain(image->gainMap.image, image->gainMap.image->depth,
+                              AVIF_RGB_FORMAT_RGBA);
+  ASSERT_EQ(avifImageYUVToRGB(image->gainMap.image, &gain), AVIF_RESULT_OK);
+  avifRGBColorSpaceInfo base_info, gain_info, tone_mapped_info;
+  ASSERT_TRUE(avifGetRGBColorSpaceInfo(&base, &base_info));
+  ASSERT_TRUE(avifGetRGBColorSpaceInfo(&gain, &gain_info));
+  ASSERT_TRUE(avifGetRGBColorSpaceInfo(&tone_mapped, &tone_mapped_info));
+
+  avifGainMapMetadataDouble metadata;
+  ASSERT_TRUE(avifGainMapMetadataFractionsToDouble(&metadata,
+                                                   &image->gainMap.metadata));
+  // hdr_headroom is between the base and alternate headrooms.
+  const float weight = (hdr_headroom - (float)metadata.baseHdrHeadroom) /
+                       (float)(metadata.alternateHdrHeadroom -
+                               metadata.baseHdrHeadroom);
+  ASSERT_GT(weight, 0.0f);
+  ASSERT_LT(weight, 1.0f);
+  const avifTransferFunction to_linear =
+      avifTransferCharacteristicsGetGammaToLinearFunction(
+          image->transferCharacteristics);
+  const avifTransferFunction to_gamma =
+      avifTransferCharacteristicsGetLinearToGammaFunction(
+          AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084);
+  for (uint32_t y = 0; y < image->height; ++y) {
+    for (uint32_t x = 0; x < image->width; ++x) {
+      float base_rgba[4], gain_rgba[4], tone_mapped_rgba[4];
+      avifGetRGBAPixel(&base, x, y, &base_info, base_rgba);
+      avifGetRGBAPixel(&gain, x, y, &gain_info, gain_rgba);
+      avifGetRGBAPixel(&tone_mapped, x, y, &tone_mapped_info,
+                       tone_mapped_rgba);
+      for (int c = 0; c < 3; ++c) {
+        const double log2_gain =
+            metadata.gainMapMin[c] +
+            (metadata.gainMapMax[c] - metadata.gainMapMin[c]) *
+                std::pow(gain_rgba[c], 1.0 / metadata.gainMapGamma[c]);
+        const double linear =
+            (to_linear(base_rgba[c]) + metadata.baseOffset[c]) *
+                std::exp2(log2_gain * weight) -
+            metadata.alternateOffset[c];
+        const float expected = std::min(
+            std::max(to_gamma(static_cast<float>(linear)), 0.0f), 1.0f);
+        ASSERT_NEAR(tone_mapped_rgba[c], expected, 2.0f / 65535)
+            << "x " << x << " y " << y << " c " << c;
+      }
+    }
+  }
+}
+
+class ToneMapYuvTest
+    : public testing::TestWithParam<std::tuple<avifPixelFormat,
+                                               /*max_threads=*/int>> {};
+
+// avifImageApplyGainMap() converts the base image to RGB and tone maps it in a
+// single pass. The result must be the same as tone mapping the whole RGB image.
+TEST_P(ToneMapYuvTest, SameAsRgb) {
+  const avifPixelFormat yuv_format = std::get<0>(GetParam());
+  const int max_threads = std::get<1>(GetParam());
+  ImagePtr image = testutil::CreateImage(/*width=*/100, /*height=*/150,
+                                         /*depth=*/10, yuv_format,
+                                         AVIF_PLANES_ALL);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  ImagePtr gain_map =
+      testutil::CreateImage(/*width=*/50, /*height=*/75, /*depth=*/8,
+                            AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_YUV);
+  ASSERT_NE(gain_map, nullptr);
+  testutil::FillImageGradient(gain_map.get());
+  image->gainMap.image = gain_map.release();
+  image->gainMap.metadata = GetTestGainMapMetadata(false);
+
+  testutil::AvifRgbImage base_rgb(image.get(), image->depth,
+                                  AVIF_RGB_FORMAT_RGBA);
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &base_rgb), AVIF_RESULT_OK);
+  testutil::AvifRgbImage expected(image.get(), 16, AVIF_RGB_FORMAT_RGBA);
+  avifContentLightLevelInformationBox expected_clli;
+  avifDiagnostics diag;
+  ASSERT_EQ(avifRGBImageApplyGainMap(
+                &base_rgb, image->transferCharacteristics, &image->gainMap,
+                /*hdrHeadroom=*/2.0f, AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084,
+                &expected, &expected_clli, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+
+  testutil::AvifRgbImage tone_mapped(image.get(), 16, AVIF_RGB_FORMAT_RGBA);
+  tone_mapped.maxThreads = max_threads;
+  avifContentLightLevelInformationBox clli;
+  ASSERT_EQ(avifImageApplyGainMap(image.get(), &image->gainMap,
+                                  /*hdrHeadroom=*/2.0f,
+                                  AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084,
+                                  &tone_mapped, &clli, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  EXPECT_TRUE(testutil::AreImagesEqual(expected, tone_mapped));
+  EXPECT_EQ(clli.maxCLL, expected_clli.maxCLL);
+  EXPECT_EQ(clli.maxPALL, expected_clli.maxPALL);
+}
+
+INSTANTIATE_TEST_SUITE_P(All, ToneMapYuvTest,
+                         testing::Combine(Values(AVIF_PIXEL_FORMAT_YUV444,
+                                                 AVIF_PIXEL_FORMAT_YUV422,
+                                                 AVIF_PIXEL_FORMAT_YUV420),
+                                          /*max_threads=*/Values(1, 4)));
+
 TEST_P(ToneMapTest, ToneMapImage) {
   const std::string source = std::get<0>(GetParam());
   const float hdr_headroom = std::get<1>(GetParam());
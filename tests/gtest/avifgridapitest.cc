@@ -278,5 +278,47 @@ TEST(GridApiTest, DifferentMatrixCoefficients) {
       AVIF_RESULT_INVALID_IMAGE_GRID);
 }
 
+TEST(GridApiTest, IdenticalCellsAreEncodedOnce) {
+  ImagePtr cell = testutil::CreateImage(
+      64, 64, /*depth=*/8, AVIF_PIXEL_FORMAT_YUV444, AVIF_PLANES_YUV);
+  ImagePtr other_cell = testutil::CreateImage(
+      64, 64, /*depth=*/8, AVIF_PIXEL_FORMAT_YUV444, AVIF_PLANES_YUV);
+  ASSERT_NE(cell, nullptr);
+  ASSERT_NE(other_cell, nullptr);
+  testutil::FillImageGradient(cell.get());
+  const uint32_t yuva[] = {0, 128, 128, 255};
+  testutil::FillImagePlain(other_cell.get(), yuva);
+
+  // Reference: a single cell.
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->speed = AVIF_SPEED_FASTEST;
+  testutil::AvifRwData single_cell;
+  ASSERT_EQ(avifEncoderWrite(encoder.get(), cell.get(), &single_cell),
+            AVIF_RESULT_OK);
+  const uint64_t cell_color_size = encoder->ioStats.colorOBUSize;
+
+  // Three identical cells and a different one.
+  encoder.reset(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->speed = AVIF_SPEED_FASTEST;
+  const avifImage* cell_image_ptrs[4] = {cell.get(), cell.get(),
+                                         other_cell.get(), cell.get()};
+  ASSERT_EQ(
+      avifEncoderAddImageGrid(encoder.get(), /*gridCols=*/2, /*gridRows=*/2,
+                              cell_image_ptrs, AVIF_ADD_IMAGE_FLAG_SINGLE),
+      AVIF_RESULT_OK);
+  testutil::AvifRwData grid;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &grid), AVIF_RESULT_OK);
+  // Only the distinct cells are stored.
+  EXPECT_GT(encoder->ioStats.colorOBUSize, cell_color_size);
+  EXPECT_LT(encoder->ioStats.colorOBUSize, 2 * cell_color_size + 1000);
+
+  ImagePtr decoded = testutil::Decode(grid.data, grid.size);
+  ASSERT_NE(decoded, nullptr);
+  EXPECT_EQ(decoded->width, 128u);
+  EXPECT_EQ(decoded->height, 128u);
+}
+
 }  // namespace
 }  // namespace avif
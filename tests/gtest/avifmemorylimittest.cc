@@ -0,0 +1,144 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "avif/avif.h"
+#include "avif/internal.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+// Parses the given test file with the given memoryLimit and sets bytes to the
+// estimated memory usage.
+avifResult ParseAndEstimate(const char* file_name, uint64_t memory_limit,
+                            uint64_t* bytes) {
+  *bytes = 0;
+  DecoderPtr decoder(avifDecoderCreate());
+  if (decoder == nullptr) return AVIF_RESULT_OUT_OF_MEMORY;
+  decoder->memoryLimit = memory_limit;
+  AVIF_CHECKRES(avifDecoderSetIOFile(
+      decoder.get(), (std::string(data_path) + file_name).c_str()));
+  AVIF_CHECKRES(avifDecoderParse(decoder.get()));
+  return avifDecoderEstimateMemoryUsage(decoder.get(), bytes);
+}
+
+TEST(MemoryLimitTest, NothingParsed) {
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  uint64_t bytes = 1;
+  EXPECT_EQ(avifDecoderEstimateMemoryUsage(decoder.get(), &bytes),
+            AVIF_RESULT_NO_CONTENT);
+  EXPECT_EQ(bytes, 0u);
+}
+
+TEST(MemoryLimitTest, StillImage) {
+  uint64_t bytes;
+  ASSERT_EQ(ParseAndEstimate("paris_icc_exif_xmp.avif", 0, &bytes),
+            AVIF_RESULT_OK);
+  // 403x302, 8-bit, 4:2:0.
+  EXPECT_GE(bytes, 403u * 302u * 3 / 2);
+  // A still image does not need the reference frames.
+  EXPECT_LT(bytes, 403u * 302u * 3 / 2 * 4);
+
+  uint64_t bytes_with_limit;
+  EXPECT_EQ(ParseAndEstimate("paris_icc_exif_xmp.avif", bytes,
+                             &bytes_with_limit),
+            AVIF_RESULT_OK);
+  EXPECT_EQ(bytes_with_limit, bytes);
+  // The limit is checked by avifDecoderParse().
+  EXPECT_EQ(ParseAndEstimate("paris_icc_exif_xmp.avif", bytes - 1,
+                             &bytes_with_limit),
+            AVIF_RESULT_MEMORY_LIMIT_EXCEEDED);
+}
+
+TEST(MemoryLimitTest, Grid) {
+  uint64_t bytes;
+  ASSERT_EQ(ParseAndEstimate("sofa_grid1x5_420.avif", 0, &bytes),
+            AVIF_RESULT_OK);
+  // 1024x770, made of 5 tiles. Both the tiles and the canvas are counted.
+  EXPECT_GE(bytes, 2u * 1024u * 770u * 3 / 2);
+  uint64_t bytes_with_limit;
+  EXPECT_EQ(ParseAndEstimate("sofa_grid1x5_420.avif", bytes - 1,
+                             &bytes_with_limit),
+            AVIF_RESULT_MEMORY_LIMIT_EXCEEDED);
+}
+
+TEST(MemoryLimitTest, Sequence) {
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOFile(
+                decoder.get(),
+                (std::string(data_path) + "colors-animated-8bpc.avif").c_str()),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderSetSource(decoder.get(), AVIF_DECODER_SOURCE_TRACKS),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  uint64_t sequence_bytes;
+  ASSERT_EQ(avifDecoderEstimateMemoryUsage(decoder.get(), &sequence_bytes),
+            AVIF_RESULT_OK);
+
+  ASSERT_EQ(
+      avifDecoderSetSource(decoder.get(), AVIF_DECODER_SOURCE_PRIMARY_ITEM),
+      AVIF_RESULT_OK);
+  uint64_t still_bytes;
+  ASSERT_EQ(avifDecoderEstimateMemoryUsage(decoder.get(), &still_bytes),
+            AVIF_RESULT_OK);
+  // The reference frames are accounted for.
+  EXPECT_GT(sequence_bytes, 8 * still_bytes);
+
+  // The limit is also checked when changing the source.
+  decoder->memoryLimit = still_bytes;
+  EXPECT_EQ(avifDecoderSetSource(decoder.get(), AVIF_DECODER_SOURCE_TRACKS),
+            AVIF_RESULT_MEMORY_LIMIT_EXCEEDED);
+  EXPECT_EQ(
+      avifDecoderSetSource(decoder.get(), AVIF_DECODER_SOURCE_PRIMARY_ITEM),
+      AVIF_RESULT_OK);
+}
+
+#if defined(AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP)
+TEST(MemoryLimitTest, GainMap) {
+  const std::string path =
+      std::string(data_path) + "color_grid_alpha_grid_gainmap_nogrid.avif";
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOFile(decoder.get(), path.c_str()), AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  uint64_t bytes_without_gain_map;
+  ASSERT_EQ(
+      avifDecoderEstimateMemoryUsage(decoder.get(), &bytes_without_gain_map),
+      AVIF_RESULT_OK);
+
+  decoder.reset(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  decoder->enableDecodingGainMap = AVIF_TRUE;
+  ASSERT_EQ(avifDecoderSetIOFile(decoder.get(), path.c_str()), AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  uint64_t bytes_with_gain_map;
+  ASSERT_EQ(avifDecoderEstimateMemoryUsage(decoder.get(), &bytes_with_gain_map),
+            AVIF_RESULT_OK);
+  EXPECT_GT(bytes_with_gain_map, bytes_without_gain_map);
+}
+#endif  // AVIF_ENABLE_EXPERIMENTAL_GAIN_MAP
+
+}  // namespace
+}  // namespace avif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  avif::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,105 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <vector>
+
+#include "avif/avif.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+class MultiResolutionTest : public testing::TestWithParam<int> {};
+
+TEST_P(MultiResolutionTest, EncodeDecode) {
+  if (!testutil::Av1EncoderAvailable() || !testutil::Av1DecoderAvailable()) {
+    GTEST_SKIP() << "AV1 Codec unavailable, skip test.";
+  }
+  const int max_threads = GetParam();
+  ImagePtr image = testutil::CreateImage(/*width=*/96, /*height=*/64,
+                                         /*depth=*/8, AVIF_PIXEL_FORMAT_YUV420,
+                                         AVIF_PLANES_ALL);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->speed = AVIF_SPEED_FASTEST;
+  encoder->maxThreads = max_threads;
+  // Unordered, with duplicates and the original width.
+  const std::vector<uint32_t> widths = {24, 96, 48, 24, 12};
+  std::vector<testutil::AvifRwData> outputs(widths.size());
+  ASSERT_EQ(avifEncoderWriteMultiResolution(
+                encoder.get(), image.get(), widths.data(),
+                static_cast<uint32_t>(widths.size()), outputs.data()),
+            AVIF_RESULT_OK);
+
+  for (size_t i = 0; i < widths.size(); ++i) {
+    ImagePtr decoded = testutil::Decode(outputs[i].data, outputs[i].size);
+    ASSERT_NE(decoded, nullptr);
+    EXPECT_EQ(decoded->width, widths[i]);
+    EXPECT_EQ(decoded->height, widths[i] * 2 / 3);
+    EXPECT_NE(decoded->alphaPlane, nullptr);
+  }
+  // The full size output is the same as a regular encode.
+  EncoderPtr single_encoder(avifEncoderCreate());
+  ASSERT_NE(single_encoder, nullptr);
+  single_encoder->speed = AVIF_SPEED_FASTEST;
+  single_encoder->maxThreads = max_threads;
+  testutil::AvifRwData single;
+  ASSERT_EQ(avifEncoderWrite(single_encoder.get(), image.get(), &single),
+            AVIF_RESULT_OK);
+  EXPECT_EQ(outputs[1].size, single.size);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, MultiResolutionTest,
+                         testing::Values(1, 2, 8));
+
+TEST(MultiResolutionInvalidTest, Widths) {
+  ImagePtr image = testutil::CreateImage(/*width=*/96, /*height=*/64,
+                                         /*depth=*/8, AVIF_PIXEL_FORMAT_YUV420,
+                                         AVIF_PLANES_YUV);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  testutil::AvifRwData outputs[2];
+
+  const uint32_t zero_width[] = {48, 0};
+  EXPECT_EQ(avifEncoderWriteMultiResolution(encoder.get(), image.get(),
+                                            zero_width, 2, outputs),
+            AVIF_RESULT_INVALID_ARGUMENT);
+  const uint32_t upscale[] = {48, 97};
+  EXPECT_EQ(avifEncoderWriteMultiResolution(encoder.get(), image.get(),
+                                            upscale, 2, outputs),
+            AVIF_RESULT_INVALID_ARGUMENT);
+  EXPECT_EQ(avifEncoderWriteMultiResolution(encoder.get(), image.get(),
+                                            upscale, 0, outputs),
+            AVIF_RESULT_INVALID_ARGUMENT);
+}
+
+TEST(MultiResolutionInvalidTest, EncodingFailure) {
+  ImagePtr image = testutil::CreateImage(/*width=*/96, /*height=*/64,
+                                         /*depth=*/8, AVIF_PIXEL_FORMAT_YUV420,
+                                         AVIF_PLANES_YUV);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->maxThreads = 4;
+  // An invalid setting makes every encode fail.
+  encoder->extraLayerCount = AVIF_MAX_AV1_LAYER_COUNT;
+  const uint32_t widths[] = {96, 48, 24};
+  testutil::AvifRwData outputs[3];
+  EXPECT_NE(avifEncoderWriteMultiResolution(encoder.get(), image.get(),
+                                            widths, 3, outputs),
+            AVIF_RESULT_OK);
+  for (const testutil::AvifRwData& output : outputs) {
+    EXPECT_EQ(output.data, nullptr);
+    EXPECT_EQ(output.size, 0u);
+  }
+}
+
+}  // namespace
+}  // namespace avif
@@ -0,0 +1,355 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "avif/avif.h"
+#include "avif/internal.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+std::vector<uint8_t> ReadFile(const std::string& file_name) {
+  std::ifstream file(std::string(data_path) + file_name, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+struct ParseParams {
+  const char* file_name;
+  uint32_t width;
+  uint32_t height;
+  int image_count;
+  bool alpha_present;
+  bool image_sequence_track_present;
+};
+
+constexpr ParseParams kParseParams[] = {
+    {"paris_icc_exif_xmp.avif", 403, 302, 1, false, false},
+    {"sofa_grid1x5_420.avif", 1024, 770, 1, false, false},
+    {"color_grid_alpha_nogrid.avif", 80, 80, 1, true, false},
+    {"colors-animated-8bpc.avif", 150, 150, 5, false, true},
+};
+
+class ParseTest : public testing::TestWithParam<ParseParams> {};
+
+TEST_P(ParseTest, Parse) {
+  const ParseParams& params = GetParam();
+  const std::vector<uint8_t> file = ReadFile(params.file_name);
+  ASSERT_FALSE(file.empty());
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  EXPECT_EQ(decoder->image->width, params.width);
+  EXPECT_EQ(decoder->image->height, params.height);
+  EXPECT_EQ(decoder->imageCount, params.image_count);
+  EXPECT_EQ(decoder->alphaPresent, params.alpha_present);
+  EXPECT_EQ(decoder->imageSequenceTrackPresent,
+            params.image_sequence_track_present);
+}
+
+// Microbenchmark of avifDecoderParse(). Disabled by default. Run with
+// --gtest_also_run_disabled_tests --gtest_filter=*Benchmark*
+TEST_P(ParseTest, DISABLED_Benchmark) {
+  const ParseParams& params = GetParam();
+  const std::vector<uint8_t> file = ReadFile(params.file_name);
+  ASSERT_FALSE(file.empty());
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()),
+            AVIF_RESULT_OK);
+
+  constexpr int kIterations = 20000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << params.file_name << ": " << elapsed.count() / kIterations
+            << " us per avifDecoderParse()" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(All, ParseTest, testing::ValuesIn(kParseParams));
+
+//------------------------------------------------------------------------------
+
+// Returns a still image file made of a 64x64 primary image item followed by
+// item_count - 1 items of an unknown type, with sparse item IDs. Every item has
+// an iinf, iloc and ipma entry. Only the box structure is valid: the AV1 sample
+// cannot be decoded.
+testutil::AvifRwData CreateFileWithManyItems(uint16_t item_count) {
+  testutil::AvifRwData file;
+  avifRWStream s;
+  avifRWStreamStart(&s, &file);
+  const auto item_id = [](uint16_t i) {
+    return static_cast<uint16_t>(1 + i * 7);
+  };
+  avifBoxMarker ftyp, mdat, meta, hdlr, pitm, iinf, infe, iloc, iprp, ipco,
+      ispe, av1c, pixi, ipma;
+  bool ok =
+      avifRWStreamWriteBox(&s, "ftyp", AVIF_BOX_SIZE_TBD, &ftyp) ==
+          AVIF_RESULT_OK &&
+      avifRWStreamWriteChars(&s, "avif", 4) == AVIF_RESULT_OK &&
+      avifRWStreamWriteU32(&s, 0) == AVIF_RESULT_OK &&
+      avifRWStreamWriteChars(&s, "avifmif1miaf", 12) == AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, ftyp);
+
+  // The mdat box comes first so that the item offset is known.
+  ok = ok &&
+       avifRWStreamWriteBox(&s, "mdat", AVIF_BOX_SIZE_TBD, &mdat) ==
+           AVIF_RESULT_OK;
+  const uint32_t sample_offset = static_cast<uint32_t>(avifRWStreamOffset(&s));
+  const uint32_t sample_size = 8;
+  ok = ok && avifRWStreamWriteZeros(&s, sample_size) == AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, mdat);
+
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "meta", AVIF_BOX_SIZE_TBD, 0, 0, &meta) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteFullBox(&s, "hdlr", AVIF_BOX_SIZE_TBD, 0, 0, &hdlr) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU32(&s, 0) == AVIF_RESULT_OK &&
+       avifRWStreamWriteChars(&s, "pict", 4) == AVIF_RESULT_OK &&
+       avifRWStreamWriteZeros(&s, 3 * 4 + 1) == AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, hdlr);
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "pitm", AVIF_BOX_SIZE_TBD, 0, 0, &pitm) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU16(&s, item_id(0)) == AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, pitm);
+
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "iinf", AVIF_BOX_SIZE_TBD, 0, 0, &iinf) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU16(&s, item_count) == AVIF_RESULT_OK;
+  for (uint16_t i = 0; i < item_count; ++i) {
+    ok = ok &&
+         avifRWStreamWriteFullBox(&s, "infe", AVIF_BOX_SIZE_TBD, 2, 0,
+                                  &infe) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU16(&s, item_id(i)) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU16(&s, 0) == AVIF_RESULT_OK &&
+         avifRWStreamWriteChars(&s, i == 0 ? "av01" : "unkn", 4) ==
+             AVIF_RESULT_OK &&
+         avifRWStreamWriteU8(&s, 0) == AVIF_RESULT_OK;
+    avifRWStreamFinishBox(&s, infe);
+  }
+  avifRWStreamFinishBox(&s, iinf);
+
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "iloc", AVIF_BOX_SIZE_TBD, 0, 0, &iloc) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU8(&s, 0x44) == AVIF_RESULT_OK &&  // 32-bit fields.
+       avifRWStreamWriteU8(&s, 0) == AVIF_RESULT_OK &&     // No base offset.
+       avifRWStreamWriteU16(&s, item_count) == AVIF_RESULT_OK;
+  for (uint16_t i = 0; i < item_count; ++i) {
+    ok = ok && avifRWStreamWriteU16(&s, item_id(i)) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU16(&s, 0) == AVIF_RESULT_OK &&  // Data reference.
+         avifRWStreamWriteU16(&s, 1) == AVIF_RESULT_OK &&  // Extent count.
+         avifRWStreamWriteU32(&s, sample_offset) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU32(&s, sample_size) == AVIF_RESULT_OK;
+  }
+  avifRWStreamFinishBox(&s, iloc);
+
+  const uint8_t av1c_content[] = {0x81, 0x00, 0x0C, 0x00};  // 8-bit 4:2:0
+  ok = ok &&
+       avifRWStreamWriteBox(&s, "iprp", AVIF_BOX_SIZE_TBD, &iprp) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteBox(&s, "ipco", AVIF_BOX_SIZE_TBD, &ipco) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteFullBox(&s, "ispe", AVIF_BOX_SIZE_TBD, 0, 0, &ispe) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU32(&s, 64) == AVIF_RESULT_OK &&
+       avifRWStreamWriteU32(&s, 64) == AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, ispe);
+  ok = ok &&
+       avifRWStreamWriteBox(&s, "av1C", AVIF_BOX_SIZE_TBD, &av1c) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWrite(&s, av1c_content, sizeof(av1c_content)) ==
+           AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, av1c);
+  const uint8_t pixi_content[] = {3, 8, 8, 8};
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "pixi", AVIF_BOX_SIZE_TBD, 0, 0, &pixi) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWrite(&s, pixi_content, sizeof(pixi_content)) ==
+           AVIF_RESULT_OK;
+  avifRWStreamFinishBox(&s, pixi);
+  avifRWStreamFinishBox(&s, ipco);
+  ok = ok &&
+       avifRWStreamWriteFullBox(&s, "ipma", AVIF_BOX_SIZE_TBD, 0, 0, &ipma) ==
+           AVIF_RESULT_OK &&
+       avifRWStreamWriteU32(&s, item_count) == AVIF_RESULT_OK;
+  for (uint16_t i = 0; i < item_count; ++i) {
+    // The properties are ispe, av1C (essential) and pixi, in this order.
+    ok = ok && avifRWStreamWriteU16(&s, item_id(i)) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU8(&s, i == 0 ? 3 : 1) == AVIF_RESULT_OK &&
+         avifRWStreamWriteU8(&s, 1) == AVIF_RESULT_OK &&
+         (i != 0 || (avifRWStreamWriteU8(&s, 0x80 | 2) == AVIF_RESULT_OK &&
+                     avifRWStreamWriteU8(&s, 3) == AVIF_RESULT_OK));
+  }
+  avifRWStreamFinishBox(&s, ipma);
+  avifRWStreamFinishBox(&s, iprp);
+  avifRWStreamFinishBox(&s, meta);
+  avifRWStreamFinishWrite(&s);
+  if (!ok) return {};
+  return file;
+}
+
+TEST(ParseManyItemsTest, Parse) {
+  for (uint16_t item_count : {1, 2, 17, 1000}) {
+    SCOPED_TRACE(item_count);
+    testutil::AvifRwData file = CreateFileWithManyItems(item_count);
+    ASSERT_NE(file.size, 0u);
+    DecoderPtr decoder(avifDecoderCreate());
+    ASSERT_NE(decoder, nullptr);
+    ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data, file.size),
+              AVIF_RESULT_OK);
+    ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK)
+        << decoder->diag.error;
+    EXPECT_EQ(decoder->image->width, 64u);
+    EXPECT_EQ(decoder->image->height, 64u);
+    EXPECT_EQ(decoder->image->yuvFormat, AVIF_PIXEL_FORMAT_YUV420);
+    EXPECT_EQ(decoder->imageCount, 1);
+  }
+}
+
+// Microbenchmark of avifDecoderParse() with many items. Disabled by default.
+TEST(ParseManyItemsTest, DISABLED_Benchmark) {
+  for (uint16_t item_count : {100, 1000, 8000}) {
+    testutil::AvifRwData file = CreateFileWithManyItems(item_count);
+    ASSERT_NE(file.size, 0u);
+    DecoderPtr decoder(avifDecoderCreate());
+    ASSERT_NE(decoder, nullptr);
+    ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data, file.size),
+              AVIF_RESULT_OK);
+
+    const int iterations = 1000000 / item_count;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << item_count << " items: " << elapsed.count() / iterations
+              << " us per avifDecoderParse()" << std::endl;
+  }
+}
+
+//------------------------------------------------------------------------------
+
+// Returns an image sequence of frame_count copies of the frame of
+// white_1x1.avif, with a keyframe every 10 frames. No codec is needed.
+testutil::AvifRwData CreateLongSequence(uint32_t frame_count) {
+  testutil::AvifRwData file;
+  const std::vector<uint8_t> still = ReadFile("white_1x1.avif");
+  DecoderPtr decoder(avifDecoderCreate());
+  EncoderPtr encoder(avifEncoderCreate());
+  avifExtent extent;
+  if (decoder == nullptr || encoder == nullptr ||
+      avifDecoderSetIOMemory(decoder.get(), still.data(), still.size()) !=
+          AVIF_RESULT_OK ||
+      avifDecoderParse(decoder.get()) != AVIF_RESULT_OK ||
+      avifDecoderNthImageMaxExtent(decoder.get(), 0, &extent) !=
+          AVIF_RESULT_OK ||
+      extent.offset + extent.size > still.size()) {
+    return file;
+  }
+  const avifROData obus = {still.data() + extent.offset, extent.size};
+  for (uint32_t i = 0; i < frame_count; ++i) {
+    const avifAddImageFlags flags = (i % 10 == 0)
+                                        ? AVIF_ADD_IMAGE_FLAG_FORCE_KEYFRAME
+                                        : AVIF_ADD_IMAGE_FLAG_NONE;
+    if (avifEncoderAddEncodedImage(encoder.get(), decoder->image, &obus,
+                                   nullptr, /*durationInTimescales=*/i + 1,
+                                   flags) != AVIF_RESULT_OK) {
+      return file;
+    }
+  }
+  if (avifEncoderFinish(encoder.get(), &file) != AVIF_RESULT_OK) {
+    avifRWDataFree(&file);
+  }
+  return file;
+}
+
+TEST(ParseLongSequenceTest, Parse) {
+  constexpr uint32_t kFrameCount = 1234;
+  testutil::AvifRwData file = CreateLongSequence(kFrameCount);
+  ASSERT_NE(file.size, 0u);
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data, file.size),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK)
+      << decoder->diag.error;
+  ASSERT_EQ(decoder->imageCount, static_cast<int>(kFrameCount));
+  for (uint32_t i = 0; i < kFrameCount; i += 97) {
+    EXPECT_EQ(avifDecoderIsKeyframe(decoder.get(), i), i % 10 == 0);
+    avifImageTiming timing;
+    ASSERT_EQ(avifDecoderNthImageTiming(decoder.get(), i, &timing),
+              AVIF_RESULT_OK);
+    EXPECT_EQ(timing.durationInTimescales, i + 1u);
+    avifExtent extent;
+    ASSERT_EQ(avifDecoderNthImageMaxExtent(decoder.get(), i, &extent),
+              AVIF_RESULT_OK);
+    EXPECT_LE(extent.offset + extent.size, file.size);
+  }
+
+  // Truncating the sample tables must fail cleanly.
+  for (size_t size = file.size / 2; size < file.size; size += file.size / 7) {
+    DecoderPtr truncated(avifDecoderCreate());
+    ASSERT_NE(truncated, nullptr);
+    ASSERT_EQ(avifDecoderSetIOMemory(truncated.get(), file.data, size),
+              AVIF_RESULT_OK);
+    EXPECT_NE(avifDecoderParse(truncated.get()), AVIF_RESULT_OK);
+  }
+}
+
+// Microbenchmark of avifDecoderParse() with large sample tables. Disabled by
+// default.
+TEST(ParseLongSequenceTest, DISABLED_Benchmark) {
+  for (uint32_t frame_count : {1000, 100000}) {
+    testutil::AvifRwData file = CreateLongSequence(frame_count);
+    ASSERT_NE(file.size, 0u);
+    DecoderPtr decoder(avifDecoderCreate());
+    ASSERT_NE(decoder, nullptr);
+    ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data, file.size),
+              AVIF_RESULT_OK);
+
+    const int iterations = static_cast<int>(10000000 / frame_count);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+    }
+    const std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << frame_count << " frames: " << elapsed.count() / iterations
+              << " us per avifDecoderParse()" << std::endl;
+  }
+}
+
+}  // namespace
+}  // namespace avif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  avif::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -1,6 +1,9 @@
 // Copyright 2023 Google LLC
 // SPDX-License-Identifier: BSD-2-Clause
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <tuple>
 
 #include "avif/internal.h"
@@ -39,6 +42,9 @@ TEST_P(SetGetRGBATest, SetGetTest) {
   } else if (rgb.isFloat) {
     epsilon = 0.0005f;  // Half precision floats are not that precise.
   }
+  // Only 2 bits of alpha in RGBA1010102.
+  const float alpha_epsilon =
+      (rgb_format == AVIF_RGB_FORMAT_RGBA1010102) ? 1.0f / 6 : epsilon;
 
   float pixel_read[4];
   for (uint32_t j = 0; j < rgb.height; ++j) {
@@ -56,7 +62,7 @@ TEST_P(SetGetRGBATest, SetGetTest) {
       EXPECT_NEAR(pixel_read[1], pixel_to_write[1], epsilon);
       EXPECT_NEAR(pixel_read[2], pixel_to_write[2], epsilon);
       if (avifRGBFormatHasAlpha(rgb_format)) {
-        EXPECT_NEAR(pixel_read[3], pixel_to_write[3], epsilon);
+        EXPECT_NEAR(pixel_read[3], pixel_to_write[3], alpha_epsilon);
       } else {
         EXPECT_EQ(pixel_read[3], 1.0f);
       }
@@ -124,6 +130,11 @@ INSTANTIATE_TEST_SUITE_P(Rgb565, SetGetRGBATest,
                                  Values(AVIF_RGB_FORMAT_RGB_565),
                                  /*is_float=*/Values(false)));
 
+INSTANTIATE_TEST_SUITE_P(Rgba1010102, SetGetRGBATest,
+                         Combine(/*rgb_depth=*/Values(10),
+                                 Values(AVIF_RGB_FORMAT_RGBA1010102),
+                                 /*is_float=*/Values(false)));
+
 INSTANTIATE_TEST_SUITE_P(
     Float, SetGetRGBATest,
     Combine(/*rgb_depth=*/Values(16),
@@ -132,5 +143,408 @@ INSTANTIATE_TEST_SUITE_P(
                    AVIF_RGB_FORMAT_BGRA, AVIF_RGB_FORMAT_ABGR),
             /*is_float=*/Values(true)));
 
+//------------------------------------------------------------------------------
+
+class BilinearUpsamplingTest
+    : public testing::TestWithParam<std::tuple<
+          /*yuv_depth=*/int, avifPixelFormat, /*rgb_depth=*/int, avifRGBFormat,
+          /*width=*/int, /*height=*/int>> {};
+
+// Checks that the dedicated bilinear upsampling kernels give the same output as
+// the generic slow path.
+TEST_P(BilinearUpsamplingTest, SameAsSlowPath) {
+  const int yuv_depth = std::get<0>(GetParam());
+  const avifPixelFormat yuv_format = std::get<1>(GetParam());
+  const int rgb_depth = std::get<2>(GetParam());
+  const avifRGBFormat rgb_format = std::get<3>(GetParam());
+  const int width = std::get<4>(GetParam());
+  const int height = std::get<5>(GetParam());
+
+  ImagePtr yuv = testutil::CreateImage(width, height, yuv_depth, yuv_format,
+                                       AVIF_PLANES_ALL, AVIF_RANGE_LIMITED);
+  ASSERT_NE(yuv, nullptr);
+  yuv->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT601;
+  testutil::FillImageGradient(yuv.get());
+  // Opaque alpha, so that premultiplication does not change the color samples.
+  const uint32_t opaque = (1u << yuv_depth) - 1u;
+  for (uint32_t y = 0; y < yuv->height; ++y) {
+    for (uint32_t x = 0; x < yuv->width; ++x) {
+      uint8_t* row = yuv->alphaPlane + y * yuv->alphaRowBytes;
+      if (avifImageUsesU16(yuv.get())) {
+        reinterpret_cast<uint16_t*>(row)[x] = static_cast<uint16_t>(opaque);
+      } else {
+        row[x] = static_cast<uint8_t>(opaque);
+      }
+    }
+  }
+
+  testutil::AvifRgbImage fast(yuv.get(), rgb_depth, rgb_format);
+  testutil::AvifRgbImage slow(yuv.get(), rgb_depth, rgb_format);
+  for (avifRGBImage* rgb : {static_cast<avifRGBImage*>(&fast),
+                            static_cast<avifRGBImage*>(&slow)}) {
+    rgb->chromaUpsampling = AVIF_CHROMA_UPSAMPLING_BILINEAR;
+    rgb->avoidLibYUV = AVIF_TRUE;
+  }
+
+  // No alpha (un)multiply is needed: the fast path is used.
+  yuv->alphaPremultiplied = AVIF_TRUE;
+  ASSERT_EQ(avifImageYUVToRGB(yuv.get(), &fast), AVIF_RESULT_OK);
+  // Premultiplication into a format without alpha can only be done by the slow
+  // path.
+  yuv->alphaPremultiplied = AVIF_FALSE;
+  ASSERT_EQ(avifImageYUVToRGB(yuv.get(), &slow), AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(fast, slow));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, BilinearUpsamplingTest,
+    Combine(/*yuv_depth=*/Values(8, 10, 12),
+            Values(AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV422),
+            /*rgb_depth=*/Values(8, 16),
+            Values(AVIF_RGB_FORMAT_RGB, AVIF_RGB_FORMAT_BGR),
+            /*width=*/Values(1, 12, 13), /*height=*/Values(1, 16, 17)));
+
+INSTANTIATE_TEST_SUITE_P(Rgb565, BilinearUpsamplingTest,
+                         Combine(/*yuv_depth=*/Values(8, 10),
+                                 Values(AVIF_PIXEL_FORMAT_YUV420),
+                                 /*rgb_depth=*/Values(8),
+                                 Values(AVIF_RGB_FORMAT_RGB_565),
+                                 /*width=*/Values(13), /*height=*/Values(17)));
+
+//------------------------------------------------------------------------------
+
+class FusedPostProcessingTest
+    : public testing::TestWithParam<std::tuple<
+          /*yuv_depth=*/int, avifPixelFormat, avifRGBFormat,
+          /*yuv_alpha_premultiplied=*/bool, /*rgb_alpha_premultiplied=*/bool,
+          /*is_float=*/bool>> {};
+
+// Same half float conversion as the one done by libavif without libyuv.
+uint16_t ToHalfFloat(uint16_t value, int depth) {
+  const float multiplier = 1.9259299444e-34f / ((1 << depth) - 1);
+  const float f = value * multiplier;
+  uint32_t u32;
+  std::memcpy(&u32, &f, sizeof(u32));
+  return static_cast<uint16_t>(u32 >> 13);
+}
+
+// Checks that alpha (un)multiply and half float conversion, done row by row
+// by the built-in YUV->RGB routines, give the same output as separate passes
+// over the whole image.
+TEST_P(FusedPostProcessingTest, SameAsSeparatePasses) {
+  const int yuv_depth = std::get<0>(GetParam());
+  const avifPixelFormat yuv_format = std::get<1>(GetParam());
+  const avifRGBFormat rgb_format = std::get<2>(GetParam());
+  const bool yuv_alpha_premultiplied = std::get<3>(GetParam());
+  const bool rgb_alpha_premultiplied = std::get<4>(GetParam());
+  const bool is_float = std::get<5>(GetParam());
+
+  ImagePtr yuv = testutil::CreateImage(/*width=*/13, /*height=*/17, yuv_depth,
+                                       yuv_format, AVIF_PLANES_ALL);
+  ASSERT_NE(yuv, nullptr);
+  testutil::FillImageGradient(yuv.get());
+  yuv->alphaPremultiplied = yuv_alpha_premultiplied;
+
+  testutil::AvifRgbImage fused(yuv.get(), /*rgbDepth=*/16, rgb_format);
+  fused.alphaPremultiplied = rgb_alpha_premultiplied;
+  fused.isFloat = is_float;
+  fused.avoidLibYUV = AVIF_TRUE;
+  ASSERT_EQ(avifImageYUVToRGB(yuv.get(), &fused), AVIF_RESULT_OK);
+
+  // Reference: plain conversion, then each post-processing step on its own.
+  testutil::AvifRgbImage reference(yuv.get(), /*rgbDepth=*/16, rgb_format);
+  reference.alphaPremultiplied = yuv_alpha_premultiplied;
+  reference.avoidLibYUV = AVIF_TRUE;
+  ASSERT_EQ(avifImageYUVToRGB(yuv.get(), &reference), AVIF_RESULT_OK);
+  if (rgb_alpha_premultiplied && !yuv_alpha_premultiplied) {
+    ASSERT_EQ(avifRGBImagePremultiplyAlpha(&reference), AVIF_RESULT_OK);
+  } else if (!rgb_alpha_premultiplied && yuv_alpha_premultiplied) {
+    ASSERT_EQ(avifRGBImageUnpremultiplyAlpha(&reference), AVIF_RESULT_OK);
+  }
+  reference.alphaPremultiplied = rgb_alpha_premultiplied;
+  if (is_float) {
+    const uint32_t channel_count = avifRGBFormatChannelCount(rgb_format);
+    for (uint32_t y = 0; y < reference.height; ++y) {
+      uint16_t* row = reinterpret_cast<uint16_t*>(reference.pixels +
+                                                  y * reference.rowBytes);
+      for (uint32_t x = 0; x < reference.width * channel_count; ++x) {
+        row[x] = ToHalfFloat(row[x], reference.depth);
+      }
+    }
+    reference.isFloat = AVIF_TRUE;
+  }
+  EXPECT_TRUE(testutil::AreImagesEqual(fused, reference));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, FusedPostProcessingTest,
+    Combine(/*yuv_depth=*/Values(8, 10),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV420,
+                   AVIF_PIXEL_FORMAT_YUV400),
+            Values(AVIF_RGB_FORMAT_RGBA, AVIF_RGB_FORMAT_ARGB),
+            /*yuv_alpha_premultiplied=*/testing::Bool(),
+            /*rgb_alpha_premultiplied=*/testing::Bool(),
+            /*is_float=*/testing::Bool()));
+
+//------------------------------------------------------------------------------
+
+class PackedFormatTest
+    : public testing::TestWithParam<std::tuple<
+          /*yuv_depth=*/int, avifPixelFormat, avifChromaUpsampling>> {
+ protected:
+  void SetUp() override {
+    // Taller than a few conversion strips.
+    yuv_ = testutil::CreateImage(/*width=*/37, /*height=*/151,
+                                 std::get<0>(GetParam()),
+                                 std::get<1>(GetParam()), AVIF_PLANES_ALL);
+    ASSERT_NE(yuv_, nullptr);
+    testutil::FillImageGradient(yuv_.get());
+  }
+
+  ImagePtr yuv_;
+};
+
+// Checks that RGBA1010102 is the packed 10-bit RGBA output, in both
+// directions.
+TEST_P(PackedFormatTest, Rgba1010102) {
+  testutil::AvifRgbImage unpacked(yuv_.get(), 10, AVIF_RGB_FORMAT_RGBA);
+  testutil::AvifRgbImage packed(yuv_.get(), 10, AVIF_RGB_FORMAT_RGBA1010102);
+  testutil::AvifRgbImage threaded(yuv_.get(), 10, AVIF_RGB_FORMAT_RGBA1010102);
+  threaded.maxThreads = 3;
+  for (avifRGBImage* rgb : {static_cast<avifRGBImage*>(&unpacked),
+                            static_cast<avifRGBImage*>(&packed),
+                            static_cast<avifRGBImage*>(&threaded)}) {
+    rgb->chromaUpsampling = std::get<2>(GetParam());
+    ASSERT_EQ(avifImageYUVToRGB(yuv_.get(), rgb), AVIF_RESULT_OK);
+  }
+  EXPECT_TRUE(testutil::AreImagesEqual(packed, threaded));
+
+  for (uint32_t y = 0; y < unpacked.height; ++y) {
+    uint16_t* row =
+        reinterpret_cast<uint16_t*>(unpacked.pixels + y * unpacked.rowBytes);
+    for (uint32_t x = 0; x < unpacked.width; ++x) {
+      uint16_t* rgba = row + x * 4;
+      uint32_t pixel;
+      std::memcpy(&pixel, packed.pixels + y * packed.rowBytes + x * 4, 4);
+      const uint32_t alpha2 = (rgba[3] * 3u + 511u) / 1023u;
+      ASSERT_EQ(pixel & 0x3FF, rgba[0]);
+      ASSERT_EQ((pixel >> 10) & 0x3FF, rgba[1]);
+      ASSERT_EQ((pixel >> 20) & 0x3FF, rgba[2]);
+      ASSERT_EQ(pixel >> 30, alpha2);
+      // What is left once packed.
+      rgba[3] = static_cast<uint16_t>(alpha2 * 341);
+    }
+  }
+
+  const uint32_t depth = yuv_->depth;
+  const avifPixelFormat format = yuv_->yuvFormat;
+  ImagePtr from_packed = testutil::CreateImage(
+      yuv_->width, yuv_->height, depth, format, AVIF_PLANES_ALL);
+  ImagePtr from_unpacked = testutil::CreateImage(
+      yuv_->width, yuv_->height, depth, format, AVIF_PLANES_ALL);
+  ASSERT_NE(from_packed, nullptr);
+  ASSERT_NE(from_unpacked, nullptr);
+  ASSERT_EQ(avifImageRGBToYUV(from_packed.get(), &packed), AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageRGBToYUV(from_unpacked.get(), &unpacked), AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(*from_packed, *from_unpacked));
+}
+
+// Checks that each dithered RGB_565 sample is one of the two closest to the
+// 8-bit RGB output, and that dithering keeps the average intensity.
+TEST_P(PackedFormatTest, DitheredRgb565) {
+  testutil::AvifRgbImage rgb(yuv_.get(), 8, AVIF_RGB_FORMAT_RGB);
+  testutil::AvifRgbImage dithered(yuv_.get(), 8, AVIF_RGB_FORMAT_RGB_565);
+  testutil::AvifRgbImage threaded(yuv_.get(), 8, AVIF_RGB_FORMAT_RGB_565);
+  dithered.ditherRGB565 = AVIF_TRUE;
+  threaded.ditherRGB565 = AVIF_TRUE;
+  threaded.maxThreads = 3;
+  for (avifRGBImage* image : {static_cast<avifRGBImage*>(&rgb),
+                              static_cast<avifRGBImage*>(&dithered),
+                              static_cast<avifRGBImage*>(&threaded)}) {
+    image->chromaUpsampling = std::get<2>(GetParam());
+    ASSERT_EQ(avifImageYUVToRGB(yuv_.get(), image), AVIF_RESULT_OK);
+  }
+  EXPECT_TRUE(testutil::AreImagesEqual(dithered, threaded));
+
+  double error_sum[3] = {0, 0, 0};
+  for (uint32_t y = 0; y < rgb.height; ++y) {
+    const uint8_t* row = rgb.pixels + y * rgb.rowBytes;
+    for (uint32_t x = 0; x < rgb.width; ++x) {
+      uint16_t pixel;
+      std::memcpy(&pixel, dithered.pixels + y * dithered.rowBytes + x * 2, 2);
+      const int quantized[3] = {pixel >> 11, (pixel >> 5) & 0x3F, pixel & 0x1F};
+      for (int c = 0; c < 3; ++c) {
+        const int shift = (c == 1) ? 2 : 3;
+        const int max_quantized = 255 >> shift;
+        const int floor = row[x * 3 + c] >> shift;
+        const int ceil = std::min((row[x * 3 + c] + (1 << shift) - 1) >> shift,
+                                  max_quantized);
+        ASSERT_TRUE(quantized[c] == floor || quantized[c] == ceil);
+        error_sum[c] += (quantized[c] << shift) - row[x * 3 + c];
+      }
+    }
+  }
+  for (double sum : error_sum) {
+    // Truncating to 5 bits would give an average error of about -3.5.
+    EXPECT_LT(std::abs(sum / (rgb.width * rgb.height)), 1.0);
+  }
+}
+
+// Checks that RGB_565 input is converted like its 8-bit RGB expansion.
+TEST_P(PackedFormatTest, Rgb565ToYuv) {
+  testutil::AvifRgbImage rgb565(yuv_.get(), 8, AVIF_RGB_FORMAT_RGB_565);
+  ASSERT_EQ(avifImageYUVToRGB(yuv_.get(), &rgb565), AVIF_RESULT_OK);
+  testutil::AvifRgbImage rgb(yuv_.get(), 8, AVIF_RGB_FORMAT_RGB);
+  for (uint32_t y = 0; y < rgb.height; ++y) {
+    uint8_t* row = rgb.pixels + y * rgb.rowBytes;
+    for (uint32_t x = 0; x < rgb.width; ++x) {
+      uint16_t pixel;
+      std::memcpy(&pixel, rgb565.pixels + y * rgb565.rowBytes + x * 2, 2);
+      const int r5 = pixel >> 11, g6 = (pixel >> 5) & 0x3F, b5 = pixel & 0x1F;
+      row[x * 3 + 0] = static_cast<uint8_t>((r5 << 3) | (r5 >> 2));
+      row[x * 3 + 1] = static_cast<uint8_t>((g6 << 2) | (g6 >> 4));
+      row[x * 3 + 2] = static_cast<uint8_t>((b5 << 3) | (b5 >> 2));
+    }
+  }
+
+  const uint32_t depth = yuv_->depth;
+  const avifPixelFormat format = yuv_->yuvFormat;
+  ImagePtr from_rgb565 = testutil::CreateImage(
+      yuv_->width, yuv_->height, depth, format, AVIF_PLANES_YUV);
+  ImagePtr from_rgb = testutil::CreateImage(yuv_->width, yuv_->height, depth,
+                                            format, AVIF_PLANES_YUV);
+  ASSERT_NE(from_rgb565, nullptr);
+  ASSERT_NE(from_rgb, nullptr);
+  ASSERT_EQ(avifImageRGBToYUV(from_rgb565.get(), &rgb565), AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageRGBToYUV(from_rgb.get(), &rgb), AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(*from_rgb565, *from_rgb));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, PackedFormatTest,
+    Combine(/*yuv_depth=*/Values(8, 10),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV420),
+            Values(AVIF_CHROMA_UPSAMPLING_FASTEST,
+                   AVIF_CHROMA_UPSAMPLING_BILINEAR)));
+
+//------------------------------------------------------------------------------
+
+class PlanarTest
+    : public testing::TestWithParam<std::tuple<
+          /*yuv_depth=*/int, avifPixelFormat, avifPlanarSampleType,
+          /*with_alpha=*/bool>> {};
+
+// Checks that the planar output is the deinterleaved output of
+// avifImageYUVToRGB(), whatever the number of threads.
+TEST_P(PlanarTest, SameAsInterleaved) {
+  const int yuv_depth = std::get<0>(GetParam());
+  const avifPixelFormat yuv_format = std::get<1>(GetParam());
+  const avifPlanarSampleType sample_type = std::get<2>(GetParam());
+  const bool with_alpha = std::get<3>(GetParam());
+
+  ImagePtr yuv = testutil::CreateImage(/*width=*/37, /*height=*/151, yuv_depth,
+                                       yuv_format, AVIF_PLANES_ALL);
+  ASSERT_NE(yuv, nullptr);
+  testutil::FillImageGradient(yuv.get());
+
+  int rgb_depth = 16;
+  if (sample_type == AVIF_PLANAR_SAMPLE_UINT8) {
+    rgb_depth = 8;
+  } else if (sample_type == AVIF_PLANAR_SAMPLE_UINT16) {
+    rgb_depth = 10;
+  }
+  const avifRGBFormat format =
+      with_alpha ? AVIF_RGB_FORMAT_RGBA : AVIF_RGB_FORMAT_RGB;
+  testutil::AvifRgbImage interleaved(yuv.get(), rgb_depth, format);
+  ASSERT_EQ(avifImageYUVToRGB(yuv.get(), &interleaved), AVIF_RESULT_OK);
+
+  const float mean[4] = {0.485f, 0.456f, 0.406f, 0.5f};
+  const float std_dev[4] = {0.229f, 0.224f, 0.225f, 0.5f};
+  avifRGBPlanarImage planar[2];
+  for (int i = 0; i < 2; ++i) {
+    avifRGBPlanarImageSetDefaults(&planar[i], yuv.get());
+    planar[i].sampleType = sample_type;
+    planar[i].depth = rgb_depth;
+    planar[i].maxThreads = (i == 0) ? 1 : 3;
+    if (sample_type == AVIF_PLANAR_SAMPLE_FLOAT32) {
+      planar[i].normalize = AVIF_TRUE;
+      std::copy(mean, mean + 4, planar[i].mean);
+      std::copy(std_dev, std_dev + 4, planar[i].std);
+    }
+    ASSERT_EQ(avifRGBPlanarImageAllocatePlanes(&planar[i], with_alpha),
+              AVIF_RESULT_OK);
+    EXPECT_EQ(planar[i].planes[1], planar[i].planes[0] +
+                                       planar[i].rowBytes[0] * yuv->height);
+    ASSERT_EQ(avifImageYUVToRGBPlanar(yuv.get(), &planar[i]), AVIF_RESULT_OK);
+  }
+
+  const uint32_t channel_count = with_alpha ? 4 : 3;
+  const size_t plane_size = planar[0].rowBytes[0] * yuv->height;
+  EXPECT_EQ(std::memcmp(planar[0].planes[0], planar[1].planes[0],
+                        plane_size * channel_count),
+            0);
+  for (uint32_t c = 0; c < channel_count; ++c) {
+    for (uint32_t y = 0; y < yuv->height; ++y) {
+      const uint8_t* row = interleaved.pixels + y * interleaved.rowBytes;
+      const uint8_t* plane_row =
+          planar[0].planes[c] + y * planar[0].rowBytes[c];
+      for (uint32_t x = 0; x < yuv->width; ++x) {
+        const uint32_t index = x * channel_count + c;
+        if (sample_type == AVIF_PLANAR_SAMPLE_UINT8) {
+          ASSERT_EQ(plane_row[x], row[index]);
+        } else if (sample_type == AVIF_PLANAR_SAMPLE_UINT16) {
+          ASSERT_EQ(reinterpret_cast<const uint16_t*>(plane_row)[x],
+                    reinterpret_cast<const uint16_t*>(row)[index]);
+        } else {
+          const float expected =
+              (reinterpret_cast<const uint16_t*>(row)[index] / 65535.0f -
+               mean[c]) /
+              std_dev[c];
+          ASSERT_NEAR(reinterpret_cast<const float*>(plane_row)[x], expected,
+                      1e-5f);
+        }
+      }
+    }
+  }
+  avifRGBPlanarImageFreePlanes(&planar[0]);
+  avifRGBPlanarImageFreePlanes(&planar[1]);
+}
+
+TEST(PlanarTest, InvalidArguments) {
+  ImagePtr yuv = testutil::CreateImage(/*width=*/4, /*height=*/4, /*depth=*/8,
+                                       AVIF_PIXEL_FORMAT_YUV420,
+                                       AVIF_PLANES_YUV);
+  ASSERT_NE(yuv, nullptr);
+  testutil::FillImageGradient(yuv.get());
+  avifRGBPlanarImage planar;
+  avifRGBPlanarImageSetDefaults(&planar, yuv.get());
+  // No planes.
+  EXPECT_EQ(avifImageYUVToRGBPlanar(yuv.get(), &planar),
+            AVIF_RESULT_REFORMAT_FAILED);
+  ASSERT_EQ(avifRGBPlanarImageAllocatePlanes(&planar, AVIF_FALSE),
+            AVIF_RESULT_OK);
+  EXPECT_EQ(avifImageYUVToRGBPlanar(yuv.get(), &planar), AVIF_RESULT_OK);
+  // Normalization of integer samples.
+  planar.normalize = AVIF_TRUE;
+  EXPECT_EQ(avifImageYUVToRGBPlanar(yuv.get(), &planar),
+            AVIF_RESULT_INVALID_ARGUMENT);
+  avifRGBPlanarImageFreePlanes(&planar);
+  planar.sampleType = AVIF_PLANAR_SAMPLE_FLOAT32;
+  ASSERT_EQ(avifRGBPlanarImageAllocatePlanes(&planar, AVIF_FALSE),
+            AVIF_RESULT_OK);
+  planar.std[1] = 0.0f;
+  EXPECT_EQ(avifImageYUVToRGBPlanar(yuv.get(), &planar),
+            AVIF_RESULT_INVALID_ARGUMENT);
+  avifRGBPlanarImageFreePlanes(&planar);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, PlanarTest,
+    Combine(/*yuv_depth=*/Values(8, 10),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV420),
+            Values(AVIF_PLANAR_SAMPLE_UINT8, AVIF_PLANAR_SAMPLE_UINT16,
+                   AVIF_PLANAR_SAMPLE_FLOAT32),
+            /*with_alpha=*/testing::Bool()));
+
 }  // namespace
 }  // namespace avif
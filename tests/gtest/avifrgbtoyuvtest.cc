@@ -2,8 +2,12 @@
 // SPDX-License-Identifier: BSD-2-Clause
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <iostream>
 #include <memory>
+#include <string>
 #include <tuple>
 
 #include "avif/internal.h"
@@ -403,6 +407,359 @@ TEST(RGBToYUVTest, AllMatrixCoefficients) {
   }
 }
 
+//------------------------------------------------------------------------------
+// Identity and YCgCo fast paths
+
+// Checks that the dedicated AVIF_MATRIX_COEFFICIENTS_IDENTITY and YCgCo
+// conversion routines give the same output as the generic slow paths, in both
+// directions. The slow paths are forced by asking for alpha premultiplication
+// of an opaque image, which does not change the color samples.
+TEST(RGBToYUVTest, IdentityAndYCgCoFastPathsSameAsSlowPaths) {
+  constexpr uint32_t kWidth = 67, kHeight = 61;
+  for (decltype(AVIF_MATRIX_COEFFICIENTS_IDENTITY) matrix_coefficients : {
+           AVIF_MATRIX_COEFFICIENTS_IDENTITY, AVIF_MATRIX_COEFFICIENTS_YCGCO,
+#if defined(AVIF_ENABLE_EXPERIMENTAL_YCGCO_R)
+           AVIF_MATRIX_COEFFICIENTS_YCGCO_RE,
+#endif
+       }) {
+    for (int yuv_depth : {8, 10, 12, 16}) {
+      for (int rgb_depth : {8, 10, 12, 16}) {
+#if defined(AVIF_ENABLE_EXPERIMENTAL_YCGCO_R)
+        if (matrix_coefficients == AVIF_MATRIX_COEFFICIENTS_YCGCO_RE &&
+            rgb_depth != yuv_depth - 2) {
+          continue;  // See avifPrepareReformatState().
+        }
+#endif
+        for (avifPixelFormat yuv_format :
+             {AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV422,
+              AVIF_PIXEL_FORMAT_YUV420}) {
+          if (matrix_coefficients == AVIF_MATRIX_COEFFICIENTS_IDENTITY &&
+              yuv_format != AVIF_PIXEL_FORMAT_YUV444) {
+            continue;
+          }
+          for (avifRange yuv_range : {AVIF_RANGE_LIMITED, AVIF_RANGE_FULL}) {
+            if (matrix_coefficients != AVIF_MATRIX_COEFFICIENTS_IDENTITY &&
+                yuv_range == AVIF_RANGE_LIMITED) {
+              continue;  // See avifGetYUVColorSpaceInfo().
+            }
+            SCOPED_TRACE("matrix " + std::to_string(matrix_coefficients) +
+                         " yuv_depth " + std::to_string(yuv_depth) +
+                         " rgb_depth " + std::to_string(rgb_depth) +
+                         " yuv_format " + std::to_string(yuv_format) +
+                         " yuv_range " + std::to_string(yuv_range));
+
+            ImagePtr fast_yuv(
+                avifImageCreate(kWidth, kHeight, yuv_depth, yuv_format));
+            ImagePtr slow_yuv(
+                avifImageCreate(kWidth, kHeight, yuv_depth, yuv_format));
+            ASSERT_NE(fast_yuv, nullptr);
+            ASSERT_NE(slow_yuv, nullptr);
+            for (avifImage* image : {fast_yuv.get(), slow_yuv.get()}) {
+              image->matrixCoefficients =
+                  static_cast<avifMatrixCoefficients>(matrix_coefficients);
+              image->yuvRange = yuv_range;
+            }
+
+            // Opaque RGBA input spanning the whole range of sample values.
+            testutil::AvifRgbImage rgba(fast_yuv.get(), rgb_depth,
+                                        AVIF_RGB_FORMAT_RGBA);
+            rgba.avoidLibYUV = AVIF_TRUE;
+            testutil::FillRgbPattern(&rgba);
+
+            // RGB to YUV.
+            fast_yuv->alphaPremultiplied = AVIF_FALSE;
+            ASSERT_EQ(avifImageRGBToYUV(fast_yuv.get(), &rgba), AVIF_RESULT_OK);
+            slow_yuv->alphaPremultiplied = AVIF_TRUE;
+            ASSERT_EQ(avifImageRGBToYUV(slow_yuv.get(), &rgba), AVIF_RESULT_OK);
+            slow_yuv->alphaPremultiplied = AVIF_FALSE;
+            EXPECT_TRUE(testutil::AreImagesEqual(*fast_yuv, *slow_yuv));
+
+            // YUV to RGB, also as RGB565 when possible.
+            for (avifRGBFormat rgb_format :
+                 {AVIF_RGB_FORMAT_RGB, AVIF_RGB_FORMAT_RGB_565}) {
+              if (rgb_format == AVIF_RGB_FORMAT_RGB_565 && rgb_depth != 8) {
+                continue;
+              }
+              testutil::AvifRgbImage fast_rgb(fast_yuv.get(), rgb_depth,
+                                              rgb_format);
+              testutil::AvifRgbImage slow_rgb(fast_yuv.get(), rgb_depth,
+                                              rgb_format);
+              for (avifRGBImage* rgb :
+                   {static_cast<avifRGBImage*>(&fast_rgb),
+                    static_cast<avifRGBImage*>(&slow_rgb)}) {
+                rgb->chromaUpsampling = AVIF_CHROMA_UPSAMPLING_NEAREST;
+                rgb->avoidLibYUV = AVIF_TRUE;
+              }
+              fast_yuv->alphaPremultiplied = AVIF_TRUE;
+              ASSERT_EQ(avifImageYUVToRGB(fast_yuv.get(), &fast_rgb),
+                        AVIF_RESULT_OK);
+              fast_yuv->alphaPremultiplied = AVIF_FALSE;
+              ASSERT_EQ(avifImageYUVToRGB(fast_yuv.get(), &slow_rgb),
+                        AVIF_RESULT_OK);
+              EXPECT_TRUE(testutil::AreImagesEqual(fast_rgb, slow_rgb));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Fixed-point conversion
+
+class FixedPointRGBToYUVTest
+    : public testing::TestWithParam<
+          std::tuple</*rgb_depth=*/int, /*yuv_depth=*/int, avifPixelFormat,
+                     avifRange, avifMatrixCoefficients>> {};
+
+// AVIF_CHROMA_DOWNSAMPLING_FASTEST uses fixed-point arithmetic, which must be
+// within 1 of the float implementation of AVIF_CHROMA_DOWNSAMPLING_AVERAGE.
+TEST_P(FixedPointRGBToYUVTest, SameAsFloatWithinOne) {
+  const int rgb_depth = std::get<0>(GetParam());
+  const int yuv_depth = std::get<1>(GetParam());
+  const avifPixelFormat yuv_format = std::get<2>(GetParam());
+  const avifRange yuv_range = std::get<3>(GetParam());
+  const avifMatrixCoefficients matrix_coefficients = std::get<4>(GetParam());
+
+  // Wider than one tile, odd dimensions.
+  ImagePtr fixed_point(avifImageCreate(301, 41, yuv_depth, yuv_format));
+  ImagePtr reference(avifImageCreate(301, 41, yuv_depth, yuv_format));
+  ASSERT_NE(fixed_point, nullptr);
+  ASSERT_NE(reference, nullptr);
+  for (avifImage* image : {fixed_point.get(), reference.get()}) {
+    image->yuvRange = yuv_range;
+    image->matrixCoefficients = matrix_coefficients;
+  }
+
+  testutil::AvifRgbImage rgb(fixed_point.get(), rgb_depth,
+                             AVIF_RGB_FORMAT_RGB);
+  rgb.avoidLibYUV = AVIF_TRUE;
+  testutil::FillRgbPattern(&rgb);
+  rgb.chromaDownsampling = AVIF_CHROMA_DOWNSAMPLING_FASTEST;
+  ASSERT_EQ(avifImageRGBToYUV(fixed_point.get(), &rgb), AVIF_RESULT_OK);
+  rgb.chromaDownsampling = AVIF_CHROMA_DOWNSAMPLING_AVERAGE;
+  ASSERT_EQ(avifImageRGBToYUV(reference.get(), &rgb), AVIF_RESULT_OK);
+
+  const int num_planes = (yuv_format == AVIF_PIXEL_FORMAT_YUV400) ? 1 : 3;
+  uint32_t num_samples = 0, num_diffs = 0;
+  for (int c = 0; c < num_planes; ++c) {
+    const uint32_t plane_width = avifImagePlaneWidth(reference.get(), c);
+    const uint32_t plane_height = avifImagePlaneHeight(reference.get(), c);
+    const uint32_t row_bytes = avifImagePlaneRowBytes(reference.get(), c);
+    for (uint32_t y = 0; y < plane_height; ++y) {
+      const uint8_t* row1 =
+          avifImagePlane(fixed_point.get(), c) + y * row_bytes;
+      const uint8_t* row2 =
+          avifImagePlane(reference.get(), c) + y * row_bytes;
+      for (uint32_t x = 0; x < plane_width; ++x) {
+        const int v1 = (yuv_depth > 8)
+                           ? reinterpret_cast<const uint16_t*>(row1)[x]
+                           : row1[x];
+        const int v2 = (yuv_depth > 8)
+                           ? reinterpret_cast<const uint16_t*>(row2)[x]
+                           : row2[x];
+        ASSERT_LE(std::abs(v1 - v2), 1)
+            << "channel " << c << " x " << x << " y " << y;
+        ++num_samples;
+        num_diffs += (v1 != v2) ? 1 : 0;
+      }
+    }
+  }
+  // Differences only come from values close to a rounding boundary.
+  EXPECT_LT(num_diffs, num_samples / 10);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, FixedPointRGBToYUVTest,
+    Combine(/*rgb_depth=*/Values(8, 10, 12),
+            /*yuv_depth=*/Values(8, 10, 12),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV422,
+                   AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV400),
+            Values(AVIF_RANGE_LIMITED, AVIF_RANGE_FULL),
+            Values(AVIF_MATRIX_COEFFICIENTS_BT601,
+                   AVIF_MATRIX_COEFFICIENTS_BT709,
+                   AVIF_MATRIX_COEFFICIENTS_BT2020_NCL)));
+
+// Timing of the fixed-point conversion compared to the float one on a very
+// wide image. Disabled by default. Run it manually with
+// --gtest_also_run_disabled_tests on an optimized build.
+TEST(FixedPointRGBToYUVTest, DISABLED_Benchmark) {
+  for (int depth : {8, 10}) {
+    ImagePtr image(
+        avifImageCreate(16384, 512, depth, AVIF_PIXEL_FORMAT_YUV420));
+    ASSERT_NE(image, nullptr);
+    image->matrixCoefficients = AVIF_MATRIX_COEFFICIENTS_BT709;
+    testutil::AvifRgbImage rgb(image.get(), depth, AVIF_RGB_FORMAT_RGBA);
+    rgb.avoidLibYUV = AVIF_TRUE;
+    testutil::FillRgbPattern(&rgb);
+    for (avifChromaDownsampling chroma_downsampling :
+         {AVIF_CHROMA_DOWNSAMPLING_AVERAGE, AVIF_CHROMA_DOWNSAMPLING_FASTEST}) {
+      rgb.chromaDownsampling = chroma_downsampling;
+      const auto start = std::chrono::steady_clock::now();
+      ASSERT_EQ(avifImageRGBToYUV(image.get(), &rgb), AVIF_RESULT_OK);
+      const std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << "depth " << depth << ", "
+                << (chroma_downsampling == AVIF_CHROMA_DOWNSAMPLING_FASTEST
+                        ? "fixed point"
+                        : "float")
+                << ": " << elapsed.count() << " ms" << std::endl;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Float input
+
+// IEEE 754 half float to float, for finite values.
+float HalfToFloat(uint16_t h) {
+  const int exponent = (h >> 10) & 31;
+  const int mantissa = h & 1023;
+  const float v = (exponent == 0)
+                      ? std::ldexp(static_cast<float>(mantissa), -24)
+                      : std::ldexp(static_cast<float>(mantissa + 1024),
+                                   exponent - 25);
+  return (h & 0x8000) ? -v : v;
+}
+
+// Same rounding as the float input of avifImageRGBToYUV().
+uint16_t FloatToUnorm16(float v) {
+  v = (v > 0.0f) ? std::min(v, 1.0f) : 0.0f;
+  return static_cast<uint16_t>(v * 65535.0f + 0.5f);
+}
+
+float* FloatRow(avifRGBImage* rgb, uint32_t y) {
+  return reinterpret_cast<float*>(rgb->pixels + y * rgb->rowBytes);
+}
+uint16_t* Uint16Row(avifRGBImage* rgb, uint32_t y) {
+  return reinterpret_cast<uint16_t*>(rgb->pixels + y * rgb->rowBytes);
+}
+
+class FloatRGBToYUVTest
+    : public testing::TestWithParam<
+          std::tuple</*yuv_depth=*/int, avifPixelFormat, avifRGBFormat,
+                     /*avoid_libyuv=*/bool>> {};
+
+// Half float and float input must give the same result as the equivalent
+// 16-bit integer input, including for out-of-range values.
+TEST_P(FloatRGBToYUVTest, SameAsUint16) {
+  const int yuv_depth = std::get<0>(GetParam());
+  const avifPixelFormat yuv_format = std::get<1>(GetParam());
+  const avifRGBFormat rgb_format = std::get<2>(GetParam());
+  const bool avoid_libyuv = std::get<3>(GetParam());
+  constexpr uint32_t kWidth = 67, kHeight = 43;
+
+  for (int float_depth : {16, 32}) {
+    ImagePtr expected(avifImageCreate(kWidth, kHeight, yuv_depth, yuv_format));
+    ImagePtr image(avifImageCreate(kWidth, kHeight, yuv_depth, yuv_format));
+    ASSERT_NE(expected, nullptr);
+    ASSERT_NE(image, nullptr);
+    testutil::AvifRgbImage reference(expected.get(), 16, rgb_format);
+    testutil::AvifRgbImage rgb(image.get(), float_depth, rgb_format);
+    rgb.isFloat = AVIF_TRUE;
+    for (avifRGBImage* r : {static_cast<avifRGBImage*>(&reference),
+                            static_cast<avifRGBImage*>(&rgb)}) {
+      r->avoidLibYUV = avoid_libyuv;
+      r->maxThreads = 3;
+    }
+
+    const uint32_t num_samples =
+        kWidth * avifRGBFormatChannelCount(rgb_format);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t i = 0; i < num_samples; ++i) {
+        const uint32_t seed = (y * num_samples + i) * 7919;
+        float v;
+        if (float_depth == 16) {
+          uint16_t h = static_cast<uint16_t>(seed);
+          if (((h >> 10) & 31) == 31) h &= ~0x4000;  // No inf or NaN.
+          Uint16Row(&rgb, y)[i] = h;
+          v = HalfToFloat(h);
+        } else {
+          v = static_cast<float>(seed % 1200) / 1000.0f - 0.1f;
+          if (seed % 97 == 0) v = NAN;
+          if (seed % 89 == 0) v = INFINITY;
+          FloatRow(&rgb, y)[i] = v;
+          if (std::isnan(v)) v = 0.0f;
+        }
+        Uint16Row(&reference, y)[i] = FloatToUnorm16(v);
+      }
+    }
+
+    ASSERT_EQ(avifImageRGBToYUV(expected.get(), &reference), AVIF_RESULT_OK);
+    ASSERT_EQ(avifImageRGBToYUV(image.get(), &rgb), AVIF_RESULT_OK);
+    EXPECT_TRUE(testutil::AreImagesEqual(*image, *expected))
+        << "float depth " << float_depth;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    All, FloatRGBToYUVTest,
+    Combine(/*yuv_depth=*/Values(8, 10, 12),
+            Values(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_YUV420,
+                   AVIF_PIXEL_FORMAT_YUV400),
+            Values(AVIF_RGB_FORMAT_RGB, AVIF_RGB_FORMAT_RGBA,
+                   AVIF_RGB_FORMAT_ARGB),
+            /*avoid_libyuv=*/Bool()));
+
+// Linear input is encoded with the transfer function of the image, except for
+// alpha.
+TEST(FloatRGBToYUVTest, LinearSameAsEncoded) {
+  constexpr uint32_t kWidth = 64, kHeight = 30;
+  for (avifTransferCharacteristics tc :
+       {AVIF_TRANSFER_CHARACTERISTICS_SMPTE2084,
+        AVIF_TRANSFER_CHARACTERISTICS_HLG,
+        AVIF_TRANSFER_CHARACTERISTICS_SRGB}) {
+    const avifTransferFunction to_gamma =
+        avifTransferCharacteristicsGetLinearToGammaFunction(tc);
+    ImagePtr expected(
+        avifImageCreate(kWidth, kHeight, 10, AVIF_PIXEL_FORMAT_YUV420));
+    ImagePtr image(
+        avifImageCreate(kWidth, kHeight, 10, AVIF_PIXEL_FORMAT_YUV420));
+    ASSERT_NE(expected, nullptr);
+    ASSERT_NE(image, nullptr);
+    expected->transferCharacteristics = tc;
+    image->transferCharacteristics = tc;
+    testutil::AvifRgbImage encoded(expected.get(), 32, AVIF_RGB_FORMAT_RGBA);
+    testutil::AvifRgbImage linear(image.get(), 32, AVIF_RGB_FORMAT_RGBA);
+    encoded.isFloat = AVIF_TRUE;
+    linear.isFloat = AVIF_TRUE;
+    linear.isLinear = AVIF_TRUE;
+    linear.maxThreads = 2;
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t i = 0; i < kWidth * 4; ++i) {
+        // Up to 50 times SDR white, beyond the range of PQ.
+        const float v = static_cast<float>((y * kWidth * 4 + i) * 31 % 5000) /
+                        100.0f;
+        const bool is_alpha = (i % 4) == 3;
+        FloatRow(&linear, y)[i] = is_alpha ? v / 50.0f : v;
+        FloatRow(&encoded, y)[i] = is_alpha ? v / 50.0f : to_gamma(v);
+      }
+    }
+    ASSERT_EQ(avifImageRGBToYUV(expected.get(), &encoded), AVIF_RESULT_OK);
+    ASSERT_EQ(avifImageRGBToYUV(image.get(), &linear), AVIF_RESULT_OK);
+    EXPECT_TRUE(testutil::AreImagesEqual(*image, *expected)) << "tc " << tc;
+  }
+}
+
+TEST(FloatRGBToYUVTest, InvalidLayouts) {
+  ImagePtr image(avifImageCreate(8, 8, 10, AVIF_PIXEL_FORMAT_YUV444));
+  ASSERT_NE(image, nullptr);
+  {
+    testutil::AvifRgbImage rgb(image.get(), 12, AVIF_RGB_FORMAT_RGB);
+    rgb.isFloat = AVIF_TRUE;
+    EXPECT_EQ(avifImageRGBToYUV(image.get(), &rgb),
+              AVIF_RESULT_REFORMAT_FAILED);
+  }
+  {
+    // Float32 output is not supported.
+    testutil::AvifRgbImage rgb(image.get(), 32, AVIF_RGB_FORMAT_RGB);
+    rgb.isFloat = AVIF_TRUE;
+    EXPECT_EQ(avifImageYUVToRGB(image.get(), &rgb),
+              AVIF_RESULT_REFORMAT_FAILED);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Selected configurations
 
@@ -753,7 +1110,8 @@ TEST_P(YUVToRGBThreadingTest, TestIdentical) {
   const avifChromaUpsampling chromaUpsampling = std::get<8>(GetParam());
   const bool has_alpha = std::get<9>(GetParam());
 
-  if (rgb_depth > 8 && rgb_format == AVIF_RGB_FORMAT_RGB_565) {
+  if ((rgb_depth > 8 && rgb_format == AVIF_RGB_FORMAT_RGB_565) ||
+      (rgb_depth != 10 && rgb_format == AVIF_RGB_FORMAT_RGBA1010102)) {
     return;
   }
 
@@ -835,5 +1193,54 @@ INSTANTIATE_TEST_SUITE_P(
                    AVIF_CHROMA_UPSAMPLING_BILINEAR),
             /*has_alpha=*/Bool()));
 
+class RGBToYUVThreadingTest
+    : public testing::TestWithParam<std::tuple<
+          /*rgb_depth=*/int, /*yuv_depth=*/int,
+          /*width=*/int, /*height=*/int, avifRGBFormat, avifPixelFormat,
+          /*threads=*/int, /*avoidLibYUV=*/bool, avifChromaDownsampling>> {};
+
+TEST_P(RGBToYUVThreadingTest, TestIdentical) {
+  const int rgb_depth = std::get<0>(GetParam());
+  const int yuv_depth = std::get<1>(GetParam());
+  const int width = std::get<2>(GetParam());
+  const int height = std::get<3>(GetParam());
+  const avifRGBFormat rgb_format = std::get<4>(GetParam());
+  const avifPixelFormat yuv_format = std::get<5>(GetParam());
+  const int maxThreads = std::get<6>(GetParam());
+  const bool avoidLibYUV = std::get<7>(GetParam());
+  const avifChromaDownsampling chromaDownsampling = std::get<8>(GetParam());
+
+  ImagePtr yuv(avifImageCreate(width, height, yuv_depth, yuv_format));
+  ImagePtr yuv_threaded(avifImageCreate(width, height, yuv_depth, yuv_format));
+  ASSERT_NE(yuv, nullptr);
+  ASSERT_NE(yuv_threaded, nullptr);
+  testutil::AvifRgbImage rgb(yuv.get(), rgb_depth, rgb_format);
+  rgb.avoidLibYUV = avoidLibYUV;
+  rgb.chromaDownsampling = chromaDownsampling;
+  testutil::FillRgbPattern(&rgb);
+
+  // Convert to YUV with 1 thread.
+  ASSERT_EQ(avifImageRGBToYUV(yuv.get(), &rgb), AVIF_RESULT_OK);
+
+  // Convert to YUV with multiple threads.
+  rgb.maxThreads = maxThreads;
+  ASSERT_EQ(avifImageRGBToYUV(yuv_threaded.get(), &rgb), AVIF_RESULT_OK);
+
+  EXPECT_TRUE(testutil::AreImagesEqual(*yuv, *yuv_threaded));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    RGBToYUVThreadingTestInstance, RGBToYUVThreadingTest,
+    Combine(/*rgb_depth=*/Values(8, 16),
+            /*yuv_depth=*/Values(8, 10),
+            /*width=*/Values(1, 127),
+            /*height=*/Values(1, 2, 127, 200),
+            Values(AVIF_RGB_FORMAT_RGB, AVIF_RGB_FORMAT_RGBA),
+            Range(AVIF_PIXEL_FORMAT_YUV444, AVIF_PIXEL_FORMAT_COUNT),
+            /*threads=*/Values(2, 7),
+            /*avoidLibYUV=*/Bool(),
+            Values(AVIF_CHROMA_DOWNSAMPLING_AVERAGE,
+                   AVIF_CHROMA_DOWNSAMPLING_FASTEST)));
+
 }  // namespace
 }  // namespace avif
@@ -1,7 +1,9 @@
 // Copyright 2023 Google LLC
 // SPDX-License-Identifier: BSD-2-Clause
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <limits>
 
 #include "avif/avif.h"
@@ -78,6 +80,309 @@ INSTANTIATE_TEST_SUITE_P(
                    AVIF_PIXEL_FORMAT_YUV420, AVIF_PIXEL_FORMAT_YUV400),
             /*create_alpha=*/Values(true, false)));
 
+class ScaleFilterTest
+    : public testing::TestWithParam<
+          std::tuple</*bit_depth=*/int, avifScaleFilter, /*max_threads=*/int>> {
+};
+
+TEST_P(ScaleFilterTest, Roundtrip) {
+  const int bit_depth = std::get<0>(GetParam());
+  const avifScaleFilter filter = std::get<1>(GetParam());
+  const int max_threads = std::get<2>(GetParam());
+
+  const ImagePtr image =
+      testutil::ReadImage(data_path, "paris_exif_xmp_icc.jpg",
+                          AVIF_PIXEL_FORMAT_YUV420, bit_depth,
+                          AVIF_CHROMA_DOWNSAMPLING_BEST_QUALITY,
+                          kIgnoreMetadata, kIgnoreMetadata, kIgnoreMetadata);
+  ASSERT_NE(image, nullptr);
+
+  ImagePtr scaled_image(avifImageCreateEmpty());
+  ASSERT_NE(scaled_image, nullptr);
+  ASSERT_EQ(avifImageCopy(scaled_image.get(), image.get(), AVIF_PLANES_ALL),
+            AVIF_RESULT_OK);
+  const uint32_t scaled_width = static_cast<uint32_t>(image->width * 0.6);
+  const uint32_t scaled_height = static_cast<uint32_t>(image->height * 1.7);
+  avifDiagnostics diag;
+  ASSERT_EQ(avifImageScaleWithFilter(scaled_image.get(), scaled_width,
+                                     scaled_height, filter, max_threads, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  EXPECT_EQ(scaled_image->width, scaled_width);
+  EXPECT_EQ(scaled_image->height, scaled_height);
+
+  // The number of threads does not change the output.
+  ImagePtr single_thread_image(avifImageCreateEmpty());
+  ASSERT_NE(single_thread_image, nullptr);
+  ASSERT_EQ(
+      avifImageCopy(single_thread_image.get(), image.get(), AVIF_PLANES_ALL),
+      AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageScaleWithFilter(single_thread_image.get(), scaled_width,
+                                     scaled_height, filter,
+                                     /*maxThreads=*/1, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  EXPECT_TRUE(testutil::AreImagesEqual(*scaled_image, *single_thread_image));
+
+  ASSERT_EQ(avifImageScaleWithFilter(scaled_image.get(), image->width,
+                                     image->height, filter, max_threads, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  const double psnr = testutil::GetPsnr(*image, *scaled_image);
+  EXPECT_GT(psnr, (filter == AVIF_SCALE_FILTER_NEAREST) ? 20.0 : 30.0);
+  EXPECT_LT(psnr, 45.0);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Filters, ScaleFilterTest,
+    Combine(/*bit_depth=*/Values(8, 10),
+            Values(AVIF_SCALE_FILTER_NEAREST, AVIF_SCALE_FILTER_BILINEAR,
+                   AVIF_SCALE_FILTER_BOX, AVIF_SCALE_FILTER_LANCZOS),
+            /*max_threads=*/Values(1, 4)));
+
+TEST(ScaleTest, BuiltInResampler) {
+  for (int bit_depth : {8, 12}) {
+    // Plain planes stay plain, whatever the scaling factor.
+    ImagePtr image =
+        testutil::CreateImage(/*width=*/37, /*height=*/23, bit_depth,
+                              AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_ALL);
+    ASSERT_NE(image, nullptr);
+    const uint32_t yuva[] = {1u, (1u << bit_depth) - 1, 1u << (bit_depth - 1),
+                             (1u << bit_depth) - 2};
+    testutil::FillImagePlain(image.get(), yuva);
+    avifDiagnostics diag;
+    ASSERT_EQ(avifImageScaleWithFilter(image.get(), 101, 7,
+                                       AVIF_SCALE_FILTER_LANCZOS,
+                                       /*maxThreads=*/3, &diag),
+              AVIF_RESULT_OK)
+        << diag.error;
+    ImagePtr expected =
+        testutil::CreateImage(/*width=*/101, /*height=*/7, bit_depth,
+                              AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_ALL);
+    ASSERT_NE(expected, nullptr);
+    testutil::FillImagePlain(expected.get(), yuva);
+    EXPECT_TRUE(testutil::AreImagesEqual(*image, *expected));
+  }
+}
+
+TEST(ScaleTest, LargerThanLibYuvLimits) {
+  // libyuv cannot scale planes wider than 16384 samples. The built-in
+  // resampler is used instead.
+  ImagePtr image =
+      testutil::CreateImage(/*width=*/20000, /*height=*/4, /*depth=*/8,
+                            AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_YUV);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  avifDiagnostics diag;
+  ASSERT_EQ(avifImageScale(image.get(), 200, 2, &diag), AVIF_RESULT_OK)
+      << diag.error;
+  EXPECT_EQ(image->width, 200u);
+  EXPECT_EQ(image->height, 2u);
+}
+
+// Fills the planes of an 8-bit image with uneven stripes, for which the box
+// and bilinear filters differ when downscaling.
+void FillImageStripes(avifImage* image) {
+  for (int channel = AVIF_CHAN_Y; channel <= AVIF_CHAN_A; ++channel) {
+    uint8_t* plane = avifImagePlane(image, channel);
+    if (plane == nullptr) continue;
+    for (uint32_t y = 0; y < avifImagePlaneHeight(image, channel); ++y) {
+      uint8_t* row = plane + y * avifImagePlaneRowBytes(image, channel);
+      for (uint32_t x = 0; x < avifImagePlaneWidth(image, channel); ++x) {
+        row[x] = ((x + y) % 7 < 2) ? 255 : 0;
+      }
+    }
+  }
+}
+
+TEST(ScaleTest, AutomaticIsBoxInBuiltInResampler) {
+  // Planes wider than 16384 samples are scaled by the built-in resampler.
+  ImagePtr automatic =
+      testutil::CreateImage(/*width=*/20000, /*height=*/4, /*depth=*/8,
+                            AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_ALL);
+  ASSERT_NE(automatic, nullptr);
+  FillImageStripes(automatic.get());
+  ImagePtr box(avifImageCreateEmpty());
+  ASSERT_NE(box, nullptr);
+  ASSERT_EQ(avifImageCopy(box.get(), automatic.get(), AVIF_PLANES_ALL),
+            AVIF_RESULT_OK);
+  avifDiagnostics diag;
+  ASSERT_EQ(avifImageScaleWithFilter(automatic.get(), 200, 2,
+                                     AVIF_SCALE_FILTER_AUTOMATIC,
+                                     /*maxThreads=*/1, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  ASSERT_EQ(avifImageScaleWithFilter(box.get(), 200, 2, AVIF_SCALE_FILTER_BOX,
+                                     /*maxThreads=*/1, &diag),
+            AVIF_RESULT_OK)
+      << diag.error;
+  EXPECT_TRUE(testutil::AreImagesEqual(*automatic, *box));
+
+  // avifImageYUVToRGBScaled() always uses the built-in resampler.
+  ImagePtr image =
+      testutil::CreateImage(/*width=*/300, /*height=*/200, /*depth=*/8,
+                            AVIF_PIXEL_FORMAT_YUV420, AVIF_PLANES_ALL);
+  ASSERT_NE(image, nullptr);
+  FillImageStripes(image.get());
+  testutil::AvifRgbImage rgb_automatic(image.get(), 8, AVIF_RGB_FORMAT_RGBA);
+  testutil::AvifRgbImage rgb_box(image.get(), 8, AVIF_RGB_FORMAT_RGBA);
+  for (avifRGBImage* rgb : {&rgb_automatic, &rgb_box}) {
+    avifRGBImageFreePixels(rgb);
+    rgb->width = 70;
+    rgb->height = 30;
+    ASSERT_EQ(avifRGBImageAllocatePixels(rgb), AVIF_RESULT_OK);
+  }
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &rgb_automatic,
+                                    AVIF_SCALE_FILTER_AUTOMATIC),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(
+      avifImageYUVToRGBScaled(image.get(), &rgb_box, AVIF_SCALE_FILTER_BOX),
+      AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(rgb_automatic, rgb_box));
+}
+
+//------------------------------------------------------------------------------
+
+class YUVToRGBScaledTest
+    : public testing::TestWithParam<
+          std::tuple</*bit_depth=*/int, avifScaleFilter, /*alpha=*/bool>> {};
+
+// With 4:4:4 input, scaling while converting is the same as scaling the YUV
+// planes with the built-in resampler then converting.
+TEST_P(YUVToRGBScaledTest, SameAsScaleThenConvert444) {
+  const int bit_depth = std::get<0>(GetParam());
+  const avifScaleFilter filter = std::get<1>(GetParam());
+  const bool create_alpha = std::get<2>(GetParam());
+
+  ImagePtr image = testutil::ReadImage(
+      data_path, "paris_exif_xmp_icc.jpg", AVIF_PIXEL_FORMAT_YUV444, bit_depth,
+      AVIF_CHROMA_DOWNSAMPLING_BEST_QUALITY, kIgnoreMetadata, kIgnoreMetadata,
+      kIgnoreMetadata);
+  ASSERT_NE(image, nullptr);
+  if (create_alpha) {
+    ASSERT_EQ(avifImageAllocatePlanes(image.get(), AVIF_PLANES_A),
+              AVIF_RESULT_OK);
+    for (uint32_t y = 0; y < image->height; ++y) {
+      std::copy(image->yuvPlanes[AVIF_CHAN_U] +
+                    y * image->yuvRowBytes[AVIF_CHAN_U],
+                image->yuvPlanes[AVIF_CHAN_U] +
+                    (y + 1) * image->yuvRowBytes[AVIF_CHAN_U],
+                image->alphaPlane + y * image->alphaRowBytes);
+    }
+  }
+  const uint32_t width = image->width * 2 / 5;
+  const uint32_t height = image->height * 3 / 2;
+
+  testutil::AvifRgbImage rgb(image.get(), bit_depth, AVIF_RGB_FORMAT_RGBA);
+  avifRGBImageFreePixels(&rgb);
+  rgb.width = width;
+  rgb.height = height;
+  ASSERT_EQ(avifRGBImageAllocatePixels(&rgb), AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &rgb, filter),
+            AVIF_RESULT_OK);
+
+  avifDiagnostics diag;
+  // Lanczos always uses the built-in resampler.
+  ASSERT_EQ(avifImageScaleWithFilter(image.get(), width, height,
+                                     AVIF_SCALE_FILTER_LANCZOS,
+                                     /*maxThreads=*/1, &diag),
+            AVIF_RESULT_OK);
+  testutil::AvifRgbImage expected(image.get(), bit_depth,
+                                  AVIF_RGB_FORMAT_RGBA);
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &expected), AVIF_RESULT_OK);
+  if (filter == AVIF_SCALE_FILTER_LANCZOS) {
+    EXPECT_TRUE(testutil::AreImagesEqual(rgb, expected));
+  } else {
+    EXPECT_FALSE(testutil::AreImagesEqual(rgb, expected));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Filters, YUVToRGBScaledTest,
+    Combine(/*bit_depth=*/Values(8, 10),
+            Values(AVIF_SCALE_FILTER_BOX, AVIF_SCALE_FILTER_LANCZOS),
+            /*alpha=*/Values(false, true)));
+
+TEST(YUVToRGBScaledTest, Subsampled) {
+  ImagePtr image = testutil::ReadImage(
+      data_path, "paris_exif_xmp_icc.jpg", AVIF_PIXEL_FORMAT_YUV420, 8,
+      AVIF_CHROMA_DOWNSAMPLING_BEST_QUALITY, kIgnoreMetadata, kIgnoreMetadata,
+      kIgnoreMetadata);
+  ASSERT_NE(image, nullptr);
+
+  // Same dimensions: regular conversion.
+  testutil::AvifRgbImage rgb(image.get(), 8, AVIF_RGB_FORMAT_RGB);
+  testutil::AvifRgbImage expected(image.get(), 8, AVIF_RGB_FORMAT_RGB);
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &rgb,
+                                    AVIF_SCALE_FILTER_AUTOMATIC),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &expected), AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(rgb, expected));
+
+  // Downscaled: close to scaling the YUV planes then converting. Chroma is
+  // resampled once instead of twice, so the results are not identical.
+  const uint32_t width = image->width / 3;
+  const uint32_t height = image->height / 3;
+  avifRGBImageFreePixels(&rgb);
+  rgb.width = width;
+  rgb.height = height;
+  ASSERT_EQ(avifRGBImageAllocatePixels(&rgb), AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &rgb,
+                                    AVIF_SCALE_FILTER_LANCZOS),
+            AVIF_RESULT_OK);
+  avifDiagnostics diag;
+  ASSERT_EQ(avifImageScaleWithFilter(image.get(), width, height,
+                                     AVIF_SCALE_FILTER_LANCZOS,
+                                     /*maxThreads=*/1, &diag),
+            AVIF_RESULT_OK);
+  testutil::AvifRgbImage scaled(image.get(), 8, AVIF_RGB_FORMAT_RGB);
+  ASSERT_EQ(avifImageYUVToRGB(image.get(), &scaled), AVIF_RESULT_OK);
+  uint64_t sum_diff = 0;
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width * 3; ++x) {
+      sum_diff += std::abs(rgb.pixels[y * rgb.rowBytes + x] -
+                           scaled.pixels[y * scaled.rowBytes + x]);
+    }
+  }
+  EXPECT_LT(static_cast<double>(sum_diff) / (width * height * 3), 2.0);
+}
+
+TEST(YUVToRGBScaledTest, MultithreadedSameAsSingleThreaded) {
+  ImagePtr image = testutil::ReadImage(
+      data_path, "paris_exif_xmp_icc.jpg", AVIF_PIXEL_FORMAT_YUV420, 10,
+      AVIF_CHROMA_DOWNSAMPLING_BEST_QUALITY, kIgnoreMetadata, kIgnoreMetadata,
+      kIgnoreMetadata);
+  ASSERT_NE(image, nullptr);
+  ASSERT_EQ(avifImageAllocatePlanes(image.get(), AVIF_PLANES_A),
+            AVIF_RESULT_OK);
+  testutil::FillImageGradient(image.get());
+
+  testutil::AvifRgbImage single(image.get(), 10, AVIF_RGB_FORMAT_RGBA);
+  testutil::AvifRgbImage multi(image.get(), 10, AVIF_RGB_FORMAT_RGBA);
+  for (avifRGBImage* rgb : {&single, &multi}) {
+    avifRGBImageFreePixels(rgb);
+    rgb->width = image->width * 3 / 4;
+    // Not a multiple of the strip height.
+    rgb->height = image->height * 3 / 2 + 1;
+    rgb->alphaPremultiplied = AVIF_TRUE;
+    ASSERT_EQ(avifRGBImageAllocatePixels(rgb), AVIF_RESULT_OK);
+  }
+  single.maxThreads = 1;
+  multi.maxThreads = 7;
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &single,
+                                    AVIF_SCALE_FILTER_BILINEAR),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifImageYUVToRGBScaled(image.get(), &multi,
+                                    AVIF_SCALE_FILTER_BILINEAR),
+            AVIF_RESULT_OK);
+  EXPECT_TRUE(testutil::AreImagesEqual(single, multi));
+
+  multi.maxThreads = -1;
+  EXPECT_EQ(avifImageYUVToRGBScaled(image.get(), &multi,
+                                    AVIF_SCALE_FILTER_BILINEAR),
+            AVIF_RESULT_REFORMAT_FAILED);
+}
+
 TEST(ScaleTest, LargerThanDefaultLimits) {
   const ImagePtr image = testutil::ReadImage(
       data_path, "paris_exif_xmp_icc.jpg", AVIF_PIXEL_FORMAT_YUV420, 8,
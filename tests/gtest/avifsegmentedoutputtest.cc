@@ -0,0 +1,243 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "avif/avif.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+std::vector<uint8_t> ReadFile(const std::string& file_name) {
+  std::ifstream file(std::string(data_path) + file_name, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+// Returns an encoder ready to be finished, holding the samples of file.
+// No codec is needed.
+EncoderPtr Remux(const std::vector<uint8_t>& file) {
+  DecoderPtr decoder(avifDecoderCreate());
+  EncoderPtr encoder(avifEncoderCreate());
+  if (decoder == nullptr || encoder == nullptr ||
+      avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()) !=
+          AVIF_RESULT_OK ||
+      avifDecoderParse(decoder.get()) != AVIF_RESULT_OK ||
+      avifEncoderRemux(encoder.get(), decoder.get()) != AVIF_RESULT_OK) {
+    return nullptr;
+  }
+  return encoder;
+}
+
+std::vector<uint8_t> Concatenate(const avifEncoderSegments& output) {
+  std::vector<uint8_t> bytes;
+  for (uint32_t i = 0; i < output.segmentCount; ++i) {
+    bytes.insert(bytes.end(), output.segments[i].data,
+                 output.segments[i].data + output.segments[i].size);
+  }
+  return bytes;
+}
+
+class SegmentedOutputTest : public testing::TestWithParam<const char*> {};
+
+TEST_P(SegmentedOutputTest, SameAsFinish) {
+  const std::vector<uint8_t> file = ReadFile(GetParam());
+  ASSERT_FALSE(file.empty());
+  EncoderPtr encoder = Remux(file);
+  EncoderPtr segmented_encoder = Remux(file);
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_NE(segmented_encoder, nullptr);
+
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+  avifEncoderSegments output = {};
+  ASSERT_EQ(avifEncoderFinishSegmented(segmented_encoder.get(), &output),
+            AVIF_RESULT_OK);
+
+  // The header is followed by at least one chunk of the mdat payload, which
+  // is not copied.
+  ASSERT_GT(output.segmentCount, 1u);
+  EXPECT_EQ(output.segments[0].data, output.header.data);
+  EXPECT_EQ(output.segments[0].size, output.header.size);
+  EXPECT_LT(output.header.size, encoded.size);
+  EXPECT_EQ(output.size, encoded.size);
+  const std::vector<uint8_t> bytes = Concatenate(output);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(bytes.data(), bytes.size(),
+                                              encoded.data, encoded.size));
+  EXPECT_EQ(segmented_encoder->ioStats.colorOBUSize,
+            encoder->ioStats.colorOBUSize);
+  EXPECT_EQ(segmented_encoder->ioStats.alphaOBUSize,
+            encoder->ioStats.alphaOBUSize);
+  avifEncoderSegmentsFree(&output);
+  EXPECT_EQ(output.segments, nullptr);
+  EXPECT_EQ(output.segmentCount, 0u);
+  EXPECT_EQ(output.header.data, nullptr);
+}
+
+INSTANTIATE_TEST_SUITE_P(Files, SegmentedOutputTest,
+                         testing::Values("white_1x1.avif",
+                                         "paris_icc_exif_xmp.avif",
+                                         "colors-animated-8bpc.avif"));
+
+TEST(SegmentedOutputTest, Deduplication) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  ASSERT_EQ(avifDecoderSetIOMemory(decoder.get(), file.data(), file.size()),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  avifExtent extent;
+  ASSERT_EQ(avifDecoderNthImageMaxExtent(decoder.get(), 0, &extent),
+            AVIF_RESULT_OK);
+  ASSERT_LE(extent.offset + extent.size, file.size());
+  const avifROData obus = {file.data() + extent.offset, extent.size};
+
+  // The same OBUs are used for color and alpha.
+  EncoderPtr encoder(avifEncoderCreate());
+  EncoderPtr segmented_encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_NE(segmented_encoder, nullptr);
+  for (avifEncoder* e : {encoder.get(), segmented_encoder.get()}) {
+    ASSERT_EQ(avifEncoderAddEncodedImage(e, decoder->image, &obus, &obus, 1,
+                                         AVIF_ADD_IMAGE_FLAG_SINGLE),
+              AVIF_RESULT_OK);
+  }
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+  avifEncoderSegments output = {};
+  ASSERT_EQ(avifEncoderFinishSegmented(segmented_encoder.get(), &output),
+            AVIF_RESULT_OK);
+
+  // Header and a single chunk shared by both items.
+  EXPECT_EQ(output.segmentCount, 2u);
+  const std::vector<uint8_t> bytes = Concatenate(output);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(bytes.data(), bytes.size(),
+                                              encoded.data, encoded.size));
+  avifEncoderSegmentsFree(&output);
+}
+
+//------------------------------------------------------------------------------
+
+// avifIO appending everything written to a vector.
+struct VectorWriter {
+  avifIO io;  // Must be the first member for casting.
+  std::vector<uint8_t> bytes;
+  bool in_order = true;
+  bool finished = false;
+
+  static avifResult Write(avifIO* io, uint32_t write_flags, uint64_t offset,
+                          const uint8_t* data, size_t size) {
+    VectorWriter* writer = reinterpret_cast<VectorWriter*>(io);
+    if (writer->finished) return AVIF_RESULT_IO_ERROR;
+    if (write_flags == AVIF_IO_WRITE_FLAG_FINISH) {
+      writer->finished = true;
+    } else if (write_flags != AVIF_IO_WRITE_FLAG_NONE) {
+      return AVIF_RESULT_IO_ERROR;
+    }
+    writer->in_order &= (offset == writer->bytes.size());
+    writer->bytes.insert(writer->bytes.end(), data, data + size);
+    return AVIF_RESULT_OK;
+  }
+};
+
+TEST(FinishToIOTest, SameAsFinish) {
+  const std::vector<uint8_t> file = ReadFile("colors-animated-8bpc.avif");
+  EncoderPtr encoder = Remux(file);
+  EncoderPtr io_encoder = Remux(file);
+  ASSERT_NE(encoder, nullptr);
+  ASSERT_NE(io_encoder, nullptr);
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderFinish(encoder.get(), &encoded), AVIF_RESULT_OK);
+
+  VectorWriter writer = {};
+  writer.io.write = VectorWriter::Write;
+  ASSERT_EQ(avifEncoderFinishToIO(io_encoder.get(), &writer.io),
+            AVIF_RESULT_OK);
+  EXPECT_TRUE(writer.in_order);
+  EXPECT_TRUE(writer.finished);
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(
+      writer.bytes.data(), writer.bytes.size(), encoded.data, encoded.size));
+}
+
+TEST(FinishToIOTest, File) {
+  const std::vector<uint8_t> file = ReadFile("paris_icc_exif_xmp.avif");
+  EncoderPtr encoder = Remux(file);
+  ASSERT_NE(encoder, nullptr);
+  const std::string path = testing::TempDir() + "/avifsegmentedoutput.avif";
+  avifIO* io = avifIOCreateFileWriter(path.c_str());
+  ASSERT_NE(io, nullptr);
+  const avifResult result = avifEncoderFinishToIO(encoder.get(), io);
+  avifIODestroy(io);
+  ASSERT_EQ(result, AVIF_RESULT_OK);
+
+  // The file was written by libavif so remuxing it as is changes nothing.
+  std::ifstream written_file(path, std::ios::binary);
+  const std::vector<uint8_t> written(
+      std::istreambuf_iterator<char>(written_file), {});
+  EXPECT_EQ(written, file);
+}
+
+TEST(FinishToIOTest, Errors) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  EncoderPtr encoder = Remux(file);
+  ASSERT_NE(encoder, nullptr);
+  // Readers cannot be written to.
+  avifIO* reader = avifIOCreateMemoryReader(file.data(), file.size());
+  ASSERT_NE(reader, nullptr);
+  EXPECT_EQ(avifEncoderFinishToIO(encoder.get(), reader),
+            AVIF_RESULT_INVALID_ARGUMENT);
+  avifIODestroy(reader);
+
+  VectorWriter writer = {};
+  writer.io.write = [](avifIO*, uint32_t, uint64_t, const uint8_t*, size_t) {
+    return AVIF_RESULT_IO_ERROR;
+  };
+  EXPECT_EQ(avifEncoderFinishToIO(encoder.get(), &writer.io),
+            AVIF_RESULT_IO_ERROR);
+
+  // Errors when committing the written data are reported too.
+  writer.io.write = [](avifIO*, uint32_t write_flags, uint64_t,
+                       const uint8_t*, size_t) {
+    return (write_flags & AVIF_IO_WRITE_FLAG_FINISH) ? AVIF_RESULT_IO_ERROR
+                                                     : AVIF_RESULT_OK;
+  };
+  EXPECT_EQ(avifEncoderFinishToIO(encoder.get(), &writer.io),
+            AVIF_RESULT_IO_ERROR);
+}
+
+#if defined(__linux__)
+// Writing to /dev/full only fails when the buffered data is flushed.
+TEST(FinishToIOTest, FileFlushError) {
+  const std::vector<uint8_t> file = ReadFile("white_1x1.avif");
+  EncoderPtr encoder = Remux(file);
+  ASSERT_NE(encoder, nullptr);
+  avifIO* io = avifIOCreateFileWriter("/dev/full");
+  if (io == nullptr) GTEST_SKIP() << "/dev/full cannot be opened";
+  const avifResult result = avifEncoderFinishToIO(encoder.get(), io);
+  avifIODestroy(io);
+  EXPECT_EQ(result, AVIF_RESULT_IO_ERROR);
+}
+#endif
+
+}  // namespace
+}  // namespace avif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  avif::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -204,6 +204,83 @@ TEST(StreamTest, Roundtrip) {
   EXPECT_FALSE(avifROStreamSkip(&ro_stream, /*byteCount=*/1));
 }
 
+TEST(StreamTest, ReadArrays) {
+  testutil::AvifRwData rw_data;
+  avifRWStream rw_stream;
+  avifRWStreamStart(&rw_stream, &rw_data);
+  const uint32_t u32s[] = {0, 1, 0x01020304, 0xFFFFFFFF, 42};
+  const uint64_t u64s[] = {0, 0x0102030405060708, 0xFFFFFFFFFFFFFFFF};
+  for (uint32_t v : u32s) {
+    ASSERT_EQ(avifRWStreamWriteU32(&rw_stream, v), AVIF_RESULT_OK);
+  }
+  for (uint64_t v : u64s) {
+    ASSERT_EQ(avifRWStreamWriteU64(&rw_stream, v), AVIF_RESULT_OK);
+  }
+  avifRWStreamFinishWrite(&rw_stream);
+
+  avifROData ro_data = {rw_data.data, rw_data.size};
+  avifROStream ro_stream;
+  avifROStreamStart(&ro_stream, &ro_data, nullptr, nullptr);
+  const uint8_t* data;
+  ASSERT_TRUE(avifROStreamReadArray(&ro_stream, 5, sizeof(uint32_t), &data));
+  EXPECT_EQ(data, rw_data.data);
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(avifLoadU32BE(data + i * sizeof(uint32_t)), u32s[i]);
+  }
+  EXPECT_EQ(avifROStreamOffset(&ro_stream), sizeof(u32s));
+
+  // Not enough bytes left. Nothing is read.
+  EXPECT_FALSE(avifROStreamReadArray(&ro_stream, 4, sizeof(uint64_t), &data));
+  EXPECT_FALSE(avifROStreamReadArray(&ro_stream,
+                                     std::numeric_limits<size_t>::max() / 4,
+                                     sizeof(uint64_t), &data));
+  EXPECT_EQ(avifROStreamOffset(&ro_stream), sizeof(u32s));
+  ASSERT_TRUE(avifROStreamReadArray(&ro_stream, 3, sizeof(uint64_t), &data));
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(avifLoadU64BE(data + i * sizeof(uint64_t)), u64s[i]);
+  }
+  EXPECT_TRUE(avifROStreamReadArray(&ro_stream, 0, sizeof(uint32_t), &data));
+  EXPECT_FALSE(avifROStreamReadArray(&ro_stream, 1, sizeof(uint32_t), &data));
+  EXPECT_EQ(avifROStreamOffset(&ro_stream), rw_data.size);
+}
+
+TEST(StreamTest, Growth) {
+  testutil::AvifRwData rw_data;
+  avifRWStream rw_stream;
+  avifRWStreamStart(&rw_stream, &rw_data);
+
+  // The buffer grows geometrically, so few reallocations happen.
+  int num_reallocations = 0;
+  const uint8_t* previous_buffer = nullptr;
+  const std::vector<uint8_t> chunk(1000, 42);
+  for (int i = 0; i < 10000; ++i) {
+    ASSERT_EQ(avifRWStreamWrite(&rw_stream, chunk.data(), chunk.size()),
+              AVIF_RESULT_OK);
+    if (rw_data.data != previous_buffer) {
+      ++num_reallocations;
+      previous_buffer = rw_data.data;
+    }
+  }
+  EXPECT_LT(num_reallocations, 20);
+
+  // Reserving makes the following writes realloc-free.
+  ASSERT_EQ(avifRWStreamReserve(&rw_stream, 12345678), AVIF_RESULT_OK);
+  previous_buffer = rw_data.data;
+  for (int i = 0; i < 12345; ++i) {
+    ASSERT_EQ(avifRWStreamWrite(&rw_stream, chunk.data(), chunk.size()),
+              AVIF_RESULT_OK);
+  }
+  EXPECT_EQ(rw_data.data, previous_buffer);
+  EXPECT_EQ(avifRWStreamReserve(&rw_stream,
+                                std::numeric_limits<size_t>::max()),
+            AVIF_RESULT_OUT_OF_MEMORY);
+
+  avifRWStreamFinishWrite(&rw_stream);
+  ASSERT_EQ(rw_data.size, size_t{(10000 + 12345) * 1000});
+  EXPECT_TRUE(std::all_of(rw_data.data, rw_data.data + rw_data.size,
+                          [](uint8_t byte) { return byte == 42; }));
+}
+
 //------------------------------------------------------------------------------
 
 }  // namespace
@@ -56,6 +56,7 @@ RgbChannelOffsets GetRgbChannelOffsets(avifRGBFormat format) {
     case AVIF_RGB_FORMAT_ABGR:
       return {/*r=*/3, /*g=*/2, /*b=*/1, /*a=*/0};
     case AVIF_RGB_FORMAT_RGB_565:
+    case AVIF_RGB_FORMAT_RGBA1010102:
     case AVIF_RGB_FORMAT_COUNT:
     default:
       return {/*r=*/0, /*g=*/0, /*b=*/0, /*a=*/0};
@@ -158,6 +159,33 @@ void FillImageChannel(avifRGBImage* image, uint32_t channel_offset,
       : FillImageChannel<uint16_t>(image, channel_offset, value);
 }
 
+void FillRgbPattern(avifRGBImage* rgb) {
+  uint32_t seed = 1;
+  const uint32_t max_value = (1u << rgb->depth) - 1;
+  const uint32_t channels = avifRGBFormatChannelCount(rgb->format);
+  for (uint32_t y = 0; y < rgb->height; ++y) {
+    uint8_t* row = rgb->pixels + y * rgb->rowBytes;
+    for (uint32_t x = 0; x < rgb->width * channels; ++x) {
+      uint32_t value;
+      if (x < rgb->width * channels / 2) {
+        value = (x / channels * (1 + x % channels) + y) * max_value /
+                (3 * rgb->width + rgb->height);
+      } else {
+        seed = seed * 1103515245u + 12345u;
+        value = (seed >> 8) % (max_value + 1);
+      }
+      if (rgb->depth > 8) {
+        reinterpret_cast<uint16_t*>(row)[x] = static_cast<uint16_t>(value);
+      } else {
+        row[x] = static_cast<uint8_t>(value);
+      }
+    }
+  }
+  if (avifRGBFormatHasAlpha(rgb->format)) {
+    FillImageChannel(rgb, GetRgbChannelOffsets(rgb->format).a, max_value);
+  }
+}
+
 //------------------------------------------------------------------------------
 
 bool AreByteSequencesEqual(const uint8_t data1[], size_t data1_length,
@@ -74,6 +74,11 @@ void FillImagePlain(avifImage* image, const uint32_t yuva[4]);
 void FillImageGradient(avifImage* image);
 void FillImageChannel(avifRGBImage* image, uint32_t channel_offset,
                       uint32_t value);
+// Fills the color channels of rgb with a deterministic pattern spanning the
+// whole range of sample values (half smooth gradient, half noise), and the
+// alpha channel (if any) with the maximum value. The pinned checksums of
+// aviffixedpointtest depend on this pattern.
+void FillRgbPattern(avifRGBImage* rgb);
 
 // Returns true if both arrays are empty or have the same length and bytes.
 // data1 may be null only when data1_length is 0.
@@ -0,0 +1,131 @@
+// Copyright 2023 Google LLC
+// SPDX-License-Identifier: BSD-2-Clause
+
+#include <string>
+
+#include "avif/avif.h"
+#include "aviftest_helpers.h"
+#include "gtest/gtest.h"
+
+namespace avif {
+namespace {
+
+// Used to pass the data folder path to the GoogleTest suites.
+const char* data_path = nullptr;
+
+// Decodes the encoded file with the given minThumbnailSize.
+DecoderPtr DecodeWithMinThumbnailSize(const testutil::AvifRwData& encoded,
+                                      uint32_t min_thumbnail_size) {
+  DecoderPtr decoder(avifDecoderCreate());
+  if (decoder == nullptr) return nullptr;
+  decoder->minThumbnailSize = min_thumbnail_size;
+  if (avifDecoderSetIOMemory(decoder.get(), encoded.data, encoded.size) !=
+          AVIF_RESULT_OK ||
+      avifDecoderNextImage(decoder.get()) != AVIF_RESULT_OK) {
+    return nullptr;
+  }
+  return decoder;
+}
+
+TEST(ThumbnailTest, EncodeDecode) {
+  if (!testutil::Av1EncoderAvailable() || !testutil::Av1DecoderAvailable()) {
+    GTEST_SKIP() << "AV1 Codec unavailable, skip test.";
+  }
+  ImagePtr image = testutil::CreateImage(/*width=*/64, /*height=*/48,
+                                         /*depth=*/8, AVIF_PIXEL_FORMAT_YUV444,
+                                         AVIF_PLANES_ALL);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  const uint8_t exif[] = {'M', 'M', 0, 42, 0, 0, 0, 8};
+  ASSERT_EQ(avifImageSetMetadataExif(image.get(), exif, sizeof(exif)),
+            AVIF_RESULT_OK);
+
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->speed = AVIF_SPEED_FASTEST;
+  encoder->thumbnailSizes[0] = 32;
+  encoder->thumbnailSizes[1] = 16;
+  encoder->thumbnailSizes[2] = 64;  // Not smaller than the image. Ignored.
+  testutil::AvifRwData encoded;
+  ASSERT_EQ(avifEncoderWrite(encoder.get(), image.get(), &encoded),
+            AVIF_RESULT_OK);
+
+  DecoderPtr decoder = DecodeWithMinThumbnailSize(encoded, 0);
+  ASSERT_NE(decoder, nullptr);
+  EXPECT_FALSE(decoder->thumbnailSelected);
+  EXPECT_EQ(decoder->image->width, 64u);
+  EXPECT_EQ(decoder->image->height, 48u);
+
+  decoder = DecodeWithMinThumbnailSize(encoded, 20);
+  ASSERT_NE(decoder, nullptr);
+  EXPECT_TRUE(decoder->thumbnailSelected);
+  EXPECT_EQ(decoder->image->width, 32u);
+  EXPECT_EQ(decoder->image->height, 24u);
+  EXPECT_TRUE(decoder->alphaPresent);
+  EXPECT_NE(decoder->image->alphaPlane, nullptr);
+  // The metadata of the primary item is kept.
+  EXPECT_TRUE(testutil::AreByteSequencesEqual(
+      decoder->image->exif.data, decoder->image->exif.size, exif,
+      sizeof(exif)));
+
+  decoder = DecodeWithMinThumbnailSize(encoded, 1);
+  ASSERT_NE(decoder, nullptr);
+  EXPECT_TRUE(decoder->thumbnailSelected);
+  EXPECT_EQ(decoder->image->width, 16u);
+  EXPECT_EQ(decoder->image->height, 12u);
+
+  // No thumbnail is large enough.
+  decoder = DecodeWithMinThumbnailSize(encoded, 33);
+  ASSERT_NE(decoder, nullptr);
+  EXPECT_FALSE(decoder->thumbnailSelected);
+  EXPECT_EQ(decoder->image->width, 64u);
+  EXPECT_EQ(decoder->image->height, 48u);
+}
+
+TEST(ThumbnailTest, OnlyForStillImages) {
+  if (!testutil::Av1EncoderAvailable()) {
+    GTEST_SKIP() << "AV1 Codec unavailable, skip test.";
+  }
+  ImagePtr image = testutil::CreateImage(/*width=*/64, /*height=*/48,
+                                         /*depth=*/8, AVIF_PIXEL_FORMAT_YUV420,
+                                         AVIF_PLANES_YUV);
+  ASSERT_NE(image, nullptr);
+  testutil::FillImageGradient(image.get());
+  EncoderPtr encoder(avifEncoderCreate());
+  ASSERT_NE(encoder, nullptr);
+  encoder->thumbnailSizes[0] = 16;
+  EXPECT_EQ(avifEncoderAddImage(encoder.get(), image.get(), 1,
+                                AVIF_ADD_IMAGE_FLAG_NONE),
+            AVIF_RESULT_INVALID_ARGUMENT);
+}
+
+TEST(ThumbnailTest, NoThumbnail) {
+  DecoderPtr decoder(avifDecoderCreate());
+  ASSERT_NE(decoder, nullptr);
+  decoder->minThumbnailSize = 16;
+  ASSERT_EQ(avifDecoderSetIOFile(
+                decoder.get(),
+                (std::string(data_path) + "paris_icc_exif_xmp.avif").c_str()),
+            AVIF_RESULT_OK);
+  ASSERT_EQ(avifDecoderParse(decoder.get()), AVIF_RESULT_OK);
+  // The primary item is selected.
+  EXPECT_FALSE(decoder->thumbnailSelected);
+  EXPECT_EQ(decoder->image->width, 403u);
+  EXPECT_EQ(decoder->image->height, 302u);
+  EXPECT_GT(decoder->image->exif.size, 0u);
+}
+
+}  // namespace
+}  // namespace avif
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  if (argc != 2) {
+    std::cerr << "There must be exactly one argument containing the path to "
+                 "the test data folder"
+              << std::endl;
+    return 1;
+  }
+  avif::data_path = argv[1];
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,71 @@
+#!/bin/bash
+# Copyright 2023 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ------------------------------------------------------------------------------
+#
+# tests for command lines (remux)
+
+# Very verbose but useful for debugging.
+set -ex
+
+if [[ "$#" -ge 1 ]]; then
+  # eval so that the passed in directory can contain variables.
+  BINARY_DIR="$(eval echo "$1")"
+else
+  # Assume "tests" is the current directory.
+  BINARY_DIR="$(pwd)/.."
+fi
+if [[ "$#" -ge 2 ]]; then
+  TESTDATA_DIR="$(eval echo "$2")"
+else
+  TESTDATA_DIR="$(pwd)/data"
+fi
+if [[ "$#" -ge 3 ]]; then
+  TMP_DIR="$(eval echo "$3")"
+else
+  TMP_DIR="$(mktemp -d)"
+fi
+
+AVIFENC="${BINARY_DIR}/avifenc"
+
+# Input file paths.
+INPUT_AVIF="${TESTDATA_DIR}/paris_icc_exif_xmp.avif"
+INPUT_AVIF_GRID="${TESTDATA_DIR}/sofa_grid1x5_420.avif"
+# Output file names.
+REMUXED_FILE="avif_test_cmd_remux_remuxed.avif"
+REMUXED_FILE_NO_METADATA="avif_test_cmd_remux_remuxed_no_metadata.avif"
+REMUXED_FILE_GRID="avif_test_cmd_remux_remuxed_grid.avif"
+
+# Cleanup
+cleanup() {
+  pushd ${TMP_DIR}
+    rm -f -- "${REMUXED_FILE}" "${REMUXED_FILE_NO_METADATA}" "${REMUXED_FILE_GRID}"
+  popd
+}
+trap cleanup EXIT
+
+pushd ${TMP_DIR}
+  # No codec is involved so these tests run with any build configuration.
+  echo "Testing remux"
+  # The input was written by libavif so remuxing it without any change is lossless.
+  "${AVIFENC}" --remux "${INPUT_AVIF}" -o "${REMUXED_FILE}"
+  cmp "${INPUT_AVIF}" "${REMUXED_FILE}"
+  # Stripping metadata should produce a smaller file.
+  "${AVIFENC}" --remux --ignore-exif --ignore-xmp "${INPUT_AVIF}" -o "${REMUXED_FILE_NO_METADATA}"
+  [[ $(wc -c < "${REMUXED_FILE_NO_METADATA}") -lt $(wc -c < "${INPUT_AVIF}") ]] || exit 1
+  # Grids are not supported.
+  "${AVIFENC}" --remux "${INPUT_AVIF_GRID}" -o "${REMUXED_FILE_GRID}" && exit 1
+popd
+
+exit 0